@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+#
+# EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+# Copyright (C) 2018-2025 The EXP-T developers.
+#
+# This file is part of EXP-T.
+#
+# EXP-T is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# EXP-T is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+#
+# E-mail:        exp-t-program@googlegroups.com
+# Google Groups: https://groups.google.com/d/forum/exp-t-program
+#
+
+#
+# Writes integrals obtained with PySCF into the files read by the EXP-T
+# PySCF interface:
+#
+#   write_spinor_info()  file with the spinor energies and occupations
+#                        (first argument of the 'integrals' directive)
+#   write_chunked_eri()  two-electron integrals in the chunked layout
+#                        (second argument, see src/rcc/include/pyscf_eri.h)
+#
+# The chunked file is written chunk by chunk: the full array of integrals
+# is not needed if get_block() transforms integrals on the fly.
+# numpy is used if available; without it (small systems, tests) blocks can be
+# nested lists and chunks are packed element by element.
+#
+# Example (Dirac-Hartree-Fock):
+#
+#   mf = scf.DHF(mol).run()
+#   eri = ao2mo.kernel(mol.intor('int2e_spinor'), mf.mo_coeff)  # (pq|rs)
+#   write_spinor_info('pyscf_1e.bin', mol.energy_nuc(), mf.e_tot, mf.mo_occ, mf.mo_energy)
+#   write_chunked_eri('pyscf_2e.bin', eri.shape[0], lambda p, q, r, s: eri[p, q, r, s])
+#
+# input for EXP-T:
+#
+#   interface pyscf
+#   integrals pyscf_1e.bin pyscf_2e.bin
+#
+
+import struct
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+MAGIC = b'EXPTERIC'
+VERSION = 1
+
+
+def write_spinor_info(path, enuc, escf, occ, eps):
+    with open(path, 'wb') as f:
+        f.write(struct.pack('<idd', len(eps), enuc, escf))
+        for n_i, e_i in zip(occ, eps):
+            f.write(struct.pack('<id', int(round(n_i)), e_i))
+
+
+def write_chunked_eri(path, n_spinors, get_block, chunk_size=32, real=False):
+    """
+    get_block(p, q, r, s) returns integrals (pq|rs) (Mulliken notation) for
+    the slices p, q, r, s of spinor indices. EXP-T stores <pq|rs> = (pr|qs).
+    """
+    n = n_spinors
+    c = chunk_size
+    nc = (n + c - 1) // c
+    value_size = 8 if real else 16
+
+    with open(path, 'wb') as f:
+        header = MAGIC + struct.pack('<iiiiq', VERSION, n, c, value_size, nc ** 4)
+        f.write(header + b'\0' * (64 - len(header)))
+
+        slices = [slice(a * c, min((a + 1) * c, n)) for a in range(nc)]
+        for sp in slices:
+            for sq in slices:
+                for sr in slices:
+                    for ss in slices:
+                        block = get_block(sp, sr, sq, ss)
+                        if np is not None:
+                            f.write(numpy_chunk(block, c, real))
+                        else:
+                            f.write(packed_chunk(block, c, real))
+
+
+def numpy_chunk(block, c, real):
+    chunk = np.zeros((c, c, c, c), dtype=np.float64 if real else np.complex128)
+    block = np.asarray(block).transpose(0, 2, 1, 3)
+    if real:
+        block = block.real
+    chunk[:block.shape[0], :block.shape[1], :block.shape[2], :block.shape[3]] = block
+    return chunk.tobytes()
+
+
+def packed_chunk(block, c, real):
+    # block[p][r][q][s] = (pr|qs) -> chunk[p][q][r][s], zero padded
+    dims = (len(block), len(block[0]), len(block[0][0]), len(block[0][0][0]))
+    values = []
+    for p in range(c):
+        for q in range(c):
+            for r in range(c):
+                for s in range(c):
+                    v = 0.0
+                    if p < dims[0] and r < dims[1] and q < dims[2] and s < dims[3]:
+                        v = complex(block[p][r][q][s])
+                    if real:
+                        values.append(v.real)
+                    else:
+                        values += [v.real, v.imag]
+    return struct.pack('<%dd' % len(values), *values)
@@ -0,0 +1,71 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Benchmarks of the EXP-T building blocks.
+ */
+
+#ifndef CC_BENCH_H_INCLUDED
+#define CC_BENCH_H_INCLUDED
+
+#include <stddef.h>
+
+typedef struct {
+    // size of the data buffers (in bytes)
+    size_t buf_size;
+
+    // number of repetitions of each measurement
+    int n_repeat;
+
+    // number of OpenMP threads
+    int nthreads;
+
+    // tolerance for the lossy compression
+    double lossy_tol;
+
+    // synthetic spinor layout for the engine benchmarks
+    int n_irreps;
+    int nocc;
+    int nvirt;
+    int tile_size;
+    int complex_arith;
+
+    // which benchmarks are to be run
+    int do_io;
+    int do_engine;
+
+    // file for results in the JSON format (NULL if not required)
+    char *json_path;
+} bench_params_t;
+
+void bench_io(bench_params_t *params);
+
+void bench_engine(bench_params_t *params);
+
+double bench_median_time(int n, double *times);
+
+void bench_report_add(char *group, char *name, double time, double n_flops, double n_bytes);
+
+void bench_report_write_json(bench_params_t *params);
+
+#endif /* CC_BENCH_H_INCLUDED */
@@ -0,0 +1,316 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Benchmarks of the diagram engine on synthetic spinor layouts (no integral
+ * files are required, see synthetic_interface.c).
+ *
+ * Operations are timed for the shapes of diagrams used in the models/
+ * directory:
+ *   mult            S2b (3 lines contracted), D2c ladder (pppp x pphh),
+ *                   T3 -> T2 contribution (4 lines contracted);
+ *   reorder         permutations of rank-4 and rank-6 diagrams;
+ *   diveps, update, scalar_product;
+ *   block_load / block_store of the on-disk pppp diagram, with and without
+ *                   compression;
+ *   diagram_new     creation of the T2 and T3 templates.
+ * Diagrams are filled with random numbers. FLOP and byte counts are taken
+ * from the engine itself (opstats.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "engine.h"
+#include "interfaces.h"
+#include "options.h"
+#include "spinors.h"
+
+
+typedef enum {
+    BENCH_MULT,
+    BENCH_REORDER,
+    BENCH_DIVEPS,
+    BENCH_UPDATE,
+    BENCH_SCALAR_PRODUCT,
+    BENCH_BLOCK_LOAD,
+    BENCH_BLOCK_STORE,
+    BENCH_DIAGRAM_NEW
+} bench_operation_t;
+
+typedef struct {
+    char *label;
+    bench_operation_t op;
+    char *name1;
+    char *name2;
+    char *arg;       // permutation (reorder) or template (diagram_new)
+    int ncontr;
+} bench_engine_case_t;
+
+static bench_engine_case_t engine_cases[] = {
+        {"mult S2b (t2 x pphp, 3)",       BENCH_MULT,           "s2b_t2",  "s2b_v",  NULL,     3},
+        {"mult D2c ladder (pppp x t2, 2)", BENCH_MULT,          "ppppr",   "t2c",    NULL,     2},
+        {"mult T3 -> T2 (t3 x pphh, 4)",  BENCH_MULT,           "t3_r",    "pphh",   NULL,     4},
+        {"reorder pphh 1243",             BENCH_REORDER,        "pphh",    NULL,     "1243",   0},
+        {"reorder pphh 2143",             BENCH_REORDER,        "pphh",    NULL,     "2143",   0},
+        {"reorder pphh 1324",             BENCH_REORDER,        "pphh",    NULL,     "1324",   0},
+        {"reorder t2 3412",               BENCH_REORDER,        "t2c",     NULL,     "3412",   0},
+        {"reorder pphp 4321",             BENCH_REORDER,        "pphp",    NULL,     "4321",   0},
+        {"reorder t3 145623",             BENCH_REORDER,        "t3c",     NULL,     "145623", 0},
+        {"diveps t2",                     BENCH_DIVEPS,         "t2nw",    NULL,     NULL,     0},
+        {"diveps t3",                     BENCH_DIVEPS,         "t3nw",    NULL,     NULL,     0},
+        {"update t2",                     BENCH_UPDATE,         "t2nw",    "t2c",    NULL,     0},
+        {"scalar_product hhpp x t2",      BENCH_SCALAR_PRODUCT, "hhpp",    "t2c",    NULL,     0},
+        {"block_store pppp",              BENCH_BLOCK_STORE,    "pppp",    NULL,     NULL,     0},
+        {"block_load pppp",               BENCH_BLOCK_LOAD,     "pppp",    NULL,     NULL,     0},
+        {"diagram_new t2",                BENCH_DIAGRAM_NEW,    "dg_new",  NULL,     "hhpp",   0},
+        {"diagram_new t3",                BENCH_DIAGRAM_NEW,    "dg_new",  NULL,     "hhhppp", 0},
+};
+
+static void create_diagrams();
+
+static void fill_random(char *name, unsigned int seed);
+
+static void bench_engine_case(bench_params_t *params, bench_engine_case_t *c, char *suffix);
+
+static double run_operation(bench_engine_case_t *c, double *n_bytes);
+
+
+void bench_engine(bench_params_t *params)
+{
+    cc_opts->tile_size = params->tile_size;
+    cc_opts->disk_usage_level = CC_DISK_USAGE_LEVEL_0;
+    cc_opts->compress = CC_COMPRESS_NONE;
+
+    synthetic_setup_spinors(cc_opts, params->n_irreps, params->nocc, params->nvirt, params->complex_arith);
+
+    printf("\n");
+    printf(" Diagram engine (%d repetitions)\n", params->n_repeat);
+    printf(" %s arithmetic, %d irreps, tile size %d, %d occupied + %d virtual spinors, %d threads\n",
+           params->complex_arith ? "complex" : "real", params->n_irreps, params->tile_size,
+           params->nocc, params->nvirt, params->nthreads);
+    printf(" ------------------------------------------------------------------------------\n");
+    printf("  operation                              time, s      GFLOP/s       GB/s\n");
+    printf(" ------------------------------------------------------------------------------\n");
+
+    create_diagrams();
+
+    int n_cases = sizeof(engine_cases) / sizeof(engine_cases[0]);
+    for (int i = 0; i < n_cases; i++) {
+        bench_engine_case_t *c = &engine_cases[i];
+
+        if (c->op == BENCH_BLOCK_LOAD || c->op == BENCH_BLOCK_STORE) {
+            // the on-disk 'pppp' diagram, as for disk usage levels >= 2
+            int compress_types[] = {CC_COMPRESS_NONE, CC_COMPRESS_LZ4};
+            char *codec_names[] = {"none", "lz4"};
+            for (int ic = 0; ic < 2; ic++) {
+                cc_opts->compress = compress_types[ic];
+                cc_opts->disk_usage_level = CC_DISK_USAGE_LEVEL_2;
+                tmplt("pppp", "pppp", "0000", "1234", NOT_PERM_UNIQUE);
+                cc_opts->disk_usage_level = CC_DISK_USAGE_LEVEL_0;
+                fill_random("pppp", 5);
+                bench_engine_case(params, c, codec_names[ic]);
+                diagram_stack_erase("pppp");
+            }
+            cc_opts->compress = CC_COMPRESS_NONE;
+        }
+        else {
+            bench_engine_case(params, c, NULL);
+        }
+    }
+
+    printf(" ------------------------------------------------------------------------------\n");
+}
+
+
+/*
+ * creates diagrams of the shapes which are typical for the CCSD and CCSDT
+ * models and fills them with random numbers
+ */
+static void create_diagrams()
+{
+    tmplt("t2c", "hhpp", "0000", "1234", IS_PERM_UNIQUE);
+    fill_random("t2c", 1);
+    tmplt("hhpp", "hhpp", "0000", "1234", NOT_PERM_UNIQUE);
+    fill_random("hhpp", 7);
+    tmplt("pphh", "pphh", "0000", "1234", NOT_PERM_UNIQUE);
+    fill_random("pphh", 2);
+    tmplt("pphp", "pphp", "0000", "1234", NOT_PERM_UNIQUE);
+    fill_random("pphp", 3);
+    tmplt("ppppr", "pppp", "0000", "3412", NOT_PERM_UNIQUE);
+    fill_random("ppppr", 4);
+    tmplt("t3c", "hhhppp", "000000", "123456", IS_PERM_UNIQUE);
+    fill_random("t3c", 6);
+
+    // operands of the S2b and T3 contributions (see sector00.c, sector00_ccsdt.c)
+    reorder("pphp", "s2b_v", "4321");
+    reorder("t2c", "s2b_t2", "2143");
+    reorder("t3c", "t3_r", "145623");
+
+    copy("t2c", "t2nw");
+    copy("t3c", "t3nw");
+
+    opstats_clear();
+}
+
+
+/*
+ * fills all unique blocks of the diagram with random numbers
+ */
+static void fill_random(char *name, unsigned int seed)
+{
+    diagram_t *dg = diagram_stack_find(name);
+
+    srand(seed);
+
+    for (size_t i = 0; i < dg->n_blocks; i++) {
+        block_t *block = dg->blocks[i];
+        if (block->is_unique == 0) {
+            continue;
+        }
+        block_load(block);
+        double *data = (double *) block->buf;
+        size_t n = block->size * SIZEOF_WORKING_TYPE / sizeof(double);
+        for (size_t j = 0; j < n; j++) {
+            data[j] = 0.1 * ((double) rand() / RAND_MAX - 0.5);
+        }
+        block_store(block);
+    }
+}
+
+
+static void bench_engine_case(bench_params_t *params, bench_engine_case_t *c, char *suffix)
+{
+    double *times = (double *) cc_malloc(sizeof(double) * params->n_repeat);
+
+    double io_bytes = 0.0;
+
+    opstats_clear();
+
+    for (int irep = 0; irep < params->n_repeat; irep++) {
+        opstats_begin("bench", c->name1, c->name2, NULL);
+        times[irep] = run_operation(c, &io_bytes);
+        opstats_end();
+
+        // results are not needed
+        if (c->op == BENCH_MULT || c->op == BENCH_REORDER) {
+            diagram_stack_erase("bench_r");
+        }
+        else if (c->op == BENCH_DIAGRAM_NEW) {
+            diagram_stack_erase(c->name1);
+        }
+    }
+
+    double n_flops = 0.0;
+    double n_bytes = 0.0;
+    opstats_get_totals(&n_flops, &n_bytes);
+    if (c->op == BENCH_BLOCK_LOAD || c->op == BENCH_BLOCK_STORE) {
+        // only the timed part of the load/store cycle
+        n_bytes = io_bytes;
+    }
+    n_flops /= params->n_repeat;
+    n_bytes /= params->n_repeat;
+    opstats_clear();
+
+    double t = bench_median_time(params->n_repeat, times);
+    double gflops = (t > 0.0) ? n_flops * 1e-9 / t : 0.0;
+    double gbytes = (t > 0.0) ? n_bytes * 1e-9 / t : 0.0;
+
+    char label[128];
+    if (suffix) {
+        snprintf(label, sizeof(label), "%s (%s)", c->label, suffix);
+    }
+    else {
+        snprintf(label, sizeof(label), "%s", c->label);
+    }
+
+    printf("  %-36s%12.6f%12.3f%12.3f\n", label, t, gflops, gbytes);
+    bench_report_add("engine", label, t, n_flops, n_bytes);
+
+    cc_free(times);
+}
+
+
+/*
+ * performs the benchmarked operation, returns its wall time.
+ * for the block I/O only the load (store) part of the load-store cycle is
+ * timed, the number of bytes transferred is accumulated in 'n_bytes'.
+ */
+static double run_operation(bench_engine_case_t *c, double *n_bytes)
+{
+    diagram_t *dg = NULL;
+    double t = 0.0;
+    double t0 = abs_time();
+
+    switch (c->op) {
+        case BENCH_MULT:
+            mult(c->name1, c->name2, "bench_r", c->ncontr);
+            break;
+        case BENCH_REORDER:
+            reorder(c->name1, "bench_r", c->arg);
+            break;
+        case BENCH_DIVEPS:
+            diveps(c->name1);
+            break;
+        case BENCH_UPDATE:
+            update(c->name1, 0.5, c->name2);
+            break;
+        case BENCH_SCALAR_PRODUCT:
+            scalar_product("C", "N", c->name1, c->name2);
+            break;
+        case BENCH_BLOCK_LOAD:
+        case BENCH_BLOCK_STORE:
+            dg = diagram_stack_find(c->name1);
+            for (size_t i = 0; i < dg->n_blocks; i++) {
+                block_t *block = dg->blocks[i];
+                if (block->is_unique == 0) {
+                    continue;
+                }
+                double t1 = abs_time();
+                block_load(block);
+                double t2 = abs_time();
+                block_store(block);
+                double t3 = abs_time();
+                t += (c->op == BENCH_BLOCK_LOAD) ? t2 - t1 : t3 - t2;
+                *n_bytes += (double) block->size * SIZEOF_WORKING_TYPE;
+            }
+            return t;
+        case BENCH_DIAGRAM_NEW: {
+            int rank = strlen(c->arg);
+            char valence[CC_DIAGRAM_MAX_RANK + 1];
+            char order[CC_DIAGRAM_MAX_RANK + 1];
+            for (int i = 0; i < rank; i++) {
+                valence[i] = '0';
+                order[i] = '1' + i;
+            }
+            valence[rank] = '\0';
+            order[rank] = '\0';
+            tmplt(c->name1, c->arg, valence, order, IS_PERM_UNIQUE);
+            break;
+        }
+    }
+
+    return abs_time() - t0;
+}
@@ -0,0 +1,176 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Throughput of the block I/O: io_write_compressed_fp() / io_read_compressed()
+ * for all the compression codecs, single- and multi-threaded.
+ * Accuracy of each codec is measured against the original data (only the
+ * lossy codec is allowed to introduce errors, up to the given tolerance).
+ * In the multi-threaded case each thread writes and reads its own file
+ * simultaneously with the others (as in the 'external' OpenMP algorithm of
+ * diagram contraction).
+ */
+
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "options.h"
+#include "timer.h"
+
+
+static void bench_io_case(bench_params_t *params, int compress, int nthreads, double *data);
+
+static void gen_synthetic_amplitudes(size_t n, double *data);
+
+
+void bench_io(bench_params_t *params)
+{
+    size_t n = params->buf_size / sizeof(double);
+    double *data = (double *) cc_malloc(n * sizeof(double));
+    gen_synthetic_amplitudes(n, data);
+
+    printf("\n");
+    printf(" Block I/O throughput (buffer size %.1f MB, %d repetitions)\n",
+           params->buf_size / (1024.0 * 1024.0), params->n_repeat);
+    printf(" lossy compression tolerance = %.1e\n", params->lossy_tol);
+    printf(" ------------------------------------------------------------------------------\n");
+    printf("  compression  threads   ratio    write, MB/s     read, MB/s   max abs error\n");
+    printf(" ------------------------------------------------------------------------------\n");
+
+    int compress_types[] = {CC_COMPRESS_NONE, CC_COMPRESS_LZ4, CC_COMPRESS_SHUFFLE,
+                            CC_COMPRESS_LOSSY, CC_COMPRESS_SPARSE};
+    for (int ic = 0; ic < 5; ic++) {
+        bench_io_case(params, compress_types[ic], 1, data);
+        if (params->nthreads > 1) {
+            bench_io_case(params, compress_types[ic], params->nthreads, data);
+        }
+    }
+    printf(" ------------------------------------------------------------------------------\n");
+
+    cc_free(data);
+}
+
+
+static void bench_io_case(bench_params_t *params, int compress, int nthreads, double *data)
+{
+    size_t nbytes = params->buf_size;
+    double *write_times = (double *) cc_malloc(sizeof(double) * params->n_repeat);
+    double *read_times = (double *) cc_malloc(sizeof(double) * params->n_repeat);
+    size_t file_size = 0;
+    double max_error = 0.0;
+
+    cc_opts->compress = compress;
+    cc_opts->compress_lossy_tol = params->lossy_tol;
+
+    for (int irep = 0; irep < params->n_repeat; irep++) {
+
+        double t0 = abs_time();
+        #pragma omp parallel num_threads(nthreads)
+        {
+            char file_name[64];
+            sprintf(file_name, "bench-io-%d.tmp", omp_get_thread_num());
+            if (io_file_exists(file_name)) {
+                io_remove(file_name);
+            }
+            int fd = io_open(file_name, "w");
+            io_write_compressed_fp(fd, data, nbytes);
+            io_close(fd);
+        }
+        write_times[irep] = abs_time() - t0;
+
+        file_size = io_fsize("bench-io-0.tmp");
+
+        t0 = abs_time();
+        #pragma omp parallel num_threads(nthreads) reduction(max:max_error)
+        {
+            char file_name[64];
+            sprintf(file_name, "bench-io-%d.tmp", omp_get_thread_num());
+            double *buf = (double *) cc_malloc(nbytes);
+            int fd = io_open(file_name, "r");
+            io_read_compressed(fd, buf, nbytes);
+            io_close(fd);
+            for (size_t i = 0; i < nbytes / sizeof(double); i++) {
+                double err = fabs(buf[i] - data[i]);
+                max_error = (err > max_error) ? err : max_error;
+            }
+            cc_free(buf);
+        }
+        read_times[irep] = abs_time() - t0;
+    }
+
+    for (int ithread = 0; ithread < nthreads; ithread++) {
+        char file_name[64];
+        sprintf(file_name, "bench-io-%d.tmp", ithread);
+        io_remove(file_name);
+    }
+
+    double tolerance = (compress == CC_COMPRESS_LOSSY) ? params->lossy_tol : 0.0;
+    if (max_error > tolerance) {
+        errquit("bench_io(): data read do not coincide with data written (max error %g)", max_error);
+    }
+
+    double total_mb = nthreads * nbytes / (1024.0 * 1024.0);
+    double t_write = bench_median_time(params->n_repeat, write_times);
+    double t_read = bench_median_time(params->n_repeat, read_times);
+
+    char *codec_names[] = {"none", "lz4", "shuffle", "lossy", "sparse"};
+    printf("  %-11s%8d%9.3f%15.1f%15.1f%16.2e\n", codec_names[compress],
+           nthreads, (double) nbytes / file_size, total_mb / t_write, total_mb / t_read, max_error);
+
+    char label[64];
+    sprintf(label, "write %s (%d threads)", codec_names[compress], nthreads);
+    bench_report_add("io", label, t_write, 0.0, (double) nthreads * nbytes);
+    sprintf(label, "read %s (%d threads)", codec_names[compress], nthreads);
+    bench_report_add("io", label, t_read, 0.0, (double) nthreads * nbytes);
+
+    cc_free(write_times);
+    cc_free(read_times);
+}
+
+
+/**
+ * fills the buffer with numbers which resemble cluster amplitudes:
+ * a lot of exact zeros (symmetry-forbidden elements) and quickly decaying
+ * values of random sign
+ */
+static void gen_synthetic_amplitudes(size_t n, double *data)
+{
+    srand(2018);
+
+    for (size_t i = 0; i < n; i++) {
+        double r = (double) rand() / RAND_MAX;
+        if (r < 0.3) {
+            data[i] = 0.0;
+        }
+        else {
+            data[i] = (r - 0.65) * exp(-0.01 * (i % 1000));
+        }
+    }
+}
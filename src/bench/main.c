@@ -0,0 +1,256 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * expt_bench: benchmarks of the EXP-T building blocks.
+ *
+ * Usage:
+ *   expt_bench [--only io|engine] [--repeat <n>] [--nthreads <n>] [--json <file>]
+ *              [--size <MB>] [--lossy-tol <tol>]
+ *              [--irreps <n>] [--tile <n>] [--nocc <n>] [--nvirt <n>] [--real|--complex]
+ *              [--memory <GB>]
+ *
+ * --size and --lossy-tol refer to the block I/O benchmarks, --irreps ... --complex
+ * define the synthetic spinor layout for the diagram engine benchmarks.
+ * Results can be saved in the JSON format to track performance regressions
+ * across versions and to compare BLAS backends.
+ *
+ * Temporary files are created in the current working directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "error.h"
+#include "memory.h"
+#include "options.h"
+#include "platform.h"
+#include "../rcc/version.h"
+
+#define BENCH_MAX_RESULTS 256
+
+typedef struct {
+    char group[16];
+    char name[64];
+    double time;
+    double n_flops;
+    double n_bytes;
+} bench_result_t;
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static int n_results = 0;
+
+static void bench_usage();
+
+
+int main(int argc, char **argv)
+{
+    bench_params_t params;
+
+    params.buf_size = 64 * 1024 * 1024;
+    params.n_repeat = 5;
+    params.nthreads = 1;
+    params.lossy_tol = 1e-10;
+    params.n_irreps = 4;
+    params.nocc = 10;
+    params.nvirt = 40;
+    params.tile_size = 100;
+    params.complex_arith = 1;
+    params.do_io = 1;
+    params.do_engine = 1;
+    params.json_path = NULL;
+    size_t max_memory_gb = 16;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            params.buf_size = (size_t) atoi(argv[++i]) * 1024 * 1024;
+        }
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            params.n_repeat = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--nthreads") == 0 && i + 1 < argc) {
+            params.nthreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--lossy-tol") == 0 && i + 1 < argc) {
+            params.lossy_tol = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--irreps") == 0 && i + 1 < argc) {
+            params.n_irreps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) {
+            params.tile_size = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--nocc") == 0 && i + 1 < argc) {
+            params.nocc = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--nvirt") == 0 && i + 1 < argc) {
+            params.nvirt = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--real") == 0) {
+            params.complex_arith = 0;
+        }
+        else if (strcmp(argv[i], "--complex") == 0) {
+            params.complex_arith = 1;
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            max_memory_gb = (size_t) atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            params.json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            i++;
+            params.do_io = (strcmp(argv[i], "io") == 0);
+            params.do_engine = (strcmp(argv[i], "engine") == 0);
+            if (!params.do_io && !params.do_engine) {
+                bench_usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            bench_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (params.buf_size == 0 || params.n_repeat <= 0 || params.nthreads <= 0 || params.lossy_tol <= 0.0 ||
+        params.n_irreps <= 0 || params.nocc <= 0 || params.nvirt <= 0 || params.tile_size <= 0 || max_memory_gb == 0) {
+        bench_usage();
+        return EXIT_FAILURE;
+    }
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    cc_opts = new_options();
+    cc_opts->nthreads = params.nthreads;
+    cc_opts->tile_size = params.tile_size;
+    cc_init_allocator(4 * (params.nthreads + 2) * params.buf_size + max_memory_gb * 1024u * 1024u * 1024u);
+
+    if (params.do_io) {
+        bench_io(&params);
+    }
+    if (params.do_engine) {
+        bench_engine(&params);
+    }
+
+    if (params.json_path) {
+        bench_report_write_json(&params);
+    }
+
+    delete_options(cc_opts);
+
+    return EXIT_SUCCESS;
+}
+
+
+static void bench_usage()
+{
+    printf("Usage: expt_bench [--only io|engine] [--repeat <n>] [--nthreads <n>] [--json <file>]\n");
+    printf("                  [--size <MB>] [--lossy-tol <tol>]\n");
+    printf("                  [--irreps <n>] [--tile <n>] [--nocc <n>] [--nvirt <n>] [--real|--complex]\n");
+    printf("                  [--memory <GB>]\n");
+}
+
+
+/**
+ * median of the measured times (the array is sorted in-place)
+ */
+double bench_median_time(int n, double *times)
+{
+    for (int i = 1; i < n; i++) {
+        double t = times[i];
+        int j = i - 1;
+        while (j >= 0 && times[j] > t) {
+            times[j + 1] = times[j];
+            j--;
+        }
+        times[j + 1] = t;
+    }
+
+    return (n % 2 == 1) ? times[n / 2] : 0.5 * (times[n / 2 - 1] + times[n / 2]);
+}
+
+
+/**
+ * saves the result of the single measurement (median time of the operation
+ * and the number of floating-point operations / bytes moved by it)
+ */
+void bench_report_add(char *group, char *name, double time, double n_flops, double n_bytes)
+{
+    if (n_results == BENCH_MAX_RESULTS) {
+        errquit("bench_report_add(): too many results (max %d)", BENCH_MAX_RESULTS);
+    }
+
+    bench_result_t *r = &results[n_results++];
+    snprintf(r->group, sizeof(r->group), "%s", group);
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->time = time;
+    r->n_flops = n_flops;
+    r->n_bytes = n_bytes;
+}
+
+
+/**
+ * writes all the results to the JSON file.
+ * parameters of the run are also written, so that results obtained with
+ * different versions of the program or BLAS libraries can be compared.
+ */
+void bench_report_write_json(bench_params_t *params)
+{
+    FILE *f = fopen(params->json_path, "w");
+    if (f == NULL) {
+        errquit("bench_report_write_json(): unable to open file '%s'", params->json_path);
+    }
+
+#ifdef BLAS_MKL
+    char *blas_name = "MKL";
+#elif defined BLAS_OPENBLAS
+    char *blas_name = "OpenBLAS";
+#else
+    char *blas_name = "undetected";
+#endif
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%d.%d.%d\",\n", CC_VERSION_MAJOR, CC_VERSION_MINOR, CC_VERSION_REVISION);
+    fprintf(f, "  \"blas\": \"%s\",\n", blas_name);
+    fprintf(f, "  \"params\": {\"nthreads\": %d, \"repeat\": %d, \"io_buffer_size\": %zu, \"lossy_tol\": %g, "
+               "\"irreps\": %d, \"tile_size\": %d, \"nocc\": %d, \"nvirt\": %d, \"arith\": \"%s\"},\n",
+            params->nthreads, params->n_repeat, params->buf_size, params->lossy_tol,
+            params->n_irreps, params->tile_size, params->nocc, params->nvirt, params->complex_arith ? "complex" : "real");
+    fprintf(f, "  \"results\": [\n");
+    for (int i = 0; i < n_results; i++) {
+        bench_result_t *r = &results[i];
+        double t = r->time;
+        fprintf(f, "    {\"group\": \"%s\", \"name\": \"%s\", \"time\": %.6e, \"flops\": %.6e, \"bytes\": %.6e, "
+                   "\"gflops_per_s\": %.6f, \"gbytes_per_s\": %.6f}%s\n",
+                r->group, r->name, t, r->n_flops, r->n_bytes,
+                (t > 0.0) ? r->n_flops * 1e-9 / t : 0.0, (t > 0.0) ? r->n_bytes * 1e-9 / t : 0.0,
+                (i < n_results - 1) ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    fclose(f);
+}
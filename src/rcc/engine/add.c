@@ -134,6 +134,8 @@ void update(char *dg1_name, double factor, char *dg2_name)
         omp_set_num_threads(cc_opts->nthreads);
     }
 
+    opstats_begin("update", dg2_name, NULL, dg1_name);
+
     for (size_t isb1 = 0; isb1 < dg1->n_blocks; isb1++) {
         block_t *block1 = dg1->blocks[isb1];
         if (block1->is_unique == 0) {
@@ -166,6 +168,8 @@ void update(char *dg1_name, double factor, char *dg2_name)
 
         // internal threading is redundant here and typically slows down calculations
         xaxpy(WORKING_TYPE, block1->size, factor, block2->buf, block1->buf);
+        opstats_add_flops(((arith == CC_ARITH_COMPLEX) ? 4.0 : 2.0) * block1->size);
+        opstats_add_bytes(3.0 * block1->size * SIZEOF_WORKING_TYPE);
 
         block_unload(block2);
         block_store(block1);
@@ -175,6 +179,8 @@ void update(char *dg1_name, double factor, char *dg2_name)
         }
     }
 
+    opstats_end();
+
     timer_stop("update");
 }
 
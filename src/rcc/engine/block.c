@@ -51,20 +51,30 @@
 
 #include "platform.h"
 #include "block.h"
+#include "cholesky_tier.h"
+#include "compressed_tier.h"
 #include "error.h"
+#include "eviction.h"
 #include "io.h"
 #include "memory.h"
+#include "opstats.h"
 #include "options.h"
 #include "spinors.h"
 #include "symmetry.h"
 #include "utils.h"
 #include "tensor.h"
+#include "timer.h"
+#include "trace.h"
 
 // locally used functions
 static void block_unique(block_t *b, int *qparts, int *valence, int *order);
 static int64_t block_get_unique_id();
 void transform(int n, int *idx, int *out, int *perm, int shift);
 static int is_ascending_order(int n, int *a);
+static int block_map(block_t *block);
+static void block_unmap(block_t *block);
+static void block_read_file(block_t *block);
+static void block_write_file(block_t *block);
 
 
 /**
@@ -146,6 +156,16 @@ block_t *block_new(int rank, int *spinor_blocks_nums, int *qparts, int *valence,
     }
 
     block->is_compressed = 0;
+    block->is_readonly = 0;
+    block->is_mapped = 0;
+    block->is_shared = 0;
+    block->ztier = NULL;
+    block->chol_conj = 0;
+    block->is_evictable = 0;
+    block->n_pins = 0;
+    block->is_evicted = 0;
+    block->evict_prev = NULL;
+    block->evict_next = NULL;
     block->is_unique = 1;
     block->sign = 1;
     block->n_equal_perms = 1;
@@ -154,35 +174,47 @@ block_t *block_new(int rank, int *spinor_blocks_nums, int *qparts, int *valence,
     }
 
     // storage of data
-
     if (block->is_unique == 0) {
         block->storage_type = CC_DIAGRAM_DUMMY;
+        block->file_name = NULL;
+        block->buf = NULL;
     }
     else {
-        block->storage_type = storage_type;
+        block_init_storage(block, storage_type);
     }
 
-    if (block->storage_type == CC_DIAGRAM_IN_MEM) {
+    return block;
+}
+
+
+/**
+ * Allocates storage for data of the (unique) block.
+ * Blocks created with the CC_DIAGRAM_DUMMY storage type can be initialized
+ * later, when the storage type is known (see diagram_new()).
+ */
+void block_init_storage(block_t *block, int storage_type)
+{
+    block->storage_type = storage_type;
+
+    if (block->storage_type == CC_DIAGRAM_IN_MEM || block->storage_type == CC_DIAGRAM_COMPRESSED) {
         block->file_name = NULL;
     }
     if (block->storage_type == CC_DIAGRAM_ON_DISK) {
         block->file_name = (char *) cc_malloc(256);
         sprintf(block->file_name, "block-%ld-%ld.sb", run_id(), block->id);   // будет долго работать!
     }
-    if (block->storage_type == CC_DIAGRAM_DUMMY) {
+    if (block->storage_type == CC_DIAGRAM_DUMMY || block->storage_type == CC_DIAGRAM_CHOLESKY) {
         block->file_name = NULL;
         block->buf = NULL;
     }
 
     // alloc memory for the buffer
-    if (block->storage_type != CC_DIAGRAM_DUMMY) {
+    if (block->storage_type != CC_DIAGRAM_DUMMY && block->storage_type != CC_DIAGRAM_CHOLESKY) {
         block->buf = (double complex *) cc_calloc(block->size, SIZEOF_WORKING_TYPE);
     }
 
     // store block on disk if required
     block_store(block);
-
-    return block;
 }
 
 
@@ -197,13 +229,27 @@ void block_delete(block_t *block)
     cc_free(block->indices);
     cc_free(block->shape);
 
-    if (block->storage_type != CC_DIAGRAM_DUMMY) {
+    if (block->is_evictable) {
+        eviction_remove_block(block);
+    }
+
+    if (block->is_mapped) {
+        block_unmap(block);
+    }
+    else if (block->storage_type != CC_DIAGRAM_DUMMY) {
         cc_free(block->buf);
         block->buf = NULL;
     }
 
+    // the block could be switched to another storage type after its creation
+    if (block->ztier) {
+        compressed_tier_delete(block);
+    }
+
     if (block->storage_type == CC_DIAGRAM_ON_DISK) {
-        io_remove(block->file_name);
+        if (!block->is_shared) {
+            io_remove(block->file_name);
+        }
         if (block->file_name) {
             cc_free(block->file_name);
         }
@@ -381,40 +427,74 @@ double complex block_get_element(block_t *block, int *idx)
 
 void block_load(block_t *block)
 {
+    if (block->is_evictable && eviction_pin_block(block)) {
+        eviction_restore_block(block);
+    }
+
     if (block->storage_type == CC_DIAGRAM_IN_MEM && block->rank == 6 && cc_opts->do_compress_triples) {
         decompress_triples_rank6(block);
         return;
     }
 
-    if (block->storage_type != CC_DIAGRAM_ON_DISK) {
+    if (block->storage_type == CC_DIAGRAM_CHOLESKY) {
+        cholesky_tier_load(block);
+        return;
+    }
+
+    if (block->storage_type != CC_DIAGRAM_ON_DISK && block->storage_type != CC_DIAGRAM_COMPRESSED) {
         //printf("load: nothing to do\n");
         return;
     }
 
-    block->buf = (double complex *) cc_malloc(block->size * SIZEOF_WORKING_TYPE);
+    double t0 = cc_trace_blocks ? abs_time() : 0.0;
+    double n_bytes = (double) block->size * SIZEOF_WORKING_TYPE;
+    opstats_add_bytes(n_bytes);
 
-    int f = io_open(block->file_name, "r");
-    if (f == -1) {
-        errquit("-1 in load, unable to open block file %s\n", block->file_name);
+    if (block->storage_type == CC_DIAGRAM_COMPRESSED) {
+        compressed_tier_load(block);
+    }
+    else if (!(block->is_readonly && block_map(block))) {
+        // read-only blocks are mapped into memory (zero-copy),
+        // others are read into the newly allocated buffer
+        block_read_file(block);
     }
 
-    io_read_compressed(f, block->buf, block->size * SIZEOF_WORKING_TYPE);
-
-    io_close(f);
+    if (cc_trace_blocks) {
+        trace_event("io", "block_load", NULL, t0, abs_time(), block->size, n_bytes);
+    }
 }
 
 
 void block_unload(block_t *block)
 {
+    if (block->is_evictable) {
+        eviction_unpin_block(block);
+    }
+
     if (block->storage_type == CC_DIAGRAM_IN_MEM && block->rank == 6 && cc_opts->do_compress_triples) {
         compress_triples_rank6(block);
         return;
     }
 
+    if (block->storage_type == CC_DIAGRAM_COMPRESSED) {
+        compressed_tier_unload(block);
+        return;
+    }
+
+    if (block->storage_type == CC_DIAGRAM_CHOLESKY) {
+        cholesky_tier_unload(block);
+        return;
+    }
+
     if (block->storage_type != CC_DIAGRAM_ON_DISK) {
         return;
     }
 
+    if (block->is_mapped) {
+        block_unmap(block);
+        return;
+    }
+
     cc_free(block->buf);
     block->buf = NULL;
 }
@@ -422,12 +502,107 @@ void block_unload(block_t *block)
 
 void block_store(block_t *block)
 {
+    if (block->is_evictable) {
+        eviction_unpin_block(block);
+    }
+
     if (block->storage_type == CC_DIAGRAM_IN_MEM && block->rank == 6 && cc_opts->do_compress_triples) {
         compress_triples_rank6(block);
         return;
     }
 
-    if (block->storage_type != CC_DIAGRAM_ON_DISK) {
+    // integrals represented by the Cholesky vectors are never modified
+    if (block->storage_type == CC_DIAGRAM_CHOLESKY) {
+        cholesky_tier_unload(block);
+        return;
+    }
+
+    if (block->storage_type != CC_DIAGRAM_ON_DISK && block->storage_type != CC_DIAGRAM_COMPRESSED) {
+        return;
+    }
+
+    double t0 = cc_trace_blocks ? abs_time() : 0.0;
+    double n_bytes = (double) block->size * SIZEOF_WORKING_TYPE;
+    opstats_add_bytes(n_bytes);
+
+    if (block->storage_type == CC_DIAGRAM_COMPRESSED) {
+        compressed_tier_store(block);
+    }
+    else {
+        block_write_file(block);
+    }
+
+    if (cc_trace_blocks) {
+        trace_event("io", "block_store", NULL, t0, abs_time(), block->size, n_bytes);
+    }
+}
+
+
+/*
+ * reads data of the on-disk block into the newly allocated buffer
+ */
+static void block_read_file(block_t *block)
+{
+    block->buf = (double complex *) cc_malloc(block->size * SIZEOF_WORKING_TYPE);
+
+    int f = io_open(block->file_name, "r");
+    if (f == -1) {
+        errquit("-1 in load, unable to open block file %s\n", block->file_name);
+    }
+
+    if (block->is_shared) {
+        io_read(f, block->buf, block->size * SIZEOF_WORKING_TYPE);
+    }
+    else {
+        io_read_compressed(f, block->buf, block->size * SIZEOF_WORKING_TYPE);
+    }
+
+    io_close(f);
+}
+
+
+/*
+ * writes data of the on-disk block to its file and releases the buffer
+ */
+static void block_write_file(block_t *block)
+{
+    // copy-on-write: the shared file is left intact, the block gets its own file
+    if (block->is_shared) {
+        cc_free(block->file_name);
+        block->file_name = (char *) cc_malloc(CC_MAX_FILE_NAME_LENGTH);
+        sprintf(block->file_name, "block-%ld-%ld.sb", run_id(), block->id);
+        block->is_shared = 0;
+        block->is_readonly = 0;
+        if (block->is_mapped) {
+            int f = io_open(block->file_name, "w");
+            if (f == -1) {
+                errquit("-1 in store name = %s\n", block->file_name);
+            }
+            io_write_compressed_fp(f, (double *) block->buf, block->size * SIZEOF_WORKING_TYPE);
+            io_close(f);
+
+            block_unmap(block);
+            return;
+        }
+    }
+
+    // the block is being modified, thus it is no longer read-only.
+    // the mapped file cannot be overwritten in-place, the data are written
+    // to the temporary file which then replaces the old one
+    if (block->is_mapped) {
+        char tmp_name[CC_MAX_FILE_NAME_LENGTH + 8];
+        sprintf(tmp_name, "%s.tmp", block->file_name);
+
+        int f = io_open(tmp_name, "w");
+        if (f == -1) {
+            errquit("-1 in store name = %s\n", tmp_name);
+        }
+        io_write_compressed_fp(f, (double *) block->buf, block->size * SIZEOF_WORKING_TYPE);
+        io_close(f);
+        io_rename(tmp_name, block->file_name);
+
+        block_unmap(block);
+        block->is_readonly = 0;
         return;
     }
 
@@ -436,7 +611,7 @@ void block_store(block_t *block)
         errquit("-1 in store name = %s\n", block->file_name);
     }
 
-    io_write_compressed(f, block->buf, block->size * SIZEOF_WORKING_TYPE);
+    io_write_compressed_fp(f, (double *) block->buf, block->size * SIZEOF_WORKING_TYPE);
     io_close(f);
 
     cc_free(block->buf);
@@ -444,6 +619,131 @@ void block_store(block_t *block)
 }
 
 
+/**
+ * Marks the block as read-only: data of the on-disk block will be mapped
+ * into memory by block_load() instead of being read into the newly allocated
+ * buffer. Pages are shared through the page cache between the subsequent
+ * loads of the block.
+ * Any block_store() call on the block turns it back to the ordinary one.
+ */
+void block_set_readonly(block_t *block)
+{
+    block->is_readonly = 1;
+}
+
+
+/**
+ * Marks the file of the on-disk block as shared (see block_t::is_shared).
+ * Such a block is also read-only, so its data are mapped from the shared file.
+ */
+void block_set_shared(block_t *block)
+{
+    if (block->storage_type != CC_DIAGRAM_ON_DISK) {
+        return;
+    }
+
+    block->is_shared = 1;
+    block->is_readonly = 1;
+}
+
+
+/**
+ * Moves data of the block to the storage of another type:
+ * RAM, compressed RAM or disk (CC_DIAGRAM_IN_MEM/COMPRESSED/ON_DISK).
+ */
+void block_set_storage_type(block_t *block, int storage_type)
+{
+    if (block->storage_type == storage_type || block->storage_type == CC_DIAGRAM_DUMMY ||
+        block->storage_type == CC_DIAGRAM_CHOLESKY) {
+        return;
+    }
+
+    int is_evictable = block->is_evictable;
+    int is_readonly = block->is_readonly;
+    double complex *buf = NULL;
+
+    // data are moved to the new buffer, the old storage is released
+    if (is_evictable && eviction_pin_block(block)) {
+        eviction_restore_block(block);
+    }
+    eviction_remove_block(block);
+    if (block->storage_type == CC_DIAGRAM_IN_MEM) {
+        buf = block->buf;
+        block->buf = NULL;
+    }
+    else {
+        block_load(block);
+        buf = (double complex *) cc_malloc(block->size * SIZEOF_WORKING_TYPE);
+        memcpy(buf, block->buf, block->size * SIZEOF_WORKING_TYPE);
+        block_unload(block);
+
+        if (block->ztier) {
+            compressed_tier_delete(block);
+        }
+        if (block->storage_type == CC_DIAGRAM_ON_DISK) {
+            if (!block->is_shared) {
+                io_remove(block->file_name);
+            }
+            block->is_shared = 0;
+            cc_free(block->file_name);
+            block->file_name = NULL;
+        }
+    }
+
+    block->storage_type = storage_type;
+    block->buf = buf;
+    if (storage_type == CC_DIAGRAM_ON_DISK) {
+        block->file_name = (char *) cc_malloc(CC_MAX_FILE_NAME_LENGTH);
+        sprintf(block->file_name, "block-%ld-%ld.sb", run_id(), block->id);
+    }
+    block_store(block);
+
+    block->is_readonly = is_readonly;
+    if (is_evictable) {
+        eviction_add_block(block);
+    }
+}
+
+
+/**
+ * Maps the file of the on-disk block into memory.
+ * Only uncompressed data can be mapped (shared files are never compressed).
+ * Mapped bytes are taken into account by the memory allocator,
+ * so the memory limit is still respected.
+ * Returns 1 on success, 0 if the conventional read is required.
+ */
+static int block_map(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+
+    if ((cc_opts->compress != CC_COMPRESS_NONE && !block->is_shared) || nbytes == 0) {
+        return 0;
+    }
+
+    cc_account_external(nbytes);
+    block->buf = (double complex *) io_mmap(block->file_name, nbytes);
+    if (block->buf == NULL) {
+        cc_release_external(nbytes);
+        return 0;
+    }
+
+    block->is_mapped = 1;
+    return 1;
+}
+
+
+static void block_unmap(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+
+    io_munmap(block->buf, nbytes);
+    cc_release_external(nbytes);
+
+    block->buf = NULL;
+    block->is_mapped = 0;
+}
+
+
 /**
  * block_write_binary
  *
@@ -479,11 +779,14 @@ void block_write_binary(int fd, block_t *block)
     }
 
     // size & data
+    // blocks represented by the Cholesky vectors are written as in-memory ones
+    int storage_type = (block->storage_type == CC_DIAGRAM_CHOLESKY) ? CC_DIAGRAM_IN_MEM : block->storage_type;
     io_write_compressed(fd, &block->size, sizeof(block->size));
-    io_write_compressed(fd, &block->storage_type, sizeof(block->storage_type));
-    if (block->storage_type == CC_DIAGRAM_IN_MEM) {
+    io_write_compressed(fd, &storage_type, sizeof(storage_type));
+    if (block->storage_type == CC_DIAGRAM_IN_MEM || block->storage_type == CC_DIAGRAM_COMPRESSED ||
+        block->storage_type == CC_DIAGRAM_CHOLESKY) {
         block_load(block);
-        io_write_compressed(fd, block->buf, SIZEOF_WORKING_TYPE * block->size);
+        io_write_compressed_fp(fd, (double *) block->buf, SIZEOF_WORKING_TYPE * block->size);
         block_unload(block);
     }
     else if (block->storage_type == CC_DIAGRAM_DUMMY) {
@@ -533,6 +836,17 @@ block_t *block_read_binary(int fd)
 
     // set new unique block's ID
     block->id = block_get_unique_id();
+    block->is_compressed = 0;
+    block->is_readonly = 0;
+    block->is_mapped = 0;
+    block->is_shared = 0;
+    block->ztier = NULL;
+    block->chol_conj = 0;
+    block->is_evictable = 0;
+    block->n_pins = 0;
+    block->is_evicted = 0;
+    block->evict_prev = NULL;
+    block->evict_next = NULL;
 
     // indices
     block->shape = (int *) cc_malloc(sizeof(int) * block->rank);
@@ -548,7 +862,8 @@ block_t *block_read_binary(int fd)
     // size & data
     io_read_compressed(fd, &block->size, sizeof(block->size));
     io_read_compressed(fd, &block->storage_type, sizeof(block->storage_type));
-    if (block->storage_type == CC_DIAGRAM_IN_MEM) {
+    if (block->storage_type == CC_DIAGRAM_IN_MEM || block->storage_type == CC_DIAGRAM_COMPRESSED) {
+        block->file_name = NULL;
         block->buf = (double complex *) cc_malloc(SIZEOF_WORKING_TYPE * block->size);
 
         if (expand_complex_to_real) {
@@ -564,7 +879,12 @@ block_t *block_read_binary(int fd)
             io_read_compressed(fd, block->buf, SIZEOF_WORKING_TYPE * block->size);
         }
 
-        block_unload(block);
+        if (block->storage_type == CC_DIAGRAM_COMPRESSED) {
+            block_store(block);
+        }
+        else {
+            block_unload(block);
+        }
     }
     else if (block->storage_type == CC_DIAGRAM_DUMMY) {
         block->buf = NULL;
@@ -52,7 +52,9 @@
 typedef enum {
     CC_DIAGRAM_IN_MEM,
     CC_DIAGRAM_ON_DISK,
-    CC_DIAGRAM_DUMMY
+    CC_DIAGRAM_DUMMY,
+    CC_DIAGRAM_COMPRESSED,
+    CC_DIAGRAM_CHOLESKY
 } storage_type_t;
 
 typedef struct block_t {
@@ -93,12 +95,45 @@ typedef struct block_t {
     int perm_from_unique[CC_DIAGRAM_MAX_RANK];
     int perm_to_unique[CC_DIAGRAM_MAX_RANK];
     int is_compressed;
+
+    // block is not modified after creation (e.g. sorted integrals),
+    // so its data can be mapped from the file instead of being read
+    int is_readonly;
+
+    // flag: buffer is a file mapping (see io_mmap())
+    int is_mapped;
+
+    // file of the on-disk block is owned by someone else (e.g. the sorted
+    // integrals cache) and is never modified or removed: the data are copied
+    // to the private file on the first write. shared files hold raw data
+    // (not compressed)
+    int is_shared;
+
+    // compressed data (for blocks of the CC_DIAGRAM_COMPRESSED type),
+    // see compressed_tier.c
+    struct compressed_tier_entry *ztier;
+
+    // data of the CC_DIAGRAM_CHOLESKY block are reconstructed from the
+    // Cholesky vectors (see cholesky_tier.c); flag: complex conjugate integrals
+    int chol_conj;
+
+    // block can be evicted to disk under memory pressure (see eviction.c):
+    // number of users of the block at the moment and the LRU list links
+    int is_evictable;
+    int n_pins;
+    // data were evicted to the file 'file_name' (the storage type is kept),
+    // they are read back by block_load()
+    int is_evicted;
+    struct block_t *evict_prev;
+    struct block_t *evict_next;
 } block_t;
 
 // constructor and destructor
 block_t *block_new(int rank, int *spinor_blocks_nums, int *qparts, int *valence, int *t3space, int *order, int storage_type,
                    int only_unique);
 
+void block_init_storage(block_t *block, int storage_type);
+
 void block_gen_indices(block_t *block, int *indices);
 
 void block_delete(block_t *block);
@@ -123,6 +158,12 @@ void block_unload(block_t *block);
 
 void block_store(block_t *block);
 
+void block_set_readonly(block_t *block);
+
+void block_set_shared(block_t *block);
+
+void block_set_storage_type(block_t *block, int storage_type);
+
 void block_write_binary(int fd, block_t *block);
 
 void block_write_file_formatted(FILE *txt_file, block_t *block);
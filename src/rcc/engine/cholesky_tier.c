@@ -0,0 +1,260 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Blocks of the pppp integrals reconstructed from the Cholesky vectors
+ * (CC_DIAGRAM_CHOLESKY storage type).
+ *
+ * Element of the block [p q r s] = <pq|rs> - <pq|sr>, where
+ *   <pq|rs> = sum_J s_J L_J[r,p] conj(L_J[q,s]).
+ * Both terms are evaluated as matrix products over the vectors index J
+ * (in batches), so that the memory required for the reconstruction does
+ * not exceed a few sizes of the block. The full set of integrals is never
+ * stored: memory is O(V^2 N_vectors) instead of O(V^4).
+ */
+
+#include <complex.h>
+#include <string.h>
+
+#include "cholesky_tier.h"
+#include "error.h"
+#include "linalg.h"
+#include "memory.h"
+#include "options.h"
+
+#define CHOLESKY_TIER_BATCH 256
+#define CHOLESKY_TIER_MAX_DIAGRAMS 16
+
+// names of diagrams to be created with the CC_DIAGRAM_CHOLESKY storage type
+static char reserved[CHOLESKY_TIER_MAX_DIAGRAMS][CC_DIAGRAM_MAX_NAME];
+static int n_reserved = 0;
+
+// vectors are the same for all the sectors
+static cholesky_vectors_t *chol_vectors = NULL;
+
+static void gather_vectors(size_t j0, size_t n_batch, int dim_1, int *indices_1, int dim_2, int *indices_2,
+                           int is_bra, void *dst);
+
+
+/*******************************************************************************
+ * cholesky_tier_reserve
+ *
+ * Diagram with this name will be created with the CC_DIAGRAM_CHOLESKY storage
+ * type (see guess_storage_class()): no memory is allocated for its blocks.
+ ******************************************************************************/
+void cholesky_tier_reserve(char *name)
+{
+    if (cholesky_tier_is_reserved(name)) {
+        return;
+    }
+    if (n_reserved == CHOLESKY_TIER_MAX_DIAGRAMS) {
+        errquit("cholesky_tier_reserve(): too many diagrams (max %d)", CHOLESKY_TIER_MAX_DIAGRAMS);
+    }
+
+    strncpy(reserved[n_reserved], name, CC_DIAGRAM_MAX_NAME);
+    reserved[n_reserved][CC_DIAGRAM_MAX_NAME - 1] = '\0';
+    n_reserved++;
+}
+
+
+int cholesky_tier_is_reserved(char *name)
+{
+    for (int i = 0; i < n_reserved; i++) {
+        if (strcmp(reserved[i], name) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+void cholesky_tier_set_vectors(cholesky_vectors_t *chol)
+{
+    chol_vectors = chol;
+}
+
+
+cholesky_vectors_t *cholesky_tier_get_vectors()
+{
+    return chol_vectors;
+}
+
+
+/*******************************************************************************
+ * cholesky_tier_load
+ *
+ * Reconstructs data of the block (block->buf) from the Cholesky vectors.
+ * The direct term is accumulated as D[(p,r),(q,s)], the exchange one as
+ * X[(p,s),(q,r)]; the block is assembled from them at the end.
+ ******************************************************************************/
+void cholesky_tier_load(block_t *block)
+{
+    cholesky_vectors_t *chol = chol_vectors;
+
+    if (chol == NULL) {
+        errquit("cholesky_tier_load(): Cholesky vectors for the pppp integrals are not available");
+    }
+
+    int dim_p = block->shape[0];
+    int dim_q = block->shape[1];
+    int dim_r = block->shape[2];
+    int dim_s = block->shape[3];
+    int *idx_p = block->indices[0];
+    int *idx_q = block->indices[1];
+    int *idx_r = block->indices[2];
+    int *idx_s = block->indices[3];
+    size_t dim_pr = (size_t) dim_p * dim_r;
+    size_t dim_qs = (size_t) dim_q * dim_s;
+    size_t dim_ps = (size_t) dim_p * dim_s;
+    size_t dim_qr = (size_t) dim_q * dim_r;
+    size_t elem_size = SIZEOF_WORKING_TYPE;
+    data_type_t type = (arith == CC_ARITH_COMPLEX) ? CC_DOUBLE_COMPLEX : CC_DOUBLE;
+
+    double complex z_one = 1.0;
+    double d_one = 1.0;
+    void *one = (arith == CC_ARITH_COMPLEX) ? (void *) &z_one : (void *) &d_one;
+
+    block->buf = (double complex *) cc_malloc(block->size * elem_size);
+    void *direct = cc_calloc(block->size, elem_size);
+    void *exchange = cc_calloc(block->size, elem_size);
+
+    size_t n_batch = (chol->n_vectors < CHOLESKY_TIER_BATCH) ? chol->n_vectors : CHOLESKY_TIER_BATCH;
+    size_t max_bra = (dim_pr > dim_ps) ? dim_pr : dim_ps;
+    size_t max_ket = (dim_qs > dim_qr) ? dim_qs : dim_qr;
+    void *bra = cc_malloc(max_bra * n_batch * elem_size + 1);
+    void *ket = cc_malloc(max_ket * n_batch * elem_size + 1);
+
+    for (size_t j0 = 0; j0 < chol->n_vectors; j0 += n_batch) {
+        size_t nb = (j0 + n_batch < chol->n_vectors) ? n_batch : chol->n_vectors - j0;
+
+        // direct: D[(p,r),(q,s)] += sum_J s_J L_J[r,p] conj(L_J[q,s])
+        gather_vectors(j0, nb, dim_p, idx_p, dim_r, idx_r, 1, bra);
+        gather_vectors(j0, nb, dim_q, idx_q, dim_s, idx_s, 0, ket);
+        xgemm(type, "N", "T", dim_pr, dim_qs, nb, one, bra, nb, ket, nb, one, direct, dim_qs);
+
+        // exchange: X[(p,s),(q,r)] += sum_J s_J L_J[s,p] conj(L_J[q,r])
+        gather_vectors(j0, nb, dim_p, idx_p, dim_s, idx_s, 1, bra);
+        gather_vectors(j0, nb, dim_q, idx_q, dim_r, idx_r, 0, ket);
+        xgemm(type, "N", "T", dim_ps, dim_qr, nb, one, bra, nb, ket, nb, one, exchange, dim_qr);
+    }
+
+    // <pq||rs> = D[(p,r),(q,s)] - X[(p,s),(q,r)]
+    size_t n = 0;
+    for (int p = 0; p < dim_p; p++) {
+        for (int q = 0; q < dim_q; q++) {
+            for (int r = 0; r < dim_r; r++) {
+                size_t i_direct = ((size_t) p * dim_r + r) * dim_qs + (size_t) q * dim_s;
+                size_t i_exchange = (size_t) p * dim_s * dim_qr + (size_t) q * dim_r + r;
+                if (arith == CC_ARITH_COMPLEX) {
+                    double complex *d = (double complex *) direct + i_direct;
+                    double complex *x = (double complex *) exchange + i_exchange;
+                    double complex *dst = (double complex *) block->buf + n;
+                    for (int s = 0; s < dim_s; s++) {
+                        double complex v = d[s] - x[(size_t) s * dim_qr];
+                        dst[s] = block->chol_conj ? conj(v) : v;
+                    }
+                }
+                else {
+                    double *d = (double *) direct + i_direct;
+                    double *x = (double *) exchange + i_exchange;
+                    double *dst = (double *) block->buf + n;
+                    for (int s = 0; s < dim_s; s++) {
+                        dst[s] = d[s] - x[(size_t) s * dim_qr];
+                    }
+                }
+                n += dim_s;
+            }
+        }
+    }
+
+    cc_free(bra);
+    cc_free(ket);
+    cc_free(direct);
+    cc_free(exchange);
+}
+
+
+/*******************************************************************************
+ * cholesky_tier_unload
+ *
+ * Releases the reconstructed data. Blocks are read-only: modifications of the
+ * data (if any) are discarded.
+ ******************************************************************************/
+void cholesky_tier_unload(block_t *block)
+{
+    cc_free(block->buf);
+    block->buf = NULL;
+}
+
+
+/*
+ * copies elements of the vectors j0 ... j0+n_batch-1 to the matrix
+ * dst[(i1,i2)][J]:
+ *   bra: s_J L_J[i2,i1]
+ *   ket: conj(L_J[i1,i2])
+ */
+static void gather_vectors(size_t j0, size_t n_batch, int dim_1, int *indices_1, int dim_2, int *indices_2,
+                           int is_bra, void *dst)
+{
+    cholesky_vectors_t *chol = chol_vectors;
+    size_t n_particles = chol->n_particles;
+    size_t n_vectors = chol->n_vectors;
+
+    for (int i1 = 0; i1 < dim_1; i1++) {
+        size_t pos_1 = chol->pos[indices_1[i1]];
+        for (int i2 = 0; i2 < dim_2; i2++) {
+            size_t pos_2 = chol->pos[indices_2[i2]];
+            size_t pair = is_bra ? pos_2 * n_particles + pos_1 : pos_1 * n_particles + pos_2;
+            size_t row = ((size_t) i1 * dim_2 + i2) * n_batch;
+            int *signs = chol->signs + j0;
+
+            if (arith == CC_ARITH_COMPLEX) {
+                double complex *vec = (double complex *) chol->vectors + pair * n_vectors + j0;
+                double complex *line = (double complex *) dst + row;
+                if (is_bra) {
+                    for (size_t j = 0; j < n_batch; j++) {
+                        line[j] = signs[j] * vec[j];
+                    }
+                }
+                else {
+                    for (size_t j = 0; j < n_batch; j++) {
+                        line[j] = conj(vec[j]);
+                    }
+                }
+            }
+            else {
+                double *vec = (double *) chol->vectors + pair * n_vectors + j0;
+                double *line = (double *) dst + row;
+                if (is_bra) {
+                    for (size_t j = 0; j < n_batch; j++) {
+                        line[j] = signs[j] * vec[j];
+                    }
+                }
+                else {
+                    memcpy(line, vec, n_batch * sizeof(double));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Storage of the pppp integrals in terms of the Cholesky vectors.
+ *
+ * The matrix M(xy,zw) = <yz|xw> over pairs of particle spinors is Hermitian
+ * and is represented as M = sum_J s_J L_J L_J^+ (s_J = +1/-1, see
+ * sort_cholesky.c). Blocks of the CC_DIAGRAM_CHOLESKY storage type have no
+ * data of their own: block_load() reconstructs the antisymmetrized integrals
+ * <pq||rs> from the vectors, block_unload() releases them.
+ */
+
+#ifndef CC_CHOLESKY_TIER_H_INCLUDED
+#define CC_CHOLESKY_TIER_H_INCLUDED
+
+#include <stddef.h>
+
+#include "block.h"
+
+typedef struct cholesky_vectors {
+    int n_particles;     // number of particle spinors V
+    int *pos;            // global spinor index -> position among particles (-1 for holes)
+    size_t n_vectors;
+    int *signs;          // s_J
+    void *vectors;       // [V][V][n_vectors], double or double complex (as the working type)
+} cholesky_vectors_t;
+
+void cholesky_tier_reserve(char *name);
+
+int cholesky_tier_is_reserved(char *name);
+
+void cholesky_tier_set_vectors(cholesky_vectors_t *chol);
+
+cholesky_vectors_t *cholesky_tier_get_vectors();
+
+void cholesky_tier_load(block_t *block);
+
+void cholesky_tier_unload(block_t *block);
+
+#endif // CC_CHOLESKY_TIER_H_INCLUDED
@@ -0,0 +1,516 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Compressed in-RAM storage tier for blocks (CC_DIAGRAM_COMPRESSED).
+ *
+ * Each block of this type owns an entry which contains the compressed frame
+ * with its data. Frames are organized into the LRU list; the total size of
+ * frames in RAM is bounded by the 'compressed_tier_fraction' of the max
+ * allowed memory, least recently used frames are spilled to disk.
+ *
+ * Unloaded blocks are not deallocated immediately: their decompressed buffers
+ * are moved to the cache (another LRU list) bounded by the small fraction of
+ * max allowed memory. A cache hit in block_load() costs nothing (the buffer
+ * is simply given back to the block).
+ *
+ * Lists are modified in the 'compressed_tier' critical section only; data are
+ * compressed and decompressed outside of it, so that different blocks can be
+ * loaded/stored concurrently. An entry being decompressed is pinned and cannot
+ * be spilled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compressed_tier.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "options.h"
+#include "utils.h"
+
+#define COMPRESSED_TIER_CACHE_FRACTION 0.1
+
+typedef struct compressed_tier_entry {
+    block_t *block;
+
+    // compressed frame (in RAM or spilled to disk)
+    char *zbuf;
+    size_t zsize;
+    int is_spilled;
+    char *spill_file_name;
+
+    // number of threads reading the frame at the moment
+    int n_pinned;
+
+    // decompressed data of the unloaded block (if cached)
+    double complex *cached_buf;
+
+    // LRU list of frames in RAM
+    struct compressed_tier_entry *lru_prev;
+    struct compressed_tier_entry *lru_next;
+    int in_lru;
+
+    // LRU list of cached decompressed buffers
+    struct compressed_tier_entry *cache_prev;
+    struct compressed_tier_entry *cache_next;
+} compressed_tier_entry_t;
+
+typedef struct {
+    compressed_tier_entry_t *head;
+    compressed_tier_entry_t *tail;
+} entry_list_t;
+
+static entry_list_t lru_list = {NULL, NULL};
+static entry_list_t cache_list = {NULL, NULL};
+
+static size_t tier_bytes = 0;
+static size_t cache_bytes = 0;
+
+static struct {
+    size_t n_stores;
+    size_t n_loads;
+    size_t n_cache_hits;
+    size_t n_spills;
+    size_t n_spilled_loads;
+    size_t raw_bytes;
+    size_t compressed_bytes;
+    size_t peak_tier_bytes;
+} tier_stat = {0};
+
+static compressed_tier_entry_t *new_entry(block_t *block);
+
+static void lru_remove(compressed_tier_entry_t *entry);
+
+static void lru_push_front(compressed_tier_entry_t *entry);
+
+static void cache_remove(compressed_tier_entry_t *entry);
+
+static void cache_push_front(compressed_tier_entry_t *entry);
+
+static void trim_cache();
+
+static void spill_frames();
+
+static int get_codec();
+
+static size_t get_tier_limit();
+
+
+/*******************************************************************************
+ * compressed_tier_store
+ *
+ * Compresses data of the block into the new frame. The decompressed buffer
+ * is moved to the cache; block->buf becomes NULL.
+ ******************************************************************************/
+void compressed_tier_store(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+    size_t zsize = 0;
+
+    char *zbuf = io_compress_buffer((double *) block->buf, nbytes, get_codec(), &zsize);
+
+    #pragma omp critical (compressed_tier)
+    {
+        if (block->ztier == NULL) {
+            block->ztier = new_entry(block);
+        }
+        compressed_tier_entry_t *entry = block->ztier;
+
+        // old data are not required anymore
+        if (entry->in_lru) {
+            lru_remove(entry);
+            tier_bytes -= entry->zsize;
+        }
+        cc_free(entry->zbuf);
+        if (entry->is_spilled) {
+            io_remove(entry->spill_file_name);
+            entry->is_spilled = 0;
+        }
+        if (entry->cached_buf) {
+            cache_remove(entry);
+            cc_free(entry->cached_buf);
+            entry->cached_buf = NULL;
+            cache_bytes -= nbytes;
+        }
+
+        entry->zbuf = zbuf;
+        entry->zsize = zsize;
+        lru_push_front(entry);
+        tier_bytes += zsize;
+
+        // the most recent version of data is cached
+        if (block->buf != NULL) {
+            entry->cached_buf = block->buf;
+            cache_push_front(entry);
+            cache_bytes += nbytes;
+            block->buf = NULL;
+        }
+
+        tier_stat.n_stores++;
+        tier_stat.raw_bytes += nbytes;
+        tier_stat.compressed_bytes += zsize;
+
+        trim_cache();
+        spill_frames();
+
+        if (tier_bytes > tier_stat.peak_tier_bytes) {
+            tier_stat.peak_tier_bytes = tier_bytes;
+        }
+    }
+}
+
+
+/*******************************************************************************
+ * compressed_tier_load
+ *
+ * Restores decompressed data of the block (block->buf).
+ ******************************************************************************/
+void compressed_tier_load(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+    compressed_tier_entry_t *entry = block->ztier;
+    int cache_hit = 0;
+
+    if (entry == NULL) {
+        errquit("compressed_tier_load(): block %ld was never stored", block->id);
+    }
+
+    #pragma omp critical (compressed_tier)
+    {
+        tier_stat.n_loads++;
+
+        if (entry->cached_buf) {
+            cache_hit = 1;
+            cache_remove(entry);
+            cache_bytes -= nbytes;
+            block->buf = entry->cached_buf;
+            entry->cached_buf = NULL;
+            tier_stat.n_cache_hits++;
+        }
+        else {
+            entry->n_pinned++;
+            if (entry->in_lru) {
+                lru_remove(entry);
+                lru_push_front(entry);
+            }
+            if (entry->is_spilled) {
+                tier_stat.n_spilled_loads++;
+            }
+        }
+    }
+
+    if (cache_hit) {
+        return;
+    }
+
+    block->buf = (double complex *) cc_malloc(nbytes);
+
+    if (entry->is_spilled) {
+        char *zbuf = (char *) cc_malloc(entry->zsize);
+        int fd = io_open(entry->spill_file_name, "r");
+        if (fd == -1) {
+            errquit("compressed_tier_load(): unable to open file %s", entry->spill_file_name);
+        }
+        io_read(fd, zbuf, entry->zsize);
+        io_close(fd);
+        io_decompress_buffer(zbuf, entry->zsize, block->buf, nbytes);
+        cc_free(zbuf);
+    }
+    else {
+        io_decompress_buffer(entry->zbuf, entry->zsize, block->buf, nbytes);
+    }
+
+    #pragma omp critical (compressed_tier)
+    {
+        entry->n_pinned--;
+    }
+}
+
+
+/*******************************************************************************
+ * compressed_tier_unload
+ *
+ * Releases decompressed data of the (unmodified) block. The buffer is kept in
+ * the cache while there is enough space.
+ ******************************************************************************/
+void compressed_tier_unload(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+    compressed_tier_entry_t *entry = block->ztier;
+
+    if (block->buf == NULL) {
+        return;
+    }
+
+    #pragma omp critical (compressed_tier)
+    {
+        if (entry->cached_buf == NULL) {
+            entry->cached_buf = block->buf;
+            cache_push_front(entry);
+            cache_bytes += nbytes;
+            trim_cache();
+        }
+        else {
+            cc_free(block->buf);
+        }
+        block->buf = NULL;
+    }
+}
+
+
+/*******************************************************************************
+ * compressed_tier_delete
+ *
+ * Deallocates all data of the block kept in the compressed tier.
+ ******************************************************************************/
+void compressed_tier_delete(block_t *block)
+{
+    size_t nbytes = block->size * SIZEOF_WORKING_TYPE;
+    compressed_tier_entry_t *entry = block->ztier;
+
+    if (entry == NULL) {
+        return;
+    }
+
+    #pragma omp critical (compressed_tier)
+    {
+        if (entry->in_lru) {
+            lru_remove(entry);
+            tier_bytes -= entry->zsize;
+        }
+        if (entry->cached_buf) {
+            cache_remove(entry);
+            cc_free(entry->cached_buf);
+            cache_bytes -= nbytes;
+        }
+        if (entry->is_spilled) {
+            io_remove(entry->spill_file_name);
+        }
+        cc_free(entry->zbuf);
+        cc_free(entry->spill_file_name);
+        cc_free(entry);
+        block->ztier = NULL;
+    }
+}
+
+
+/*******************************************************************************
+ * compressed_tier_get_memory_used
+ *
+ * Returns size of compressed data of the block in RAM and on disk (bytes).
+ ******************************************************************************/
+void compressed_tier_get_memory_used(block_t *block, size_t *ram_used, size_t *disk_used)
+{
+    compressed_tier_entry_t *entry = block->ztier;
+
+    *ram_used = 0;
+    *disk_used = 0;
+
+    if (entry == NULL) {
+        return;
+    }
+
+    #pragma omp critical (compressed_tier)
+    {
+        if (entry->is_spilled) {
+            *disk_used = entry->zsize;
+        }
+        else {
+            *ram_used = entry->zsize;
+        }
+    }
+}
+
+
+/*******************************************************************************
+ * compressed_tier_print_stats
+ ******************************************************************************/
+void compressed_tier_print_stats()
+{
+    if (tier_stat.n_stores == 0) {
+        return;
+    }
+
+    double ratio = tier_stat.compressed_bytes > 0 ?
+                   (double) tier_stat.raw_bytes / tier_stat.compressed_bytes : 0.0;
+    double hit_rate = tier_stat.n_loads > 0 ?
+                      100.0 * tier_stat.n_cache_hits / tier_stat.n_loads : 0.0;
+
+    printf(" compressed RAM tier:\n");
+    printf("   limit                     %.3f Mb (cache %.3f Mb)\n", get_tier_limit() / (1024.0 * 1024.0),
+           COMPRESSED_TIER_CACHE_FRACTION * cc_opts->max_memory_size / (1024.0 * 1024.0));
+    printf("   peak size                 %.3f Mb\n", tier_stat.peak_tier_bytes / (1024.0 * 1024.0));
+    printf("   stores                    %ld (avg compression ratio %.2f)\n", tier_stat.n_stores, ratio);
+    printf("   loads                     %ld (cache hits %.1f%%)\n", tier_stat.n_loads, hit_rate);
+    printf("   spills to disk            %ld (loads of spilled blocks %ld)\n", tier_stat.n_spills,
+           tier_stat.n_spilled_loads);
+}
+
+
+static compressed_tier_entry_t *new_entry(block_t *block)
+{
+    compressed_tier_entry_t *entry = (compressed_tier_entry_t *) cc_calloc(1, sizeof(compressed_tier_entry_t));
+
+    entry->block = block;
+    entry->spill_file_name = (char *) cc_malloc(CC_MAX_FILE_NAME_LENGTH);
+    sprintf(entry->spill_file_name, "block-%ld-%ld.zsb", run_id(), block->id);
+
+    return entry;
+}
+
+
+static void lru_remove(compressed_tier_entry_t *entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    }
+    else {
+        lru_list.head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    }
+    else {
+        lru_list.tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+    entry->in_lru = 0;
+}
+
+
+static void lru_push_front(compressed_tier_entry_t *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = lru_list.head;
+    if (lru_list.head) {
+        lru_list.head->lru_prev = entry;
+    }
+    lru_list.head = entry;
+    if (lru_list.tail == NULL) {
+        lru_list.tail = entry;
+    }
+    entry->in_lru = 1;
+}
+
+
+static void cache_remove(compressed_tier_entry_t *entry)
+{
+    if (entry->cache_prev) {
+        entry->cache_prev->cache_next = entry->cache_next;
+    }
+    else {
+        cache_list.head = entry->cache_next;
+    }
+    if (entry->cache_next) {
+        entry->cache_next->cache_prev = entry->cache_prev;
+    }
+    else {
+        cache_list.tail = entry->cache_prev;
+    }
+    entry->cache_prev = NULL;
+    entry->cache_next = NULL;
+}
+
+
+static void cache_push_front(compressed_tier_entry_t *entry)
+{
+    entry->cache_prev = NULL;
+    entry->cache_next = cache_list.head;
+    if (cache_list.head) {
+        cache_list.head->cache_prev = entry;
+    }
+    cache_list.head = entry;
+    if (cache_list.tail == NULL) {
+        cache_list.tail = entry;
+    }
+}
+
+
+/*
+ * deallocates least recently used buffers while the cache is overfilled
+ */
+static void trim_cache()
+{
+    size_t cache_limit = COMPRESSED_TIER_CACHE_FRACTION * cc_opts->max_memory_size;
+
+    while (cache_bytes > cache_limit && cache_list.tail != NULL) {
+        compressed_tier_entry_t *entry = cache_list.tail;
+        cache_remove(entry);
+        cc_free(entry->cached_buf);
+        entry->cached_buf = NULL;
+        cache_bytes -= entry->block->size * SIZEOF_WORKING_TYPE;
+    }
+}
+
+
+/*
+ * moves least recently used frames to disk while the tier is overfilled.
+ * pinned frames (being decompressed right now) are skipped.
+ */
+static void spill_frames()
+{
+    size_t tier_limit = get_tier_limit();
+    compressed_tier_entry_t *entry = lru_list.tail;
+
+    while (tier_bytes > tier_limit && entry != NULL) {
+        compressed_tier_entry_t *prev = entry->lru_prev;
+
+        if (entry->n_pinned == 0) {
+            int fd = io_open(entry->spill_file_name, "w");
+            if (fd == -1) {
+                errquit("compressed_tier_store(): unable to open file %s", entry->spill_file_name);
+            }
+            io_write(fd, entry->zbuf, entry->zsize);
+            io_close(fd);
+
+            lru_remove(entry);
+            tier_bytes -= entry->zsize;
+            cc_free(entry->zbuf);
+            entry->zbuf = NULL;
+            entry->is_spilled = 1;
+            tier_stat.n_spills++;
+        }
+
+        entry = prev;
+    }
+}
+
+
+/*
+ * data are compressed with the codec chosen for the data on disk (if any),
+ * LZ4 otherwise
+ */
+static int get_codec()
+{
+    return cc_opts->compress != CC_COMPRESS_NONE ? cc_opts->compress : CC_COMPRESS_LZ4;
+}
+
+
+static size_t get_tier_limit()
+{
+    return cc_opts->compressed_tier_fraction * cc_opts->max_memory_size;
+}
@@ -0,0 +1,54 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Compressed in-RAM storage tier for blocks.
+ *
+ * Blocks of the CC_DIAGRAM_COMPRESSED storage type are kept in RAM as
+ * compressed frames (see io_compress_buffer()). Recently used blocks are also
+ * kept decompressed in the small LRU cache, so that repeated loads of the same
+ * block do not require decompression. The total size of compressed frames
+ * is limited by a fraction of the max allowed memory; when the limit is
+ * exceeded, least recently used frames are spilled to disk.
+ */
+
+#ifndef CC_COMPRESSED_TIER_H_INCLUDED
+#define CC_COMPRESSED_TIER_H_INCLUDED
+
+#include <stddef.h>
+
+#include "block.h"
+
+void compressed_tier_store(block_t *block);
+
+void compressed_tier_load(block_t *block);
+
+void compressed_tier_unload(block_t *block);
+
+void compressed_tier_delete(block_t *block);
+
+void compressed_tier_get_memory_used(block_t *block, size_t *ram_used, size_t *disk_used);
+
+void compressed_tier_print_stats();
+
+#endif // CC_COMPRESSED_TIER_H_INCLUDED
@@ -39,7 +39,9 @@ void copy(char *src, char *target)
     diagram_t *dg_src = diagram_stack_find(src);
 
     // copy
+    cc_memory_push_default_tag(target);
     diagram_t *dg_tgt = diagram_copy(dg_src);
+    cc_memory_pop_tag();
     strcpy(dg_tgt->name, target);
 
     // save new diagram to stack
@@ -188,7 +188,7 @@ void diagram_stack_print()
 
         for (int isb = 0; isb < dg->n_blocks; isb++) {
             block_t *block = dg->blocks[isb];
-            if (block->storage_type == CC_DIAGRAM_ON_DISK) {
+            if (block->storage_type == CC_DIAGRAM_ON_DISK || block->is_evicted) {
                 count_blocks_on_disk++;
             }
             else {
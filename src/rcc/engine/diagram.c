@@ -47,9 +47,13 @@
 #include <string.h>
 
 #include "io.h"
+#include "cholesky_tier.h"
+#include "compressed_tier.h"
 #include "dgstack.h"
+#include "placement.h"
 #include "diagram.h"
 #include "error.h"
+#include "eviction.h"
 #include "memory.h"
 #include "options.h"
 #include "spinors.h"
@@ -68,7 +72,7 @@ void parse_valence_string(int rank, char *val_str, int *val);
 
 void parse_order_string(int rank, char *order_str, int *order);
 
-int guess_storage_class(char *name, int rank, char *qparts, char *valence);
+static block_t **diagram_create_blocks(diagram_t *dg, size_t *n_blocks);
 
 void diagram_init_inverse_index(diagram_t *dg, size_t n_blocks, block_t **block_list);
 
@@ -96,12 +100,8 @@ diagram_t *diagram_new(char *name, char *qparts, char *valence, char *t3space, c
     int valence_arr[CC_DIAGRAM_MAX_RANK];
     int t3space_arr[CC_DIAGRAM_MAX_RANK];
     int order_arr[CC_DIAGRAM_MAX_RANK];
-    size_t i;
-    block_t **block_list;  // temporary storage for the created symmetry blocks
-    int max_sbs;            // max number of sym blocks = (# spinor blocks)^rank
-    int blocks_counter = 0;          // counter of created blocks
-    int ijkl[CC_DIAGRAM_MAX_RANK];  // indices for the arbitrary-nested loop
     int only_unique = perm_unique;
+    size_t n_blocks = 0;
 
     // check arguments for correctness and pre-process them
     int rank = guess_rank(qparts, valence, order);
@@ -125,16 +125,126 @@ diagram_t *diagram_new(char *name, char *qparts, char *valence, char *t3space, c
     intcpy(dg->t3space, t3space_arr, rank);
     intcpy(dg->order, order_arr, rank);
 
+    // create symmetry blocks (without data)
+    block_t **block_list = diagram_create_blocks(dg, &n_blocks);
+
+    // size of the diagram is known, storage can be chosen and allocated
+    size_t size = 0;
+    for (size_t i = 0; i < n_blocks; i++) {
+        if (block_list[i]->is_unique) {
+            size += block_list[i]->size * SIZEOF_WORKING_TYPE;
+        }
+    }
+
+    int storage_type = guess_storage_class(name, rank, qparts, valence, size);
+
+    for (size_t i = 0; i < n_blocks; i++) {
+        if (block_list[i]->is_unique) {
+            block_init_storage(block_list[i], storage_type);
+        }
+    }
+
+    diagram_bind_blocks(dg, n_blocks, block_list);
+
+    // cleanup
+    cc_free(block_list);
+
+    return dg;
+}
+
+
+/**
+ * Estimates size (in bytes) of data of the diagram which is not created yet.
+ * Arguments are the same as for diagram_new(). No memory for data is allocated.
+ */
+size_t diagram_estimate_size(char *qparts, char *valence, char *t3space, char *order, int perm_unique, int irrep)
+{
+    diagram_t dg;
+    size_t n_blocks = 0;
+    size_t size = 0;
+
+    dg.rank = guess_rank(qparts, valence, order);
+    dg.symmetry = irrep;
+    dg.only_unique = perm_unique;
+    parse_qp_string(dg.rank, qparts, dg.qparts);
+    parse_valence_string(dg.rank, valence, dg.valence);
+    parse_valence_string(dg.rank, t3space, dg.t3space);
+    parse_order_string(dg.rank, order, dg.order);
+
+    block_t **block_list = diagram_create_blocks(&dg, &n_blocks);
+
+    for (size_t i = 0; i < n_blocks; i++) {
+        if (block_list[i]->is_unique) {
+            size += block_list[i]->size * SIZEOF_WORKING_TYPE;
+        }
+        block_delete(block_list[i]);
+    }
+    cc_free(block_list);
+
+    return size;
+}
+
+
+/**
+ * Estimates size (in bytes) of metadata of the diagram which is not created
+ * yet: descriptors of all blocks (including non-unique ones), the list of
+ * blocks and the inverted index. Metadata always reside in RAM.
+ * Arguments are the same as for diagram_new().
+ */
+size_t diagram_estimate_metadata_size(char *qparts, char *valence, char *t3space, char *order, int perm_unique,
+                                      int irrep)
+{
+    diagram_t dg;
+    size_t n_blocks = 0;
+
+    dg.rank = guess_rank(qparts, valence, order);
+    dg.symmetry = irrep;
+    dg.only_unique = perm_unique;
+    parse_qp_string(dg.rank, qparts, dg.qparts);
+    parse_valence_string(dg.rank, valence, dg.valence);
+    parse_valence_string(dg.rank, t3space, dg.t3space);
+    parse_order_string(dg.rank, order, dg.order);
+
+    block_t **block_list = diagram_create_blocks(&dg, &n_blocks);
+
+    size_t size = sizeof(diagram_t) + n_blocks * sizeof(block_t *) + int_pow(n_spinor_blocks, dg.rank) * sizeof(size_t);
+    for (size_t i = 0; i < n_blocks; i++) {
+        block_t *block = block_list[i];
+        size += sizeof(block_t) + block->rank * (sizeof(int) + sizeof(int *));
+        for (int j = 0; j < block->rank; j++) {
+            size += sizeof(int) * spinor_blocks[block->spinor_blocks[j]].size;
+        }
+        block_delete(block);
+    }
+    cc_free(block_list);
+
+    return size;
+}
+
+
+/**
+ * Creates all symmetry-allowed non-zero blocks of the diagram.
+ * Blocks are created without data (CC_DIAGRAM_DUMMY storage type),
+ * see block_init_storage().
+ * Returns newly allocated list of blocks.
+ */
+static block_t **diagram_create_blocks(diagram_t *dg, size_t *n_blocks)
+{
+    int rank = dg->rank;
+    int irrep = dg->symmetry;
+    size_t i;
+    int max_sbs;            // max number of sym blocks = (# spinor blocks)^rank
+    int blocks_counter = 0;          // counter of created blocks
+    int ijkl[CC_DIAGRAM_MAX_RANK];  // indices for the arbitrary-nested loop
+
     // permutation which is inverse to the 'order' perm-n
     // is required for the subsequent application of the DPD scheme
     int reverse_order[CC_DIAGRAM_MAX_RANK];
-    inverse_perm(rank, order_arr, reverse_order);
-
-    int storage_type = guess_storage_class(name, rank, qparts, valence);
+    inverse_perm(rank, dg->order, reverse_order);
 
     // create symmetry blocks
     max_sbs = (int) pow(n_spinor_blocks, rank);
-    block_list = (block_t **) cc_malloc(sizeof(block_t *) * max_sbs);
+    block_t **block_list = (block_t **) cc_malloc(sizeof(block_t *) * max_sbs);
 
     int is_fully_sym = (irrep == get_totally_symmetric_irrep()) ? 1 : 0;
 
@@ -170,15 +280,11 @@ diagram_t *diagram_new(char *name, char *qparts, char *valence, char *t3space, c
         }
 
         // create empty block
-        block_t *block = block_new(rank, ijkl, dg->qparts, dg->valence, dg->t3space, dg->order, storage_type,
-                                   only_unique);
+        block_t *block = block_new(rank, ijkl, dg->qparts, dg->valence, dg->t3space, dg->order, CC_DIAGRAM_DUMMY,
+                                   dg->only_unique);
         if (block == NULL) {
             goto next_symblock;
         }
-        /*else {
-            if (rank == 6)
-            printf("nonzero!\n");
-        }*/
 
         // save this block (and count it)
         block_list[blocks_counter] = block;
@@ -200,12 +306,8 @@ diagram_t *diagram_new(char *name, char *qparts, char *valence, char *t3space, c
         // (next set of indices)
     }
 
-    diagram_bind_blocks(dg, blocks_counter, block_list);
-
-    // cleanup
-    cc_free(block_list);
-
-    return dg;
+    *n_blocks = blocks_counter;
+    return block_list;
 }
 
 
@@ -310,9 +412,22 @@ void diagram_get_memory_used(diagram_t *dg, size_t *ram_used, size_t *disk_used)
 
     for (size_t ib = 0; ib < dg->n_blocks; ib++) {
         block_t *block = dg->blocks[ib];
-        if (block->storage_type == CC_DIAGRAM_IN_MEM) {
+        if (block->is_evicted) {
+            *disk_used += block->size * SIZEOF_WORKING_TYPE;
+        }
+        else if (block->storage_type == CC_DIAGRAM_IN_MEM) {
             *ram_used += block->size * SIZEOF_WORKING_TYPE;
         }
+        else if (block->storage_type == CC_DIAGRAM_COMPRESSED) {
+            size_t zram = 0;
+            size_t zdisk = 0;
+            compressed_tier_get_memory_used(block, &zram, &zdisk);
+            *ram_used += zram;
+            *disk_used += zdisk;
+        }
+        else if (block->storage_type == CC_DIAGRAM_CHOLESKY) {
+            // the Cholesky vectors are shared by all the blocks
+        }
         else { // CC_DIAGRAM_ON_DISK
             *disk_used += block->size * SIZEOF_WORKING_TYPE;
         }
@@ -329,14 +444,10 @@ void diagram_get_memory_used(diagram_t *dg, size_t *ram_used, size_t *disk_used)
  */
 block_t *diagram_get_block(diagram_t *dg, int *spinor_blocks_nums)
 {
-    static int dims[CC_DIAGRAM_MAX_RANK];
-    static int initialized = 0;
-
-    if (initialized == 0) {
-        initialized = 1;
-        for (int i = 0; i < CC_DIAGRAM_MAX_RANK; i++) {
-            dims[i] = n_spinor_blocks;
-        }
+    // no static data here: can be called by several threads at once
+    int dims[CC_DIAGRAM_MAX_RANK];
+    for (int i = 0; i < CC_DIAGRAM_MAX_RANK; i++) {
+        dims[i] = n_spinor_blocks;
     }
 
     /*
@@ -408,19 +519,27 @@ diagram_t *diagram_copy(diagram_t *dg)
 
 
 /**
- * Storage type: in memory or on disk.
+ * Storage type: in memory, compressed in memory, on disk or Cholesky vectors.
  * Diagram is assumed to be stored on disk even in case only one block is
- * stored on disk.
+ * stored on disk. The same is for compressed blocks.
  */
 storage_type_t diagram_get_storage_type(diagram_t *dg)
 {
+    int n_compressed = 0;
+
     for (int i = 0; i < dg->n_blocks; i++) {
         if (dg->blocks[i]->storage_type == CC_DIAGRAM_ON_DISK) {
             return CC_DIAGRAM_ON_DISK;
         }
+        if (dg->blocks[i]->storage_type == CC_DIAGRAM_CHOLESKY) {
+            return CC_DIAGRAM_CHOLESKY;
+        }
+        if (dg->blocks[i]->storage_type == CC_DIAGRAM_COMPRESSED) {
+            n_compressed++;
+        }
     }
 
-    return CC_DIAGRAM_IN_MEM;
+    return n_compressed > 0 ? CC_DIAGRAM_COMPRESSED : CC_DIAGRAM_IN_MEM;
 }
 
 
@@ -614,6 +733,87 @@ diagram_t *diagram_clear(diagram_t *dg)
 }
 
 
+/**
+ * Marks all blocks of the diagram as read-only: the diagram is not going to be
+ * modified anymore (sorted integrals). On-disk blocks of such diagrams are
+ * mapped into memory instead of being read (see block_set_readonly()).
+ */
+void diagram_set_readonly(diagram_t *dg)
+{
+    for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+        block_set_readonly(dg->blocks[isb]);
+    }
+}
+
+
+/**
+ * Marks files of all on-disk blocks of the diagram as shared: they belong
+ * to the cache of sorted integrals and are never modified or removed
+ * (see block_set_shared()).
+ */
+void diagram_set_shared(diagram_t *dg)
+{
+    for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+        block_set_shared(dg->blocks[isb]);
+    }
+}
+
+
+/**
+ * Moves all blocks of the diagram to the storage of the given type
+ * (RAM, compressed RAM or disk), see block_set_storage_type().
+ */
+void diagram_set_storage_type(diagram_t *dg, int storage_type)
+{
+    for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+        block_set_storage_type(dg->blocks[isb], storage_type);
+    }
+}
+
+
+/**
+ * Marks in-memory blocks of the diagram as evictable: they can be moved to
+ * disk when the memory limit is reached (see eviction.c).
+ * Only diagrams accessed through block_load()/block_unload() can be evictable.
+ * One-particle diagrams are small and are never evicted.
+ */
+void diagram_set_evictable(diagram_t *dg)
+{
+    if (dg->rank < 4) {
+        return;
+    }
+
+    for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+        eviction_add_block(dg->blocks[isb]);
+    }
+}
+
+
+/**
+ * Loads (and pins) data of all unique blocks of the diagram.
+ * Required before element-wise access (diagram_get()) to the diagrams
+ * which can be stored off RAM or evicted.
+ */
+void diagram_load_blocks(diagram_t *dg)
+{
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        if (dg->blocks[ib]->is_unique) {
+            block_load(dg->blocks[ib]);
+        }
+    }
+}
+
+
+void diagram_unload_blocks(diagram_t *dg)
+{
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        if (dg->blocks[ib]->is_unique) {
+            block_unload(dg->blocks[ib]);
+        }
+    }
+}
+
+
 void set_order(char *dg_name, char *new_order)
 {
     diagram_t *dg = diagram_stack_find(dg_name);
@@ -873,19 +1073,45 @@ int guess_rank(char *qparts, char *valence, char *order)
 }
 
 
-// storage class: RAM or DISK
-int guess_storage_class(char *name, int rank, char *qparts, char *valence)
+// storage class: RAM, compressed RAM, DISK or Cholesky vectors
+int guess_storage_class(char *name, int rank, char *qparts, char *valence, size_t size)
+{
+    // pppp integrals reconstructed from the Cholesky vectors
+    if (cholesky_tier_is_reserved(name)) {
+        return CC_DIAGRAM_CHOLESKY;
+    }
+
+    // diagrams created in advance (for the subsequent sectors) wait off RAM
+    if (placement_is_parked(name)) {
+        return placement_get_off_ram_storage_type();
+    }
+
+    // placement depends on sizes of diagrams and the memory limit
+    if (cc_opts->disk_usage_level == CC_DISK_USAGE_AUTO) {
+        return placement_get_storage_type(name, rank, qparts, valence);
+    }
+
+    // fixed rules (disk usage level is set explicitly)
+    int storage_type = get_fixed_storage_class(name, rank, qparts, valence, cc_opts->disk_usage_level);
+
+    // disk diagrams are kept compressed in RAM (if possible)
+    if (storage_type == CC_DIAGRAM_ON_DISK && cc_opts->compressed_tier) {
+        storage_type = CC_DIAGRAM_COMPRESSED;
+    }
+
+    return storage_type;
+}
+
+
+/**
+ * Storage class (RAM or disk) prescribed by the fixed disk usage level.
+ */
+int get_fixed_storage_class(char *name, int rank, char *qparts, char *valence, int level)
 {
-    int storage_type = CC_DIAGRAM_IN_MEM;
     if (strcmp(name, "pppp") == 0 || strcmp(name, "ppppr") == 0) {
-        if (cc_opts->disk_usage_level >= 2) {
-            storage_type = CC_DIAGRAM_ON_DISK;
-        }
-        else {
-            storage_type = CC_DIAGRAM_IN_MEM;
-        }
+        return (level >= 2) ? CC_DIAGRAM_ON_DISK : CC_DIAGRAM_IN_MEM;
     }
-    else if (rank == 4 && cc_opts->disk_usage_level >= 3) { // three inactive 'p' indices
+    else if (rank == 4 && level >= 3) { // three inactive 'p' indices
         int np = 0;
         for (int i = 0; i < rank; i++) {
             if (qparts[i] == 'p' && valence[i] == '0') {
@@ -893,14 +1119,12 @@ int guess_storage_class(char *name, int rank, char *qparts, char *valence)
             }
         }
         if (np >= 3) {
-            storage_type = CC_DIAGRAM_ON_DISK;
+            return CC_DIAGRAM_ON_DISK;
         }
     }
-    else if (rank >= 6 && cc_opts->disk_usage_level >= 1) { // triples+ diagrams: always on disk
-        storage_type = CC_DIAGRAM_ON_DISK;
+    else if (rank >= 6 && level >= 1) { // triples+ diagrams: always on disk
+        return CC_DIAGRAM_ON_DISK;
     }
-    else {
-        storage_type = CC_DIAGRAM_IN_MEM;
-    }
-    return storage_type;
+
+    return CC_DIAGRAM_IN_MEM;
 }
@@ -84,6 +84,16 @@ typedef struct diagram {
 // singly-linked list "dg_stack"
 diagram_t *diagram_new(char *name, char *qparts, char *valence, char *t3space, char *order, int perm_unique, int irrep);
 
+size_t diagram_estimate_size(char *qparts, char *valence, char *t3space, char *order, int perm_unique, int irrep);
+
+size_t diagram_estimate_metadata_size(char *qparts, char *valence, char *t3space, char *order, int perm_unique,
+                                      int irrep);
+
+// storage class (RAM, compressed RAM or disk) for the new diagram
+int guess_storage_class(char *name, int rank, char *qparts, char *valence, size_t size);
+
+int get_fixed_storage_class(char *name, int rank, char *qparts, char *valence, int level);
+
 // deallocates all memory associated with this object
 void diagram_delete(diagram_t *dg);
 
@@ -150,6 +160,16 @@ diagram_t *diagram_mult(diagram_t *dg1, diagram_t *dg2, int ncontr, int perm_uni
 // memory management: on disk or in RAM
 void diagram_set_storage_type(diagram_t *dg, int storage_type);
 
+void diagram_set_readonly(diagram_t *dg);
+
+void diagram_set_shared(diagram_t *dg);
+
+void diagram_set_evictable(diagram_t *dg);
+
+void diagram_load_blocks(diagram_t *dg);
+
+void diagram_unload_blocks(diagram_t *dg);
+
 block_t *diagram_get_block(diagram_t *dg, int *spinor_blocks_nums);//, size_t *block_index);
 
 void set_order(char *dg_name, char *new_order);
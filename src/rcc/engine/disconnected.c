@@ -76,10 +76,10 @@ void construct_disconnected_rank2_rank2(char *src1_name, char *src2_name, char *
 
     for (size_t iblock = 0; iblock < dst_diagram->n_blocks; iblock++) {
         block_t *block = dst_diagram->blocks[iblock];
-        block_load(block);
         if (block->is_unique == 0) {
             continue;
         }
+        block_load(block);
 
         int *indices = (int *) cc_malloc(block->size * rank * sizeof(int));
         block_gen_indices(block, indices);
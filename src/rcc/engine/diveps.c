@@ -33,6 +33,7 @@
 #include "engine.h"
 #include "error.h"
 #include "options.h"
+#include "perfcnt.h"
 #include "spinors.h"
 #include "timer.h"
 
@@ -67,7 +68,9 @@ void diveps(char *name)
 
     assert_diagram_exists(name);
     diagram_t *dg = diagram_stack_find(name);
+    opstats_begin("diveps", NULL, NULL, name);
     diagram_diveps(dg);
+    opstats_end();
 
     timer_stop("diveps");
 }
@@ -90,6 +93,11 @@ diagram_t *diagram_diveps(diagram_t *dg)
         }
         block_load(block);
 
+        perfcnt_sample_t perf_start;
+        if (cc_perfcnt_enabled) {
+            perfcnt_read(&perf_start);
+        }
+
         if (rank == 2) {
             diveps_block_rank_2(block);
         }
@@ -103,6 +111,11 @@ diagram_t *diagram_diveps(diagram_t *dg)
             diveps_block_general(block);
         }
 
+        if (cc_perfcnt_enabled) {
+            perfcnt_add(PERFCNT_DIVEPS, &perf_start);
+        }
+        opstats_add_bytes(2.0 * block->size * SIZEOF_WORKING_TYPE);
+
         block_store(block);
     }
 
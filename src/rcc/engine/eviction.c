@@ -0,0 +1,275 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Eviction of in-memory blocks to disk under memory pressure.
+ *
+ * The LRU list of evictable blocks and pin counters are modified in the
+ * 'cc_eviction' critical section only. The eviction handler itself is called
+ * by the memory allocator inside the same critical section (see memory.c),
+ * so it works with the list directly.
+ */
+
+#include <stdio.h>
+
+#include "eviction.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "options.h"
+#include "utils.h"
+
+static block_t *lru_head = NULL;    // most recently used
+static block_t *lru_tail = NULL;    // least recently used
+
+static struct {
+    size_t n_events;
+    size_t n_blocks;
+    size_t n_bytes;
+} eviction_stat = {0};
+
+static size_t evict_blocks(size_t nbytes);
+
+static void evict_block(block_t *block);
+
+static void lru_remove(block_t *block);
+
+static void lru_push_front(block_t *block);
+
+
+/**
+ * Adds the in-memory block to the list of evictable blocks.
+ * The eviction handler is registered on the first call.
+ */
+void eviction_add_block(block_t *block)
+{
+    if (block->storage_type != CC_DIAGRAM_IN_MEM || block->is_evictable) {
+        return;
+    }
+
+    #pragma omp critical (cc_eviction)
+    {
+        if (lru_head == NULL && lru_tail == NULL) {
+            cc_set_eviction_handler(evict_blocks);
+        }
+        block->is_evictable = 1;
+        block->n_pins = 0;
+        lru_push_front(block);
+    }
+}
+
+
+/**
+ * Removes the block from the list of evictable blocks (before deletion or
+ * change of the storage type). Data of the evicted block are discarded:
+ * eviction_restore_block() must be called before if they are needed.
+ */
+void eviction_remove_block(block_t *block)
+{
+    if (!block->is_evictable) {
+        return;
+    }
+
+    #pragma omp critical (cc_eviction)
+    {
+        if (block->is_evicted) {
+            io_remove(block->file_name);
+            cc_free(block->file_name);
+            block->file_name = NULL;
+            block->is_evicted = 0;
+        }
+        else {
+            lru_remove(block);
+        }
+        block->is_evictable = 0;
+    }
+}
+
+
+/**
+ * The block is being used: it cannot be evicted until it is unpinned.
+ * Returns 1 if data of the block were evicted and must be restored.
+ */
+int eviction_pin_block(block_t *block)
+{
+    int is_evicted;
+
+    #pragma omp critical (cc_eviction)
+    {
+        block->n_pins++;
+        is_evicted = block->is_evicted;
+        if (!is_evicted) {
+            lru_remove(block);
+            lru_push_front(block);
+        }
+    }
+
+    return is_evicted;
+}
+
+
+/**
+ * Reads data of the evicted block back into RAM. The block must be pinned,
+ * concurrent calls for the same block read the data only once.
+ * Memory for the data is allocated outside the 'cc_eviction' critical
+ * section since the allocation can call the eviction handler.
+ */
+void eviction_restore_block(block_t *block)
+{
+    #pragma omp critical (cc_eviction_restore)
+    {
+        int is_evicted;
+        #pragma omp critical (cc_eviction)
+        is_evicted = block->is_evicted;
+
+        if (is_evicted) {
+            size_t n_bytes = block->size * SIZEOF_WORKING_TYPE;
+            double complex *buf = (double complex *) cc_malloc(n_bytes);
+
+            int fd = io_open(block->file_name, "r");
+            if (fd == -1) {
+                errquit("eviction_restore_block(): unable to open file %s", block->file_name);
+            }
+            io_read_compressed(fd, buf, n_bytes);
+            io_close(fd);
+            io_remove(block->file_name);
+
+            #pragma omp critical (cc_eviction)
+            {
+                cc_free(block->file_name);
+                block->file_name = NULL;
+                block->buf = buf;
+                block->is_evicted = 0;
+                lru_push_front(block);
+            }
+        }
+    }
+}
+
+
+void eviction_unpin_block(block_t *block)
+{
+    #pragma omp critical (cc_eviction)
+    {
+        if (block->n_pins > 0) {
+            block->n_pins--;
+        }
+    }
+}
+
+
+void eviction_print_stats()
+{
+    if (eviction_stat.n_events == 0) {
+        return;
+    }
+
+    printf(" memory limit was reached %ld times: %ld blocks (%.3f MB) were evicted to disk\n",
+           eviction_stat.n_events, eviction_stat.n_blocks, eviction_stat.n_bytes / (1024.0 * 1024.0));
+}
+
+
+/*
+ * eviction handler (see cc_set_eviction_handler()).
+ * evicts least recently used unpinned blocks until at least 'nbytes' bytes
+ * are released. returns number of bytes released.
+ */
+static size_t evict_blocks(size_t nbytes)
+{
+    size_t n_released = 0;
+    size_t n_evicted = 0;
+    block_t *block = lru_tail;
+
+    while (n_released < nbytes && block != NULL) {
+        block_t *prev = block->evict_prev;
+
+        if (block->n_pins == 0) {
+            n_released += block->size * SIZEOF_WORKING_TYPE;
+            n_evicted++;
+            evict_block(block);
+        }
+
+        block = prev;
+    }
+
+    eviction_stat.n_events++;
+    eviction_stat.n_blocks += n_evicted;
+    eviction_stat.n_bytes += n_released;
+
+    printf(" memory limit reached: %ld blocks (%.3f MB) were evicted to disk\n",
+           n_evicted, n_released / (1024.0 * 1024.0));
+
+    return n_released;
+}
+
+
+static void evict_block(block_t *block)
+{
+    block->file_name = (char *) cc_malloc(CC_MAX_FILE_NAME_LENGTH);
+    sprintf(block->file_name, "block-%ld-%ld.sb", run_id(), block->id);
+
+    int fd = io_open(block->file_name, "w");
+    if (fd == -1) {
+        errquit("evict_block(): unable to open file %s", block->file_name);
+    }
+    io_write_compressed(fd, block->buf, block->size * SIZEOF_WORKING_TYPE);
+    io_close(fd);
+
+    lru_remove(block);
+    cc_free(block->buf);
+    block->buf = NULL;
+    block->is_evicted = 1;
+}
+
+
+static void lru_remove(block_t *block)
+{
+    if (block->evict_prev) {
+        block->evict_prev->evict_next = block->evict_next;
+    }
+    else if (lru_head == block) {
+        lru_head = block->evict_next;
+    }
+    if (block->evict_next) {
+        block->evict_next->evict_prev = block->evict_prev;
+    }
+    else if (lru_tail == block) {
+        lru_tail = block->evict_prev;
+    }
+    block->evict_prev = NULL;
+    block->evict_next = NULL;
+}
+
+
+static void lru_push_front(block_t *block)
+{
+    block->evict_prev = NULL;
+    block->evict_next = lru_head;
+    if (lru_head) {
+        lru_head->evict_prev = block;
+    }
+    lru_head = block;
+    if (lru_tail == NULL) {
+        lru_tail = block;
+    }
+}
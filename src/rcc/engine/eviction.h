@@ -0,0 +1,55 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Eviction of in-memory blocks to disk under memory pressure.
+ *
+ * Blocks of "evictable" diagrams (sorted integrals, vectors of the DIIS
+ * subspace) are organized into the LRU list. When the memory limit is
+ * reached, cc_malloc() calls the eviction handler which writes the least
+ * recently used unpinned blocks to disk (losslessly) and releases their
+ * buffers. The storage type of evicted blocks is not changed (it still
+ * defines the contraction algorithms), they are only marked with the
+ * 'is_evicted' flag and are read back transparently by block_load().
+ * Blocks are pinned between block_load() and block_unload()/block_store(),
+ * pinned blocks are never evicted.
+ */
+
+#ifndef CC_EVICTION_H_INCLUDED
+#define CC_EVICTION_H_INCLUDED
+
+#include "block.h"
+
+void eviction_add_block(block_t *block);
+
+void eviction_remove_block(block_t *block);
+
+int eviction_pin_block(block_t *block);
+
+void eviction_restore_block(block_t *block);
+
+void eviction_unpin_block(block_t *block);
+
+void eviction_print_stats();
+
+#endif // CC_EVICTION_H_INCLUDED
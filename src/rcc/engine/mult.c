@@ -38,7 +38,9 @@
 #include "linalg.h"
 #include "options.h"
 #include "symmetry.h"
+#include "perfcnt.h"
 #include "timer.h"
+#include "trace.h"
 #include "utils.h"
 #include "tt.h"
 
@@ -139,7 +141,11 @@ void mult(char *name1, char *name2, char *target, int ncontr)
         errquit("mult(): diagram '%s' not found", name2);
     }
 
+    opstats_begin("mult", name1, name2, target);
+    cc_memory_push_tag(target);
     dg_prod = diagram_mult(dg1, dg2, ncontr, (target[0] == '$') ? 1 : 0);
+    cc_memory_pop_tag();
+    opstats_end();
     strcpy(dg_prod->name, target);
 
     // save new diagram to stack
@@ -254,10 +260,10 @@ void mult_algorithm_m_mm_openmp_external(diagram_t *op1, diagram_t *op2, diagram
     #pragma omp parallel for schedule(dynamic) num_threads(cc_opts->nthreads)
     for (size_t ib3 = 0; ib3 < tgt->n_blocks; ib3++) {
         block_t *b3 = tgt->blocks[ib3];
-        block_load(b3);
         if (b3->is_unique == 0) {
             continue;
         }
+        block_load(b3);
 
         for (size_t ib1 = 0; ib1 < op1->n_blocks; ib1++) {
             block_t *b1 = op1->blocks[ib1];
@@ -303,10 +309,10 @@ void mult_algorithm_m_mm_openmp_internal(diagram_t *op1, diagram_t *op2, diagram
 
     for (size_t ib3 = 0; ib3 < tgt->n_blocks; ib3++) {
         block_t *b3 = tgt->blocks[ib3];
-        block_load(b3);
         if (b3->is_unique == 0) {
             continue;
         }
+        block_load(b3);
 
         for (size_t ib1 = 0; ib1 < op1->n_blocks; ib1++) {
             block_t *b1 = op1->blocks[ib1];
@@ -499,6 +505,18 @@ void mulblocks(block_t *op1, block_t *op2, block_t *prod, int ncontr, int nthrea
 
     supmat_dims(op1, op2, ncontr, &M, &N, &K);
 
+    // C(M,N) += A(M,K) * B(N,K)^T: one complex multiply-add is 8 real FLOPs
+    double t0 = cc_trace_blocks ? abs_time() : 0.0;
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
+    double mnk = (double) M * (double) N * (double) K;
+    double n_bytes = ((double) M * K + (double) N * K + 2.0 * M * N) * SIZEOF_WORKING_TYPE;
+    opstats_add_flops((arith == CC_ARITH_COMPLEX) ? 8.0 * mnk : 2.0 * mnk);
+    opstats_add_bytes(n_bytes);
+
     double complex *A = op1->buf;
     double complex *B = op2->buf;
     double complex *C = prod->buf;
@@ -608,6 +626,13 @@ void mulblocks(block_t *op1, block_t *op2, block_t *prod, int ncontr, int nthrea
     }
 
     omp_set_num_threads(nthreads);
+
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_MULBLOCKS, &perf_start);
+    }
+    if (cc_trace_blocks) {
+        trace_event("kernel", "mulblocks", NULL, t0, abs_time(), prod->size, n_bytes);
+    }
 }
 
 
@@ -820,7 +845,8 @@ static diagram_t *mult_product_template(diagram_t *dg1, diagram_t *dg2, int ncon
 /**
  * Returns the type of the algorithm to be used for tensor contraction.
  * The order of three nested loops completely determines performance.
- * Recall: M -- Memory, D -- Disk
+ * Recall: M -- Memory, D -- Disk (or compressed in memory: blocks have to be
+ * loaded/stored one by one as for the disk diagrams)
  *
  * @param op1 operand 1
  * @param op2 operand 2
@@ -829,9 +855,9 @@ static diagram_t *mult_product_template(diagram_t *dg1, diagram_t *dg2, int ncon
  */
 static int mult_type(diagram_t *op1, diagram_t *op2, diagram_t *prod)
 {
-    int type_prod = diagram_get_storage_type(prod) == CC_DIAGRAM_ON_DISK ? 1 : 0;
-    int type_op1 = diagram_get_storage_type(op1) == CC_DIAGRAM_ON_DISK ? 1 : 0;
-    int type_op2 = diagram_get_storage_type(op2) == CC_DIAGRAM_ON_DISK ? 1 : 0;
+    int type_prod = diagram_get_storage_type(prod) != CC_DIAGRAM_IN_MEM ? 1 : 0;
+    int type_op1 = diagram_get_storage_type(op1) != CC_DIAGRAM_IN_MEM ? 1 : 0;
+    int type_op2 = diagram_get_storage_type(op2) != CC_DIAGRAM_IN_MEM ? 1 : 0;
 
     int algorithms[2][2][2];
     algorithms[0][0][0] = MULT_M_MM;
@@ -0,0 +1,300 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Accounting of floating-point operations and memory traffic of the diagram
+ * engine (see opstats.h).
+ *
+ * Call sites are opened/closed by the master thread only (outside parallel
+ * regions), while kernels may add their counts from any thread: counters of
+ * the active call site are updated atomically.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opstats.h"
+#include "error.h"
+#include "timer.h"
+#include "trace.h"
+
+#define CC_OPSTATS_MAX_SITES 1024
+#define CC_OPSTATS_LABEL_LENGTH 16
+#define CC_OPSTATS_KEY_LENGTH 112
+#define CC_OPSTATS_MAX_DEPTH 16
+
+typedef struct {
+    char label[CC_OPSTATS_LABEL_LENGTH];
+    char key[CC_OPSTATS_KEY_LENGTH];    // names of diagrams
+    size_t n_calls;
+    double time;
+    double flops;
+    double bytes;
+} opstats_site_t;
+
+typedef struct {
+    int site;
+    double t_start;
+    double flops_start;
+    double bytes_start;
+} opstats_frame_t;
+
+static opstats_site_t sites[CC_OPSTATS_MAX_SITES];
+static int n_sites = 0;
+
+static opstats_frame_t site_stack[CC_OPSTATS_MAX_DEPTH];
+static int stack_depth = 0;
+
+// innermost active call site, -1 if none
+static int curr_site = -1;
+
+static int find_site(char *label, char *key);
+
+static int site_time_greater(const void *a, const void *b);
+
+
+/**
+ * Opens the call site of the engine operation.
+ * Names of the diagrams are optional (NULL).
+ */
+void opstats_begin(char *label, char *name1, char *name2, char *target)
+{
+    char key[CC_OPSTATS_KEY_LENGTH];
+
+    if (name1 && name2) {
+        snprintf(key, sizeof(key), "%s <- %s * %s", target ? target : "", name1, name2);
+    }
+    else if (name1) {
+        snprintf(key, sizeof(key), "%s <- %s", target ? target : "", name1);
+    }
+    else {
+        snprintf(key, sizeof(key), "%s", target ? target : "");
+    }
+
+    if (stack_depth == CC_OPSTATS_MAX_DEPTH) {
+        errquit("opstats_begin(): too deep nesting of engine operations (max %d)", CC_OPSTATS_MAX_DEPTH);
+    }
+
+    int site = find_site(label, key);
+    opstats_frame_t *frame = &site_stack[stack_depth++];
+    frame->site = site;
+    frame->t_start = abs_time();
+    frame->flops_start = sites[site].flops;
+    frame->bytes_start = sites[site].bytes;
+
+    curr_site = site;
+}
+
+
+/**
+ * Closes the innermost call site.
+ * Counts are also attributed to the current region of the profiler.
+ */
+void opstats_end()
+{
+    if (stack_depth == 0) {
+        errquit("opstats_end(): no active engine operation");
+    }
+
+    opstats_frame_t *frame = &site_stack[--stack_depth];
+    opstats_site_t *s = &sites[frame->site];
+
+    double t_end = abs_time();
+    s->n_calls++;
+    s->time += t_end - frame->t_start;
+    timer_add_flops(s->flops - frame->flops_start);
+    timer_add_bytes(s->bytes - frame->bytes_start);
+
+    if (cc_trace_enabled) {
+        trace_event("engine", s->label, s->key, frame->t_start, t_end, 0, s->bytes - frame->bytes_start);
+    }
+
+    curr_site = (stack_depth > 0) ? site_stack[stack_depth - 1].site : -1;
+}
+
+
+/**
+ * Adds floating-point operations to the active call site.
+ * Can be called from any thread.
+ */
+void opstats_add_flops(double n_flops)
+{
+    int site = curr_site;
+    if (site < 0) {
+        return;
+    }
+
+    #pragma omp atomic
+    sites[site].flops += n_flops;
+}
+
+
+/**
+ * Adds bytes moved (read + written) to the active call site.
+ * Can be called from any thread.
+ */
+void opstats_add_bytes(double n_bytes)
+{
+    int site = curr_site;
+    if (site < 0) {
+        return;
+    }
+
+    #pragma omp atomic
+    sites[site].bytes += n_bytes;
+}
+
+
+/**
+ * Prints the roofline-style table for the 'n_top' most expensive (in terms
+ * of wall time) operations.
+ */
+void opstats_print_roofline(char *title, int n_top)
+{
+    if (n_sites == 0) {
+        return;
+    }
+
+    opstats_site_t *sorted = (opstats_site_t *) malloc(sizeof(opstats_site_t) * n_sites);
+    memcpy(sorted, sites, sizeof(opstats_site_t) * n_sites);
+    qsort(sorted, n_sites, sizeof(opstats_site_t), site_time_greater);
+
+    double total_time = 0.0;
+    double total_flops = 0.0;
+    double total_bytes = 0.0;
+    for (int i = 0; i < n_sites; i++) {
+        total_time += sorted[i].time;
+        total_flops += sorted[i].flops;
+        total_bytes += sorted[i].bytes;
+    }
+
+    printf("\n");
+    printf(" Engine operations: %s (top %d of %d)\n", title, (n_top < n_sites) ? n_top : n_sites, n_sites);
+    printf(" ---------------------------------------------------------------------------------------------------------------\n");
+    printf("  %-48s %8s %10s %10s %10s %10s %10s\n", "operation", "calls", "time, s", "GFLOP", "GFLOP/s", "GB/s", "flop/byte");
+    printf(" ---------------------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < n_sites && i < n_top; i++) {
+        opstats_site_t *s = &sorted[i];
+        double gflops = s->flops * 1e-9;
+        double gbytes = s->bytes * 1e-9;
+        double perf = (s->time > 0.0) ? gflops / s->time : 0.0;
+        double bw = (s->time > 0.0) ? gbytes / s->time : 0.0;
+        printf("  %-8s %-39.39s %8ld %10.3f %10.3f %10.3f %10.3f ", s->label, s->key, s->n_calls, s->time, gflops, perf, bw);
+        if (s->bytes > 0.0) {
+            printf("%10.3f\n", s->flops / s->bytes);
+        }
+        else {
+            printf("%10s\n", "-");
+        }
+    }
+    printf(" ---------------------------------------------------------------------------------------------------------------\n");
+    printf("  %-48s %8s %10.3f %10.3f %10.3f %10.3f ", "total", "", total_time, total_flops * 1e-9,
+           (total_time > 0.0) ? total_flops * 1e-9 / total_time : 0.0,
+           (total_time > 0.0) ? total_bytes * 1e-9 / total_time : 0.0);
+    if (total_bytes > 0.0) {
+        printf("%10.3f\n", total_flops / total_bytes);
+    }
+    else {
+        printf("%10s\n", "-");
+    }
+    printf(" ---------------------------------------------------------------------------------------------------------------\n");
+    printf("  time is inclusive (nested operations are also counted separately)\n\n");
+
+    free(sorted);
+}
+
+
+/**
+ * Removes all call sites (typically at the end of the sector).
+ * Must not be called when there are active call sites.
+ */
+void opstats_clear()
+{
+    if (stack_depth > 0) {
+        errquit("opstats_clear(): %d engine operations are still active", stack_depth);
+    }
+
+    n_sites = 0;
+    curr_site = -1;
+}
+
+
+/**
+ * Total number of floating-point operations and bytes moved over all call
+ * sites since the last opstats_clear().
+ */
+void opstats_get_totals(double *n_flops, double *n_bytes)
+{
+    *n_flops = 0.0;
+    *n_bytes = 0.0;
+    for (int i = 0; i < n_sites; i++) {
+        *n_flops += sites[i].flops;
+        *n_bytes += sites[i].bytes;
+    }
+}
+
+
+/*
+ * returns index of the call site, creates it if not found.
+ */
+static int find_site(char *label, char *key)
+{
+    for (int i = 0; i < n_sites; i++) {
+        if (strcmp(sites[i].key, key) == 0 && strcmp(sites[i].label, label) == 0) {
+            return i;
+        }
+    }
+
+    // table is full: the rest of call sites are merged into the last entry
+    if (n_sites == CC_OPSTATS_MAX_SITES) {
+        strcpy(sites[n_sites - 1].label, "(other)");
+        strcpy(sites[n_sites - 1].key, "");
+        return n_sites - 1;
+    }
+
+    opstats_site_t *s = &sites[n_sites];
+    snprintf(s->label, sizeof(s->label), "%s", label);
+    snprintf(s->key, sizeof(s->key), "%s", key);
+    s->n_calls = 0;
+    s->time = 0.0;
+    s->flops = 0.0;
+    s->bytes = 0.0;
+
+    return n_sites++;
+}
+
+
+static int site_time_greater(const void *a, const void *b)
+{
+    double ta = ((const opstats_site_t *) a)->time;
+    double tb = ((const opstats_site_t *) b)->time;
+
+    if (ta > tb) {
+        return -1;
+    }
+    if (ta < tb) {
+        return 1;
+    }
+    return 0;
+}
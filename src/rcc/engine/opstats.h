@@ -0,0 +1,55 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Accounting of floating-point operations and memory traffic of the diagram
+ * engine.
+ *
+ * Counters are aggregated per call site of the engine: the operation label
+ * (mult, reorder, update, ...) plus the names of the diagrams involved.
+ * Kernels (mulblocks, reorder_block, block_load, ...) add their counts to the
+ * innermost active call site. The roofline-style table (GFLOP/s, GB/s and
+ * arithmetic intensity) of the most expensive operations is printed at the
+ * end of each sector.
+ */
+
+#ifndef CC_OPSTATS_H_INCLUDED
+#define CC_OPSTATS_H_INCLUDED
+
+#define CC_OPSTATS_TOP 20
+
+void opstats_begin(char *label, char *name1, char *name2, char *target);
+
+void opstats_end();
+
+void opstats_add_flops(double n_flops);
+
+void opstats_add_bytes(double n_bytes);
+
+void opstats_print_roofline(char *title, int n_top);
+
+void opstats_clear();
+
+void opstats_get_totals(double *n_flops, double *n_bytes);
+
+#endif // CC_OPSTATS_H_INCLUDED
@@ -0,0 +1,326 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Budget-driven placement of diagrams (RAM vs disk).
+ *
+ * Placement of integral diagrams is planned before sorting. The expected I/O
+ * volume per CC iteration is estimated as
+ *     sum_{diagrams off RAM} size * access frequency,
+ * it is minimized (greedily) under the memory budget:
+ *     max_memory_size * CC_PLACEMENT_MAX_FILL - (current usage) - (reserve),
+ * where the reserve is the estimated size of cluster amplitudes, their copies
+ * in the DIIS subspace and intermediates.
+ * The access frequency of a diagram is estimated from its indices: integrals
+ * with hole and valence indices enter many terms of CC equations, while
+ * integrals with inactive particle indices are used mostly in the ladder-type
+ * terms.
+ *
+ * Only the diagrams which the fixed disk usage levels can move off RAM
+ * (pppp and the integrals with three inactive particle indices, see
+ * get_fixed_storage_class()) are candidates: contractions are implemented
+ * for these positions of off-RAM operands only. Other integrals always stay
+ * in RAM.
+ *
+ * Diagrams absent from the plan (amplitudes, intermediates, reordered copies
+ * of integrals) are placed as for the disk usage level 1: rank-6+ diagrams
+ * off RAM, all the rest in RAM.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "placement.h"
+#include "block.h"
+#include "diagram.h"
+#include "engine.h"
+#include "error.h"
+#include "memory.h"
+#include "options.h"
+#include "symmetry.h"
+
+#define CC_PLACEMENT_MAX_DIAGRAMS 256
+#define CC_PLACEMENT_MAX_FILL 0.8
+
+typedef struct {
+    char name[CC_DIAGRAM_MAX_NAME];
+    char qparts[CC_DIAGRAM_MAX_RANK + 1];
+    char valence[CC_DIAGRAM_MAX_RANK + 1];
+    size_t size;
+    double access_freq;
+    int is_candidate;   // can be moved off RAM
+    int storage_type;
+} placement_entry_t;
+
+static placement_entry_t plan[CC_PLACEMENT_MAX_DIAGRAMS];
+static int plan_size = 0;
+
+// names of parked diagrams
+static char parked[CC_PLACEMENT_MAX_DIAGRAMS][CC_DIAGRAM_MAX_NAME];
+static int n_parked = 0;
+
+static double estimate_access_frequency(char *qparts, char *valence);
+
+static size_t estimate_amplitudes_reserve();
+
+static int cmp_by_access_frequency(const void *p1, const void *p2);
+
+static char *storage_type_to_string(int storage_type);
+
+
+/**
+ * Adds the diagram (not created yet) to the list of diagrams to be planned.
+ */
+void placement_add_diagram(char *name, char *qparts, char *valence, size_t size)
+{
+    if (plan_size == CC_PLACEMENT_MAX_DIAGRAMS) {
+        errquit("placement_add_diagram(): too many diagrams (max %d)", CC_PLACEMENT_MAX_DIAGRAMS);
+    }
+
+    placement_entry_t *entry = &plan[plan_size];
+    strncpy(entry->name, name, CC_DIAGRAM_MAX_NAME);
+    entry->name[CC_DIAGRAM_MAX_NAME - 1] = '\0';
+    strncpy(entry->qparts, qparts, CC_DIAGRAM_MAX_RANK);
+    entry->qparts[CC_DIAGRAM_MAX_RANK] = '\0';
+    strncpy(entry->valence, valence, CC_DIAGRAM_MAX_RANK);
+    entry->valence[CC_DIAGRAM_MAX_RANK] = '\0';
+    entry->size = size;
+    entry->access_freq = estimate_access_frequency(qparts, valence);
+    entry->is_candidate = get_fixed_storage_class(name, strlen(qparts), qparts, valence,
+                                                  CC_DISK_USAGE_LEVEL_3) != CC_DIAGRAM_IN_MEM;
+    entry->storage_type = CC_DIAGRAM_IN_MEM;
+
+    plan_size++;
+}
+
+
+/**
+ * Decides which of the planned diagrams stay in RAM and prints the plan.
+ */
+void placement_make_plan()
+{
+    size_t max_fill = CC_PLACEMENT_MAX_FILL * cc_opts->max_memory_size;
+    size_t reserve = estimate_amplitudes_reserve();
+    size_t used = cc_get_current_memory_usage() + reserve;
+    size_t budget = (max_fill > used) ? max_fill - used : 0;
+    size_t resident_size = 0;
+    size_t off_ram_size = 0;
+    double io_volume = 0.0;
+
+    // greedy: the most frequently accessed diagrams (the smallest first
+    // in case of equal frequencies) are placed to RAM; diagrams which are not
+    // candidates are always in RAM and reduce the budget for the rest
+    placement_entry_t **order = (placement_entry_t **) cc_malloc(sizeof(placement_entry_t *) * plan_size);
+    for (int i = 0; i < plan_size; i++) {
+        order[i] = &plan[i];
+    }
+    qsort(order, plan_size, sizeof(placement_entry_t *), cmp_by_access_frequency);
+
+    for (int i = 0; i < plan_size; i++) {
+        if (!plan[i].is_candidate) {
+            resident_size += plan[i].size;
+        }
+    }
+
+    for (int i = 0; i < plan_size; i++) {
+        placement_entry_t *entry = order[i];
+        if (!entry->is_candidate) {
+            entry->storage_type = CC_DIAGRAM_IN_MEM;
+        }
+        else if (resident_size + entry->size <= budget) {
+            entry->storage_type = CC_DIAGRAM_IN_MEM;
+            resident_size += entry->size;
+        }
+        else {
+            entry->storage_type = placement_get_off_ram_storage_type();
+            off_ram_size += entry->size;
+            io_volume += entry->size * entry->access_freq;
+        }
+    }
+
+    cc_free(order);
+
+    // print the plan
+    printf(" Placement of integral diagrams:\n");
+    printf("   memory budget for integrals %.3f MB (reserved for amplitudes %.3f MB)\n",
+           budget / (1024.0 * 1024.0), reserve / (1024.0 * 1024.0));
+    printf("   %-12s%-8s%-8s%14s%10s  %s\n", "name", "qparts", "valence", "size, MB", "access", "storage");
+    for (int i = 0; i < plan_size; i++) {
+        placement_entry_t *entry = &plan[i];
+        printf("   %-12s%-8s%-8s%14.3f%10.1f  %s%s\n", entry->name, entry->qparts, entry->valence,
+               entry->size / (1024.0 * 1024.0), entry->access_freq, storage_type_to_string(entry->storage_type),
+               placement_is_parked(entry->name) ? " (parked)" : "");
+    }
+    printf("   total in RAM %.3f MB, off RAM %.3f MB\n", resident_size / (1024.0 * 1024.0),
+           off_ram_size / (1024.0 * 1024.0));
+    printf("   expected I/O volume per iteration %.3f MB\n", io_volume / (1024.0 * 1024.0));
+}
+
+
+/**
+ * Removes all diagrams from the plan.
+ */
+void placement_clear()
+{
+    plan_size = 0;
+}
+
+
+/**
+ * Storage type for the diagram which is to be created.
+ */
+int placement_get_storage_type(char *name, int rank, char *qparts, char *valence)
+{
+    for (int i = 0; i < plan_size; i++) {
+        if (strcmp(plan[i].name, name) == 0) {
+            return plan[i].storage_type;
+        }
+    }
+
+    if (get_fixed_storage_class(name, rank, qparts, valence, CC_DISK_USAGE_LEVEL_1) == CC_DIAGRAM_IN_MEM) {
+        return CC_DIAGRAM_IN_MEM;
+    }
+
+    return placement_get_off_ram_storage_type();
+}
+
+
+/**
+ * Diagram with this name will be created off RAM (see guess_storage_class())
+ * until placement_unpark_all() is called.
+ */
+void placement_park_diagram(char *name)
+{
+    if (placement_is_parked(name)) {
+        return;
+    }
+    if (n_parked == CC_PLACEMENT_MAX_DIAGRAMS) {
+        errquit("placement_park_diagram(): too many diagrams (max %d)", CC_PLACEMENT_MAX_DIAGRAMS);
+    }
+
+    strncpy(parked[n_parked], name, CC_DIAGRAM_MAX_NAME);
+    parked[n_parked][CC_DIAGRAM_MAX_NAME - 1] = '\0';
+    n_parked++;
+}
+
+
+void placement_unpark_all()
+{
+    n_parked = 0;
+}
+
+
+int placement_is_parked(char *name)
+{
+    for (int i = 0; i < n_parked; i++) {
+        if (strcmp(parked[i], name) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static double estimate_access_frequency(char *qparts, char *valence)
+{
+    double freq = 1.0;
+
+    for (int i = 0; qparts[i] != '\0'; i++) {
+        if (qparts[i] == 'h' || valence[i] == '1') {
+            freq += 1.0;
+        }
+    }
+
+    return freq;
+}
+
+
+/*
+ * memory required besides the integrals:
+ * - doubles amplitudes: old and new amplitudes, two intermediates of the
+ *   same size, amplitudes and error vectors in the DIIS subspace;
+ * - the largest intermediates of the particle-particle ladder: product of
+ *   pppp and T1 (ppph) and the non-unique blocks of pppp restored in RAM
+ *   for the contraction (see mult_algorithm_m_mm_openmp_external()).
+ */
+static size_t estimate_amplitudes_reserve()
+{
+    int irrep = get_totally_symmetric_irrep();
+
+    size_t t2_size = diagram_estimate_size("hhpp", "0000", "0000", "1234", NOT_PERM_UNIQUE, irrep);
+    int n_copies = 4;
+    if (cc_opts->diis_enabled) {
+        n_copies += 2 * cc_opts->diis_dim;
+    }
+
+    size_t ladder_size = diagram_estimate_size("ppph", "0000", "0000", "1234", NOT_PERM_UNIQUE, irrep);
+    if (cc_opts->openmp_algorithm == CC_OPENMP_ALGORITHM_EXTERNAL) {
+        ladder_size += diagram_estimate_size("pppp", "0000", "0000", "1234", NOT_PERM_UNIQUE, irrep) -
+                       diagram_estimate_size("pppp", "0000", "0000", "1234", IS_PERM_UNIQUE, irrep);
+    }
+
+    return n_copies * t2_size + ladder_size;
+}
+
+
+/**
+ * Storage type for diagrams which do not fit into RAM.
+ */
+int placement_get_off_ram_storage_type()
+{
+    return cc_opts->compressed_tier ? CC_DIAGRAM_COMPRESSED : CC_DIAGRAM_ON_DISK;
+}
+
+
+static int cmp_by_access_frequency(const void *p1, const void *p2)
+{
+    placement_entry_t *e1 = *(placement_entry_t **) p1;
+    placement_entry_t *e2 = *(placement_entry_t **) p2;
+
+    if (e1->access_freq != e2->access_freq) {
+        return (e1->access_freq > e2->access_freq) ? -1 : 1;
+    }
+    if (e1->size != e2->size) {
+        return (e1->size < e2->size) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+static char *storage_type_to_string(int storage_type)
+{
+    switch (storage_type) {
+        case CC_DIAGRAM_IN_MEM:
+            return "RAM";
+        case CC_DIAGRAM_ON_DISK:
+            return "disk";
+        case CC_DIAGRAM_COMPRESSED:
+            return "compressed RAM";
+        case CC_DIAGRAM_CHOLESKY:
+            return "Cholesky vectors";
+        default:
+            return "dummy";
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Budget-driven placement of diagrams: RAM vs disk (or compressed RAM).
+ *
+ * Sizes of integral diagrams to be sorted are known before they are created,
+ * so the placement of these diagrams is planned in advance: diagrams with
+ * higher expected access frequency per byte stay in RAM while the memory
+ * budget allows. Only the diagrams which can be moved off RAM by the fixed
+ * disk usage levels are candidates. All other diagrams (amplitudes,
+ * intermediates) are placed at creation time as for the disk usage level 1.
+ *
+ * The placement is used with 'disk_usage auto' (CC_DISK_USAGE_AUTO),
+ * otherwise the fixed rules are applied (see guess_storage_class()).
+ *
+ * Diagrams which are created in advance but will not be used for a while
+ * (integrals sorted for the subsequent Fock space sectors) can be "parked":
+ * they are created off RAM regardless of the disk usage level. Parking is
+ * released as soon as these diagrams are created.
+ */
+
+#ifndef CC_PLACEMENT_H_INCLUDED
+#define CC_PLACEMENT_H_INCLUDED
+
+#include <stddef.h>
+
+void placement_add_diagram(char *name, char *qparts, char *valence, size_t size);
+
+void placement_make_plan();
+
+void placement_clear();
+
+int placement_get_storage_type(char *name, int rank, char *qparts, char *valence);
+
+void placement_park_diagram(char *name);
+
+void placement_unpark_all();
+
+int placement_is_parked(char *name);
+
+int placement_get_off_ram_storage_type();
+
+#endif // CC_PLACEMENT_H_INCLUDED
@@ -65,6 +65,8 @@
 #include "options.h"
 #include "utils.h"
 #include "linalg.h"
+#include "perfcnt.h"
+#include "trace.h"
 
 
 void reverse_perm(int n, const int *direct_perm, int *inv_perm);
@@ -98,7 +100,11 @@ void reorder(char *src_diargam_name, char *target_diagram_name, char *perm_str)
     diagram_t *dg_src = diagram_stack_find(src_diargam_name);
 
     // perform reordering
+    opstats_begin("reorder", src_diargam_name, NULL, target_diagram_name);
+    cc_memory_push_tag(target_diagram_name);
     diagram_t *dg_tgt = diagram_reorder(dg_src, perm);
+    cc_memory_pop_tag();
+    opstats_end();
 
     // save new diagram to stack
     // (replace the old diagram named 'target_diagram_name' if needed)
@@ -245,6 +251,12 @@ void reorder_block(block_t *source_block, block_t *target_block, int *perm)
     block_load(source_block);
     block_load(target_block);
 
+    double t0 = cc_trace_blocks ? abs_time() : 0.0;
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
     if (arith == CC_ARITH_COMPLEX) {
         TEMPLATE(tensor_transpose, double_complex_t)(source_block->rank, source_block->buf,
                                                      source_block->shape, target_block->shape, perm,
@@ -255,6 +267,15 @@ void reorder_block(block_t *source_block, block_t *target_block, int *perm)
                                            source_block->shape, target_block->shape, perm,
                                            (double *) target_block->buf, cc_opts->nthreads);
     }
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_TRANSPOSE, &perf_start);
+    }
+    opstats_add_bytes(2.0 * source_block->size * SIZEOF_WORKING_TYPE);
+
+    if (cc_trace_blocks) {
+        trace_event("kernel", "reorder_block", NULL, t0, abs_time(), source_block->size,
+                    2.0 * source_block->size * SIZEOF_WORKING_TYPE);
+    }
 
     block_unload(source_block);
     block_store(target_block);
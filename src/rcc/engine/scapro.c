@@ -61,6 +61,8 @@ double complex scalar_product(char *conj1, char *conj2, char *name1, char *name2
 
     //printf("\nSCAPRO\n\n");
 
+    opstats_begin("scapro", name1, name2, NULL);
+
     double complex scal_prod = 0.0 + 0.0 * I;
     for (size_t isb1 = 0; isb1 < dg1->n_blocks; isb1++) {
 
@@ -117,6 +119,8 @@ double complex scalar_product(char *conj1, char *conj2, char *name1, char *name2
         //printf(" n_eq_perms = %d\n", block1->n_equal_perms);
 
         scal_prod += /*block1->n_equal_perms * */ xdot(WORKING_TYPE, conj1, conj2, size, buf1, buf2);
+        opstats_add_flops(((arith == CC_ARITH_COMPLEX) ? 8.0 : 2.0) * size);
+        opstats_add_bytes(2.0 * size * SIZEOF_WORKING_TYPE);
 
         if (is_unique_1 == 0) {
             destroy_block(block1);
@@ -140,5 +144,7 @@ double complex scalar_product(char *conj1, char *conj2, char *name1, char *name2
         //printf("\n");
     }
 
+    opstats_end();
+
     return scal_prod;
 }
@@ -61,6 +61,7 @@ void tmplt_sym(char *name, char *qparts, char *valence, char *order, int perm_un
     // remove old diagram if presented
     diagram_t *dg = diagram_stack_find(name);
 
+    cc_memory_push_tag(name);
     if (dg != NULL) {
         dg = diagram_new(name, qparts, valence, t3space, order, perm_unique, irrep);
         diagram_stack_replace(name, dg);
@@ -69,6 +70,7 @@ void tmplt_sym(char *name, char *qparts, char *valence, char *order, int perm_un
         dg = diagram_new(name, qparts, valence, t3space, order, perm_unique, irrep);
         diagram_stack_push(dg);
     }
+    cc_memory_pop_tag();
 
     timer_stop("tmplt");
 }
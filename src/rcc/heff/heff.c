@@ -98,6 +98,8 @@ void heff_analysis(int sect_h, int sect_p, ...)
     const int MAX_DIAGRAMS = 64;
     char *diagram_names[MAX_DIAGRAMS];
 
+    cc_memory_push_tag("heff");
+
     /*
      * Construct model space
      */
@@ -167,6 +169,8 @@ void heff_analysis(int sect_h, int sect_p, ...)
         cc_free(det_basis[irrep]);
     }
     cc_free(det_basis);
+
+    cc_memory_pop_tag();
 }
 
 
@@ -220,6 +224,7 @@ void construct_heff(
             if (dg_veff == NULL) {
                 errquit("in construct_heff(): diagram '%s' not found", dg_name);
             }
+            diagram_load_blocks(dg_veff);
             setup_slater(dg_veff, (matrix_getter_fun) diagram_get, sect_h, sect_p, sect_h, sect_p, rank(dg_name) / 2);
 
             // construct matrix of the effective interaction (Veff) in the basis
@@ -231,6 +236,7 @@ void construct_heff(
                     heff_blocks[irep][i * ms_size + j] += slater_rule(bra, ket);
                 }
             }
+            diagram_unload_blocks(dg_veff);
         }
     }
 }
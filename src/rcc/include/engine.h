@@ -50,6 +50,11 @@
 #include "../engine/block.h"    // blocks
 #include "../engine/diagram.h"  // diagrams
 #include "../engine/dgstack.h"  // stack of diagrams
+#include "../engine/compressed_tier.h"  // compressed in-RAM storage tier
+#include "../engine/cholesky_tier.h"    // pppp integrals represented by the Cholesky vectors
+#include "../engine/placement.h"  // placement of diagrams: RAM vs disk
+#include "../engine/eviction.h"   // eviction of blocks to disk under memory pressure
+#include "../engine/opstats.h"    // FLOP and memory traffic accounting
 
 enum {
     NOT_PERM_UNIQUE = 0,
@@ -26,15 +26,25 @@
  * Interfaces implemented:
  *   DIRAC
  *   OneProp (by L. V. Skripnikov)
+ * Synthetic systems with fabricated integrals (no integral files) are
+ * also set up here.
  */
 
 #ifndef CC_INTERFACES_H_INCLUDED
 #define CC_INTERFACES_H_INCLUDED
 
+#include <complex.h>
+
 #include "options.h"
 
 void dirac_interface(cc_options_t *opts);
 
 void pyscf_interface(cc_options_t *opts);
 
+void synthetic_interface(cc_options_t *opts);
+
+void synthetic_setup_spinors(cc_options_t *opts, int n_irreps, int nocc, int nvirt, int complex_arith);
+
+double complex synthetic_eri(int p, int q, int r, int s);
+
 #endif /* CC_INTERFACES_H_INCLUDED */
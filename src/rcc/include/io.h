@@ -39,6 +39,7 @@ typedef struct io_stat {
     size_t n_closed;
     size_t n_created;
     size_t n_removed;
+    size_t n_mapped;
 } io_stat_t;
 
 int io_open(char *path, char *mode);
@@ -49,6 +50,8 @@ int64_t io_read(int fd, void *buf, size_t count);
 
 int64_t io_read_unsafe(int fd, void *buf, size_t count);
 
+int64_t io_pread(int fd, void *buf, size_t count, int64_t offset);
+
 int64_t io_write(int fd, const void *buf, size_t count);
 
 int io_file_exists(char *filename);
@@ -65,10 +68,22 @@ int io_remove(char *pathname);
 
 size_t io_fsize(char *pathname);
 
+void *io_mmap(char *path, size_t count);
+
+int io_munmap(void *addr, size_t count);
+
+int io_rename(char *old_path, char *new_path);
+
 size_t io_write_compressed(int fd, const void *buf, size_t count);
 
+size_t io_write_compressed_fp(int fd, const double *buf, size_t count);
+
 size_t io_read_compressed(int fd, void *buf, size_t count);
 
+char *io_compress_buffer(const double *buf, size_t count, int codec_id, size_t *frame_len);
+
+void io_decompress_buffer(const char *frame, size_t frame_len, void *buf, size_t count);
+
 void print_compression_stats();
 
 void io_statistics(io_stat_t *st);
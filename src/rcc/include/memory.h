@@ -34,12 +34,26 @@ void cc_init_allocator(size_t max_mem);
 // wrapper for malloc() from libc
 void *cc_malloc(size_t nbytes);
 
+// allocation attributed to the owner tag (see cc_memory_get_tag())
+void *cc_malloc_tagged(size_t nbytes, int tag);
+
 // allocate memory and set all bytes to zero
 void *cc_calloc(size_t num, size_t size);
 
 // wrapper for free() from libc
 void cc_free(void *p);
 
+// accounting of memory which is not allocated by cc_malloc (e.g. file mappings)
+void cc_account_external(size_t nbytes);
+
+void cc_release_external(size_t nbytes);
+
+// function which releases memory when the limit is reached,
+// returns number of bytes released
+typedef size_t (*cc_eviction_handler_t)(size_t nbytes);
+
+void cc_set_eviction_handler(cc_eviction_handler_t handler);
+
 // finalization of memory allocation subsystem
 void cc_finalize_allocator();
 
@@ -51,6 +65,21 @@ size_t cc_get_current_memory_usage();
 
 size_t cc_get_peak_memory_usage();
 
+// attribution of memory to owners (diagrams or subsystems)
+#define CC_MEMORY_TOP_CONSUMERS 20
+
+void cc_memory_push_tag(char *tag);
+
+void cc_memory_push_default_tag(char *tag);
+
+void cc_memory_pop_tag();
+
+int cc_memory_get_tag(char *name);
+
+void cc_memory_enable_timeline(char *path);
+
+void cc_memory_print_peak_consumers(int n_top);
+
 char *cc_strdup(const char *src);
 
 char *cc_memdup(const void *src, size_t n_bytes);
@@ -60,4 +60,31 @@ int sector_1h2p(cc_options_t *opts);
 
 int sector_2h1p(cc_options_t *opts);
 
+// integral sorting requests of the sectors (without sorting itself)
+void request_integrals_0h0p();
+
+void request_integrals_0h1p();
+
+void request_integrals_1h0p();
+
+void request_integrals_1h1p();
+
+void request_integrals_0h2p();
+
+void request_integrals_2h0p();
+
+void request_integrals_0h3p();
+
+void request_integrals_3h0p();
+
+void request_integrals_1h2p();
+
+void request_integrals_2h1p();
+
+// single-pass sorting of integrals for all the sectors to be visited
+void presort_integrals(cc_options_t *opts);
+
+// dry run: estimation of memory, disk and FLOPs (expt.x --plan)
+int plan_resources(cc_options_t *opts);
+
 #endif /* CC_METHODS_H_INCLUDED */
@@ -46,6 +46,9 @@
 #define CC_MAX_NPROP 256
 #define CC_MAX_SELECTION 64
 
+// max length of the integral cache directory: room is left for the names of entry files
+#define CC_MAX_CACHE_DIR_LENGTH (CC_MAX_PATH_LENGTH - 64)
+
 // boolean constants
 enum {
     CC_DISABLED = 0,
@@ -68,7 +71,8 @@ enum {
 // integral source
 typedef enum {
     CC_INTEGRALS_DIRAC,
-    CC_INTEGRALS_PYSCF
+    CC_INTEGRALS_PYSCF,
+    CC_INTEGRALS_SYNTHETIC
 } cc_interface_t;
 
 // source of property matrices
@@ -79,9 +83,10 @@ enum {
 
 // level of disk usage
 enum {
+    CC_DISK_USAGE_AUTO = -1, // placement is planned under the memory limit
     CC_DISK_USAGE_LEVEL_0,  // all data in RAM
-    CC_DISK_USAGE_LEVEL_1,  // rank 6+ diagrams on disk (default)
-    CC_DISK_USAGE_LEVEL_2,  // rank 6+, pppp on disk
+    CC_DISK_USAGE_LEVEL_1,  // rank 6+ diagrams on disk
+    CC_DISK_USAGE_LEVEL_2,  // rank 6+, pppp on disk (default)
     CC_DISK_USAGE_LEVEL_3,  // rank 6+, pppp, *ppp on disk
     CC_DISK_USAGE_LEVEL_4   // rank 6+, pppp, *ppp on disk + compression enabled
 };
@@ -191,10 +196,13 @@ typedef struct {
     int  approx_denominator;
 } cc_ms_prop_query_t;
 
-// data compression algorithm
+// data compression algorithm (codec)
 typedef enum {
     CC_COMPRESS_NONE,
-    CC_COMPRESS_LZ4
+    CC_COMPRESS_LZ4,      // plain LZ4
+    CC_COMPRESS_SHUFFLE,  // byte shuffle + LZ4
+    CC_COMPRESS_LOSSY,    // truncation of mantissas + byte shuffle + LZ4
+    CC_COMPRESS_SPARSE    // zero-run encoding
 } cc_compression_type_t;
 
 // parallelization alogirthm (for tensor contractions)
@@ -237,6 +245,9 @@ struct cc_options {
     int print_model_space;
     int print_model_vectors;
     int print_eff_config;
+    int print_trace;    // timeline of engine activity (Chrome trace format), 2 = with blocks
+    int print_perf_counters;    // hardware performance counters (Linux only)
+    int print_memory_timeline;  // time series of memory usage by owners
 
     /*
      * recommended arithmetic
@@ -252,6 +263,7 @@ struct cc_options {
      * data compression
      */
     cc_compression_type_t compress;
+    double compress_lossy_tol;  // absolute tolerance for the lossy codec
 
     /*
      * compression of arrays with triples amplitudes
@@ -266,10 +278,23 @@ struct cc_options {
     int tile_size;
 
     /*
-     * level of disk usage (all in RAM, rank6 on disk, pppp on disk, etc)
+     * level of disk usage (automatic, all in RAM, rank6 on disk, pppp on disk, etc)
      */
     int disk_usage_level;
 
+    /*
+     * compressed in-RAM tier: diagrams which are to be stored on disk
+     * are kept compressed in RAM (spilled to disk only if the tier is full)
+     */
+    int compressed_tier;
+    double compressed_tier_fraction;    // max size of the tier (fraction of max_memory_size)
+
+    /*
+     * pppp integrals are represented by the Cholesky vectors and are
+     * reconstructed block by block on demand (0 = disabled)
+     */
+    double cholesky_thresh;
+
     /*
      * number of lightweight (OpenMP) threads
      */
@@ -346,6 +371,7 @@ struct cc_options {
     char integral_file_prop[CC_MAX_PATH_LENGTH];  // name of the file with properties MO integrals
     int x2cmmf;    // x2c molecular mean field Hamiltonian enabled in DIRAC
     int new_sorting;
+    int presort_integrals;    // sort integrals for all the sectors in one pass
 
     /*
      * for D. Maison's integral program
@@ -360,6 +386,7 @@ struct cc_options {
      */
     int reuse_integrals_1;
     int reuse_integrals_2;
+    char integral_cache_dir[CC_MAX_PATH_LENGTH];  // persistent cache of sorted integrals ("" = disabled)
 
     /*
      * precomputed cluster amplitudes as initial guess
@@ -367,9 +394,11 @@ struct cc_options {
     int reuse_amplitudes[MAX_SECTOR_RANK][MAX_SECTOR_RANK];
 
     /*
-     * flush non-converged amplitudes to disk
+     * flush non-converged amplitudes and the restart checkpoint to disk
+     * (every do_flush_iter iterations and/or every do_flush_time seconds)
      */
     int do_flush_iter;
+    int do_flush_time;
 
     // SCF energy
     double escf;
@@ -0,0 +1,85 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Hardware performance counters (Linux perf_event_open) around the main
+ * kernels: cycles, instructions, last-level cache misses and data TLB misses
+ * aggregated per kernel.
+ *
+ * Counters are disabled by default; when they are disabled, the overhead is
+ * a single branch on the 'cc_perfcnt_enabled' flag:
+ *
+ *   perfcnt_sample_t s;
+ *   if (cc_perfcnt_enabled) {
+ *       perfcnt_read(&s);
+ *   }
+ *   . . . kernel . . .
+ *   if (cc_perfcnt_enabled) {
+ *       perfcnt_add(PERFCNT_MULBLOCKS, &s);
+ *   }
+ *
+ * Counters are per-thread: events in threads created by the BLAS library are
+ * not counted.
+ */
+
+#ifndef CC_PERFCNT_H_INCLUDED
+#define CC_PERFCNT_H_INCLUDED
+
+#include <stdint.h>
+
+// environment variable which enables hardware counters
+#define CC_PERFCNT_ENV_VAR "EXPT_PERF_COUNTERS"
+
+typedef enum {
+    PERFCNT_MULBLOCKS = 0,
+    PERFCNT_TRANSPOSE,
+    PERFCNT_DIVEPS,
+    PERFCNT_SORT_FILL,
+    PERFCNT_LZ4_COMPRESS,
+    PERFCNT_LZ4_DECOMPRESS,
+    PERFCNT_N_KERNELS
+} perfcnt_kernel_t;
+
+typedef enum {
+    PERFCNT_CYCLES = 0,
+    PERFCNT_INSTRUCTIONS,
+    PERFCNT_LLC_MISSES,
+    PERFCNT_DTLB_MISSES,
+    PERFCNT_N_EVENTS
+} perfcnt_event_t;
+
+typedef struct {
+    uint64_t values[PERFCNT_N_EVENTS];
+} perfcnt_sample_t;
+
+extern int cc_perfcnt_enabled;
+
+void perfcnt_enable();
+
+void perfcnt_read(perfcnt_sample_t *sample);
+
+void perfcnt_add(perfcnt_kernel_t kernel, perfcnt_sample_t *start);
+
+void perfcnt_print_stats();
+
+#endif /* CC_PERFCNT_H_INCLUDED */
@@ -0,0 +1,77 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Two-electron integrals produced by PySCF in the chunked layout
+ * (see scripts/pyscf_eri_chunked.py).
+ *
+ * The spinor index range [0,n) is cut into nc = ceil(n/c) chunks of c
+ * spinors. The file consists of the 64-byte header followed by nc^4 chunks
+ * (A,B,C,D) in the lexicographic order. Each chunk is a dense array
+ * v[p][q][r][s] = <pq|rs> of c^4 values (indices are local within the chunks,
+ * the chunks at the end of the range are padded with zeros), so the offset of
+ * any integral is known in advance and no index is stored.
+ *
+ * The file is mapped read-only into memory: only the pages touched by the
+ * quadruples of spinor blocks actually requested are read from disk, and the
+ * mapping can be shared by all sorting threads.
+ */
+
+#ifndef CC_PYSCF_ERI_H_INCLUDED
+#define CC_PYSCF_ERI_H_INCLUDED
+
+#include <complex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CC_PYSCF_ERI_MAGIC "EXPTERIC"
+#define CC_PYSCF_ERI_VERSION 1
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t n_spinors;
+    int32_t chunk_size;
+    int32_t value_size;         // sizeof(double) or sizeof(double complex)
+    int64_t n_chunks;           // nc^4, for checking
+    char reserved[32];
+} pyscf_eri_header_t;
+
+typedef struct {
+    int n_spinors;
+    int chunk_size;
+    int n_chunks_1d;            // chunks along one index
+    int value_size;
+    char *map_addr;             // whole file, header included
+    size_t map_size;
+} pyscf_eri_t;
+
+int pyscf_eri_read_header(char *path, pyscf_eri_header_t *header);
+
+pyscf_eri_t *pyscf_eri_open(char *path);
+
+void pyscf_eri_close(pyscf_eri_t *eri);
+
+void pyscf_eri_read_quadruple(pyscf_eri_t *eri, int *dims, int **indices, double complex *buf);
+
+#endif /* CC_PYSCF_ERI_H_INCLUDED */
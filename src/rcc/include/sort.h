@@ -43,6 +43,9 @@ void request_sorting_sym(char *name, char *qparts, char *valence, char *order, i
 // performs sorting for all the requests leaved
 void perform_sorting();
 
+// sorting for the requests of all the sectors to be visited (in one pass)
+void perform_presorting();
+
 void sort_prop(int nspinors, double complex *oper_ints);
 
 #endif /* CC_SORT_H_INCLUDED */
@@ -22,24 +22,39 @@
  */
 
 /*
- * Utility for time measurements.
+ * Utility for time measurements (hierarchical profiler).
  */
 
 #ifndef CC_TIMER_H_INCLUDED
 #define CC_TIMER_H_INCLUDED
 
+// interned timer entry (index in the table of entries)
+typedef int timer_handle_t;
+
 void timer_new_entry(char *key, char *label);
 
+timer_handle_t timer_intern(char *key, char *label);
+
 void timer_clear_all();
 
 void timer_start(char *key);
 
 void timer_stop(char *key);
 
+void timer_start_handle(timer_handle_t h);
+
+void timer_stop_handle(timer_handle_t h);
+
+void timer_add_flops(double n_flops);
+
+void timer_add_bytes(double n_bytes);
+
 double timer_get(char *key);
 
 void timer_stats();
 
+void timer_write_json(char *path);
+
 double abs_time();
 
 #endif /* CC_TIMER_H_INCLUDED */
@@ -0,0 +1,66 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Timeline of engine activity in the Chrome trace-event format
+ * (can be viewed with Perfetto or chrome://tracing).
+ *
+ * Each thread records events into its own buffer (no locks are taken when
+ * the event is recorded); the full buffer is appended to the JSON file, the
+ * rest is written at the end of the run. Tracing is disabled by default;
+ * when it is disabled, the overhead is a single branch on the flag:
+ *
+ *   double t0 = cc_trace_enabled ? abs_time() : 0.0;
+ *   . . . some code . . .
+ *   if (cc_trace_enabled) {
+ *       trace_event("engine", "mult", "t2 veff", t0, abs_time(), size, n_bytes);
+ *   }
+ *
+ * By default only coarse spans (timer regions, engine operations) are
+ * recorded. Events of individual blocks (block kernels and block i/o,
+ * millions per iteration for large systems) are guarded by the separate
+ * 'cc_trace_blocks' flag and are recorded only on request.
+ */
+
+#ifndef CC_TRACE_H_INCLUDED
+#define CC_TRACE_H_INCLUDED
+
+#include <stddef.h>
+
+// environment variable which enables tracing ("1" or path to the output file)
+#define CC_TRACE_ENV_VAR "EXPT_TRACE"
+
+// environment variable which enables events of individual blocks
+#define CC_TRACE_BLOCKS_ENV_VAR "EXPT_TRACE_BLOCKS"
+
+extern int cc_trace_enabled;
+extern int cc_trace_blocks;
+
+void trace_enable(char *path, int with_blocks);
+
+void trace_event(const char *category, const char *name, const char *args,
+                 double t_begin, double t_end, size_t size, double n_bytes);
+
+void trace_write_json();
+
+#endif /* CC_TRACE_H_INCLUDED */
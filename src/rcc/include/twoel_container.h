@@ -0,0 +1,91 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Container of two-electron integrals split into quadruples of spinor blocks.
+ *
+ * The DIRAC interface (dirac_binary.f90) accumulates integrals of each
+ * quadruple of spinor blocks <IJ|KL> in its own buffer. Instead of one file
+ * per quadruple, the flushed buffers ("chunks") are appended to a few large
+ * files ("shards"), and the list of chunks is stored in the index file:
+ *
+ *   <prefix>.<shard>.dat  chunks: [int64 len1][int64 len2][indices][values],
+ *                         indices and values are compressed frames if the
+ *                         container is compressed (see io_compress_buffer())
+ *   <prefix>.idx          header + extents (quadruple, shard, offset, length)
+ *
+ * All chunks of a quadruple go to the same shard. The index is written last,
+ * so the container is complete if the index exists. Chunks are read with
+ * pread(), thus one opened container can be shared by all sorting threads.
+ */
+
+#ifndef CC_TWOEL_CONTAINER_H_INCLUDED
+#define CC_TWOEL_CONTAINER_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CC_TWOEL_CONTAINER_MAX_SHARDS 8
+
+typedef struct {
+    int32_t spinor_blocks[4];   // numeration from 1 (as in the DIRAC interface)
+    int32_t shard;
+    int32_t nint;               // number of integrals in the chunk
+    int64_t offset;
+    int64_t length;             // length of the chunk in the shard file, bytes
+} twoel_extent_t;
+
+typedef struct {
+    int n_shards;
+    int compressed;
+    int value_size;             // sizeof(double) or sizeof(double complex)
+    int fd[CC_TWOEL_CONTAINER_MAX_SHARDS];
+    int64_t n_extents;
+    twoel_extent_t *extents;    // sorted by quadruples, in order of writing
+    int64_t max_length;         // the longest chunk
+} twoel_container_t;
+
+// writing (one container at a time, called from the Fortran code)
+
+void twoel_container_create(char *prefix);
+
+void twoel_container_append(int32_t sb1, int32_t sb2, int32_t sb3, int32_t sb4,
+                            int32_t nint, int16_t *indices, void *values, int32_t value_size);
+
+void twoel_container_finalize();
+
+// reading
+
+twoel_container_t *twoel_container_open(char *prefix);
+
+void twoel_container_close(twoel_container_t *cont);
+
+twoel_extent_t *twoel_container_lookup(twoel_container_t *cont, int sb1, int sb2, int sb3, int sb4,
+                                       int64_t *n_extents);
+
+size_t twoel_container_quadruple_size(twoel_container_t *cont, int sb1, int sb2, int sb3, int sb4);
+
+void twoel_container_read(twoel_container_t *cont, twoel_extent_t *ext, char *scratch,
+                          int16_t *indices, void *values);
+
+#endif /* CC_TWOEL_CONTAINER_H_INCLUDED */
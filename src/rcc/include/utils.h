@@ -34,6 +34,9 @@
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #define MAX(a,b) (((a)>(b))?(a):(b))
 
+// initial value of the FNV-1a hash
+#define FNV1A_OFFSET_BASIS 14695981039346656037ULL
+
 void decompose_time(double t, int *d, int *h, int *m, int *s, int *ms);
 
 enum {
@@ -105,4 +108,6 @@ int str_to_int_array(char *str, int *array);
 
 int int_array_to_str(int n, const int *array, char *str);
 
+uint64_t fnv1a_hash(uint64_t h, const void *data, size_t count);
+
 #endif /* CC_UTILS_H_INCLUDED */
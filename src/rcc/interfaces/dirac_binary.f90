@@ -98,6 +98,18 @@ module c_io
             type(c_ptr), value :: buf
             integer(c_size_t), value :: sz
         end function io_write_compressed
+        ! containers of integrals: see twoel_container.h
+        subroutine twoel_container_create(prefix) bind(C, name = "twoel_container_create")
+            character, dimension(*) :: prefix
+        end subroutine twoel_container_create
+        subroutine twoel_container_append(sb1, sb2, sb3, sb4, nint, indices, values, value_size) &
+                bind(C, name = "twoel_container_append")
+            use iso_c_binding
+            integer(4), value :: sb1, sb2, sb3, sb4, nint, value_size
+            type(c_ptr), value :: indices, values
+        end subroutine twoel_container_append
+        subroutine twoel_container_finalize() bind(C, name = "twoel_container_finalize")
+        end subroutine twoel_container_finalize
         subroutine c_asctime() bind(C, name = "c_asctime")
         end subroutine c_asctime
     end interface
@@ -267,6 +279,8 @@ end module spinor_blocks
 ! for all possible non-zero 4d integral blocks we have an individual I/O buffer.
 ! only really used buffers are stored; if no buffer for integral block IJKL is
 ! provided, outbuf_idx(I,J,K,L) == 0.
+! full buffers are appended to the single container of integrals
+! (files <prefix>.*.dat + index <prefix>.idx, see twoel_container.h).
 ! ******************************************************************************
 module output_buffers
 
@@ -287,8 +301,6 @@ module output_buffers
     integer(2), dimension(:, :), allocatable, target :: buf_indices
     ! current number of integrals in each buffer
     integer(4), dimension(:), allocatable, target :: buf_nint
-    ! == 1 if the buffer was already used; else == 0
-    logical, dimension(:), allocatable :: buf_flushed
     ! total number of bytes written
     integer(8) :: nbytes_written = 0
     ! prefix -- used in names of files with integrals
@@ -300,6 +312,8 @@ contains
     subroutine init_output_buffers(prefix, nspi, nsymrpa, irpamo, repanames, tilesz, multb)
         use general
         use spinor_blocks
+        use iso_c_binding
+        use c_io
         character(len = *), intent(in) :: prefix
         integer(4) :: nspi, nsymrpa, irpamo(nspi), tilesz
         integer(4) :: i1, i2, i3, i4
@@ -363,9 +377,9 @@ contains
         end if
         allocate(buf_indices(4 * BUF_SIZE, n_outbuf)) ! I/O buffer for quadruples of indices
         allocate(buf_nint(n_outbuf))               ! number of int-s in each buffer
-        allocate(buf_flushed(n_outbuf))
         buf_nint = 0
-        buf_flushed = .FALSE.
+
+        call twoel_container_create(trim(files_prefix) // C_NULL_CHAR)
 
     end subroutine init_output_buffers
 
@@ -374,19 +388,12 @@ contains
     subroutine delete_output_buffers()
         use general
         use spinor_blocks
-        use iso_c_binding
         use c_io
-        integer(4) :: fd, status
-        integer(4), target :: nint
         integer(4) :: ibuf, sb1, sb2, sb3, sb4
-        character(len = 100) :: filename
-        integer(8) :: sizeof_int2 = 2
-        integer(8) :: sizeof_int4 = 4
-        integer(8) :: sizeof_complex8 = 16
-        integer(8) :: sizeof_real8 = 8
-        integer(4) :: stat
-        integer(8) :: n_vint_files = 0
+        integer(8) :: n_blocks_written
 
+        ! flush the rest of integrals
+        n_blocks_written = 0
         do sb1 = 1, n_spinor_blocks
             do sb2 = 1, n_spinor_blocks
                 do sb3 = 1, n_spinor_blocks
@@ -395,28 +402,17 @@ contains
                         if (ibuf == 0) then
                             cycle
                         end if
-
-                        write (filename, "(a,a1,i0,a1,i0,a1,i0,a1,i0,a1)") trim(files_prefix), &
-                                "-", sb1, "-", sb2, "-", sb3, "-", sb4
-                        if (.not. buf_flushed(ibuf)) then
-                            open(unit = 1234, iostat = stat, file = filename, status = 'old')
-                            if (stat == 0) close(1234, status = 'delete')
-                        end if
-                        n_vint_files = n_vint_files + 1
-
+                        n_blocks_written = n_blocks_written + 1
                         call flush_buf(sb1, sb2, sb3, sb4)
-
-                        ! terminate file with zero
-                        nint = 0
-                        fd = io_open(trim(filename) // C_NULL_CHAR, "a" // C_NULL_CHAR)
-                        status = io_write_compressed(fd, c_loc(nint), sizeof_int4)
-                        status = io_close(fd)
                     end do
                 end do
             end do
         end do
 
-        print *, 'number of VINT* files written ', n_vint_files
+        call twoel_container_finalize()
+
+        print '(a,i0,a,a,a)', ' number of integral blocks written ', n_blocks_written, &
+                ' (', trim(files_prefix), '.*)'
         print '(a,i0,a,f7.2,a)', ' written to disk: ', nbytes_written, &
                 ' bytes = ', nbytes_written / (1024.0**3), ' Gb'
 
@@ -428,13 +424,12 @@ contains
         end if
         deallocate(buf_indices)
         deallocate(buf_nint)
-        deallocate(buf_flushed)
 
     end subroutine delete_output_buffers
 
 
     ! puts integral with indices <i1,i2|i3,i4> with value 'val'
-    ! to the appropriate file VINT-*
+    ! to the buffer of the appropriate integral block
     subroutine put_integral(i1, i2, i3, i4, val)
         use general
         use spinor_blocks
@@ -456,7 +451,6 @@ contains
         nint = buf_nint(ibuf)
 
         ! flush buffer if needed
-        ! "VINT-*" file must be truncated if opened for the first time
         if (nint == BUF_SIZE) then
             call flush_buf(sb1, sb2, sb3, sb4)
             nint = 0
@@ -482,39 +476,29 @@ contains
         use c_io
         integer(4), intent(in) :: sb1, sb2, sb3, sb4
         integer(4) :: ibuf
-        integer(4), target :: nint
-        character(len = 100) :: filename
-        integer(8), parameter :: sizeof_int2 = 2
-        integer(8), parameter :: sizeof_int4 = 4
-        integer(8), parameter :: sizeof_complex8 = 16
-        integer(8), parameter :: sizeof_real8 = 8
-        integer(4) :: stat
-        integer(4) :: fd
+        integer(4) :: nint
+        integer(4), parameter :: sizeof_int2 = 2
+        integer(4), parameter :: sizeof_complex8 = 16
+        integer(4), parameter :: sizeof_real8 = 8
 
         ibuf = outbuf_idx(sb1, sb2, sb3, sb4)
         if (ibuf == 0) then
             return
         end if
         nint = buf_nint(ibuf)
-
-        write (filename, "(a,a1,i0,a1,i0,a1,i0,a1,i0,a1)") trim(files_prefix), "-", sb1, "-", sb2, "-", sb3, "-", sb4
-        if (.not. buf_flushed(ibuf)) then
-            open(unit = 1234, iostat = stat, file = filename, status = 'old')
-            if (stat == 0) close(1234, status = 'delete')
+        if (nint == 0) then
+            return
         end if
-        buf_flushed(ibuf) = .TRUE.
-        fd = io_open(trim(filename) // C_NULL_CHAR, "a" // C_NULL_CHAR)
-        stat = io_write_compressed(fd, c_loc(nint), sizeof_int4)
-        stat = io_write_compressed(fd, c_loc(buf_indices(:, ibuf)), 4 * nint * sizeof_int2)
-        nbytes_written = nbytes_written + sizeof_int4 + 4 * nint * sizeof_int2
+
         if (carith) then
-            stat = io_write_compressed(fd, c_loc(buf_vint(:, ibuf)), nint * sizeof_complex8)
-            nbytes_written = nbytes_written + nint * sizeof_complex8
+            call twoel_container_append(sb1, sb2, sb3, sb4, nint, c_loc(buf_indices(:, ibuf)), &
+                    c_loc(buf_vint(:, ibuf)), sizeof_complex8)
+            nbytes_written = nbytes_written + int(nint, 8) * (4 * sizeof_int2 + sizeof_complex8)
         else
-            stat = io_write_compressed(fd, c_loc(buf_vint_re(:, ibuf)), nint * sizeof_real8)
-            nbytes_written = nbytes_written + nint * sizeof_real8
+            call twoel_container_append(sb1, sb2, sb3, sb4, nint, c_loc(buf_indices(:, ibuf)), &
+                    c_loc(buf_vint_re(:, ibuf)), sizeof_real8)
+            nbytes_written = nbytes_written + int(nint, 8) * (4 * sizeof_int2 + sizeof_real8)
         end if
-        stat = io_close(fd)
         buf_nint(ibuf) = 0
 
     end subroutine flush_buf
@@ -582,7 +566,7 @@ end module dirac_32_64_compatibility
 ! "main" subroutine of this file. subroutine is invoked from the C code (file
 ! dirac_interface.c).
 ! reads info about 1-particle functions from the MRCONEE file,
-! splits the MDCINT file into integral blocks (files VINT-*)
+! splits the MDCINT file into integral blocks (container VINT.*)
 ! ******************************************************************************
 subroutine dirac_interface_binary(err) bind(C)
 
@@ -0,0 +1,192 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Reader of the chunked PySCF two-electron integrals (see pyscf_eri.h).
+ */
+
+// mmap(), madvise()
+#define _DEFAULT_SOURCE
+
+#include "pyscf_eri.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+
+
+/*******************************************************************************
+ * pyscf_eri_read_header
+ *
+ * Returns 1 if the file exists and has the header of the chunked layout,
+ * 0 otherwise (the file can be in the old dense layout).
+ ******************************************************************************/
+int pyscf_eri_read_header(char *path, pyscf_eri_header_t *header)
+{
+    if (!io_file_exists(path) || io_fsize(path) < sizeof(pyscf_eri_header_t)) {
+        return 0;
+    }
+
+    int fd = io_open(path, "r");
+    io_read(fd, header, sizeof(pyscf_eri_header_t));
+    io_close(fd);
+
+    return memcmp(header->magic, CC_PYSCF_ERI_MAGIC, sizeof(header->magic)) == 0;
+}
+
+
+/*******************************************************************************
+ * pyscf_eri_open
+ *
+ * Checks the header and maps the file into memory.
+ * Returns NULL if the file is not in the chunked layout.
+ ******************************************************************************/
+pyscf_eri_t *pyscf_eri_open(char *path)
+{
+    pyscf_eri_header_t header;
+
+    if (!pyscf_eri_read_header(path, &header)) {
+        return NULL;
+    }
+
+    int64_t n = header.n_spinors;
+    int64_t c = header.chunk_size;
+    int64_t nc = (c > 0) ? (n + c - 1) / c : 0;
+    size_t expected_size = sizeof(pyscf_eri_header_t) + nc * nc * nc * nc * c * c * c * c * header.value_size;
+
+    if (header.version != CC_PYSCF_ERI_VERSION || n <= 0 || c <= 0 ||
+        (header.value_size != sizeof(double) && header.value_size != sizeof(double complex)) ||
+        header.n_chunks != nc * nc * nc * nc) {
+        errquit("pyscf_eri_open(): file '%s' is not a valid file of chunked two-electron integrals", path);
+    }
+    if (io_fsize(path) != expected_size) {
+        errquit("pyscf_eri_open(): file '%s' is truncated (%zu bytes expected, %zu found)",
+                path, expected_size, io_fsize(path));
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        errquit("pyscf_eri_open(): cannot open file '%s'", path);
+    }
+
+    // mapped bytes are taken into account by the memory allocator (as in block_map())
+    cc_account_external(expected_size);
+    void *addr = mmap(NULL, expected_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        cc_release_external(expected_size);
+        errquit("pyscf_eri_open(): cannot map file '%s' into memory", path);
+    }
+
+    // quadruples are read in the order of the first spinor block, but
+    // the chunks of the other three indices are scattered over the file
+    madvise(addr, expected_size, MADV_RANDOM);
+
+    pyscf_eri_t *eri = (pyscf_eri_t *) cc_malloc(sizeof(pyscf_eri_t));
+    eri->n_spinors = header.n_spinors;
+    eri->chunk_size = header.chunk_size;
+    eri->n_chunks_1d = (int) nc;
+    eri->value_size = header.value_size;
+    eri->map_addr = (char *) addr;
+    eri->map_size = expected_size;
+
+    return eri;
+}
+
+
+void pyscf_eri_close(pyscf_eri_t *eri)
+{
+    if (eri == NULL) {
+        return;
+    }
+
+    io_munmap(eri->map_addr, eri->map_size);
+    cc_release_external(eri->map_size);
+    cc_free(eri);
+}
+
+
+/*******************************************************************************
+ * pyscf_eri_read_quadruple
+ *
+ * buf[i][j][k][l] = <pq|rs>, p = indices[0][i], q = indices[1][j], etc.
+ * (global spinor indices, from 0). Integrals are gathered from the mapped
+ * chunks; the offset along each index is split into the chunk part and the
+ * part within the chunk, both are computed once per index.
+ * Serial: quadruples are read concurrently by the sorting threads.
+ ******************************************************************************/
+void pyscf_eri_read_quadruple(pyscf_eri_t *eri, int *dims, int **indices, double complex *buf)
+{
+    size_t c = eri->chunk_size;
+    size_t nc = eri->n_chunks_1d;
+    size_t chunk_len = c * c * c * c;
+
+    // offsets (in values) of the index in the chunk grid and inside the chunk
+    size_t *offsets[4];
+    size_t strides_chunk[4] = {nc * nc * nc * chunk_len, nc * nc * chunk_len, nc * chunk_len, chunk_len};
+    size_t strides_local[4] = {c * c * c, c * c, c, 1};
+    for (int k = 0; k < 4; k++) {
+        offsets[k] = (size_t *) cc_malloc(sizeof(size_t) * (dims[k] + 1));
+        for (int i = 0; i < dims[k]; i++) {
+            size_t p = indices[k][i];
+            offsets[k][i] = (p / c) * strides_chunk[k] + (p % c) * strides_local[k];
+        }
+    }
+
+    const char *data = eri->map_addr + sizeof(pyscf_eri_header_t);
+    int dims_1 = dims[0];
+    int dims_2 = dims[1];
+    int dims_3 = dims[2];
+    int dims_4 = dims[3];
+
+    for (int i = 0; i < dims_1; i++) {
+        for (int j = 0; j < dims_2; j++) {
+            for (int k = 0; k < dims_3; k++) {
+                size_t base = offsets[0][i] + offsets[1][j] + offsets[2][k];
+                double complex *dst = buf + (((size_t) i * dims_2 + j) * dims_3 + k) * dims_4;
+                if (eri->value_size == sizeof(double complex)) {
+                    const double complex *src = (const double complex *) data + base;
+                    for (int l = 0; l < dims_4; l++) {
+                        dst[l] = src[offsets[3][l]];
+                    }
+                }
+                else {
+                    const double *src = (const double *) data + base;
+                    for (int l = 0; l < dims_4; l++) {
+                        dst[l] = src[offsets[3][l]] + 0.0 * I;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        cc_free(offsets[k]);
+    }
+}
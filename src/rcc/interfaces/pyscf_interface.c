@@ -32,6 +32,7 @@
 #include "engine.h"
 #include "error.h"
 #include "options.h"
+#include "pyscf_eri.h"
 #include "spinors.h"
 #include "symmetry.h"
 #include "timer.h"
@@ -48,6 +49,9 @@ void check_irrep_names();
 double complex *pyscf_unique_eri = NULL;
 size_t *pyscf_eri_index = NULL;
 
+// two-electron integrals are in the chunked layout (see pyscf_eri.h)
+int pyscf_chunked_eri = 0;
+
 
 void pyscf_interface(cc_options_t *opts)
 {
@@ -76,11 +80,31 @@ void pyscf_interface(cc_options_t *opts)
     opts->enuc = enuc;
     opts->escf = escf;
 
-    printf(" switching tile size to %d\n", CC_MAX_SPINORS);
-    opts->tile_size = CC_MAX_SPINORS;
+    /*
+     * integrals in the chunked layout are sorted into the tiles as usual,
+     * the old dense files fit only the diagrams made of a single block
+     */
+    pyscf_eri_header_t eri_header;
+    pyscf_chunked_eri = pyscf_eri_read_header(opts->integral_file_2, &eri_header);
+    if (pyscf_chunked_eri) {
+        if (eri_header.n_spinors != nspinors) {
+            errquit("number of spinors in '%s' (%d) differs from that in '%s' (%d)",
+                    opts->integral_file_2, eri_header.n_spinors, opts->integral_file_1, nspinors);
+        }
+        if (opts->use_goldstone) {
+            errquit("the Goldstone formalism requires two-electron integrals in the dense layout");
+        }
+        printf(" file with two-electron integrals: %s\n", opts->integral_file_2);
+        printf(" chunked layout, chunk size = %d, %s values\n", eri_header.chunk_size,
+               eri_header.value_size == sizeof(double) ? "real" : "complex");
+    }
+    else {
+        printf(" switching tile size to %d\n", CC_MAX_SPINORS);
+        opts->tile_size = CC_MAX_SPINORS;
 
-    printf(" switching openmp parallalization algorithm to 'internal'\n");
-    opts->openmp_algorithm = CC_OPENMP_ALGORITHM_INTERNAL;
+        printf(" switching openmp parallalization algorithm to 'internal'\n");
+        opts->openmp_algorithm = CC_OPENMP_ALGORITHM_INTERNAL;
+    }
 
     /*
      * complex arithmetic
@@ -0,0 +1,479 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Synthetic molecular systems: spinor spaces of the given size and symmetry
+ * together with the fabricated one- and two-electron integrals. No integral
+ * files are required, so sorting, the CC models and the FS sectors can be
+ * tested and benchmarked at any scale.
+ *
+ * Input file (passed by the 'integrals' directive, 'interface synthetic'):
+ *
+ *   # comment
+ *   group    Z4              # Z<n> (C1 = Z1), Cinfv or Dinfh
+ *   arith    complex         # real | complex
+ *   spinors  A0  10  40      # irrep, number of occupied and virtual spinors
+ *   spinors  A1  10  40      # (one line per irrep)
+ *   eps_occ  -2.0  -0.5      # range of orbital energies of occupied spinors
+ *   eps_virt  0.1   5.0      # range of orbital energies of virtual spinors
+ *   decay    0.5             # <pq|rs> ~ exp(-decay*(|e_p-e_r| + |e_q-e_s|))
+ *   scale    0.05            # magnitude of integrals
+ *   seed     2018
+ *   enuc     0.0             # nuclear repulsion energy
+ *
+ * Symmetry groups: for Z<n> the abelian double group Z_n x Z_2 is used,
+ * there are n fermion irreps A0 ... A(n-1) and n boson irreps a0 ... a(n-1),
+ * the product of irreps with indices i and j has index (i + j) mod n.
+ * For Cinfv and Dinfh the extended groups are generated as in the DIRAC
+ * interface (see symmetry.c).
+ *
+ * Fock matrix is diagonal (canonical HF spinors). Two-electron integrals are
+ * pseudo-random numbers of random phase which satisfy the permutational
+ * symmetry <pq|rs> = <qp|sr> = <rs|pq>*, so the result of the calculation
+ * does not depend on the order in which integrals are requested.
+ */
+
+#include "interfaces.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "options.h"
+#include "spinors.h"
+#include "symmetry.h"
+#include "timer.h"
+
+#define SYNTHETIC_MAX_LINE 1024
+#define SYNTHETIC_TWO_PI 6.28318530717958647692
+
+typedef struct {
+    char group[MAX_IRREP_NAME];
+    int complex_arith;
+    int n_irreps_spec;
+    char irrep_names[CC_MAX_NUM_IRREPS][MAX_IRREP_NAME];
+    int nocc[CC_MAX_NUM_IRREPS];
+    int nvirt[CC_MAX_NUM_IRREPS];
+    double eps_occ[2];
+    double eps_virt[2];
+    double decay;
+    double scale;
+    uint64_t seed;
+    double enuc;
+} synthetic_spec_t;
+
+static synthetic_spec_t spec;
+
+void check_irrep_names();
+
+static void set_default_spec(synthetic_spec_t *s);
+
+static void read_spec(char *path, synthetic_spec_t *s);
+
+static void setup_system(cc_options_t *opts, synthetic_spec_t *s);
+
+static void setup_group(synthetic_spec_t *s);
+
+static double synthetic_escf();
+
+static int compare_indices(int *idx_1, int *idx_2);
+
+
+/**
+ * Interface mode CC_INTEGRALS_SYNTHETIC: sets up the system described in the
+ * input file opts->integral_file_1. Integrals are generated on the fly by
+ * the sorting module (see synthetic_eri()).
+ */
+void synthetic_interface(cc_options_t *opts)
+{
+    timer_new_entry("synthetic", "Synthetic system setup");
+    timer_start("synthetic");
+    printf("\n begin interface to the synthetic integral generator\n");
+    printf(" file with the description of the system: %s\n", opts->integral_file_1);
+
+    set_default_spec(&spec);
+    read_spec(opts->integral_file_1, &spec);
+    setup_system(opts, &spec);
+
+    opts->enuc = spec.enuc;
+    opts->escf = synthetic_escf();
+
+    printf(" number of spinors = %d\n", get_num_spinors());
+    printf(" number of occupied spinors = %d\n", get_num_electrons());
+    printf(" integral decay rate = %g, magnitude = %g, seed = %lu\n", spec.decay, spec.scale, (unsigned long) spec.seed);
+    printf(" nuclear repulsion energy = %.16f\n", opts->enuc);
+    printf(" scf energy = %.16f\n", opts->escf);
+    printf(" end interface to the synthetic integral generator\n\n");
+
+    print_symmetry_info();
+    print_spinor_info_table();
+    check_irrep_names();
+
+    timer_stop("synthetic");
+}
+
+
+/**
+ * Sets up the synthetic spinor space only (no integrals), group Z_n x Z_2.
+ * Spinors are distributed over the fermion irreps in a round-robin manner.
+ * Is used by the expt_bench program to generate layouts of diagrams which are
+ * representative of the real-world calculations.
+ */
+void synthetic_setup_spinors(cc_options_t *opts, int n_irreps, int nocc, int nvirt, int complex_arith)
+{
+    if (n_irreps <= 0 || 2 * n_irreps > CC_MAX_NUM_IRREPS) {
+        errquit("synthetic_setup_spinors(): wrong number of irreps %d (must be 1 ... %d)",
+                n_irreps, CC_MAX_NUM_IRREPS / 2);
+    }
+    if (nocc < n_irreps || nvirt < n_irreps) {
+        errquit("synthetic_setup_spinors(): too few spinors (nocc = %d, nvirt = %d) for %d irreps",
+                nocc, nvirt, n_irreps);
+    }
+
+    set_default_spec(&spec);
+    sprintf(spec.group, "Z%d", n_irreps);
+    spec.complex_arith = complex_arith;
+    spec.n_irreps_spec = n_irreps;
+    for (int i = 0; i < n_irreps; i++) {
+        sprintf(spec.irrep_names[i], "A%d", i);
+        spec.nocc[i] = nocc / n_irreps + (i < nocc % n_irreps);
+        spec.nvirt[i] = nvirt / n_irreps + (i < nvirt % n_irreps);
+    }
+
+    setup_system(opts, &spec);
+}
+
+
+/**
+ * Two-electron integral <pq|rs> (physicists' notation, not antisymmetrized,
+ * absolute spinor indices).
+ * Can be called from any thread.
+ */
+double complex synthetic_eri(int p, int q, int r, int s)
+{
+    /*
+     * canonical representative of the orbit {pqrs, qpsr} U {rspq, srqp};
+     * integrals from the second half are complex conjugated
+     */
+    int orbit[4][4] = {
+            {p, q, r, s},
+            {q, p, s, r},
+            {r, s, p, q},
+            {s, r, q, p}
+    };
+    int imin = 0;
+    for (int i = 1; i < 4; i++) {
+        if (compare_indices(orbit[i], orbit[imin]) < 0) {
+            imin = i;
+        }
+    }
+    int *c = orbit[imin];
+    int conjugate = (imin >= 2);
+    int self_conjugate = (compare_indices(orbit[0], orbit[2]) == 0 || compare_indices(orbit[0], orbit[3]) == 0);
+
+    // pseudo-random numbers: splitmix64 hash of the canonical indices
+    uint64_t h = spec.seed;
+    for (int k = 0; k < 4; k++) {
+        h += (uint64_t) c[k] + 0x9e3779b97f4a7c15ull;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        h = h ^ (h >> 31);
+    }
+    double u1 = (double) (h >> 40) / (double) (1ull << 24);
+    double u2 = (double) (h & 0xffffffull) / (double) (1ull << 24);
+
+    double de = fabs(spinor_info[p].eps - spinor_info[r].eps) + fabs(spinor_info[q].eps - spinor_info[s].eps);
+    double magnitude = spec.scale * (0.5 + u1) * exp(-spec.decay * de);
+
+    if (arith == CC_ARITH_REAL || self_conjugate) {
+        return (u2 < 0.5) ? -magnitude : magnitude;
+    }
+
+    double complex v = magnitude * cexp(SYNTHETIC_TWO_PI * u2 * I);
+    return conjugate ? conj(v) : v;
+}
+
+
+static void set_default_spec(synthetic_spec_t *s)
+{
+    memset(s, 0, sizeof(synthetic_spec_t));
+    strcpy(s->group, "Z1");
+    s->complex_arith = 1;
+    s->eps_occ[0] = -2.0;
+    s->eps_occ[1] = -0.5;
+    s->eps_virt[0] = 0.1;
+    s->eps_virt[1] = 5.0;
+    s->decay = 0.5;
+    s->scale = 0.05;
+    s->seed = 2018;
+    s->enuc = 0.0;
+}
+
+
+static void read_spec(char *path, synthetic_spec_t *s)
+{
+    char line[SYNTHETIC_MAX_LINE];
+    char key[SYNTHETIC_MAX_LINE];
+    char word[SYNTHETIC_MAX_LINE];
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        errquit("synthetic interface: unable to open file '%s'", path);
+    }
+
+    int line_no = 0;
+    while (fgets(line, SYNTHETIC_MAX_LINE, f) != NULL) {
+        line_no++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (sscanf(line, "%s", key) != 1) {
+            continue;
+        }
+
+        int ok = 1;
+        if (strcmp(key, "group") == 0) {
+            ok = sscanf(line, "%*s %63s", s->group) == 1;
+        }
+        else if (strcmp(key, "arith") == 0) {
+            ok = sscanf(line, "%*s %s", word) == 1 && (strcmp(word, "real") == 0 || strcmp(word, "complex") == 0);
+            s->complex_arith = (strcmp(word, "complex") == 0);
+        }
+        else if (strcmp(key, "spinors") == 0) {
+            int i = s->n_irreps_spec;
+            if (i == CC_MAX_NUM_IRREPS) {
+                errquit("synthetic interface: too many irreps (max %d)", CC_MAX_NUM_IRREPS);
+            }
+            ok = sscanf(line, "%*s %63s %d %d", s->irrep_names[i], &s->nocc[i], &s->nvirt[i]) == 3 &&
+                 s->nocc[i] >= 0 && s->nvirt[i] >= 0;
+            s->n_irreps_spec++;
+        }
+        else if (strcmp(key, "eps_occ") == 0) {
+            ok = sscanf(line, "%*s %lf %lf", &s->eps_occ[0], &s->eps_occ[1]) == 2 && s->eps_occ[0] < s->eps_occ[1];
+        }
+        else if (strcmp(key, "eps_virt") == 0) {
+            ok = sscanf(line, "%*s %lf %lf", &s->eps_virt[0], &s->eps_virt[1]) == 2 && s->eps_virt[0] < s->eps_virt[1];
+        }
+        else if (strcmp(key, "decay") == 0) {
+            ok = sscanf(line, "%*s %lf", &s->decay) == 1 && s->decay >= 0.0;
+        }
+        else if (strcmp(key, "scale") == 0) {
+            ok = sscanf(line, "%*s %lf", &s->scale) == 1;
+        }
+        else if (strcmp(key, "seed") == 0) {
+            unsigned long seed;
+            ok = sscanf(line, "%*s %lu", &seed) == 1;
+            s->seed = seed;
+        }
+        else if (strcmp(key, "enuc") == 0) {
+            ok = sscanf(line, "%*s %lf", &s->enuc) == 1;
+        }
+        else {
+            errquit("synthetic interface: unknown keyword '%s' (file '%s', line %d)", key, path, line_no);
+        }
+
+        if (!ok) {
+            errquit("synthetic interface: wrong arguments of '%s' (file '%s', line %d)", key, path, line_no);
+        }
+    }
+
+    fclose(f);
+
+    if (s->n_irreps_spec == 0) {
+        errquit("synthetic interface: no spinors specified in '%s'", path);
+    }
+    if (s->eps_occ[1] >= s->eps_virt[0]) {
+        errquit("synthetic interface: occupied and virtual energy ranges overlap");
+    }
+}
+
+
+/*
+ * symmetry, arithmetic, spinors and their blocks
+ */
+static void setup_system(cc_options_t *opts, synthetic_spec_t *s)
+{
+    if (s->complex_arith) {
+        arith = CC_ARITH_COMPLEX;
+        WORKING_TYPE = CC_DOUBLE_COMPLEX;
+        SIZEOF_WORKING_TYPE = sizeof(double complex);
+    }
+    else {
+        arith = CC_ARITH_REAL;
+        WORKING_TYPE = CC_DOUBLE;
+        SIZEOF_WORKING_TYPE = sizeof(double);
+    }
+
+    setup_group(s);
+
+    /*
+     * orbital energies are spread uniformly over the given ranges;
+     * spinors of different irreps are interleaved in energy,
+     * inside each irrep spinors are ordered by energy (as in DIRAC)
+     */
+    int nspinors = 0;
+    for (int i = 0; i < s->n_irreps_spec; i++) {
+        nspinors += s->nocc[i] + s->nvirt[i];
+    }
+    if (nspinors == 0 || nspinors > CC_MAX_SPINORS) {
+        errquit("synthetic interface: wrong number of spinors %d (max %d)", nspinors, CC_MAX_SPINORS);
+    }
+
+    int *irreps = cc_calloc(nspinors, sizeof(int));
+    double *eps = cc_calloc(nspinors, sizeof(double));
+    int *occ = cc_calloc(nspinors, sizeof(int));
+
+    int ispinor = 0;
+    for (int i = 0; i < s->n_irreps_spec; i++) {
+        int irep = get_rep_number(s->irrep_names[i]);
+        if (irep == -1) {
+            errquit("synthetic interface: irrep '%s' is not found in the group %s", s->irrep_names[i], s->group);
+        }
+        double shift = (i + 0.5) / s->n_irreps_spec;
+        for (int k = 0; k < s->nocc[i]; k++) {
+            irreps[ispinor] = irep;
+            eps[ispinor] = s->eps_occ[0] + (s->eps_occ[1] - s->eps_occ[0]) * (k + shift) / s->nocc[i];
+            occ[ispinor] = 1;
+            ispinor++;
+        }
+        for (int k = 0; k < s->nvirt[i]; k++) {
+            irreps[ispinor] = irep;
+            eps[ispinor] = s->eps_virt[0] + (s->eps_virt[1] - s->eps_virt[0]) * (k + shift) / s->nvirt[i];
+            occ[ispinor] = 0;
+            ispinor++;
+        }
+    }
+
+    create_spinor_info(nspinors, irreps, eps, occ);
+
+    create_spinor_blocks(opts->tile_size);
+    setup_occupation_numbers(opts, nspinors, spinor_info);
+    setup_active_space(opts);
+    setup_fast_access_spinor_lists();
+
+    cc_free(irreps);
+    cc_free(eps);
+    cc_free(occ);
+}
+
+
+static void setup_group(synthetic_spec_t *s)
+{
+    int nsym = 0;
+    int irrep_a1 = 0;
+    int *mult_table = NULL;
+    char **rep_names = NULL;
+    int group_type = s->complex_arith ? CC_GROUP_COMPLEX : CC_GROUP_REAL;
+
+    if (strcmp(s->group, "Cinfv") == 0) {
+        int max_omega_x2 = CC_MAX_NUM_IRREPS / 2 - 2;
+        rep_names = generate_irreps_Cinfv(max_omega_x2, &nsym);
+        irrep_a1 = search_string("0", rep_names, nsym);
+        mult_table = construct_direct_product_table(nsym, rep_names, multiply_irreps_Cinfv);
+    }
+    else if (strcmp(s->group, "Dinfh") == 0) {
+        int max_omega_x2 = CC_MAX_NUM_IRREPS / 4 - 2;
+        rep_names = generate_irreps_Dinfh(max_omega_x2, &nsym);
+        irrep_a1 = search_string("0g", rep_names, nsym);
+        mult_table = construct_direct_product_table(nsym, rep_names, multiply_irreps_Dinfh);
+    }
+    else if (strcmp(s->group, "C1") == 0 || s->group[0] == 'Z') {
+        // Z_n x Z_2: fermion irreps go first, then bosons; totally symmetric irrep is a0
+        int n = (strcmp(s->group, "C1") == 0) ? 1 : atoi(s->group + 1);
+        if (n <= 0 || 2 * n > CC_MAX_NUM_IRREPS) {
+            errquit("synthetic interface: wrong group '%s' (Z1 ... Z%d are allowed)", s->group, CC_MAX_NUM_IRREPS / 2);
+        }
+        nsym = 2 * n;
+        irrep_a1 = n;
+
+        mult_table = cc_calloc(nsym * nsym, sizeof(int));
+        for (int i = 0; i < nsym; i++) {
+            for (int j = 0; j < nsym; j++) {
+                int is_boson = (i / n) == (j / n);
+                int k = (i % n + j % n) % n;
+                mult_table[i * nsym + j] = is_boson ? n + k : k;
+            }
+        }
+
+        rep_names = cc_calloc(nsym, sizeof(char *));
+        for (int i = 0; i < n; i++) {
+            char name[MAX_IRREP_NAME];
+            sprintf(name, "A%d", i);
+            rep_names[i] = cc_strdup(name);
+            sprintf(name, "a%d", i);
+            rep_names[n + i] = cc_strdup(name);
+        }
+    }
+    else {
+        errquit("synthetic interface: unknown group '%s' (Z<n>, C1, Cinfv and Dinfh are allowed)", s->group);
+    }
+
+    setup_symmetry(group_type, s->group, nsym, rep_names, irrep_a1, mult_table);
+
+    cc_free(mult_table);
+}
+
+
+/*
+ * energy of the reference determinant:
+ * E = E_nuc + sum_i e_i - 1/2 sum_ij <ij||ij>
+ */
+static double synthetic_escf()
+{
+    int nspinors = get_num_spinors();
+    double escf = spec.enuc;
+
+    for (int i = 0; i < nspinors; i++) {
+        if (!is_hole(i)) {
+            continue;
+        }
+        escf += spinor_info[i].eps;
+        for (int j = 0; j < nspinors; j++) {
+            if (is_hole(j)) {
+                escf -= 0.5 * creal(synthetic_eri(i, j, i, j) - synthetic_eri(i, j, j, i));
+            }
+        }
+    }
+
+    return escf;
+}
+
+
+/*
+ * lexicographical comparison of two quadruples of indices
+ */
+static int compare_indices(int *idx_1, int *idx_2)
+{
+    for (int k = 0; k < 4; k++) {
+        if (idx_1[k] != idx_2[k]) {
+            return (idx_1[k] < idx_2[k]) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,357 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Codecs for the compression of data blocks stored on disk:
+ *
+ *  lz4        plain LZ4
+ *  shuffle    byte shuffle + LZ4: bytes of 8-byte words are regrouped by their
+ *             significance (all first bytes, then all second bytes, etc), so
+ *             that exponents and high-order bytes of mantissas of nearby
+ *             numbers (which are often close) form long compressible runs
+ *  lossy      mantissas of doubles are truncated so that the absolute error
+ *             does not exceed the given tolerance, then byte shuffle + LZ4.
+ *             numbers smaller than the tolerance become zeros
+ *  sparse     zero-run encoding for (nearly) empty blocks:
+ *             [uint32 n_zeros] [uint32 n_nonzeros] [nonzero 8-byte words] ...
+ *
+ * Buffers are treated as arrays of 8-byte words (real or complex numbers);
+ * the trailing bytes (if any) are copied as is.
+ */
+
+#include "codecs.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lz4.h"
+#include "options.h"
+#include "perfcnt.h"
+
+#define WORD_SIZE 8
+
+static size_t lz4_bound(size_t src_size);
+
+static size_t lz4_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                           char *work, io_codec_args_t *args);
+
+static size_t lz4_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work);
+
+static size_t shuffle_lz4_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                                   char *work, io_codec_args_t *args);
+
+static size_t shuffle_lz4_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work);
+
+static size_t lossy_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                             char *work, io_codec_args_t *args);
+
+static size_t sparse_bound(size_t src_size);
+
+static size_t sparse_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                              char *work, io_codec_args_t *args);
+
+static size_t sparse_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work);
+
+static void byte_shuffle(size_t size, const char *src, char *dst);
+
+static void byte_unshuffle(size_t size, const char *src, char *dst);
+
+static double truncate_mantissa(double x, int log2_tol);
+
+
+/*
+ * table of codecs, indexed by cc_compression_type_t
+ */
+static io_codec_t codecs[] = {
+        {"none",    0, NULL,         NULL,                 NULL},
+        {"lz4",     0, lz4_bound,    lz4_compress,         lz4_decompress},
+        {"shuffle", 0, lz4_bound,    shuffle_lz4_compress, shuffle_lz4_decompress},
+        {"lossy",   1, lz4_bound,    lossy_compress,       shuffle_lz4_decompress},
+        {"sparse",  0, sparse_bound, sparse_compress,      sparse_decompress}
+};
+
+
+io_codec_t *io_get_codec(int codec_id)
+{
+    if (codec_id <= CC_COMPRESS_NONE || codec_id > CC_COMPRESS_SPARSE) {
+        return NULL;
+    }
+
+    return &codecs[codec_id];
+}
+
+
+/*
+ * LZ4
+ */
+
+static size_t lz4_bound(size_t src_size)
+{
+    return LZ4_COMPRESSBOUND(src_size);
+}
+
+
+static size_t lz4_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                           char *work, io_codec_args_t *args)
+{
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
+    int n = LZ4_compress_default(src, dst, src_size, dst_capacity);
+
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_LZ4_COMPRESS, &perf_start);
+    }
+
+    return (n > 0) ? n : 0;
+}
+
+
+static size_t lz4_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work)
+{
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
+    int n = LZ4_decompress_safe(src, dst, src_size, dst_size);
+
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_LZ4_DECOMPRESS, &perf_start);
+    }
+
+    return (n > 0) ? n : 0;
+}
+
+
+/*
+ * byte shuffle + LZ4
+ */
+
+static size_t shuffle_lz4_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                                   char *work, io_codec_args_t *args)
+{
+    byte_shuffle(src_size, src, work);
+    return lz4_compress(work, src_size, dst, dst_capacity, NULL, args);
+}
+
+
+static size_t shuffle_lz4_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work)
+{
+    size_t n = lz4_decompress(src, src_size, work, dst_size, NULL);
+    if (n != dst_size) {
+        return 0;
+    }
+
+    byte_unshuffle(dst_size, work, dst);
+    return n;
+}
+
+
+/*
+ * truncation of mantissas + byte shuffle + LZ4
+ */
+
+static size_t lossy_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                             char *work, io_codec_args_t *args)
+{
+    const size_t n_words = src_size / WORD_SIZE;
+    const int log2_tol = (int) floor(log2(args->tolerance));
+    double max_error = 0.0;
+    size_t n_modified = 0;
+
+    // truncated numbers are placed to the 'dst' buffer (it is large enough)
+    // and then are shuffled to the 'work' buffer
+    double *truncated = (double *) dst;
+    for (size_t i = 0; i < n_words; i++) {
+        double x;
+        memcpy(&x, src + i * WORD_SIZE, WORD_SIZE);
+        double y = (fabs(x) < args->tolerance) ? 0.0 : truncate_mantissa(x, log2_tol);
+        double err = fabs(x - y);
+        if (err > max_error) {
+            max_error = err;
+        }
+        if (y != x) {
+            n_modified++;
+        }
+        truncated[i] = y;
+    }
+    memcpy(dst + n_words * WORD_SIZE, src + n_words * WORD_SIZE, src_size - n_words * WORD_SIZE);
+
+    args->max_error = (max_error > args->max_error) ? max_error : args->max_error;
+    args->n_modified += n_modified;
+
+    byte_shuffle(src_size, dst, work);
+    return lz4_compress(work, src_size, dst, dst_capacity, NULL, args);
+}
+
+
+/*
+ * zero-run encoding
+ */
+
+static size_t sparse_bound(size_t src_size)
+{
+    // worst case: zeros and non-zeros alternate
+    return 2 * src_size + 2 * sizeof(uint32_t) + WORD_SIZE;
+}
+
+
+static size_t sparse_compress(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                              char *work, io_codec_args_t *args)
+{
+    const size_t n_words = src_size / WORD_SIZE;
+    const uint64_t *words = (const uint64_t *) src;
+    size_t pos = 0;
+    size_t i = 0;
+
+    while (i < n_words) {
+        uint32_t n_zeros = 0;
+        uint32_t n_nonzeros = 0;
+
+        while (i + n_zeros < n_words && words[i + n_zeros] == 0 && n_zeros < UINT32_MAX) {
+            n_zeros++;
+        }
+        i += n_zeros;
+        while (i + n_nonzeros < n_words && words[i + n_nonzeros] != 0 && n_nonzeros < UINT32_MAX) {
+            n_nonzeros++;
+        }
+
+        if (pos + 2 * sizeof(uint32_t) + n_nonzeros * WORD_SIZE > dst_capacity) {
+            return 0;
+        }
+        memcpy(dst + pos, &n_zeros, sizeof(uint32_t));
+        memcpy(dst + pos + sizeof(uint32_t), &n_nonzeros, sizeof(uint32_t));
+        pos += 2 * sizeof(uint32_t);
+        memcpy(dst + pos, words + i, n_nonzeros * WORD_SIZE);
+        pos += n_nonzeros * WORD_SIZE;
+        i += n_nonzeros;
+    }
+
+    // trailing bytes
+    size_t n_tail = src_size - n_words * WORD_SIZE;
+    if (pos + n_tail > dst_capacity) {
+        return 0;
+    }
+    memcpy(dst + pos, src + n_words * WORD_SIZE, n_tail);
+
+    return pos + n_tail;
+}
+
+
+static size_t sparse_decompress(const char *src, size_t src_size, char *dst, size_t dst_size, char *work)
+{
+    const size_t n_words = dst_size / WORD_SIZE;
+    const size_t n_tail = dst_size - n_words * WORD_SIZE;
+    size_t pos = 0;
+    size_t i = 0;
+
+    while (i < n_words) {
+        uint32_t n_zeros, n_nonzeros;
+
+        if (pos + 2 * sizeof(uint32_t) > src_size) {
+            return 0;
+        }
+        memcpy(&n_zeros, src + pos, sizeof(uint32_t));
+        memcpy(&n_nonzeros, src + pos + sizeof(uint32_t), sizeof(uint32_t));
+        pos += 2 * sizeof(uint32_t);
+
+        if (i + n_zeros + n_nonzeros > n_words || pos + n_nonzeros * WORD_SIZE > src_size) {
+            return 0;
+        }
+        memset(dst + i * WORD_SIZE, 0, n_zeros * WORD_SIZE);
+        i += n_zeros;
+        memcpy(dst + i * WORD_SIZE, src + pos, n_nonzeros * WORD_SIZE);
+        i += n_nonzeros;
+        pos += n_nonzeros * WORD_SIZE;
+    }
+
+    if (pos + n_tail != src_size) {
+        return 0;
+    }
+    memcpy(dst + n_words * WORD_SIZE, src + pos, n_tail);
+
+    return dst_size;
+}
+
+
+/*
+ * helper functions
+ */
+
+static void byte_shuffle(size_t size, const char *src, char *dst)
+{
+    const size_t n_words = size / WORD_SIZE;
+
+    for (size_t i = 0; i < n_words; i++) {
+        for (size_t b = 0; b < WORD_SIZE; b++) {
+            dst[b * n_words + i] = src[i * WORD_SIZE + b];
+        }
+    }
+    memcpy(dst + n_words * WORD_SIZE, src + n_words * WORD_SIZE, size - n_words * WORD_SIZE);
+}
+
+
+static void byte_unshuffle(size_t size, const char *src, char *dst)
+{
+    const size_t n_words = size / WORD_SIZE;
+
+    for (size_t i = 0; i < n_words; i++) {
+        for (size_t b = 0; b < WORD_SIZE; b++) {
+            dst[i * WORD_SIZE + b] = src[b * n_words + i];
+        }
+    }
+    memcpy(dst + n_words * WORD_SIZE, src + n_words * WORD_SIZE, size - n_words * WORD_SIZE);
+}
+
+
+/**
+ * zeroes the lowest bits of the mantissa of 'x' which are below 2^log2_tol.
+ * the number is truncated towards zero, thus |x - result| < 2^log2_tol.
+ */
+static double truncate_mantissa(double x, int log2_tol)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+
+    int exponent = (int) ((bits >> 52) & 0x7ff) - 1023;
+    if (exponent == 1024) {   // inf or nan
+        return x;
+    }
+
+    int n_drop = log2_tol - exponent + 52;
+    if (n_drop <= 0) {
+        return x;
+    }
+    if (n_drop > 52) {
+        n_drop = 52;
+    }
+
+    bits &= ~((((uint64_t) 1) << n_drop) - 1);
+    memcpy(&x, &bits, sizeof(double));
+
+    return x;
+}
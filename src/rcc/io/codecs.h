@@ -0,0 +1,70 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Codecs for the compression of data blocks stored on disk.
+ * Codecs are selected by the 'compress' option (cc_compression_type_t)
+ * and are used by io_write_compressed() / io_read_compressed().
+ */
+
+#ifndef CC_CODECS_H_INCLUDED
+#define CC_CODECS_H_INCLUDED
+
+#include <stddef.h>
+
+/*
+ * parameters and statistics of a single (de)compression operation
+ */
+typedef struct {
+    // [in] absolute tolerance for lossy codecs
+    double tolerance;
+
+    // [out] max absolute error introduced by a lossy codec
+    double max_error;
+
+    // [out] number of floating-point numbers modified by a lossy codec
+    size_t n_modified;
+} io_codec_args_t;
+
+typedef struct {
+    char *name;
+
+    // lossy codecs can be applied only to arrays of double precision numbers
+    int is_lossy;
+
+    // upper bound for the length of compressed data
+    size_t (*bound)(size_t src_size);
+
+    // returns length of compressed data or 0 if compression failed.
+    // 'work' is a temporary buffer of size >= src_size
+    size_t (*compress)(const char *src, size_t src_size, char *dst, size_t dst_capacity,
+                       char *work, io_codec_args_t *args);
+
+    // returns number of decompressed bytes (must be equal to 'dst_size').
+    // 'work' is a temporary buffer of size >= dst_size
+    size_t (*decompress)(const char *src, size_t src_size, char *dst, size_t dst_size, char *work);
+} io_codec_t;
+
+io_codec_t *io_get_codec(int codec_id);
+
+#endif /* CC_CODECS_H_INCLUDED */
@@ -32,6 +32,9 @@
  *
  ******************************************************************************/
 
+// mmap(), madvise()
+#define _DEFAULT_SOURCE
+
 #include "io.h"
 
 #include <errno.h>
@@ -48,6 +51,7 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -86,8 +90,10 @@ int io_open(char *path, char *mode)
     }
 
     if (creat) {
+        #pragma omp atomic
         IO_STAT.n_created++;
     }
+    #pragma omp atomic
     IO_STAT.n_open++;
     return ret;
 }
@@ -100,6 +106,7 @@ int io_close(int fd)
         errquit("io_close(): %s", strerror(errno));
     }
 
+    #pragma omp atomic
     IO_STAT.n_closed++;
     return status;
 }
@@ -126,6 +133,7 @@ int64_t io_read(int fd, void *buf, size_t count)
         }
 
         buf += nr;
+        #pragma omp atomic
         IO_STAT.n_read += status;
     }
 
@@ -158,6 +166,35 @@ int64_t io_read_unsafe(int fd, void *buf, size_t count)
         }*/
 
         buf += nr;
+        #pragma omp atomic
+        IO_STAT.n_read += status;
+    }
+
+    return count_total;
+}
+
+
+/**
+ * reads 'count' bytes starting from the position 'offset' of the file.
+ * the file position is not changed, so several threads can share one
+ * file descriptor.
+ */
+int64_t io_pread(int fd, void *buf, size_t count, int64_t offset)
+{
+    size_t count_total = count;
+
+    while (count > 0) {
+        size_t nr = (count > CHUNK_SIZE) ? CHUNK_SIZE : count;
+        count -= nr;
+
+        ssize_t status = pread(fd, buf, nr, offset);
+        if (status != nr) {
+            errquit("io_pread(): %s", strerror(errno));
+        }
+
+        buf += nr;
+        offset += nr;
+        #pragma omp atomic
         IO_STAT.n_read += status;
     }
 
@@ -179,6 +216,7 @@ int64_t io_write(int fd, const void *buf, size_t count)
         }
 
         buf += nw;
+        #pragma omp atomic
         IO_STAT.n_written += status;
     }
 
@@ -255,6 +293,7 @@ int io_remove(char *pathname)
         errquit("io_remove(): (errno = %d, strerror = %s)", errno, strerror(errno));
     }
 
+    #pragma omp atomic
     IO_STAT.n_removed++;
     return s;
 }
@@ -276,6 +315,68 @@ size_t io_fsize(char *pathname)
 }
 
 
+/**
+ * Maps the first 'count' bytes of the file into memory.
+ * The mapping is private: the data can be modified in RAM, but these changes
+ * never go to the file. The kernel is advised that the data will be read
+ * sequentially and soon, so the pages are prefetched into the page cache.
+ * Returns NULL if the file cannot be mapped (the caller is expected to fall
+ * back to the conventional io_read() in this case).
+ */
+void *io_mmap(char *path, size_t count)
+{
+    if (count == 0) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, count, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    madvise(addr, count, MADV_SEQUENTIAL);
+    madvise(addr, count, MADV_WILLNEED);
+
+    #pragma omp atomic
+    IO_STAT.n_mapped += count;
+    return addr;
+}
+
+
+/**
+ * Releases the mapping created by io_mmap().
+ */
+int io_munmap(void *addr, size_t count)
+{
+    int status = munmap(addr, count);
+    if (status == -1) {
+        errquit("io_munmap(): %s", strerror(errno));
+    }
+
+    return status;
+}
+
+
+/**
+ * Atomically replaces the file 'new_path' with the file 'old_path'.
+ */
+int io_rename(char *old_path, char *new_path)
+{
+    int status = rename(old_path, new_path);
+    if (status == -1) {
+        errquit("io_rename(): %s -> %s: %s", old_path, new_path, strerror(errno));
+    }
+
+    return status;
+}
+
+
 void io_statistics(io_stat_t *st)
 {
     *st = IO_STAT;
@@ -289,9 +390,25 @@ void io_statistics(io_stat_t *st)
 /*******************************************************************************
  *
  * Data compression -- interface to data compression libraries.
- * Implemented bindings: LZ4
+ * Implemented codecs (see codecs.c): LZ4, byte shuffle + LZ4, lossy (truncation
+ * of mantissas + byte shuffle + LZ4), zero-run encoding.
  * All subroutines perform compression only if data compression is required by
  * the 'compress' option (see options.h)
+ *
+ * Compressed data are stored as a frame of independent chunks:
+ *   [int -n_chunks] [int chunk_size] [int codec]
+ *   [int zsize_1] ... [int zsize_n] [compressed chunk 1] ... [compressed chunk n]
+ * Negative zsize_i means that the chunk is stored uncompressed (incompressible
+ * data). The codec is recorded in the frame, so any frame can be read
+ * regardless of the current codec.
+ * There is no limit on the size of a buffer to be compressed (except for the
+ * disk space), and chunks of large buffers are (de)compressed in parallel.
+ * Data written by the older versions ([int zsize] [LZ4 compressed data]) are
+ * recognized by the positive first entry.
+ *
+ * All routines are thread-safe: each thread has its own buffers and its own
+ * counters for statistics (they are merged on print).
+ *
  * References:
  * LZ4   https://github.com/lz4/lz4 (Copyright (C) 2011-present, Yann Collet)
  *
@@ -299,27 +416,62 @@ void io_statistics(io_stat_t *st)
  ******************************************************************************/
 
 #include <math.h>
+#include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
 
+#include "codecs.h"
 #include "lz4.h"
 #include "options.h"
 #include "utils.h"
 
-static void grow_zbuf(size_t count);
+#define IO_COMPRESSION_CHUNK_SIZE (4*1024*1024)
+#define IO_FRAME_HEADER_LEN 3
+#define IO_MAX_COMPRESSION_CONTEXTS 1024
+#define IO_HISTOGRAM_SIZE 20
+
+/*
+ * per-thread data of the compression module
+ */
+typedef struct {
+    // buffer for compressed data
+    char *zbuf;
+    size_t zbuf_len;
+
+    // temporary buffer for codecs
+    char *work;
+    size_t work_len;
+
+    // for collecting statistics
+    int histogram[IO_HISTOGRAM_SIZE];
+    double min_compression_ratio;
+    double max_compression_ratio;
+    double mean_compression_ratio;
+    double mean_compression_ratio_10; // for values of ratios <= 10
+    size_t n_compressions;     // for evaluation of mean compression ratio
+    size_t n_compressions_10;  // for values <= 10
+
+    // accuracy of lossy compression
+    double max_error;
+    size_t n_modified;
+    size_t n_lossy_values;
+} compression_context_t;
+
+static __thread compression_context_t *thread_context = NULL;
+static compression_context_t *all_contexts[IO_MAX_COMPRESSION_CONTEXTS];
+static int n_contexts = 0;
+
+static size_t write_compressed(int fd, const void *buf, size_t count, int codec_id);
+
+static size_t build_frame(compression_context_t *ctx, const void *buf, size_t count, int codec_id);
 
-// buffer for compressed data
-static char *zbuf;
-static size_t zbuf_len = 0;
+static void unpack_frame(const char *frame, size_t n_chunks, void *buf, size_t count);
 
-// for collecting statistics
-static int compress_module_is_initialized = 0;
-static int histogram[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // size = 20
-static double min_compression_ratio = 100.0;
-static double max_compression_ratio = 0.0;
-static double mean_compression_ratio = 0.0;
-static double mean_compression_ratio_10 = 0.0; // for values of ratios <= 10
-static int n_compressions = 0;  // for evaluation of mean compression ratio
-static int n_compressions_10 = 0;  // for values <= 10
+static compression_context_t *get_compression_context();
+
+static char *grow_buffer(char *buf, size_t *len, size_t new_len);
+
+static void save_compression_ratio(compression_context_t *ctx, double comp_ratio);
 
 
 /*******************************************************************************
@@ -327,6 +479,8 @@ static int n_compressions_10 = 0;  // for values <= 10
  *
  * Writes data to disk. Performs data compression if required (see options.h,
  * cc_options_t->compress field).
+ * Data are always compressed losslessly: if the lossy codec is chosen, only
+ * the byte shuffle + LZ4 is applied (see io_write_compressed_fp()).
  * NOTE: compression is not performed if buffer length <= 16
  * Arguments:
  *   fd     file descriptor
@@ -337,48 +491,41 @@ static int n_compressions_10 = 0;  // for values <= 10
  ******************************************************************************/
 size_t io_write_compressed(int fd, const void *buf, size_t count)
 {
-    int src_size, dst_size;
+    int codec_id = cc_opts->compress;
 
-    // if no compression is required
-    if (cc_opts->compress == 0 || count <= 16) {
-        return io_write(fd, buf, count);
+    if (codec_id == CC_COMPRESS_LOSSY) {
+        codec_id = CC_COMPRESS_SHUFFLE;
     }
-    // else compress data ...
 
-    src_size = count;
-    if (src_size >= LZ4_MAX_INPUT_SIZE) {
-        errquit("io_write_compressed(): src_size (%ld) > LZ4_MAX_INPUT_SIZE (%ld). "
-                "Please, decrease the tize size or contact A. Oleynichenko for "
-                "increasing this limit (alexvoleynichenko@gmail.com)", src_size, LZ4_MAX_INPUT_SIZE);
-    }
+    return write_compressed(fd, buf, count, codec_id);
+}
 
-    dst_size = LZ4_compressBound(src_size);
 
-    if (dst_size > zbuf_len) {
-        grow_zbuf(dst_size);
-    }
+/*******************************************************************************
+ * io_write_compressed_fp
+ *
+ * The same as io_write_compressed(), but the buffer is known to contain
+ * double precision numbers (real or complex), thus lossy compression can be
+ * applied.
+ ******************************************************************************/
+size_t io_write_compressed_fp(int fd, const double *buf, size_t count)
+{
+    return write_compressed(fd, buf, count, cc_opts->compress);
+}
 
-    dst_size = LZ4_compress_default(buf, zbuf, src_size, dst_size);
 
-    // save statistics
-    double comp_ratio = ((double) src_size) / dst_size;
-    if (comp_ratio < min_compression_ratio) {
-        min_compression_ratio = comp_ratio;
-    }
-    if (comp_ratio > max_compression_ratio) {
-        max_compression_ratio = comp_ratio;
-    }
-    if (0.0 <= comp_ratio && comp_ratio <= 10.0) {
-        histogram[(int) ceil(comp_ratio * 2)] += 1;  // step for histogram == 0.5
-        n_compressions_10 += 1;
-        mean_compression_ratio_10 += comp_ratio;
+static size_t write_compressed(int fd, const void *buf, size_t count, int codec_id)
+{
+    // if no compression is required
+    if (codec_id == CC_COMPRESS_NONE || count <= 16) {
+        return io_write(fd, buf, count);
     }
-    mean_compression_ratio += comp_ratio;
-    n_compressions += 1;
+    // else compress data ...
+
+    compression_context_t *ctx = get_compression_context();
+    size_t frame_len = build_frame(ctx, buf, count, codec_id);
 
-    // write: [actual length of compressed data] [data]
-    io_write(fd, &dst_size, sizeof(int));
-    return io_write(fd, zbuf, dst_size);
+    return io_write(fd, ctx->zbuf, frame_len);
 }
 
 
@@ -397,33 +544,251 @@ size_t io_write_compressed(int fd, const void *buf, size_t count)
  ******************************************************************************/
 size_t io_read_compressed(int fd, void *buf, size_t count)
 {
-    int compressed_size;
-    int dst_capacity;
+    int marker;
 
     // if no decompression is needed
-    if (cc_opts->compress == 0 || count <= 16) {
+    if (cc_opts->compress == CC_COMPRESS_NONE || count <= 16) {
         return io_read(fd, buf, count);
     }
     // else decompress data ...
 
-    dst_capacity = count;
+    compression_context_t *ctx = get_compression_context();
 
-    size_t s = io_read(fd, &compressed_size, sizeof(int));
+    io_read(fd, &marker, sizeof(int));
 
-    if (compressed_size >= LZ4_MAX_INPUT_SIZE) {
-        errquit("io_read_compressed(): compressed_size (%ld) > LZ4_MAX_INPUT_SIZE (%ld). "
-                "Please, decrease the tize size or contact A. Oleynichenko for "
-                "increasing this limit (alexvoleynichenko@gmail.com)", compressed_size, LZ4_MAX_INPUT_SIZE);
+    // data written by older versions: single LZ4 block
+    if (marker >= 0) {
+        ctx->zbuf = grow_buffer(ctx->zbuf, &ctx->zbuf_len, marker);
+        io_read(fd, ctx->zbuf, marker);
+        int n_bytes = LZ4_decompress_safe(ctx->zbuf, buf, marker, count);
+        if (n_bytes < 0 || (size_t) n_bytes != count) {
+            errquit("io_read_compressed(): lz4 decompression failed (%d bytes, %ld bytes are expected)",
+                    n_bytes, count);
+        }
+        return count;
     }
 
-    // increase zbuf ?
-    if (compressed_size > zbuf_len) {
-        grow_zbuf(compressed_size);
+    // read header: chunk size, codec and sizes of compressed chunks
+    size_t n_chunks = -marker;
+    size_t header_len = sizeof(int) * (n_chunks + IO_FRAME_HEADER_LEN - 1);
+    ctx->zbuf = grow_buffer(ctx->zbuf, &ctx->zbuf_len, header_len);
+    io_read(fd, ctx->zbuf, header_len);
+
+    int *zsizes = (int *) ctx->zbuf + IO_FRAME_HEADER_LEN - 1;
+    size_t total_zsize = 0;
+    for (size_t i = 0; i < n_chunks; i++) {
+        total_zsize += abs(zsizes[i]);
     }
 
-    io_read(fd, zbuf, compressed_size);
+    // read all compressed chunks at once
+    ctx->zbuf = grow_buffer(ctx->zbuf, &ctx->zbuf_len, header_len + total_zsize);
+    io_read(fd, ctx->zbuf + header_len, total_zsize);
 
-    return LZ4_decompress_safe(zbuf, buf, compressed_size, dst_capacity);
+    unpack_frame(ctx->zbuf, n_chunks, buf, count);
+
+    return count;
+}
+
+
+/*******************************************************************************
+ * io_compress_buffer
+ *
+ * Compresses data into the newly allocated memory buffer (compressed frame).
+ * The buffer contains double precision numbers, so any codec can be used.
+ * Arguments:
+ *   buf        data buffer
+ *   count      number of bytes in the buffer
+ *   codec_id   codec (cc_compression_type_t), must not be CC_COMPRESS_NONE
+ *   frame_len  [out] length of the compressed frame
+ * Returns:
+ *   compressed frame (must be deallocated with cc_free()), NULL if count == 0
+ ******************************************************************************/
+char *io_compress_buffer(const double *buf, size_t count, int codec_id, size_t *frame_len)
+{
+    if (count == 0) {
+        *frame_len = 0;
+        return NULL;
+    }
+
+    compression_context_t *ctx = get_compression_context();
+    *frame_len = build_frame(ctx, buf, count, codec_id);
+
+    return cc_memdup(ctx->zbuf, *frame_len);
+}
+
+
+/*******************************************************************************
+ * io_decompress_buffer
+ *
+ * Decompresses the frame obtained from io_compress_buffer().
+ * Arguments:
+ *   frame      compressed frame
+ *   frame_len  length of the compressed frame
+ *   buf        output buffer
+ *   count      number of bytes to be decompressed
+ ******************************************************************************/
+void io_decompress_buffer(const char *frame, size_t frame_len, void *buf, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    int marker = *((int *) frame);
+    unpack_frame(frame + sizeof(int), -marker, buf, count);
+}
+
+
+/*******************************************************************************
+ * build_frame
+ *
+ * Compresses data chunk-by-chunk (in parallel, if possible) and places the
+ * compressed frame to the buffer of the calling thread (ctx->zbuf).
+ * Returns length of the frame.
+ ******************************************************************************/
+static size_t build_frame(compression_context_t *ctx, const void *buf, size_t count, int codec_id)
+{
+    const size_t chunk_size = IO_COMPRESSION_CHUNK_SIZE;
+
+    io_codec_t *codec = io_get_codec(codec_id);
+    io_codec_args_t args;
+    args.tolerance = cc_opts->compress_lossy_tol;
+    args.max_error = 0.0;
+    args.n_modified = 0;
+
+    // [header] [slot for chunk 1] ... [slot for chunk n]
+    size_t n_chunks = (count + chunk_size - 1) / chunk_size;
+    size_t header_len = sizeof(int) * (n_chunks + IO_FRAME_HEADER_LEN);
+    size_t last_chunk_size = count - (n_chunks - 1) * chunk_size;
+    size_t slot_size = codec->bound(n_chunks > 1 ? chunk_size : last_chunk_size);
+    size_t zbuf_len = header_len + n_chunks * slot_size;
+
+    ctx->zbuf = grow_buffer(ctx->zbuf, &ctx->zbuf_len, zbuf_len);
+
+    int *header = (int *) ctx->zbuf;
+    int *zsizes = header + IO_FRAME_HEADER_LEN;
+    header[0] = -(int) n_chunks;
+    header[1] = chunk_size;
+    header[2] = codec_id;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(cc_opts->nthreads) if (n_chunks > 1 && !omp_in_parallel())
+    for (size_t i = 0; i < n_chunks; i++) {
+        const char *src = (const char *) buf + i * chunk_size;
+        char *dst = ctx->zbuf + header_len + i * slot_size;
+        size_t src_size = (i == n_chunks - 1) ? last_chunk_size : chunk_size;
+
+        // codecs use the temporary buffer of the working thread
+        compression_context_t *wctx = get_compression_context();
+        wctx->work = grow_buffer(wctx->work, &wctx->work_len, src_size);
+
+        io_codec_args_t chunk_args;
+        chunk_args.tolerance = args.tolerance;
+        chunk_args.max_error = 0.0;
+        chunk_args.n_modified = 0;
+        size_t zsize = codec->compress(src, src_size, dst, slot_size, wctx->work, &chunk_args);
+        if (zsize == 0 || zsize >= src_size) {
+            // incompressible data: the chunk is stored as is (exactly)
+            memcpy(dst, src, src_size);
+            zsizes[i] = -(int) src_size;
+            chunk_args.max_error = 0.0;
+            chunk_args.n_modified = 0;
+        }
+        else {
+            zsizes[i] = zsize;
+        }
+
+        #pragma omp critical (io_lossy_stats)
+        {
+            args.max_error = (chunk_args.max_error > args.max_error) ? chunk_args.max_error : args.max_error;
+            args.n_modified += chunk_args.n_modified;
+        }
+    }
+
+    // pack chunks: [header] [chunk 1] [chunk 2] ... [chunk n]
+    size_t frame_len = header_len + abs(zsizes[0]);
+    for (size_t i = 1; i < n_chunks; i++) {
+        memmove(ctx->zbuf + frame_len, ctx->zbuf + header_len + i * slot_size, abs(zsizes[i]));
+        frame_len += abs(zsizes[i]);
+    }
+
+    save_compression_ratio(ctx, ((double) count) / frame_len);
+    if (codec->is_lossy) {
+        ctx->max_error = (args.max_error > ctx->max_error) ? args.max_error : ctx->max_error;
+        ctx->n_modified += args.n_modified;
+        ctx->n_lossy_values += count / sizeof(double);
+    }
+
+    return frame_len;
+}
+
+
+/*******************************************************************************
+ * unpack_frame
+ *
+ * Decompresses chunks of the frame (in parallel, if possible).
+ * Arguments:
+ *   frame     [int chunk_size] [int codec] [int zsize_1] ... [int zsize_n]
+ *             [compressed chunk 1] ... [compressed chunk n]
+ *             (i.e. the frame without its first entry)
+ *   n_chunks  number of chunks
+ *   buf       output buffer
+ *   count     number of bytes to be decompressed
+ ******************************************************************************/
+static void unpack_frame(const char *frame, size_t n_chunks, void *buf, size_t count)
+{
+    const int *header = (const int *) frame;
+    const int *zsizes = header + IO_FRAME_HEADER_LEN - 1;
+    size_t header_len = sizeof(int) * (n_chunks + IO_FRAME_HEADER_LEN - 1);
+    size_t chunk_size = header[0];
+    int error = 0;
+
+    io_codec_t *codec = io_get_codec(header[1]);
+    if (codec == NULL) {
+        errquit("io_read_compressed(): unknown codec (%d)", header[1]);
+    }
+    if (n_chunks != (count + chunk_size - 1) / chunk_size) {
+        errquit("io_read_compressed(): wrong number of chunks (%ld), %ld bytes of data are expected",
+                n_chunks, count);
+    }
+
+    size_t *offsets = (size_t *) cc_malloc(sizeof(size_t) * n_chunks);
+    offsets[0] = header_len;
+    for (size_t i = 1; i < n_chunks; i++) {
+        offsets[i] = offsets[i - 1] + abs(zsizes[i - 1]);
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(cc_opts->nthreads) if (n_chunks > 1 && !omp_in_parallel())
+    for (size_t i = 0; i < n_chunks; i++) {
+        const char *src = frame + offsets[i];
+        char *dst = (char *) buf + i * chunk_size;
+        size_t dst_size = (i == n_chunks - 1) ? count - i * chunk_size : chunk_size;
+
+        // chunk stored as is
+        if (zsizes[i] < 0) {
+            if (-zsizes[i] != dst_size) {
+                #pragma omp atomic write
+                error = 1;
+            }
+            else {
+                memcpy(dst, src, dst_size);
+            }
+            continue;
+        }
+
+        compression_context_t *wctx = get_compression_context();
+        wctx->work = grow_buffer(wctx->work, &wctx->work_len, dst_size);
+
+        size_t n_decompressed = codec->decompress(src, zsizes[i], dst, dst_size, wctx->work);
+        if (n_decompressed != dst_size) {
+            #pragma omp atomic write
+            error = 1;
+        }
+    }
+
+    cc_free(offsets);
+
+    if (error) {
+        errquit("io_read_compressed(): %s decompression failed (%ld bytes)", codec->name, count);
+    }
 }
 
 
@@ -431,23 +796,60 @@ size_t io_read_compressed(int fd, void *buf, size_t count)
  * print_compression_stats
  *
  * Prints statistical data about compression.
+ * Statistics are collected separately by each thread.
  ******************************************************************************/
 void print_compression_stats()
 {
+    int histogram[IO_HISTOGRAM_SIZE];
+    double min_compression_ratio = 100.0;
+    double max_compression_ratio = 0.0;
+    double mean_compression_ratio = 0.0;
+    double mean_compression_ratio_10 = 0.0;
+    size_t n_compressions = 0;
+    size_t n_compressions_10 = 0;
+    double max_error = 0.0;
+    size_t n_modified = 0;
+    size_t n_lossy_values = 0;
+
     if (cc_opts->compress == CC_COMPRESS_NONE) {
         return;
     }
 
-    printf(" Compression statistics:\n");
+    memset(histogram, 0, sizeof(histogram));
+    for (int ictx = 0; ictx < n_contexts; ictx++) {
+        compression_context_t *ctx = all_contexts[ictx];
+        for (int i = 0; i < IO_HISTOGRAM_SIZE; i++) {
+            histogram[i] += ctx->histogram[i];
+        }
+        min_compression_ratio = (ctx->min_compression_ratio < min_compression_ratio) ?
+                                ctx->min_compression_ratio : min_compression_ratio;
+        max_compression_ratio = (ctx->max_compression_ratio > max_compression_ratio) ?
+                                ctx->max_compression_ratio : max_compression_ratio;
+        mean_compression_ratio += ctx->mean_compression_ratio;
+        mean_compression_ratio_10 += ctx->mean_compression_ratio_10;
+        n_compressions += ctx->n_compressions;
+        n_compressions_10 += ctx->n_compressions_10;
+        max_error = (ctx->max_error > max_error) ? ctx->max_error : max_error;
+        n_modified += ctx->n_modified;
+        n_lossy_values += ctx->n_lossy_values;
+    }
+
+    printf(" Compression statistics (%s):\n", io_get_codec(cc_opts->compress)->name);
     printf("   min compression ratio = %.3f\n", min_compression_ratio);
     printf("   max compression ratio = %.3f\n", max_compression_ratio);
     printf("   mean compression ratio = %.3f\n", mean_compression_ratio / n_compressions);
     printf("   mean compression ratio (<=10) = %.3f\n", mean_compression_ratio_10 / n_compressions_10);
+    if (cc_opts->compress == CC_COMPRESS_LOSSY) {
+        printf("   lossy compression: tolerance = %.3e\n", cc_opts->compress_lossy_tol);
+        printf("   lossy compression: max abs error = %.3e\n", max_error);
+        printf("   lossy compression: modified %ld of %ld numbers (%.1f%%)\n", n_modified, n_lossy_values,
+               n_lossy_values > 0 ? 100.0 * n_modified / n_lossy_values : 0.0);
+    }
     printf("   distribution of compression ratios:\n");
 
     // build histogram
-    int maxval = imax(20, histogram);
-    for (int i = 0; i < 20; i++) {
+    int maxval = imax(IO_HISTOGRAM_SIZE, histogram);
+    for (int i = 0; i < IO_HISTOGRAM_SIZE; i++) {
         int nbars = ((double) histogram[i] / maxval) * 50;
         printf("   [%4.1f -%4.1f] |", 0.5 * i, 0.5 * i + 0.5);
         for (int j = 0; j < nbars; j++) {
@@ -459,21 +861,85 @@ void print_compression_stats()
 
 
 /*******************************************************************************
- * grow_zbuf
+ * get_compression_context
+ *
+ * Returns buffers and statistics counters of the calling thread.
+ * They are created when the thread calls the compression routines for the
+ * first time.
+ ******************************************************************************/
+static compression_context_t *get_compression_context()
+{
+    if (thread_context != NULL) {
+        return thread_context;
+    }
+
+    compression_context_t *ctx = (compression_context_t *) cc_calloc(1, sizeof(compression_context_t));
+    ctx->zbuf = NULL;
+    ctx->zbuf_len = 0;
+    ctx->work = NULL;
+    ctx->work_len = 0;
+    ctx->min_compression_ratio = 100.0;
+
+    #pragma omp critical (io_compression_contexts)
+    {
+        if (n_contexts == IO_MAX_COMPRESSION_CONTEXTS) {
+            errquit("get_compression_context(): too many threads (> %d)", IO_MAX_COMPRESSION_CONTEXTS);
+        }
+        all_contexts[n_contexts] = ctx;
+        n_contexts++;
+    }
+
+    thread_context = ctx;
+    return ctx;
+}
+
+
+/*******************************************************************************
+ * grow_buffer
  *
  * Reallocates memory for the temporary buffer used for (de)compression.
+ * Contents of the buffer are preserved.
  ******************************************************************************/
-void grow_zbuf(size_t count)
+static char *grow_buffer(char *buf, size_t *len, size_t new_len)
 {
-    if (zbuf_len == 0) {
-        zbuf = (char *) cc_malloc(count);
-        zbuf_len = count;
+    if (new_len <= *len) {
+        return buf;
+    }
+
+    static int lz4_tag = -1;
+    if (lz4_tag == -1) {
+        lz4_tag = cc_memory_get_tag("lz4 buffers");
+    }
+
+    char *buf2 = (char *) cc_malloc_tagged(new_len, lz4_tag);
+    if (*len > 0) {
+        memcpy(buf2, buf, *len);
+        cc_free(buf);
+    }
+    *len = new_len;
+
+    return buf2;
+}
+
+
+/*******************************************************************************
+ * save_compression_ratio
+ *
+ * Updates statistics of the calling thread.
+ ******************************************************************************/
+static void save_compression_ratio(compression_context_t *ctx, double comp_ratio)
+{
+    if (comp_ratio < ctx->min_compression_ratio) {
+        ctx->min_compression_ratio = comp_ratio;
+    }
+    if (comp_ratio > ctx->max_compression_ratio) {
+        ctx->max_compression_ratio = comp_ratio;
     }
-    else {  // realloc
-        char *zbuf2 = (char *) cc_malloc(count);
-        memcpy(zbuf2, zbuf, zbuf_len);
-        cc_free(zbuf);
-        zbuf = zbuf2;
-        zbuf_len = count;
+    if (0.0 <= comp_ratio && comp_ratio < 10.0) {
+        ctx->histogram[(int) (comp_ratio * 2)] += 1;  // step for histogram == 0.5
+        ctx->n_compressions_10 += 1;
+        ctx->mean_compression_ratio_10 += comp_ratio;
     }
+    ctx->mean_compression_ratio += comp_ratio;
+    ctx->n_compressions += 1;
 }
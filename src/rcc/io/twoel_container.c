@@ -0,0 +1,514 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Container of two-electron integrals (see twoel_container.h).
+ *
+ * Writer: chunks are packed into a staging buffer of each shard and written
+ * by large portions. If the staging buffer of a shard is full, all shards
+ * filled by more than half are written in parallel. The extents of chunks
+ * are kept in memory and written to the index file at the end.
+ *
+ * Reader: the index is loaded once and sorted by quadruples; chunks of the
+ * quadruple are then read by single pread() calls.
+ */
+
+#include "twoel_container.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comdef.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "omp.h"
+#include "options.h"
+#include "utils.h"
+
+#define CC_TWOEL_CONTAINER_MAGIC "EXPTVIDX"
+#define CC_TWOEL_CONTAINER_VERSION 1
+#define CC_TWOEL_CONTAINER_STAGING_SIZE (16 * 1024 * 1024)
+
+// prefix + the longest suffix (".idx.<run id>")
+#define CC_TWOEL_CONTAINER_PATH_LENGTH (CC_MAX_PATH_LENGTH + 32)
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t n_shards;
+    int32_t compressed;
+    int32_t value_size;
+    int64_t n_extents;
+} twoel_index_header_t;
+
+static struct {
+    int active;
+    char prefix[CC_MAX_PATH_LENGTH];
+    int n_shards;
+    int compressed;
+    int value_size;
+    int fd[CC_TWOEL_CONTAINER_MAX_SHARDS];
+    char *staging[CC_TWOEL_CONTAINER_MAX_SHARDS];
+    size_t n_staged[CC_TWOEL_CONTAINER_MAX_SHARDS];
+    int64_t shard_size[CC_TWOEL_CONTAINER_MAX_SHARDS];   // bytes already written to the shard file
+    twoel_extent_t *extents;
+    int64_t n_extents;
+    int64_t capacity;
+} writer;
+
+static void shard_file_name(char *prefix, int shard, char *file_name);
+
+static void make_file_name(char *file_name, size_t max_len, const char *format, ...);
+
+static int quadruple_to_shard(int32_t sb1, int32_t sb2, int32_t sb3, int32_t sb4, int n_shards);
+
+static void flush_shards(size_t min_staged, int forced_shard);
+
+static void add_extent(twoel_extent_t *ext);
+
+static void remove_if_exists(char *file_name);
+
+static int cmp_extents(const void *p1, const void *p2);
+
+
+/*******************************************************************************
+ * twoel_container_create
+ *
+ * Starts writing of the container <prefix>.*; old files with the same prefix
+ * are removed. Several shards are used in parallel runs only.
+ ******************************************************************************/
+void twoel_container_create(char *prefix)
+{
+    char file_name[CC_TWOEL_CONTAINER_PATH_LENGTH];
+
+    if (writer.active) {
+        errquit("twoel_container_create(): container '%s' is not finalized", writer.prefix);
+    }
+
+    memset(&writer, 0, sizeof(writer));
+    writer.active = 1;
+    make_file_name(writer.prefix, sizeof(writer.prefix), "%s", prefix);
+    writer.n_shards = (cc_opts->nthreads < CC_TWOEL_CONTAINER_MAX_SHARDS) ? cc_opts->nthreads
+                                                                          : CC_TWOEL_CONTAINER_MAX_SHARDS;
+    if (writer.n_shards < 1) {
+        writer.n_shards = 1;
+    }
+    writer.compressed = (cc_opts->compress != CC_COMPRESS_NONE);
+
+    make_file_name(file_name, sizeof(file_name), "%s.idx", writer.prefix);
+    remove_if_exists(file_name);
+    for (int shard = 0; shard < CC_TWOEL_CONTAINER_MAX_SHARDS; shard++) {
+        shard_file_name(writer.prefix, shard, file_name);
+        remove_if_exists(file_name);
+    }
+
+    for (int shard = 0; shard < writer.n_shards; shard++) {
+        shard_file_name(writer.prefix, shard, file_name);
+        writer.fd[shard] = io_open(file_name, "w");
+        if (writer.fd[shard] == -1) {
+            errquit("twoel_container_create(): cannot open file '%s'", file_name);
+        }
+        writer.staging[shard] = cc_malloc(CC_TWOEL_CONTAINER_STAGING_SIZE);
+    }
+}
+
+
+/*******************************************************************************
+ * twoel_container_append
+ *
+ * Appends the chunk of integrals of the quadruple (sb1,sb2,sb3,sb4):
+ * 4*nint indices and nint values of size 'value_size'.
+ ******************************************************************************/
+void twoel_container_append(int32_t sb1, int32_t sb2, int32_t sb3, int32_t sb4,
+                            int32_t nint, int16_t *indices, void *values, int32_t value_size)
+{
+    if (nint == 0) {
+        return;
+    }
+
+    size_t indices_len = 4 * sizeof(int16_t) * nint;
+    size_t values_len = (size_t) value_size * nint;
+    char *indices_data = (char *) indices;
+    char *values_data = (char *) values;
+    char *indices_frame = NULL;
+    char *values_frame = NULL;
+
+    writer.value_size = value_size;
+
+    if (writer.compressed) {
+        // indices are integers: lossy compression is not allowed for them
+        int codec_id = (cc_opts->compress == CC_COMPRESS_LOSSY) ? CC_COMPRESS_SHUFFLE : cc_opts->compress;
+        indices_frame = io_compress_buffer((double *) indices, indices_len, codec_id, &indices_len);
+        values_frame = io_compress_buffer((double *) values, values_len, cc_opts->compress, &values_len);
+        indices_data = indices_frame;
+        values_data = values_frame;
+    }
+
+    int64_t lengths[2] = {indices_len, values_len};
+    size_t chunk_len = sizeof(lengths) + indices_len + values_len;
+    int shard = quadruple_to_shard(sb1, sb2, sb3, sb4, writer.n_shards);
+
+    if (writer.n_staged[shard] + chunk_len > CC_TWOEL_CONTAINER_STAGING_SIZE) {
+        flush_shards(CC_TWOEL_CONTAINER_STAGING_SIZE / 2, shard);
+    }
+
+    twoel_extent_t ext;
+    ext.spinor_blocks[0] = sb1;
+    ext.spinor_blocks[1] = sb2;
+    ext.spinor_blocks[2] = sb3;
+    ext.spinor_blocks[3] = sb4;
+    ext.shard = shard;
+    ext.nint = nint;
+    ext.offset = writer.shard_size[shard] + writer.n_staged[shard];
+    ext.length = chunk_len;
+    add_extent(&ext);
+
+    if (chunk_len > CC_TWOEL_CONTAINER_STAGING_SIZE) {
+        // too large for staging (staging buffer of the shard is empty here)
+        io_write(writer.fd[shard], lengths, sizeof(lengths));
+        io_write(writer.fd[shard], indices_data, indices_len);
+        io_write(writer.fd[shard], values_data, values_len);
+        writer.shard_size[shard] += chunk_len;
+    }
+    else {
+        char *dest = writer.staging[shard] + writer.n_staged[shard];
+        memcpy(dest, lengths, sizeof(lengths));
+        memcpy(dest + sizeof(lengths), indices_data, indices_len);
+        memcpy(dest + sizeof(lengths) + indices_len, values_data, values_len);
+        writer.n_staged[shard] += chunk_len;
+    }
+
+    cc_free(indices_frame);
+    cc_free(values_frame);
+}
+
+
+/*******************************************************************************
+ * twoel_container_finalize
+ *
+ * Writes the rest of data and the index file. The index is written to the
+ * temporary file and then renamed, so it appears only for complete containers.
+ ******************************************************************************/
+void twoel_container_finalize()
+{
+    char file_name[CC_TWOEL_CONTAINER_PATH_LENGTH];
+    char tmp_file_name[CC_TWOEL_CONTAINER_PATH_LENGTH];
+
+    if (!writer.active) {
+        return;
+    }
+
+    flush_shards(1, -1);
+    for (int shard = 0; shard < writer.n_shards; shard++) {
+        io_close(writer.fd[shard]);
+        cc_free(writer.staging[shard]);
+    }
+
+    twoel_index_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CC_TWOEL_CONTAINER_MAGIC, sizeof(header.magic));
+    header.version = CC_TWOEL_CONTAINER_VERSION;
+    header.n_shards = writer.n_shards;
+    header.compressed = writer.compressed;
+    header.value_size = writer.value_size;
+    header.n_extents = writer.n_extents;
+
+    make_file_name(file_name, sizeof(file_name), "%s.idx", writer.prefix);
+    make_file_name(tmp_file_name, sizeof(tmp_file_name), "%s.idx.%zu", writer.prefix, run_id());
+    int fd = io_open(tmp_file_name, "w");
+    if (fd == -1) {
+        errquit("twoel_container_finalize(): cannot open file '%s'", tmp_file_name);
+    }
+    io_write(fd, &header, sizeof(header));
+    io_write(fd, writer.extents, sizeof(twoel_extent_t) * writer.n_extents);
+    io_close(fd);
+    io_rename(tmp_file_name, file_name);
+
+    cc_free(writer.extents);
+    memset(&writer, 0, sizeof(writer));
+}
+
+
+/*******************************************************************************
+ * twoel_container_open
+ *
+ * Loads the index of the container <prefix>.* and opens its shards.
+ * Returns NULL if there is no such container.
+ ******************************************************************************/
+twoel_container_t *twoel_container_open(char *prefix)
+{
+    char file_name[CC_TWOEL_CONTAINER_PATH_LENGTH];
+    twoel_index_header_t header;
+
+    make_file_name(file_name, sizeof(file_name), "%s.idx", prefix);
+    if (!io_file_exists(file_name)) {
+        return NULL;
+    }
+
+    int fd = io_open(file_name, "r");
+    io_read(fd, &header, sizeof(header));
+    if (memcmp(header.magic, CC_TWOEL_CONTAINER_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CC_TWOEL_CONTAINER_VERSION ||
+        header.n_shards < 1 || header.n_shards > CC_TWOEL_CONTAINER_MAX_SHARDS) {
+        errquit("twoel_container_open(): file '%s' is not a valid index of two-electron integrals", file_name);
+    }
+
+    twoel_container_t *cont = (twoel_container_t *) cc_malloc(sizeof(twoel_container_t));
+    cont->n_shards = header.n_shards;
+    cont->compressed = header.compressed;
+    cont->value_size = header.value_size;
+    cont->n_extents = header.n_extents;
+    cont->extents = (twoel_extent_t *) cc_malloc(sizeof(twoel_extent_t) * (header.n_extents + 1));
+    io_read(fd, cont->extents, sizeof(twoel_extent_t) * header.n_extents);
+    io_close(fd);
+
+    // chunks of the quadruple are in the same shard, their offsets follow the order of writing
+    qsort(cont->extents, cont->n_extents, sizeof(twoel_extent_t), cmp_extents);
+
+    cont->max_length = 0;
+    for (int64_t i = 0; i < cont->n_extents; i++) {
+        if (cont->extents[i].length > cont->max_length) {
+            cont->max_length = cont->extents[i].length;
+        }
+    }
+
+    for (int shard = 0; shard < cont->n_shards; shard++) {
+        shard_file_name(prefix, shard, file_name);
+        cont->fd[shard] = io_open(file_name, "r");
+        if (cont->fd[shard] == -1) {
+            errquit("twoel_container_open(): cannot open file '%s'", file_name);
+        }
+    }
+
+    return cont;
+}
+
+
+void twoel_container_close(twoel_container_t *cont)
+{
+    if (cont == NULL) {
+        return;
+    }
+
+    for (int shard = 0; shard < cont->n_shards; shard++) {
+        io_close(cont->fd[shard]);
+    }
+    cc_free(cont->extents);
+    cc_free(cont);
+}
+
+
+/*******************************************************************************
+ * twoel_container_lookup
+ *
+ * Returns chunks of the quadruple (sb1,sb2,sb3,sb4) (numeration from 1) and
+ * their number (NULL and 0 if the quadruple was not written).
+ ******************************************************************************/
+twoel_extent_t *twoel_container_lookup(twoel_container_t *cont, int sb1, int sb2, int sb3, int sb4,
+                                       int64_t *n_extents)
+{
+    twoel_extent_t key;
+    key.spinor_blocks[0] = sb1;
+    key.spinor_blocks[1] = sb2;
+    key.spinor_blocks[2] = sb3;
+    key.spinor_blocks[3] = sb4;
+    key.offset = -1;
+
+    // lower bound: the first chunk of the quadruple
+    int64_t lo = 0;
+    int64_t hi = cont->n_extents;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (cmp_extents(cont->extents + mid, &key) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    int64_t n = 0;
+    while (lo + n < cont->n_extents &&
+           memcmp(cont->extents[lo + n].spinor_blocks, key.spinor_blocks, sizeof(key.spinor_blocks)) == 0) {
+        n++;
+    }
+
+    *n_extents = n;
+    return (n > 0) ? cont->extents + lo : NULL;
+}
+
+
+/*
+ * total length of chunks of the quadruple, bytes
+ */
+size_t twoel_container_quadruple_size(twoel_container_t *cont, int sb1, int sb2, int sb3, int sb4)
+{
+    int64_t n_extents;
+    twoel_extent_t *ext = twoel_container_lookup(cont, sb1, sb2, sb3, sb4, &n_extents);
+
+    size_t size = 0;
+    for (int64_t i = 0; i < n_extents; i++) {
+        size += ext[i].length;
+    }
+
+    return size;
+}
+
+
+/*******************************************************************************
+ * twoel_container_read
+ *
+ * Reads the chunk: 4*nint indices and nint values.
+ * 'scratch' must be at least cont->max_length bytes long.
+ * Can be called by several threads at once.
+ ******************************************************************************/
+void twoel_container_read(twoel_container_t *cont, twoel_extent_t *ext, char *scratch,
+                          int16_t *indices, void *values)
+{
+    int64_t lengths[2];
+    size_t indices_len = 4 * sizeof(int16_t) * ext->nint;
+    size_t values_len = (size_t) cont->value_size * ext->nint;
+
+    io_pread(cont->fd[ext->shard], scratch, ext->length, ext->offset);
+    memcpy(lengths, scratch, sizeof(lengths));
+
+    char *indices_data = scratch + sizeof(lengths);
+    char *values_data = indices_data + lengths[0];
+
+    if (cont->compressed) {
+        io_decompress_buffer(indices_data, lengths[0], indices, indices_len);
+        io_decompress_buffer(values_data, lengths[1], values, values_len);
+    }
+    else {
+        memcpy(indices, indices_data, indices_len);
+        memcpy(values, values_data, values_len);
+    }
+}
+
+
+static void shard_file_name(char *prefix, int shard, char *file_name)
+{
+    make_file_name(file_name, CC_TWOEL_CONTAINER_PATH_LENGTH, "%s.%d.dat", prefix, shard);
+}
+
+
+/*
+ * formats the name of the container file, stops if it does not fit into
+ * the buffer (names are never truncated silently)
+ */
+static void make_file_name(char *file_name, size_t max_len, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(file_name, max_len, format, args);
+    va_end(args);
+
+    if (len < 0 || (size_t) len >= max_len) {
+        errquit("twoel_container: file name is too long (%d > %ld)", len, max_len - 1);
+    }
+}
+
+
+static int quadruple_to_shard(int32_t sb1, int32_t sb2, int32_t sb3, int32_t sb4, int n_shards)
+{
+    uint32_t h = 2166136261u;
+    int32_t sb[4] = {sb1, sb2, sb3, sb4};
+
+    for (int i = 0; i < 4; i++) {
+        h = (h ^ (uint32_t) sb[i]) * 16777619u;
+    }
+
+    return (int) (h % (uint32_t) n_shards);
+}
+
+
+/*
+ * writes staging buffers containing at least 'min_staged' bytes (and the
+ * buffer of 'forced_shard' in any case), different shards are written in parallel
+ */
+static void flush_shards(size_t min_staged, int forced_shard)
+{
+    int shards[CC_TWOEL_CONTAINER_MAX_SHARDS];
+    int n = 0;
+
+    for (int shard = 0; shard < writer.n_shards; shard++) {
+        if (writer.n_staged[shard] > 0 && (writer.n_staged[shard] >= min_staged || shard == forced_shard)) {
+            shards[n++] = shard;
+        }
+    }
+
+    #pragma omp parallel for num_threads(n) schedule(dynamic) if (n > 1)
+    for (int i = 0; i < n; i++) {
+        int shard = shards[i];
+        io_write(writer.fd[shard], writer.staging[shard], writer.n_staged[shard]);
+        writer.shard_size[shard] += writer.n_staged[shard];
+        writer.n_staged[shard] = 0;
+    }
+}
+
+
+static void add_extent(twoel_extent_t *ext)
+{
+    if (writer.n_extents == writer.capacity) {
+        int64_t new_capacity = (writer.capacity == 0) ? 1024 : 2 * writer.capacity;
+        twoel_extent_t *new_extents = (twoel_extent_t *) cc_malloc(sizeof(twoel_extent_t) * new_capacity);
+        if (writer.n_extents > 0) {
+            memcpy(new_extents, writer.extents, sizeof(twoel_extent_t) * writer.n_extents);
+        }
+        cc_free(writer.extents);
+        writer.extents = new_extents;
+        writer.capacity = new_capacity;
+    }
+
+    writer.extents[writer.n_extents++] = *ext;
+}
+
+
+static void remove_if_exists(char *file_name)
+{
+    if (io_file_exists(file_name)) {
+        io_remove(file_name);
+    }
+}
+
+
+static int cmp_extents(const void *p1, const void *p2)
+{
+    const twoel_extent_t *e1 = (const twoel_extent_t *) p1;
+    const twoel_extent_t *e2 = (const twoel_extent_t *) p2;
+
+    for (int k = 0; k < 4; k++) {
+        if (e1->spinor_blocks[k] != e2->spinor_blocks[k]) {
+            return (e1->spinor_blocks[k] < e2->spinor_blocks[k]) ? -1 : 1;
+        }
+    }
+    if (e1->offset != e2->offset) {
+        return (e1->offset < e2->offset) ? -1 : 1;
+    }
+
+    return 0;
+}
@@ -48,11 +48,14 @@
 #include "interfaces.h"
 #include "methods.h"
 #include "options.h"
+#include "perfcnt.h"
 #include "spinors.h"
 #include "symmetry.h"
 #include "timer.h"
+#include "trace.h"
 #include "utils.h"
 #include "version.h"
+#include "models/checkpoint.h"
 #include "new_sorting/new_sorting.h"
 
 
@@ -71,6 +74,8 @@ void print_footer_banner(int exit_code);
 
 void tt_ccsd();
 
+static int run_sector(int (*solver)(cc_options_t *), char *sector_label, cc_options_t *opts);
+
 
 /**
  * entry point
@@ -80,13 +85,14 @@ int main(int argc, char **argv)
     char input_name[256];
     int exit_code = EXIT_SUCCESS;
     int do_clean_scratch = 0;
+    int do_plan = 0;
     char *scratch_dir_path = NULL;
 
     // turn off buffering for stdout (for seeing output immediately)
     setvbuf(stdout, NULL, _IONBF, 0);
 
     // parse command line arguments
-    parse_argv(argc, argv, input_name, &scratch_dir_path, &do_clean_scratch);
+    parse_argv(argc, argv, input_name, &scratch_dir_path, &do_clean_scratch, &do_plan);
 
     print_header_banner();
 
@@ -110,9 +116,36 @@ int main(int argc, char **argv)
 
     cc_init_allocator(cc_opts->max_memory_size);
 
+    // dry run: estimate resources and exit, scratch directory is not needed
+    if (do_plan) {
+        exit_code = plan_resources(opts);
+        delete_options(opts);
+        symmetry_cleanup();
+        spinors_cleanup();
+        cc_finalize_allocator();
+        return exit_code;
+    }
+
     // setup scratch directory: create if needed and cd to it
     setup_scratch();
 
+    // timeline of engine activity: print "trace" or the EXPT_TRACE env variable,
+    // events of individual blocks: print "trace blocks" or EXPT_TRACE_BLOCKS
+    int trace_blocks = (opts->print_trace == 2 || getenv(CC_TRACE_BLOCKS_ENV_VAR) != NULL);
+    if (opts->print_trace || getenv(CC_TRACE_ENV_VAR) != NULL || trace_blocks) {
+        trace_enable(getenv(CC_TRACE_ENV_VAR), trace_blocks);
+    }
+
+    // hardware performance counters: print "counters" or the EXPT_PERF_COUNTERS env variable
+    if (opts->print_perf_counters || getenv(CC_PERFCNT_ENV_VAR) != NULL) {
+        perfcnt_enable();
+    }
+
+    // memory usage by diagrams and subsystems: print "memory" or the EXPT_MEMORY_TIMELINE env variable
+    if (opts->print_memory_timeline || getenv("EXPT_MEMORY_TIMELINE") != NULL) {
+        cc_memory_enable_timeline("memory.csv");
+    }
+
     // for debug purposes:
     #ifdef TENSOR_TRAIN
     if (cc_opts->tt_options.tt_module_enabled && cc_opts->tt_options.use_pyscf_integrals) {
@@ -134,165 +167,175 @@ int main(int argc, char **argv)
     else if (opts->int_source == CC_INTEGRALS_PYSCF) {
         pyscf_interface(opts);
     }
+    else if (opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        synthetic_interface(opts);
+    }
     else {
         printf("unknown integral interface\n");
         return 1;
     }
 
+    // sort integrals for all the sectors to be visited at once
+    // (can be switched off by the EXPT_NO_PRESORT environment variable)
+    if (getenv("EXPT_NO_PRESORT") != NULL) {
+        opts->presort_integrals = 0;
+    }
+    presort_integrals(opts);
+
     // solve FS-CC equations in the required sector
     if (opts->sector_h == 0 && opts->sector_p == 0) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
     }
     else if (opts->sector_h == 0 && opts->sector_p == 1) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 1 && opts->sector_p == 0) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 1 && opts->sector_p == 1) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h1p(opts);
+        exit_code = run_sector(sector_1h1p, "1h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 0 && opts->sector_p == 2) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h2p(opts);
+        exit_code = run_sector(sector_0h2p, "0h2p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 2 && opts->sector_p == 0) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_2h0p(opts);
+        exit_code = run_sector(sector_2h0p, "2h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 0 && opts->sector_p == 3) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h2p(opts);
+        exit_code = run_sector(sector_0h2p, "0h2p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h3p(opts);
+        exit_code = run_sector(sector_0h3p, "0h3p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 3 && opts->sector_p == 0) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_2h0p(opts);
+        exit_code = run_sector(sector_2h0p, "2h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_3h0p(opts);
+        exit_code = run_sector(sector_3h0p, "3h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 1 && opts->sector_p == 2) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h1p(opts);
+        exit_code = run_sector(sector_1h1p, "1h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h2p(opts);
+        exit_code = run_sector(sector_0h2p, "0h2p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h2p(opts);
+        exit_code = run_sector(sector_1h2p, "1h2p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
     }
     else if (opts->sector_h == 2 && opts->sector_p == 1) {
-        exit_code = sector_0h0p(opts);
+        exit_code = run_sector(sector_0h0p, "0h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h0p(opts);
+        exit_code = run_sector(sector_1h0p, "1h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_0h1p(opts);
+        exit_code = run_sector(sector_0h1p, "0h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_1h1p(opts);
+        exit_code = run_sector(sector_1h1p, "1h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_2h0p(opts);
+        exit_code = run_sector(sector_2h0p, "2h0p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
-        exit_code = sector_2h1p(opts);
+        exit_code = run_sector(sector_2h1p, "2h1p", opts);
         if (exit_code == EXIT_FAILURE) {
             goto finalize;
         }
@@ -303,14 +346,26 @@ int main(int argc, char **argv)
 
     finalize:
 
+    // restart checkpoint is not needed anymore after the successful run
+    checkpoint_finalize(exit_code == EXIT_SUCCESS);
+
     timer_stop("tot");
     if (opts->print_level >= CC_PRINT_MEDIUM) {
         timer_stats();
     }
+    perfcnt_print_stats();
+
+    // machine-readable summary of the profile (in the scratch directory)
+    timer_write_json("profile.json");
+    trace_write_json();
 
     if (opts->compress != CC_COMPRESS_NONE && opts->print_level >= CC_PRINT_HIGH) {
         print_compression_stats();
     }
+    if (opts->compressed_tier && opts->print_level >= CC_PRINT_MEDIUM) {
+        compressed_tier_print_stats();
+    }
+    eviction_print_stats();
 
     // final clean-up and exit
     delete_options(opts);
@@ -553,6 +608,9 @@ void print_footer_banner(int exit_code)
     printf("   files created: %ld   files removed: %ld\n", io_st.n_created, io_st.n_removed);
     printf("   read   %15ld bytes = %.3f Gb\n", io_st.n_read, io_st.n_read / (1024.0 * 1024.0 * 1024.0));
     printf("   write  %15ld bytes = %.3f Gb\n", io_st.n_written, io_st.n_written / (1024.0 * 1024.0 * 1024.0));
+    if (io_st.n_mapped > 0) {
+        printf("   mapped %15ld bytes = %.3f Gb\n", io_st.n_mapped, io_st.n_mapped / (1024.0 * 1024.0 * 1024.0));
+    }
     printf("\n");
 
     // calculate number of days, hours, minutes, seconds, milliseconds
@@ -567,3 +625,22 @@ void print_footer_banner(int exit_code)
     }
     printf(" Total run time: %d days %d hours %d minutes %d seconds %d milliseconds\n", d, h, m, s, ms);
 }
+
+
+/*
+ * solves CC equations in the given sector and prints statistics of engine
+ * operations performed in it (FLOP rates, memory traffic)
+ */
+static int run_sector(int (*solver)(cc_options_t *), char *sector_label, cc_options_t *opts)
+{
+    int exit_code = solver(opts);
+
+    if (opts->print_level >= CC_PRINT_MEDIUM) {
+        char title[64];
+        sprintf(title, "sector %s", sector_label);
+        opstats_print_roofline(title, CC_OPSTATS_TOP);
+    }
+    opstats_clear();
+
+    return exit_code;
+}
@@ -23,19 +23,83 @@
 
 /*
  * Memory allocator.
+ *
+ * Each allocation is attributed to the owner tag: a diagram name or the name
+ * of a subsystem (sorting, DIIS, ...). Tags are pushed/popped by the master
+ * thread (cc_memory_push_tag()/cc_memory_pop_tag()), allocations made by any
+ * thread are attributed to the tag on the top of the stack (or to the tag
+ * given explicitly to cc_malloc_tagged()). The tag id is
+ * stored in the header of the allocated block, so the memory is released
+ * from the same tag.
+ * When the peak memory usage grows by more than CC_MEMORY_SNAPSHOT_STEP, the
+ * memory usage by tags is saved; the top consumers at the peak are printed
+ * at the end of the run. Optionally, the time series of memory usage by tags
+ * is written to the CSV file.
  */
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "memory.h"
+#include "timer.h"
+
+#define CC_MEMORY_MAX_TAGS 1024
+#define CC_MEMORY_TAG_LENGTH 32
+#define CC_MEMORY_MAX_TAG_DEPTH 32
+#define CC_MEMORY_SNAPSHOT_STEP 0.01      // relative growth of the peak between snapshots
+#define CC_MEMORY_TIMELINE_INTERVAL 0.5   // seconds between samples of the time series
+
+// header of the allocated block (16 bytes, keeps alignment of the data)
+typedef struct {
+    size_t nbytes;
+    int32_t tag;
+    int32_t reserved;
+} cc_memory_header_t;
+
 static size_t n_allocated = 0;
 static size_t max_allocated = 0;
 static size_t max_available = 100 * 1024u * 1024u; // start with 100 Mb
 
+// owner tags
+static char tag_names[CC_MEMORY_MAX_TAGS][CC_MEMORY_TAG_LENGTH] = {"untagged", "file mappings"};
+static size_t tag_usage[CC_MEMORY_MAX_TAGS];
+static size_t tag_usage_at_peak[CC_MEMORY_MAX_TAGS];
+static int n_tags = 2;
+static size_t snapshot_peak = 0;
+
+enum {
+    CC_MEMORY_TAG_UNTAGGED = 0,
+    CC_MEMORY_TAG_MAPPINGS = 1
+};
+
+static int tag_stack[CC_MEMORY_MAX_TAG_DEPTH];
+static int tag_depth = 0;
+static int curr_tag = CC_MEMORY_TAG_UNTAGGED;
+
+// time series of memory usage by tags
+static FILE *timeline_file = NULL;
+static double timeline_t0 = 0.0;
+static double timeline_last = 0.0;
+
+// handler which releases memory when the limit is reached (see eviction.c)
+static cc_eviction_handler_t eviction_handler = NULL;
+static __thread int in_eviction = 0;
+
 void cc_memory_usage();
 
+static int check_memory_limit(size_t nbytes);
+
+static void memory_allocated(size_t nbytes, int tag);
+
+static void memory_released(size_t nbytes, int tag);
+
+static void write_timeline_sample(double t);
+
+static void print_top_consumers(char *title, size_t *usage, size_t total, int n_top);
+
 
 void cc_init_allocator(size_t max_mem)
 {
@@ -46,42 +110,44 @@ void cc_init_allocator(size_t max_mem)
 /**
  * Wrapper for malloc() from libc.
  * Allocates memory:
- * [sizeof(size_t) block-size-nbytes] [useful space]
- *                                    ^
- *                                 returns
+ * [header: block-size-nbytes, owner tag] [useful space]
+ *                                        ^
+ *                                     returns
  */
 void *cc_malloc(size_t nbytes)
+{
+    return cc_malloc_tagged(nbytes, curr_tag);
+}
+
+
+/**
+ * Allocates memory attributed to the given owner tag (see cc_memory_get_tag()).
+ * Can be used by any thread.
+ */
+void *cc_malloc_tagged(size_t nbytes, int tag)
 {
     void *mem;
 
-    if (n_allocated + nbytes > max_available) {
-        printf("bytes allocated        = %ld\n", n_allocated);
-        printf("max memory usage limit = %ld\n", max_available);
-        printf("bytes available (free) = %ld\n", max_available - n_allocated);
-        printf("bytes required for the current allocation = %ld\n", nbytes);
-        printf("cc_malloc(): cannot allocate memory (not enough memory)\n");
-        abort();
+    if (check_memory_limit(nbytes) == 0) {
         return NULL;
     }
 
-    mem = malloc(sizeof(size_t) + nbytes);
+    mem = malloc(sizeof(cc_memory_header_t) + nbytes);
     if (mem == NULL) {
         printf("cc_malloc(): cannot allocate memory (%ld bytes): %s\n", nbytes,
                strerror(errno));
         return NULL;
     }
 
-    // first entry = number of "useful" bytes
-    *((size_t *) mem) = nbytes;
+    // header: number of "useful" bytes and the owner
+    cc_memory_header_t *header = (cc_memory_header_t *) mem;
+    header->nbytes = nbytes;
+    header->tag = tag;
+    header->reserved = 0;
 
-    // update counters
-    #pragma omp atomic
-    n_allocated += nbytes;
-    if (n_allocated > max_allocated) {
-        max_allocated = n_allocated;
-    }
+    memory_allocated(nbytes, header->tag);
 
-    return mem + sizeof(size_t);
+    return mem + sizeof(cc_memory_header_t);
 }
 
 
@@ -107,26 +173,233 @@ void *cc_calloc(size_t num, size_t size)
  */
 void cc_free(void *p)
 {
-    size_t nbytes;
     void *mem;
 
     if (p == NULL) { return; }
 
-    mem = p - sizeof(size_t);
-    nbytes = *((size_t *) mem);
+    mem = p - sizeof(cc_memory_header_t);
+    cc_memory_header_t *header = (cc_memory_header_t *) mem;
 
-    // update counter
-    #pragma omp atomic
-    n_allocated -= nbytes;
+    // update counters
+    memory_released(header->nbytes, header->tag);
 
     // free memory
     free(mem);
 }
 
 
+/**
+ * Accounts memory which is not allocated with cc_malloc() but is still
+ * resident in RAM (for example, file mappings of on-disk blocks).
+ * The same memory limit as for cc_malloc() is applied.
+ */
+void cc_account_external(size_t nbytes)
+{
+    check_memory_limit(nbytes);
+
+    memory_allocated(nbytes, CC_MEMORY_TAG_MAPPINGS);
+}
+
+
+/**
+ * Releases memory accounted previously with cc_account_external().
+ */
+void cc_release_external(size_t nbytes)
+{
+    memory_released(nbytes, CC_MEMORY_TAG_MAPPINGS);
+}
+
+
+/**
+ * Registers the function which is called when the memory limit is reached.
+ * The handler must release (with cc_free()) at least the given number of
+ * bytes, if possible, and return the number of bytes released.
+ */
+void cc_set_eviction_handler(cc_eviction_handler_t handler)
+{
+    eviction_handler = handler;
+}
+
+
+/**
+ * Checks if 'nbytes' more bytes can be allocated without exceeding
+ * the memory limit. If the limit is reached, the eviction handler is called
+ * (in the critical section) to release memory. Aborts execution if nothing
+ * can be released.
+ * Allocations made by the eviction handler itself (i/o buffers) are allowed to
+ * exceed the limit temporarily.
+ */
+static int check_memory_limit(size_t nbytes)
+{
+    if (n_allocated + nbytes <= max_available) {
+        return 1;
+    }
+
+    if (in_eviction) {
+        return 1;
+    }
+
+    if (eviction_handler != NULL) {
+        #pragma omp critical (cc_eviction)
+        {
+            // the handler allocates a little itself (file names, i/o buffers),
+            // so it is called until the limit is met or nothing is released
+            in_eviction = 1;
+            while (n_allocated + nbytes > max_available) {
+                if (eviction_handler(n_allocated + nbytes - max_available) == 0) {
+                    break;
+                }
+            }
+            in_eviction = 0;
+        }
+    }
+
+    if (n_allocated + nbytes > max_available) {
+        printf("bytes allocated        = %ld\n", n_allocated);
+        printf("max memory usage limit = %ld\n", max_available);
+        printf("bytes available (free) = %ld\n", max_available - n_allocated);
+        printf("bytes required for the current allocation = %ld\n", nbytes);
+        printf("cc_malloc(): cannot allocate memory (not enough memory, nothing to evict)\n");
+        print_top_consumers("now", tag_usage, n_allocated, CC_MEMORY_TOP_CONSUMERS);
+        cc_memory_print_peak_consumers(CC_MEMORY_TOP_CONSUMERS);
+        abort();
+        return 0;
+    }
+
+    return 1;
+}
+
+
 void cc_finalize_allocator()
 {
     cc_memory_usage();
+    cc_memory_print_peak_consumers(CC_MEMORY_TOP_CONSUMERS);
+
+    if (timeline_file != NULL) {
+        write_timeline_sample(abs_time());
+        fclose(timeline_file);
+        timeline_file = NULL;
+    }
+}
+
+
+/**
+ * Sets the owner tag for subsequent allocations (diagram name or subsystem).
+ * Must be called by the master thread outside parallel regions.
+ */
+void cc_memory_push_tag(char *tag)
+{
+    if (tag_depth >= CC_MEMORY_MAX_TAG_DEPTH) {
+        // too deep nesting: attribute to the current owner
+        tag_depth++;
+        return;
+    }
+
+    tag_stack[tag_depth++] = curr_tag;
+    curr_tag = cc_memory_get_tag(tag);
+}
+
+
+/**
+ * Returns id of the owner tag with the given name, registers the new tag if
+ * needed. Can be called by any thread.
+ */
+int cc_memory_get_tag(char *name)
+{
+    int id = -1;
+
+    #pragma omp critical (cc_memory_tags)
+    {
+        for (int i = 0; i < n_tags; i++) {
+            if (strncmp(tag_names[i], name, CC_MEMORY_TAG_LENGTH - 1) == 0) {
+                id = i;
+                break;
+            }
+        }
+        if (id == -1 && n_tags < CC_MEMORY_MAX_TAGS) {
+            id = n_tags;
+            strncpy(tag_names[id], name, CC_MEMORY_TAG_LENGTH - 1);
+            tag_names[id][CC_MEMORY_TAG_LENGTH - 1] = '\0';
+            n_tags++;
+        }
+    }
+
+    // table of tags is full
+    return (id == -1) ? CC_MEMORY_TAG_UNTAGGED : id;
+}
+
+
+/**
+ * Sets the owner tag only if no owner is set yet (otherwise allocations are
+ * still attributed to the current owner, e.g. the subsystem). Must be paired
+ * with cc_memory_pop_tag().
+ */
+void cc_memory_push_default_tag(char *tag)
+{
+    if (tag_depth > 0) {
+        if (tag_depth < CC_MEMORY_MAX_TAG_DEPTH) {
+            tag_stack[tag_depth] = curr_tag;
+        }
+        tag_depth++;
+        return;
+    }
+
+    cc_memory_push_tag(tag);
+}
+
+
+/**
+ * Restores the previous owner tag.
+ */
+void cc_memory_pop_tag()
+{
+    if (tag_depth == 0) {
+        return;
+    }
+
+    tag_depth--;
+    if (tag_depth < CC_MEMORY_MAX_TAG_DEPTH) {
+        curr_tag = tag_stack[tag_depth];
+    }
+
+    if (timeline_file != NULL) {
+        double t = abs_time();
+        if (t - timeline_last >= CC_MEMORY_TIMELINE_INTERVAL) {
+            write_timeline_sample(t);
+        }
+    }
+}
+
+
+/**
+ * Enables the time series of memory usage by tags.
+ * CSV format: time (sec), tag, bytes. Samples are taken when tags are popped
+ * (at most once per CC_MEMORY_TIMELINE_INTERVAL seconds) and at new peaks.
+ */
+void cc_memory_enable_timeline(char *path)
+{
+    timeline_file = fopen(path, "w");
+    if (timeline_file == NULL) {
+        printf(" cannot open file '%s' for the memory timeline: %s\n", path, strerror(errno));
+        return;
+    }
+
+    fprintf(timeline_file, "time,tag,bytes\n");
+    timeline_t0 = abs_time();
+    timeline_last = timeline_t0;
+}
+
+
+/**
+ * Prints the 'n_top' largest consumers of memory at the peak of memory usage.
+ */
+void cc_memory_print_peak_consumers(int n_top)
+{
+    if (snapshot_peak == 0) {
+        return;
+    }
+
+    print_top_consumers("at the peak", tag_usage_at_peak, snapshot_peak, n_top);
 }
 
 
@@ -155,6 +428,121 @@ size_t cc_get_peak_memory_usage()
 }
 
 
+/*
+ * updates global and per-tag counters, saves memory usage by tags if the
+ * peak has grown sufficiently since the last snapshot
+ */
+static void memory_allocated(size_t nbytes, int tag)
+{
+    size_t curr;
+
+    #pragma omp atomic capture
+    curr = n_allocated += nbytes;
+
+    #pragma omp atomic
+    tag_usage[tag] += nbytes;
+
+    /*
+     * the high-water mark is updated by concurrent allocations and by
+     * cc_account_external(), so the read-compare-write must be atomic
+     */
+    size_t peak;
+    #pragma omp atomic read
+    peak = max_allocated;
+    if (curr > peak) {
+        #pragma omp critical (cc_memory_peak)
+        {
+            if (curr > max_allocated) {
+                max_allocated = curr;
+            }
+        }
+    }
+
+    if (curr > snapshot_peak * (1.0 + CC_MEMORY_SNAPSHOT_STEP)) {
+        #pragma omp critical (cc_memory_snapshot)
+        {
+            if (curr > snapshot_peak * (1.0 + CC_MEMORY_SNAPSHOT_STEP)) {
+                memcpy(tag_usage_at_peak, tag_usage, sizeof(size_t) * n_tags);
+                snapshot_peak = curr;
+                if (timeline_file != NULL) {
+                    double t = abs_time();
+                    if (t - timeline_last >= CC_MEMORY_TIMELINE_INTERVAL) {
+                        write_timeline_sample(t);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+static void memory_released(size_t nbytes, int tag)
+{
+    #pragma omp atomic
+    n_allocated -= nbytes;
+
+    #pragma omp atomic
+    tag_usage[tag] -= nbytes;
+}
+
+
+/*
+ * prints the 'n_top' largest entries of the table of memory usage by tags
+ */
+static void print_top_consumers(char *title, size_t *usage, size_t total, int n_top)
+{
+    const double b2mb = 1.0 / (1024.0 * 1024.0);
+    int order[CC_MEMORY_MAX_TAGS];
+
+    for (int i = 0; i < n_tags; i++) {
+        order[i] = i;
+    }
+
+    // partial selection sort: n_top is small
+    int n_print = 0;
+    for (int i = 0; i < n_tags && n_print < n_top; i++) {
+        int imax = i;
+        for (int j = i + 1; j < n_tags; j++) {
+            if (usage[order[j]] > usage[order[imax]]) {
+                imax = j;
+            }
+        }
+        int tmp = order[i];
+        order[i] = order[imax];
+        order[imax] = tmp;
+        if (usage[order[i]] == 0) {
+            break;
+        }
+        n_print++;
+    }
+
+    printf(" top consumers of memory %s (%.1f Mb):\n", title, b2mb * total);
+    for (int i = 0; i < n_print; i++) {
+        size_t nbytes = usage[order[i]];
+        printf("   %-32s %12.1f Mb  %5.1f%%\n", tag_names[order[i]], b2mb * nbytes, 100.0 * nbytes / total);
+    }
+}
+
+
+/*
+ * writes memory usage by tags (only non-zero entries) to the timeline file
+ */
+static void write_timeline_sample(double t)
+{
+    #pragma omp critical (cc_memory_timeline)
+    {
+        double dt = t - timeline_t0;
+        fprintf(timeline_file, "%.3f,total,%zu\n", dt, n_allocated);
+        for (int i = 0; i < n_tags; i++) {
+            if (tag_usage[i] != 0) {
+                fprintf(timeline_file, "%.3f,%s,%zu\n", dt, tag_names[i], tag_usage[i]);
+            }
+        }
+        timeline_last = t;
+    }
+}
+
+
 /*
  * Duplicate a string.
  */
@@ -174,7 +562,7 @@ char *cc_strdup(const char *src)
 /*
  * Duplicate a block of bytes.
  */
-void *cc_memdup(const void *src, size_t n_bytes)
+char *cc_memdup(const void *src, size_t n_bytes)
 {
     void *dest = cc_malloc(n_bytes);
     if (dest == NULL) {
@@ -33,12 +33,14 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "checkpoint.h"
 #include "codata.h"
 #include "crop.h"
 #include "diis.h"
 #include "engine.h"
 #include "methods.h"
 #include "options.h"
+#include "sort.h"
 #include "symmetry.h"
 #include "utils.h"
 
@@ -76,6 +78,19 @@ int solve_amplitude_equations(
     int do_doubles = (doubles != NULL) ? 1 : 0;
     int do_triples = (triples != NULL) ? 1 : 0;
 
+    /*
+     * restart from the checkpoint (if any)
+     */
+    checkpoint_solve_t ckpt = {
+        sector_h, sector_p,
+        singles, singles_buf,
+        doubles, doubles_buf,
+        triples, triples_buf,
+        veff, NULL, NULL
+    };
+    int n_iter_done = 0;
+    int restart = checkpoint_begin_solve(&ckpt, &n_iter_done);
+
     /*
      * setup DIIS/CROP
      */
@@ -87,6 +102,11 @@ int solve_amplitude_equations(
     else if (cc_opts->crop_enabled) {
         crop_queue = new_crop_queue(do_singles, do_doubles, do_triples && cc_opts->crop_triples);
     }
+    ckpt.diis_queue = diis_queue;
+    ckpt.crop_queue = crop_queue;
+    if (restart == CC_CHECKPOINT_STATE) {
+        checkpoint_restore_state(&ckpt, &prev_ecorr);
+    }
 
     /*
      * beautiful header before iterations
@@ -100,8 +120,15 @@ int solve_amplitude_equations(
     int diverged = 0;
     double time_start = abs_time();
 
-    for (iter = 1; iter <= cc_opts->maxiter; iter++) {
+    if (restart == CC_CHECKPOINT_SOLVED) {
+        iter = n_iter_done;
+        converged = 1;
+        goto finalize;
+    }
+
+    for (iter = n_iter_done + 1; iter <= cc_opts->maxiter; iter++) {
         double it_t1, it_t2;
+        int do_flush = 0;
         it_t1 = abs_time();
 
         /*
@@ -309,7 +336,8 @@ int solve_amplitude_equations(
         /*
          * flush amplitudes to disk if needed
          */
-        if (cc_opts->do_flush_iter && (iter % cc_opts->do_flush_iter == 0)) {
+        do_flush = checkpoint_due(iter);
+        if (do_flush) {
             save_cluster_amplitudes(sector_h, sector_p, singles, doubles, triples, veff);
         }
 
@@ -342,11 +370,23 @@ int solve_amplitude_equations(
         if (converged || diverged) {
             break;
         }
+
+        /*
+         * restart checkpoint: the iteration is complete
+         */
+        if (do_flush) {
+            checkpoint_save(&ckpt, iter, prev_ecorr);
+        }
+    }
+
+    if (converged) {
+        checkpoint_solved(&ckpt, iter);
     }
 
     /*
      * finalize DIIS/CROP
      */
+    finalize:
     if (diis_queue) {
         delete_diis_queue(diis_queue);
     }
@@ -803,3 +843,117 @@ void print_iterations_table_footer(int singles_column, int doubles_column, int t
     }
     printf("\n");
 }
+
+
+/**
+ * Sectors to be solved for the target sector, in the same order as in main().
+ * Returns the number of sectors (0 if the target sector is not implemented).
+ */
+int get_visited_sectors(int sect_h, int sect_p, int *visited_h, int *visited_p)
+{
+    static const char *paths[][CC_MAX_VISITED_SECTORS + 1] = {
+            {"0h0p"},
+            {"0h0p", "0h1p"},
+            {"0h0p", "1h0p"},
+            {"0h0p", "1h0p", "0h1p", "1h1p"},
+            {"0h0p", "0h1p", "0h2p"},
+            {"0h0p", "1h0p", "2h0p"},
+            {"0h0p", "0h1p", "0h2p", "0h3p"},
+            {"0h0p", "1h0p", "2h0p", "3h0p"},
+            {"0h0p", "1h0p", "0h1p", "1h1p", "0h2p", "1h2p"},
+            {"0h0p", "1h0p", "0h1p", "1h1p", "2h0p", "2h1p"},
+    };
+    int n_paths = sizeof(paths) / sizeof(paths[0]);
+    char target[16];
+
+    sprintf(target, "%dh%dp", sect_h, sect_p);
+
+    for (int ipath = 0; ipath < n_paths; ipath++) {
+        int len = 0;
+        while (len < CC_MAX_VISITED_SECTORS && paths[ipath][len] != NULL) {
+            len++;
+        }
+        if (strcmp(paths[ipath][len - 1], target) != 0) {
+            continue;
+        }
+
+        for (int i = 0; i < len; i++) {
+            sscanf(paths[ipath][i], "%dh%dp", &visited_h[i], &visited_p[i]);
+        }
+        return len;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Registers requests for sorting of integrals used in the given sector.
+ */
+void request_integrals(int sect_h, int sect_p)
+{
+    if (sect_h == 0 && sect_p == 0) {
+        request_integrals_0h0p();
+    }
+    else if (sect_h == 0 && sect_p == 1) {
+        request_integrals_0h1p();
+    }
+    else if (sect_h == 1 && sect_p == 0) {
+        request_integrals_1h0p();
+    }
+    else if (sect_h == 1 && sect_p == 1) {
+        request_integrals_1h1p();
+    }
+    else if (sect_h == 0 && sect_p == 2) {
+        request_integrals_0h2p();
+    }
+    else if (sect_h == 2 && sect_p == 0) {
+        request_integrals_2h0p();
+    }
+    else if (sect_h == 0 && sect_p == 3) {
+        request_integrals_0h3p();
+    }
+    else if (sect_h == 3 && sect_p == 0) {
+        request_integrals_3h0p();
+    }
+    else if (sect_h == 1 && sect_p == 2) {
+        request_integrals_1h2p();
+    }
+    else if (sect_h == 2 && sect_p == 1) {
+        request_integrals_2h1p();
+    }
+    else {
+        errquit("request_integrals(): sector %dh%dp is not implemented", sect_h, sect_p);
+    }
+}
+
+
+/**
+ * Sorts integrals required for all the sectors on the way to the target one
+ * in a single pass over the raw integrals (see perform_presorting()).
+ * Each sector then only picks up its diagrams.
+ */
+void presort_integrals(cc_options_t *opts)
+{
+    int visited_h[CC_MAX_VISITED_SECTORS];
+    int visited_p[CC_MAX_VISITED_SECTORS];
+
+    if (!opts->presort_integrals || opts->reuse_integrals_1 || opts->reuse_integrals_2) {
+        return;
+    }
+
+    int n_visited = get_visited_sectors(opts->sector_h, opts->sector_p, visited_h, visited_p);
+    if (n_visited < 2) {
+        return;
+    }
+
+    for (int i = 0; i < n_visited; i++) {
+        opts->curr_sector_h = visited_h[i];
+        opts->curr_sector_p = visited_p[i];
+        request_integrals(visited_h[i], visited_p[i]);
+    }
+
+    opts->curr_sector_h = visited_h[0];
+    opts->curr_sector_p = visited_p[0];
+    perform_presorting();
+}
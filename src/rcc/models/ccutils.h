@@ -31,6 +31,9 @@
 #include "comdef.h"
 #include "options.h"
 
+// max number of sectors solved on the way to the target sector
+#define CC_MAX_VISITED_SECTORS 6
+
 void print_sector_banner(int sect_h, int sect_p);
 
 void damping(int h, int p, char *old_ampl, char *new_ampl, int iter);
@@ -74,4 +77,8 @@ int solve_amplitude_equations(
         void (*construct_folded)()
 );
 
+int get_visited_sectors(int sect_h, int sect_p, int *visited_h, int *visited_p);
+
+void request_integrals(int sect_h, int sect_p);
+
 #endif /* CC_CCUTILS_H_INCLUDED */
@@ -0,0 +1,1052 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Restart checkpoints for the iterative solution of amplitude equations
+ * (see checkpoint.h).
+ */
+
+// fsync()
+#define _DEFAULT_SOURCE
+
+#include "checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "engine.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "options.h"
+#include "timer.h"
+#include "utils.h"
+#include "../sorting/sort_cache.h"
+
+#define CC_CHECKPOINT_MAGIC "EXPTCKPT"
+
+// version of the file layout; to be incremented when the layout changes
+#define CC_CHECKPOINT_VERSION 1
+
+#define CC_CHECKPOINT_FILE "checkpoint.chk"
+
+// max number of files written by the background thread at once
+#define CC_CHECKPOINT_MAX_FILES 2
+
+// adds the value of the variable 'x' to the hash 'h'
+#define HASH_VALUE(h, x) fnv1a_hash((h), &(x), sizeof(x))
+
+/*
+ * header of the checkpoint files (both checkpoint.chk and checkpoint-<i>.chk)
+ */
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t n_solved;      // number of converged solutions (checkpoint.chk)
+    uint64_t fingerprint;  // calculation the checkpoint belongs to
+    int32_t has_state;     // state of the current solution follows (checkpoint.chk)
+    int32_t solve_index;   // number of the solution in the sequence
+    int32_t sector_h;
+    int32_t sector_p;
+    int32_t in_lambda;
+    int32_t iter;          // number of iterations completed
+    int32_t diis_enabled;  // DIIS/CROP can be switched off during iterations
+    int32_t crop_enabled;
+    double prev_ecorr;
+    int64_t data_size;     // bytes following the header
+} checkpoint_header_t;
+
+/*
+ * destination of the serialized data: in-memory image, file or nothing
+ * (only the size is counted)
+ */
+typedef struct {
+    char *image;
+    int fd;
+    size_t pos;
+    int error;
+} checkpoint_sink_t;
+
+/*
+ * writes the header and data of the file
+ */
+typedef void (*checkpoint_put_func_t)(checkpoint_sink_t *sink, checkpoint_header_t *hdr, checkpoint_solve_t *s);
+
+/*
+ * files to be written by the background thread
+ */
+typedef struct {
+    int n_files;
+    char path[CC_CHECKPOINT_MAX_FILES][CC_MAX_PATH_LENGTH];
+    char *image[CC_CHECKPOINT_MAX_FILES];
+    size_t size[CC_CHECKPOINT_MAX_FILES];
+    int error;  // errno of the failed operation (0 if succeeded)
+    char *failed_path;
+} checkpoint_job_t;
+
+/*
+ * state of the module
+ */
+static int n_solves = 0;                     // solutions started in this run
+static int restart_ready = 0;                // checkpoint on disk has been examined
+static int restart_n_solved = 0;             // converged solutions available on disk
+static int restart_has_state = 0;            // state of the next solution is available on disk
+static checkpoint_header_t restart_header;   // header of checkpoint.chk
+static uint64_t fingerprint = 0;
+static double last_save_time = 0.0;
+
+static pthread_t writer_thread;
+static int writer_running = 0;
+static checkpoint_job_t writer_job;
+
+static int checkpoint_enabled();
+
+static void init_restart();
+
+static uint64_t get_fingerprint();
+
+static void get_solved_file_name(int index, char *path);
+
+static int open_checkpoint_file(char *path, checkpoint_header_t *hdr);
+
+static void init_header(checkpoint_header_t *hdr, checkpoint_solve_t *s, int iter);
+
+static void put_main_file(checkpoint_sink_t *sink, checkpoint_header_t *hdr, checkpoint_solve_t *s);
+
+static void put_solved_file(checkpoint_sink_t *sink, checkpoint_header_t *hdr, checkpoint_solve_t *s);
+
+static void put_queue(checkpoint_sink_t *sink, int n, int do_t1, int do_t2, int do_t3,
+                      char (*t1)[CC_DIAGRAM_MAX_NAME], char (*e1)[CC_DIAGRAM_MAX_NAME],
+                      char (*t2)[CC_DIAGRAM_MAX_NAME], char (*e2)[CC_DIAGRAM_MAX_NAME],
+                      char (*t3)[CC_DIAGRAM_MAX_NAME], char (*e3)[CC_DIAGRAM_MAX_NAME],
+                      checkpoint_solve_t *s);
+
+static void put_diagram(checkpoint_sink_t *sink, char *name, char *template);
+
+static void sink_put(checkpoint_sink_t *sink, const void *data, size_t count);
+
+static void read_queue_names(int fd, int n,
+                             char (*t1)[CC_DIAGRAM_MAX_NAME], char (*e1)[CC_DIAGRAM_MAX_NAME],
+                             char (*t2)[CC_DIAGRAM_MAX_NAME], char (*e2)[CC_DIAGRAM_MAX_NAME],
+                             char (*t3)[CC_DIAGRAM_MAX_NAME], char (*e3)[CC_DIAGRAM_MAX_NAME]);
+
+static void read_diagrams(int fd, char *path);
+
+static void write_files(int n_files, char **paths, checkpoint_put_func_t *put_funcs,
+                        checkpoint_header_t *headers, checkpoint_solve_t *s);
+
+static void *writer_main(void *arg);
+
+static int open_tmp_file(char *path);
+
+static int commit_tmp_file(char *path, int fd, int error);
+
+static void report_write_error(char *path, int error);
+
+static void join_writer();
+
+
+/**
+ * Registers the next solution of amplitude equations and restores it from
+ * the checkpoint if possible.
+ *
+ * Returns:
+ *   CC_CHECKPOINT_SOLVED  the converged solution is restored (amplitudes,
+ *                         buffers, veff), 'iter' = number of iterations made
+ *   CC_CHECKPOINT_STATE   flags of DIIS/CROP are restored, 'iter' = number of
+ *                         iterations completed; the rest of the state is to be
+ *                         restored by checkpoint_restore_state() after the
+ *                         DIIS/CROP queues are created
+ *   CC_CHECKPOINT_NONE    nothing is restored, 'iter' = 0
+ */
+int checkpoint_begin_solve(checkpoint_solve_t *s, int *iter)
+{
+    char path[CC_MAX_PATH_LENGTH];
+    checkpoint_header_t hdr;
+
+    int index = n_solves++;
+    *iter = 0;
+
+    if (!checkpoint_enabled()) {
+        return CC_CHECKPOINT_NONE;
+    }
+
+    init_restart();
+
+    if (index < restart_n_solved) {
+        get_solved_file_name(index, path);
+        int fd = open_checkpoint_file(path, &hdr);
+        if (fd != -1 && hdr.solve_index == index &&
+            hdr.sector_h == s->sector_h && hdr.sector_p == s->sector_p &&
+            hdr.in_lambda == cc_opts->curr_in_lambda_equations) {
+
+            read_diagrams(fd, path);
+            io_close(fd);
+            cc_opts->diis_enabled = hdr.diis_enabled;
+            cc_opts->crop_enabled = hdr.crop_enabled;
+            printf(" solution is restored from the checkpoint file %s\n", path);
+
+            *iter = hdr.iter;
+            return CC_CHECKPOINT_SOLVED;
+        }
+
+        if (fd != -1) {
+            io_close(fd);
+        }
+        printf(" Warning: checkpoint file %s does not match the calculation, the rest of the checkpoint is ignored\n",
+               path);
+        restart_n_solved = 0;
+        restart_has_state = 0;
+        return CC_CHECKPOINT_NONE;
+    }
+
+    if (index == restart_n_solved && restart_has_state) {
+        hdr = restart_header;
+        if (hdr.solve_index == index &&
+            hdr.sector_h == s->sector_h && hdr.sector_p == s->sector_p &&
+            hdr.in_lambda == cc_opts->curr_in_lambda_equations) {
+
+            cc_opts->diis_enabled = hdr.diis_enabled;
+            cc_opts->crop_enabled = hdr.crop_enabled;
+            printf(" restart from the checkpoint file %s after iteration %d\n", CC_CHECKPOINT_FILE, hdr.iter);
+
+            *iter = hdr.iter;
+            return CC_CHECKPOINT_STATE;
+        }
+
+        printf(" Warning: checkpoint file %s does not match the calculation and is ignored\n", CC_CHECKPOINT_FILE);
+        restart_has_state = 0;
+    }
+
+    return CC_CHECKPOINT_NONE;
+}
+
+
+/**
+ * Restores amplitudes and the DIIS/CROP subspace of the current solution
+ * (after checkpoint_begin_solve() has returned CC_CHECKPOINT_STATE).
+ * Buffers of amplitudes are set equal to amplitudes, as at the end of
+ * the iteration.
+ */
+void checkpoint_restore_state(checkpoint_solve_t *s, double *prev_ecorr)
+{
+    checkpoint_header_t hdr;
+    int32_t queue_type, queue_len;
+
+    restart_has_state = 0;
+
+    int fd = open_checkpoint_file(CC_CHECKPOINT_FILE, &hdr);
+    if (fd == -1) {
+        errquit("checkpoint_restore_state(): unable to read the checkpoint file %s", CC_CHECKPOINT_FILE);
+    }
+
+    /*
+     * DIIS/CROP queue: names of diagrams and the DIIS error matrix
+     */
+    io_read(fd, &queue_type, sizeof(int32_t));
+    io_read(fd, &queue_len, sizeof(int32_t));
+
+    diis_queue_t *dq = s->diis_queue;
+    crop_queue_t *cq = s->crop_queue;
+    if (queue_type == 1) {
+        if (dq == NULL) {
+            errquit("checkpoint file %s is inconsistent with the DIIS settings", CC_CHECKPOINT_FILE);
+        }
+        read_queue_names(fd, queue_len, dq->t1, dq->e1, dq->t2, dq->e2, dq->t3, dq->e3);
+        for (int i = 0; i < queue_len; i++) {
+            io_read(fd, &dq->err_matrix[i * DIIS_MAX], sizeof(double) * queue_len);
+        }
+        dq->n = queue_len;
+    }
+    else if (queue_type == 2) {
+        if (cq == NULL) {
+            errquit("checkpoint file %s is inconsistent with the CROP settings", CC_CHECKPOINT_FILE);
+        }
+        read_queue_names(fd, queue_len, cq->t1, cq->e1, cq->t2, cq->e2, cq->t3, cq->e3);
+        cq->n = queue_len;
+    }
+
+    /*
+     * amplitudes, effective interaction and vectors of the subspace
+     */
+    read_diagrams(fd, CC_CHECKPOINT_FILE);
+    io_close(fd);
+
+    char *amplitudes[] = {s->singles, s->doubles, s->triples};
+    char *buffers[] = {s->singles_buf, s->doubles_buf, s->triples_buf};
+    for (int i = 0; i < 3; i++) {
+        if (amplitudes[i] == NULL || buffers[i] == NULL) {
+            continue;
+        }
+        diagram_t *src = diagram_stack_find(amplitudes[i]);
+        diagram_t *dst = diagram_stack_find(buffers[i]);
+        if (src == NULL || dst == NULL || src->n_blocks != dst->n_blocks) {
+            continue;
+        }
+        for (size_t ib = 0; ib < src->n_blocks; ib++) {
+            block_copy_data(dst->blocks[ib], src->blocks[ib]);
+        }
+    }
+
+    *prev_ecorr = hdr.prev_ecorr;
+    last_save_time = abs_time();
+}
+
+
+/**
+ * Returns 1 if the checkpoint is to be written after the given iteration
+ * (and non-converged amplitudes are to be flushed), 0 otherwise.
+ */
+int checkpoint_due(int iter)
+{
+    if (!checkpoint_enabled()) {
+        return 0;
+    }
+
+    if (cc_opts->do_flush_iter > 0 && iter % cc_opts->do_flush_iter == 0) {
+        return 1;
+    }
+
+    if (cc_opts->do_flush_time > 0 && abs_time() - last_save_time >= cc_opts->do_flush_time) {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Writes the state of the current solution after the iteration 'iter'
+ * has been completed.
+ */
+void checkpoint_save(checkpoint_solve_t *s, int iter, double prev_ecorr)
+{
+    if (!checkpoint_enabled()) {
+        return;
+    }
+
+    init_restart();
+
+    checkpoint_header_t hdr;
+    init_header(&hdr, s, iter);
+    hdr.n_solved = n_solves - 1;
+    hdr.has_state = 1;
+    hdr.prev_ecorr = prev_ecorr;
+
+    char *paths[] = {CC_CHECKPOINT_FILE};
+    checkpoint_put_func_t put_funcs[] = {put_main_file};
+    write_files(1, paths, put_funcs, &hdr, s);
+
+    last_save_time = abs_time();
+}
+
+
+/**
+ * Writes the converged solution (obtained in 'iter' iterations)
+ * and marks it as completed.
+ */
+void checkpoint_solved(checkpoint_solve_t *s, int iter)
+{
+    char path[CC_MAX_PATH_LENGTH];
+
+    if (!checkpoint_enabled()) {
+        return;
+    }
+
+    init_restart();
+
+    checkpoint_header_t headers[2];
+    init_header(&headers[0], s, iter);
+    init_header(&headers[1], s, iter);
+    headers[1].n_solved = n_solves;
+
+    // the solution is written first: the main file never refers to
+    // the solution which is absent on disk
+    get_solved_file_name(n_solves - 1, path);
+    char *paths[] = {path, CC_CHECKPOINT_FILE};
+    checkpoint_put_func_t put_funcs[] = {put_solved_file, put_main_file};
+    write_files(2, paths, put_funcs, headers, s);
+
+    last_save_time = abs_time();
+}
+
+
+/**
+ * Waits for the checkpoint to be written. Checkpoint files are removed
+ * after the successful run and are kept for restart otherwise.
+ */
+void checkpoint_finalize(int success)
+{
+    char path[CC_MAX_PATH_LENGTH];
+
+    if (!checkpoint_enabled()) {
+        return;
+    }
+
+    join_writer();
+
+    if (!success) {
+        if (io_file_exists(CC_CHECKPOINT_FILE)) {
+            printf(" restart checkpoint is kept in %s\n", CC_CHECKPOINT_FILE);
+        }
+        return;
+    }
+
+    int n_files = MAX(n_solves, restart_n_solved);
+    for (int i = 0; i < n_files; i++) {
+        get_solved_file_name(i, path);
+        if (io_file_exists(path)) {
+            io_remove(path);
+        }
+    }
+    if (io_file_exists(CC_CHECKPOINT_FILE)) {
+        io_remove(CC_CHECKPOINT_FILE);
+    }
+}
+
+
+static int checkpoint_enabled()
+{
+    return cc_opts->do_flush_iter > 0 || cc_opts->do_flush_time > 0;
+}
+
+
+/*
+ * examines the checkpoint on disk (once per run)
+ */
+static void init_restart()
+{
+    checkpoint_header_t hdr;
+
+    if (restart_ready) {
+        return;
+    }
+    restart_ready = 1;
+    fingerprint = get_fingerprint();
+    last_save_time = abs_time();
+
+    if (!io_file_exists(CC_CHECKPOINT_FILE)) {
+        return;
+    }
+
+    int fd = open_checkpoint_file(CC_CHECKPOINT_FILE, &hdr);
+    if (fd == -1) {
+        printf(" Warning: checkpoint file %s does not match the calculation and is ignored\n", CC_CHECKPOINT_FILE);
+        return;
+    }
+    io_close(fd);
+
+    restart_header = hdr;
+    restart_n_solved = hdr.n_solved;
+    restart_has_state = hdr.has_state;
+    printf(" Restart checkpoint %s is found: %d solution(s) converged", CC_CHECKPOINT_FILE, restart_n_solved);
+    if (restart_has_state) {
+        printf(", %d iteration(s) of the next one completed", hdr.iter);
+    }
+    printf("\n");
+}
+
+
+/*
+ * the checkpoint is valid only for the same integrals, spinor spaces, layout
+ * of data (see sort_cache_system_key()) and the options which affect
+ * iterations or the sequence of solutions
+ */
+static uint64_t get_fingerprint()
+{
+    cc_options_t *opts = cc_opts;
+    int version = CC_CHECKPOINT_VERSION;
+
+    uint64_t h = sort_cache_system_key();
+    h = HASH_VALUE(h, version);
+
+    // model, target sector and convergence
+    h = HASH_VALUE(h, opts->cc_model);
+    h = HASH_VALUE(h, opts->hughes_kaldor_1h2p);
+    h = HASH_VALUE(h, opts->hughes_kaldor_2h1p);
+    h = HASH_VALUE(h, opts->sector_h);
+    h = HASH_VALUE(h, opts->sector_p);
+    h = HASH_VALUE(h, opts->conv_thresh);
+    h = HASH_VALUE(h, opts->use_goldstone);
+    h = HASH_VALUE(h, opts->use_oe);
+    h = HASH_VALUE(h, opts->do_compress_triples);
+    h = HASH_VALUE(h, opts->skip_sector);
+    h = HASH_VALUE(h, opts->reuse_amplitudes);
+    h = HASH_VALUE(h, opts->calc_density);
+
+    // convergence acceleration and damping
+    h = HASH_VALUE(h, opts->diis_enabled);
+    h = HASH_VALUE(h, opts->diis_dim);
+    h = HASH_VALUE(h, opts->diis_triples);
+    h = HASH_VALUE(h, opts->crop_enabled);
+    h = HASH_VALUE(h, opts->crop_dim);
+    h = HASH_VALUE(h, opts->crop_triples);
+    for (int i = 0; i < MAX_SECTOR_RANK; i++) {
+        for (int j = 0; j < MAX_SECTOR_RANK; j++) {
+            cc_damping_params_t *damp = &opts->damping[i][j];
+            h = HASH_VALUE(h, damp->enabled);
+            h = HASH_VALUE(h, damp->stop);
+            h = HASH_VALUE(h, damp->factor);
+        }
+    }
+
+    // denominator shifts
+    h = HASH_VALUE(h, opts->shift_type);
+    for (int i = 0; i < MAX_SECTOR_RANK; i++) {
+        for (int j = 0; j < MAX_SECTOR_RANK; j++) {
+            cc_shift_params_t *shift = &opts->shifts[i][j];
+            h = HASH_VALUE(h, shift->enabled);
+            h = HASH_VALUE(h, shift->type);
+            h = HASH_VALUE(h, shift->power);
+            h = HASH_VALUE(h, shift->shifts);
+        }
+    }
+    h = HASH_VALUE(h, opts->do_intham_imms);
+    if (opts->do_intham_imms) {
+        h = HASH_VALUE(h, opts->intham_imms_opts);
+    }
+
+    // selection of amplitudes
+    h = HASH_VALUE(h, opts->n_select);
+    for (int i = 0; i < opts->n_select; i++) {
+        ampl_selection_t *sel = &opts->selects[i];
+        h = HASH_VALUE(h, sel->sect_h);
+        h = HASH_VALUE(h, sel->sect_p);
+        h = HASH_VALUE(h, sel->rank);
+        h = HASH_VALUE(h, sel->task);
+        h = HASH_VALUE(h, sel->rule);
+        h = HASH_VALUE(h, sel->e1);
+        h = HASH_VALUE(h, sel->e2);
+    }
+    h = HASH_VALUE(h, opts->do_restrict_t3);
+    if (opts->do_restrict_t3) {
+        h = HASH_VALUE(h, opts->restrict_t3_bounds);
+    }
+
+    return h;
+}
+
+
+static void get_solved_file_name(int index, char *path)
+{
+    snprintf(path, CC_MAX_PATH_LENGTH, "checkpoint-%d.chk", index);
+}
+
+
+/*
+ * opens the checkpoint file and reads its header.
+ * returns the descriptor positioned after the header or -1 if the file is
+ * absent, truncated or belongs to another calculation.
+ */
+static int open_checkpoint_file(char *path, checkpoint_header_t *hdr)
+{
+    if (!io_file_exists(path) || io_fsize(path) < sizeof(checkpoint_header_t)) {
+        return -1;
+    }
+
+    int fd = io_open(path, "r");
+    if (fd == -1) {
+        return -1;
+    }
+    io_read(fd, hdr, sizeof(checkpoint_header_t));
+
+    if (memcmp(hdr->magic, CC_CHECKPOINT_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != CC_CHECKPOINT_VERSION ||
+        hdr->fingerprint != fingerprint ||
+        hdr->data_size < 0 ||
+        io_fsize(path) != sizeof(checkpoint_header_t) + (size_t) hdr->data_size) {
+        io_close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+static void init_header(checkpoint_header_t *hdr, checkpoint_solve_t *s, int iter)
+{
+    memset(hdr, 0, sizeof(checkpoint_header_t));
+    memcpy(hdr->magic, CC_CHECKPOINT_MAGIC, sizeof(hdr->magic));
+    hdr->version = CC_CHECKPOINT_VERSION;
+    hdr->fingerprint = fingerprint;
+    hdr->solve_index = n_solves - 1;
+    hdr->sector_h = s->sector_h;
+    hdr->sector_p = s->sector_p;
+    hdr->in_lambda = cc_opts->curr_in_lambda_equations;
+    hdr->iter = iter;
+    hdr->diis_enabled = cc_opts->diis_enabled;
+    hdr->crop_enabled = cc_opts->crop_enabled;
+}
+
+
+/*
+ * checkpoint.chk: header and the state of the current solution (if any):
+ *   DIIS/CROP queue: type (0 = none, 1 = DIIS, 2 = CROP), length, names of
+ *                    diagrams (empty for parts which are not extrapolated),
+ *                    DIIS error matrix
+ *   diagrams: amplitudes, effective interaction, vectors of the subspace
+ */
+static void put_main_file(checkpoint_sink_t *sink, checkpoint_header_t *hdr, checkpoint_solve_t *s)
+{
+    sink_put(sink, hdr, sizeof(checkpoint_header_t));
+    if (!hdr->has_state) {
+        return;
+    }
+
+    // the queue is not used anymore if the accelerator has been switched off
+    int32_t queue_type = 0;
+    int32_t queue_len = 0;
+    if (s->diis_queue != NULL && hdr->diis_enabled) {
+        queue_type = 1;
+        queue_len = s->diis_queue->n;
+    }
+    else if (s->crop_queue != NULL && hdr->crop_enabled) {
+        queue_type = 2;
+        queue_len = s->crop_queue->n;
+    }
+    sink_put(sink, &queue_type, sizeof(int32_t));
+    sink_put(sink, &queue_len, sizeof(int32_t));
+
+    if (queue_type == 1) {
+        diis_queue_t *q = s->diis_queue;
+        put_queue(sink, q->n, q->do_t1, q->do_t2, q->do_t3, q->t1, q->e1, q->t2, q->e2, q->t3, q->e3, NULL);
+        for (int i = 0; i < q->n; i++) {
+            sink_put(sink, &q->err_matrix[i * DIIS_MAX], sizeof(double) * q->n);
+        }
+    }
+    else if (queue_type == 2) {
+        crop_queue_t *q = s->crop_queue;
+        put_queue(sink, q->n, q->do_t1, q->do_t2, q->do_t3, q->t1, q->e1, q->t2, q->e2, q->t3, q->e3, NULL);
+    }
+
+    put_diagram(sink, s->singles, NULL);
+    put_diagram(sink, s->doubles, NULL);
+    put_diagram(sink, s->triples, NULL);
+    put_diagram(sink, s->veff, NULL);
+    if (queue_type == 1) {
+        diis_queue_t *q = s->diis_queue;
+        put_queue(sink, q->n, q->do_t1, q->do_t2, q->do_t3, q->t1, q->e1, q->t2, q->e2, q->t3, q->e3, s);
+    }
+    else if (queue_type == 2) {
+        crop_queue_t *q = s->crop_queue;
+        put_queue(sink, q->n, q->do_t1, q->do_t2, q->do_t3, q->t1, q->e1, q->t2, q->e2, q->t3, q->e3, s);
+    }
+
+    // end of the list of diagrams
+    put_diagram(sink, "", NULL);
+}
+
+
+/*
+ * checkpoint-<i>.chk: header and diagrams of the converged solution
+ */
+static void put_solved_file(checkpoint_sink_t *sink, checkpoint_header_t *hdr, checkpoint_solve_t *s)
+{
+    sink_put(sink, hdr, sizeof(checkpoint_header_t));
+
+    put_diagram(sink, s->singles, NULL);
+    put_diagram(sink, s->singles_buf, NULL);
+    put_diagram(sink, s->doubles, NULL);
+    put_diagram(sink, s->doubles_buf, NULL);
+    put_diagram(sink, s->triples, NULL);
+    put_diagram(sink, s->triples_buf, NULL);
+    put_diagram(sink, s->veff, NULL);
+
+    // end of the list of diagrams
+    put_diagram(sink, "", NULL);
+}
+
+
+/*
+ * s == NULL: names of diagrams of the queue (empty names for parts which are
+ *            not extrapolated);
+ * s != NULL: diagrams of the queue, amplitudes are used as templates to
+ *            create them on restart
+ */
+static void put_queue(checkpoint_sink_t *sink, int n, int do_t1, int do_t2, int do_t3,
+                      char (*t1)[CC_DIAGRAM_MAX_NAME], char (*e1)[CC_DIAGRAM_MAX_NAME],
+                      char (*t2)[CC_DIAGRAM_MAX_NAME], char (*e2)[CC_DIAGRAM_MAX_NAME],
+                      char (*t3)[CC_DIAGRAM_MAX_NAME], char (*e3)[CC_DIAGRAM_MAX_NAME],
+                      checkpoint_solve_t *s)
+{
+    char empty[CC_DIAGRAM_MAX_NAME];
+    memset(empty, 0, sizeof(empty));
+
+    int do_parts[] = {do_t1, do_t2, do_t3};
+    char (*t_names[])[CC_DIAGRAM_MAX_NAME] = {t1, t2, t3};
+    char (*e_names[])[CC_DIAGRAM_MAX_NAME] = {e1, e2, e3};
+
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            if (s == NULL) {
+                sink_put(sink, do_parts[k] ? t_names[k][i] : empty, CC_DIAGRAM_MAX_NAME);
+                sink_put(sink, do_parts[k] ? e_names[k][i] : empty, CC_DIAGRAM_MAX_NAME);
+            }
+            else if (do_parts[k]) {
+                char *template = (k == 0) ? s->singles : (k == 1) ? s->doubles : s->triples;
+                put_diagram(sink, t_names[k][i], template);
+                put_diagram(sink, e_names[k][i], template);
+            }
+        }
+    }
+}
+
+
+/*
+ * record of the diagram:
+ *   name, template (to be copied if the diagram is absent on restart),
+ *   flag 'evictable', number of blocks, then for each stored block:
+ *   index, size and data (terminated by the index -1).
+ * the empty name marks the end of the list of diagrams.
+ */
+static void put_diagram(checkpoint_sink_t *sink, char *name, char *template)
+{
+    char name_buf[CC_DIAGRAM_MAX_NAME];
+    char template_buf[CC_DIAGRAM_MAX_NAME];
+    int32_t flags[2] = {0, 0};
+    int64_t n_blocks = 0;
+    int64_t end_of_blocks = -1;
+
+    if (name == NULL) {
+        return;
+    }
+
+    diagram_t *dg = NULL;
+    if (name[0] != '\0') {
+        dg = diagram_stack_find(name);
+        if (dg == NULL) {
+            return;
+        }
+    }
+
+    memset(name_buf, 0, sizeof(name_buf));
+    memset(template_buf, 0, sizeof(template_buf));
+    strncpy(name_buf, name, CC_DIAGRAM_MAX_NAME - 1);
+    if (template != NULL) {
+        strncpy(template_buf, template, CC_DIAGRAM_MAX_NAME - 1);
+    }
+    sink_put(sink, name_buf, CC_DIAGRAM_MAX_NAME);
+    if (dg == NULL) {
+        return;
+    }
+    sink_put(sink, template_buf, CC_DIAGRAM_MAX_NAME);
+
+    n_blocks = dg->n_blocks;
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        flags[0] = flags[0] || dg->blocks[ib]->is_evictable;
+    }
+    sink_put(sink, flags, sizeof(flags));
+    sink_put(sink, &n_blocks, sizeof(int64_t));
+
+    int counting = (sink->image == NULL && sink->fd == -1);
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        block_t *block = dg->blocks[ib];
+        if (block->storage_type == CC_DIAGRAM_DUMMY) {
+            continue;
+        }
+
+        int64_t index = ib;
+        int64_t size = block->size;
+        size_t n_bytes = block->size * SIZEOF_WORKING_TYPE;
+        sink_put(sink, &index, sizeof(int64_t));
+        sink_put(sink, &size, sizeof(int64_t));
+        if (counting) {
+            sink->pos += n_bytes;
+            continue;
+        }
+        block_load(block);
+        sink_put(sink, block->buf, n_bytes);
+        block_unload(block);
+    }
+
+    sink_put(sink, &end_of_blocks, sizeof(int64_t));
+}
+
+
+static void sink_put(checkpoint_sink_t *sink, const void *data, size_t count)
+{
+    if (sink->image != NULL) {
+        memcpy(sink->image + sink->pos, data, count);
+    }
+    else if (sink->fd != -1 && sink->error == 0) {
+        const char *p = (const char *) data;
+        size_t n_left = count;
+        while (n_left > 0) {
+            ssize_t n_written = write(sink->fd, p, n_left);
+            if (n_written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                sink->error = errno;
+                break;
+            }
+            p += n_written;
+            n_left -= n_written;
+        }
+    }
+
+    sink->pos += count;
+}
+
+
+static void read_queue_names(int fd, int n,
+                             char (*t1)[CC_DIAGRAM_MAX_NAME], char (*e1)[CC_DIAGRAM_MAX_NAME],
+                             char (*t2)[CC_DIAGRAM_MAX_NAME], char (*e2)[CC_DIAGRAM_MAX_NAME],
+                             char (*t3)[CC_DIAGRAM_MAX_NAME], char (*e3)[CC_DIAGRAM_MAX_NAME])
+{
+    char (*t_names[])[CC_DIAGRAM_MAX_NAME] = {t1, t2, t3};
+    char (*e_names[])[CC_DIAGRAM_MAX_NAME] = {e1, e2, e3};
+
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            io_read(fd, t_names[k][i], CC_DIAGRAM_MAX_NAME);
+            io_read(fd, e_names[k][i], CC_DIAGRAM_MAX_NAME);
+        }
+    }
+}
+
+
+/*
+ * reads records of diagrams (see put_diagram()) and overwrites data of
+ * the corresponding diagrams; absent diagrams are created from templates
+ */
+static void read_diagrams(int fd, char *path)
+{
+    char name[CC_DIAGRAM_MAX_NAME];
+    char template[CC_DIAGRAM_MAX_NAME];
+    int32_t flags[2];
+    int64_t n_blocks, index, size;
+
+    while (1) {
+        io_read(fd, name, CC_DIAGRAM_MAX_NAME);
+        if (name[0] == '\0') {
+            break;
+        }
+        io_read(fd, template, CC_DIAGRAM_MAX_NAME);
+        io_read(fd, flags, sizeof(flags));
+        io_read(fd, &n_blocks, sizeof(int64_t));
+        if (n_blocks < 0) {
+            errquit("checkpoint file %s is corrupted (diagram '%s')", path, name);
+        }
+
+        diagram_t *dg = diagram_stack_find(name);
+        if (dg == NULL && template[0] != '\0' && diagram_stack_find(template) != NULL) {
+            copy(template, name);
+            dg = diagram_stack_find(name);
+            if (flags[0]) {
+                diagram_set_evictable(dg);
+            }
+        }
+        if (dg != NULL && dg->n_blocks != (size_t) n_blocks) {
+            errquit("checkpoint file %s is inconsistent with the diagram '%s'", path, name);
+        }
+
+        while (1) {
+            io_read(fd, &index, sizeof(int64_t));
+            if (index == -1) {
+                break;
+            }
+            io_read(fd, &size, sizeof(int64_t));
+            if (index < 0 || index >= n_blocks || size < 0) {
+                errquit("checkpoint file %s is corrupted (diagram '%s')", path, name);
+            }
+            size_t n_bytes = size * SIZEOF_WORKING_TYPE;
+
+            if (dg == NULL) {
+                // diagram does not exist in this run, skip data
+                lseek(fd, n_bytes, SEEK_CUR);
+                continue;
+            }
+
+            block_t *block = dg->blocks[index];
+            if (block->storage_type == CC_DIAGRAM_DUMMY || block->size != (size_t) size) {
+                errquit("checkpoint file %s is inconsistent with the diagram '%s'", path, name);
+            }
+            block_load(block);
+            io_read(fd, block->buf, n_bytes);
+            block_store(block);
+        }
+    }
+}
+
+
+/*
+ * serializes the files and passes them to the background thread.
+ * files are written synchronously if their images do not fit into
+ * the half of the free memory.
+ */
+static void write_files(int n_files, char **paths, checkpoint_put_func_t *put_funcs,
+                        checkpoint_header_t *headers, checkpoint_solve_t *s)
+{
+    size_t sizes[CC_CHECKPOINT_MAX_FILES];
+    size_t total_size = 0;
+
+    // the previous checkpoint must be complete
+    join_writer();
+
+    // sizes of files
+    for (int i = 0; i < n_files; i++) {
+        checkpoint_sink_t sink = {NULL, -1, 0, 0};
+        put_funcs[i](&sink, &headers[i], s);
+        sizes[i] = sink.pos;
+        headers[i].data_size = sink.pos - sizeof(checkpoint_header_t);
+        total_size += sink.pos;
+    }
+
+    size_t used = cc_get_current_memory_usage();
+    size_t free_mem = (used < cc_opts->max_memory_size) ? cc_opts->max_memory_size - used : 0;
+
+    if (total_size <= free_mem / 2) {
+        writer_job.n_files = n_files;
+        writer_job.error = 0;
+        writer_job.failed_path = NULL;
+        cc_memory_push_tag("checkpoint");
+        for (int i = 0; i < n_files; i++) {
+            checkpoint_sink_t sink = {NULL, -1, 0, 0};
+            sink.image = (char *) cc_malloc(sizes[i]);
+            put_funcs[i](&sink, &headers[i], s);
+            writer_job.image[i] = sink.image;
+            writer_job.size[i] = sizes[i];
+            strcpy(writer_job.path[i], paths[i]);
+        }
+        cc_memory_pop_tag();
+
+        if (pthread_create(&writer_thread, NULL, writer_main, &writer_job) == 0) {
+            writer_running = 1;
+        }
+        else {
+            writer_main(&writer_job);
+            report_write_error(writer_job.failed_path, writer_job.error);
+        }
+        return;
+    }
+
+    // synchronous write: data go directly to files
+    for (int i = 0; i < n_files; i++) {
+        checkpoint_sink_t sink = {NULL, -1, 0, 0};
+        sink.fd = open_tmp_file(paths[i]);
+        if (sink.fd == -1) {
+            sink.error = errno;
+        }
+        else {
+            put_funcs[i](&sink, &headers[i], s);
+            sink.error = commit_tmp_file(paths[i], sink.fd, sink.error);
+        }
+        if (sink.error != 0) {
+            report_write_error(paths[i], sink.error);
+            return;
+        }
+    }
+}
+
+
+/*
+ * background thread: writes images of files one by one and frees them
+ */
+static void *writer_main(void *arg)
+{
+    checkpoint_job_t *job = (checkpoint_job_t *) arg;
+
+    for (int i = 0; i < job->n_files; i++) {
+        if (job->error == 0) {
+            checkpoint_sink_t sink = {NULL, -1, 0, 0};
+            sink.fd = open_tmp_file(job->path[i]);
+            if (sink.fd == -1) {
+                job->error = errno;
+            }
+            else {
+                sink_put(&sink, job->image[i], job->size[i]);
+                job->error = commit_tmp_file(job->path[i], sink.fd, sink.error);
+            }
+            if (job->error != 0) {
+                job->failed_path = job->path[i];
+            }
+        }
+        cc_free(job->image[i]);
+        job->image[i] = NULL;
+    }
+
+    return NULL;
+}
+
+
+/*
+ * files are written under temporary names and renamed into place when
+ * complete, so the previous version is replaced only by the complete one
+ */
+static int open_tmp_file(char *path)
+{
+    char tmp_path[CC_MAX_PATH_LENGTH + 8];
+    sprintf(tmp_path, "%s.tmp", path);
+
+    return open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+}
+
+
+/*
+ * flushes and closes the temporary file, renames it into place if no error
+ * has occurred. returns 0 on success, errno otherwise.
+ */
+static int commit_tmp_file(char *path, int fd, int error)
+{
+    char tmp_path[CC_MAX_PATH_LENGTH + 8];
+    sprintf(tmp_path, "%s.tmp", path);
+
+    if (error == 0 && fsync(fd) != 0) {
+        error = errno;
+    }
+    close(fd);
+
+    if (error == 0 && rename(tmp_path, path) != 0) {
+        error = errno;
+    }
+
+    return error;
+}
+
+
+static void report_write_error(char *path, int error)
+{
+    if (error != 0) {
+        printf(" Warning: unable to write checkpoint file %s: %s\n", path, strerror(error));
+    }
+}
+
+
+static void join_writer()
+{
+    if (!writer_running) {
+        return;
+    }
+
+    pthread_join(writer_thread, NULL);
+    writer_running = 0;
+
+    report_write_error(writer_job.failed_path, writer_job.error);
+}
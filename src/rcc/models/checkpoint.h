@@ -0,0 +1,87 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Restart checkpoints for the iterative solution of amplitude equations.
+ *
+ * The run is considered as a deterministic sequence of calls to
+ * solve_amplitude_equations() (sectors of the Fock space, lambda equations).
+ * The checkpoint (in the scratch directory) consists of:
+ *   checkpoint.chk      fingerprint of the calculation, number of solutions
+ *                       completed and the state of the current one: iteration,
+ *                       amplitudes and the DIIS/CROP subspace (vectors and
+ *                       the error matrix)
+ *   checkpoint-<i>.chk  converged i-th solution: amplitudes, buffers and
+ *                       effective interaction
+ * Checkpoints are written together with flushed amplitudes (the 'flush'
+ * directive). On restart the completed solutions are restored without any
+ * iterations and the current one is continued from the saved iteration.
+ * Files are written by the background thread and renamed into place when
+ * complete; they are removed after the successful run.
+ */
+
+#ifndef CC_CHECKPOINT_H_INCLUDED
+#define CC_CHECKPOINT_H_INCLUDED
+
+#include "crop.h"
+#include "diis.h"
+
+/*
+ * what was restored from the checkpoint for the current solution
+ */
+enum {
+    CC_CHECKPOINT_NONE,    // nothing, start from scratch
+    CC_CHECKPOINT_SOLVED,  // converged solution (no iterations needed)
+    CC_CHECKPOINT_STATE    // iterations are to be continued
+};
+
+/*
+ * diagrams and convergence accelerators of the current solution
+ */
+typedef struct {
+    int sector_h;
+    int sector_p;
+    char *singles;
+    char *singles_buf;
+    char *doubles;
+    char *doubles_buf;
+    char *triples;
+    char *triples_buf;
+    char *veff;
+    diis_queue_t *diis_queue;
+    crop_queue_t *crop_queue;
+} checkpoint_solve_t;
+
+int checkpoint_begin_solve(checkpoint_solve_t *s, int *iter);
+
+void checkpoint_restore_state(checkpoint_solve_t *s, double *prev_ecorr);
+
+int checkpoint_due(int iter);
+
+void checkpoint_save(checkpoint_solve_t *s, int iter, double prev_ecorr);
+
+void checkpoint_solved(checkpoint_solve_t *s, int iter);
+
+void checkpoint_finalize(int success);
+
+#endif /* CC_CHECKPOINT_H_INCLUDED */
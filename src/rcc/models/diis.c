@@ -112,6 +112,7 @@ void diis_put(diis_queue_t *q,
 
     timer_new_entry("diis", "DIIS extrapolation");
     timer_start("diis");
+    cc_memory_push_tag("DIIS");
 
     if (q->n >= DIIS_MAX) {
         errquit("Too many vectors (%d) in DIIS! Please, increase DIIS_MAX (src/methods/diis.h)", q->n);
@@ -141,6 +142,10 @@ void diis_put(diis_queue_t *q,
         copy(diag_t2new, buf_err);
         update(buf_err, -1.0, diag_t2old);
         strcpy(q->e2[q->n], buf_err);
+
+        // vectors of the subspace can be moved to disk under memory pressure
+        diagram_set_evictable(diagram_stack_find(buf));
+        diagram_set_evictable(diagram_stack_find(buf_err));
     }
 
     if (q->do_t3) {
@@ -154,6 +159,10 @@ void diis_put(diis_queue_t *q,
         copy(diag_t3new, buf_err);
         update(buf_err, -1.0, diag_t3old);
         strcpy(q->e3[q->n], buf_err);
+
+        // vectors of the subspace can be moved to disk under memory pressure
+        diagram_set_evictable(diagram_stack_find(buf));
+        diagram_set_evictable(diagram_stack_find(buf_err));
     }
 
     // calculate scalar products with itself and all previous error vectors
@@ -181,6 +190,7 @@ void diis_put(diis_queue_t *q,
 
     q->n++;
 
+    cc_memory_pop_tag();
     timer_stop("diis");
 }
 
@@ -251,6 +261,7 @@ void diis_extrapolate(diis_queue_t *q, char *extrap_t1, char *extrap_t2, char *e
 {
     timer_new_entry("diis", "DIIS extrapolation");
     timer_start("diis");
+    cc_memory_push_tag("DIIS");
 
     int dim = q->n;
     int bdim = dim + 1;
@@ -362,5 +373,6 @@ void diis_extrapolate(diis_queue_t *q, char *extrap_t1, char *extrap_t2, char *e
     cc_free(right);
     cc_free(diis_coeffs);
 
+    cc_memory_pop_tag();
     timer_stop("diis");
 }
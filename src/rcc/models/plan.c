@@ -0,0 +1,609 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Dry-run resource planner (expt.x --plan <input-file>).
+ *
+ * Estimates RAM, disk space and arithmetic work of the calculation before it
+ * is queued. Only the spinor blocks and the block layouts of the diagrams are
+ * constructed: no data buffers are allocated and no two-electron integrals
+ * are read (for DIRAC, only MRCONEE and MDPROP files are processed).
+ *
+ * The estimate covers sorted integrals, cluster amplitudes and effective
+ * interaction, new amplitudes, constant parts of the FS-CC equations and the
+ * DIIS subspace. Intermediates are sized from the largest contraction targets
+ * of the sector: copies of the largest amplitude or effective interaction
+ * or, in the sectors with the particle-particle ladder, the product of pppp
+ * and T1-like amplitudes (ppph), its reordered copy and the non-unique blocks
+ * of pppp restored in RAM for the contraction. Metadata of the diagrams
+ * (descriptors of blocks and inverted indices) are always counted in RAM, as
+ * well as the DIIS error matrix and the options. FLOPs per iteration are
+ * evaluated for the dominant contractions only, as size(A) * size(B) / dim(contracted lines) with
+ * symmetry-reduced sizes of the operands.
+ */
+
+#include "methods.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccutils.h"
+#include "engine.h"
+#include "error.h"
+#include "interfaces.h"
+#include "options.h"
+#include "spinors.h"
+#include "symmetry.h"
+#include "diis.h"
+#include "../new_sorting/new_sorting.h"
+#include "../sorting/sorting_request.h"
+
+
+#define PLAN_MAX_SECTORS CC_MAX_VISITED_SECTORS
+#define PLAN_NUM_LEVELS  5
+#define PLAN_GB          (1024.0 * 1024.0 * 1024.0)
+
+// peak RAM is estimated within ~20%: the recommended level must fit with the margin
+#define PLAN_RAM_MARGIN  1.25
+
+/*
+ * cluster operators of the Fock space sector
+ */
+typedef struct {
+    int h;
+    int p;
+    char *label;
+    void (*request_integrals)();
+    char *ampl_qparts[3];   // T1, T2, T3 (NULL if absent)
+    char *ampl_valence[3];
+    char *veff_qparts;      // effective interaction (NULL if absent)
+    char *veff_valence;
+    int pppp_ladder;        // pppp is contracted with T1-like amplitudes: 1 - always,
+                            // 2 - in the models with iterative triples only
+} plan_sector_t;
+
+static plan_sector_t plan_sectors[] = {
+        {0, 0, "0h0p", request_integrals_0h0p,
+                {"hp", "hhpp", "hhhppp"}, {"00", "0000", "000000"}, NULL, NULL, 1},
+        {1, 0, "1h0p", request_integrals_1h0p,
+                {"hh", "hhhp", "hhhhpp"}, {"01", "0010", "000100"}, "hh", "11", 2},
+        {0, 1, "0h1p", request_integrals_0h1p,
+                {"pp", "phpp", "phhppp"}, {"10", "1000", "100000"}, "pp", "11", 1},
+        {1, 1, "1h1p", request_integrals_1h1p,
+                {"ph", "phph", "phhphp"}, {"11", "1001", "100010"}, "phph", "1111", 2},
+        {0, 2, "0h2p", request_integrals_0h2p,
+                {NULL, "pppp", "pphppp"}, {NULL, "1100", "110000"}, "pppp", "1111", 1},
+        {2, 0, "2h0p", request_integrals_2h0p,
+                {NULL, "hhhh", "hhhhhp"}, {NULL, "0011", "000110"}, "hhhh", "1111", 0},
+        {1, 2, "1h2p", request_integrals_1h2p,
+                {NULL, "ppph", "pphpph"}, {NULL, "1101", "110001"}, "pphpph", "111111", 2},
+        {2, 1, "2h1p", request_integrals_2h1p,
+                {NULL, "hphh", NULL}, {NULL, "0111", NULL}, "hhphhp", "111111", 0},
+        {0, 3, "0h3p", request_integrals_0h3p,
+                {NULL, NULL, "pppppp"}, {NULL, NULL, "111000"}, "pppppp", "111111", 2},
+        {3, 0, "3h0p", request_integrals_3h0p,
+                {NULL, NULL, "hhhhhh"}, {NULL, NULL, "000111"}, "hhhhhh", "111111", 0},
+};
+
+/*
+ * estimated resources of the sector
+ */
+typedef struct {
+    double resident_ram[PLAN_NUM_LEVELS];   // kept until the end of the calculation
+    double resident_disk[PLAN_NUM_LEVELS];
+    double transient_ram[PLAN_NUM_LEVELS];  // released at the end of the sector
+    double transient_disk[PLAN_NUM_LEVELS];
+    double integrals;                       // bytes, placement-independent
+    double amplitudes;
+    double flops;                           // per iteration
+} plan_usage_t;
+
+
+/*
+ * declarations of functions used in this file
+ */
+static void plan_setup_system(cc_options_t *opts);
+
+static int plan_get_visited_sectors(int sect_h, int sect_p, plan_sector_t **visited);
+
+static void plan_sector(plan_sector_t *sector, plan_usage_t *usage);
+
+static void plan_add_diagram(double *ram, double *disk, char *name, char *qparts, char *valence,
+                             size_t size, int count);
+
+static size_t plan_diagram_size(char *qparts, char *valence, int perm_unique);
+
+static size_t plan_diagram_metadata_size(char *qparts, char *valence);
+
+static void plan_intermediates(plan_usage_t *usage, int pppp_ladder, char *max_ampl_qparts,
+                               char *max_ampl_valence, size_t max_ampl_size);
+
+static double plan_contraction_flops(char *qparts_1, char *valence_1, char *qparts_2, char *valence_2,
+                                     char *contracted);
+
+static void plan_print_report(cc_options_t *opts, int n_sectors, plan_sector_t **visited, plan_usage_t *usage);
+
+
+/**
+ * Dry run: estimates resources required for the calculation in the target
+ * Fock space sector and prints the report. Nothing is computed.
+ */
+int plan_resources(cc_options_t *opts)
+{
+    plan_sector_t *visited[PLAN_MAX_SECTORS];
+    plan_usage_t usage[PLAN_MAX_SECTORS];
+
+    printf("\n");
+    printf(" Dry run: estimation of resources required for the calculation\n");
+    printf(" (no integrals will be sorted, no amplitudes will be computed)\n\n");
+
+    plan_setup_system(opts);
+
+    int n_sectors = plan_get_visited_sectors(opts->sector_h, opts->sector_p, visited);
+    if (n_sectors == 0) {
+        errquit("Fock space sector %dh%dp is not implemented yet", opts->sector_h, opts->sector_p);
+    }
+
+    // integrals cannot be reused in the dry run: the requests are only counted
+    int reuse_integrals_1 = opts->reuse_integrals_1;
+    int reuse_integrals_2 = opts->reuse_integrals_2;
+    opts->reuse_integrals_1 = 0;
+    opts->reuse_integrals_2 = 0;
+    char integral_cache_dir_0 = opts->integral_cache_dir[0];
+    opts->integral_cache_dir[0] = '\0';
+
+    for (int i = 0; i < n_sectors; i++) {
+        opts->curr_sector_h = visited[i]->h;
+        opts->curr_sector_p = visited[i]->p;
+        plan_sector(visited[i], &usage[i]);
+    }
+
+    opts->reuse_integrals_1 = reuse_integrals_1;
+    opts->reuse_integrals_2 = reuse_integrals_2;
+    opts->integral_cache_dir[0] = integral_cache_dir_0;
+
+    plan_print_report(opts, n_sectors, visited, usage);
+
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * Symmetry, spinors and spinor blocks. Integrals are not read if possible.
+ */
+static void plan_setup_system(cc_options_t *opts)
+{
+    if (opts->int_source == CC_INTEGRALS_DIRAC) {
+        // MRCONEE and MDPROP only; MDCINT is not touched
+        new_sorting(opts);
+    }
+    else if (opts->int_source == CC_INTEGRALS_PYSCF) {
+        printf(" Note: the PySCF interface reads all integrals at start-up\n\n");
+        pyscf_interface(opts);
+    }
+    else if (opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        synthetic_interface(opts);
+    }
+    else {
+        errquit("unknown integral interface");
+    }
+}
+
+
+/**
+ * Sectors to be solved for the target sector, in the same order as in main().
+ */
+static int plan_get_visited_sectors(int sect_h, int sect_p, plan_sector_t **visited)
+{
+    int visited_h[PLAN_MAX_SECTORS];
+    int visited_p[PLAN_MAX_SECTORS];
+    int n_known = sizeof(plan_sectors) / sizeof(plan_sectors[0]);
+
+    int n_visited = get_visited_sectors(sect_h, sect_p, visited_h, visited_p);
+
+    for (int i = 0; i < n_visited; i++) {
+        for (int j = 0; j < n_known; j++) {
+            if (plan_sectors[j].h == visited_h[i] && plan_sectors[j].p == visited_p[i]) {
+                visited[i] = &plan_sectors[j];
+            }
+        }
+    }
+
+    return n_visited;
+}
+
+
+/**
+ * Estimates memory, disk and FLOPs for the one sector.
+ */
+static void plan_sector(plan_sector_t *sector, plan_usage_t *usage)
+{
+    cc_model_t model = cc_opts->cc_model;
+    int triples = triples_enabled();
+    int pert_triples = (model == CC_MODEL_CCSD_T3 || model == CC_MODEL_CCSD_T3_STAR ||
+                        model == CC_MODEL_CCSD_T4 || model == CC_MODEL_CCSD_T4_STAR);
+    int fock_space = sector->h > 0 || sector->p > 0;
+    char name[CC_DIAGRAM_MAX_NAME];
+
+    memset(usage, 0, sizeof(plan_usage_t));
+
+    /*
+     * sorted integrals: templates are sized exactly as in perform_sorting()
+     */
+    n_requests = 0;
+    sector->request_integrals();
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        size_t size = 0;
+        if (req->rank == 2) {
+            size = diagram_estimate_size(req->hp, req->valence, "00", "12", NOT_PERM_UNIQUE,
+                                         req->operator_symmetry);
+        }
+        else {
+            size = diagram_estimate_size(req->hp, req->valence, "0000", "1234", IS_PERM_UNIQUE,
+                                         req->operator_symmetry);
+        }
+        plan_add_diagram(usage->resident_ram, usage->resident_disk, req->dg_name, req->hp, req->valence, size, 1);
+        usage->integrals += size;
+    }
+    n_requests = 0;
+
+    /*
+     * cluster amplitudes
+     */
+    size_t max_ampl_size = 0;
+    char *max_ampl_qparts = NULL;
+    char *max_ampl_valence = NULL;
+
+    for (int rank = 1; rank <= 3; rank++) {
+        char *qparts = sector->ampl_qparts[rank - 1];
+        char *valence = sector->ampl_valence[rank - 1];
+        if (qparts == NULL) {
+            continue;
+        }
+        // T3 in the 0h3p and 3h0p sectors is the only cluster operator
+        int iterated = (rank < 3) || triples || sector->ampl_qparts[1] == NULL;
+        if (!iterated && !(pert_triples && rank == 3)) {
+            continue;
+        }
+
+        size_t size = plan_diagram_size(qparts, valence, (rank == 1) ? NOT_PERM_UNIQUE : IS_PERM_UNIQUE);
+        usage->amplitudes += size;
+
+        if (!iterated) {
+            // perturbative correction: one temporary copy of triples
+            sprintf(name, "t%d_pt", rank);
+            plan_add_diagram(usage->transient_ram, usage->transient_disk, name, qparts, valence, size, 1);
+            continue;
+        }
+
+        // current (kept for the subsequent sectors) and new amplitudes
+        sprintf(name, "t%dc", rank);
+        plan_add_diagram(usage->resident_ram, usage->resident_disk, name, qparts, valence, size, 1);
+        sprintf(name, "t%dnw", rank);
+        plan_add_diagram(usage->transient_ram, usage->transient_disk, name, qparts, valence, size, 1);
+
+        // constant (T-independent) part of the FS-CC equations
+        if (fock_space) {
+            sprintf(name, "t%d_0", rank);
+            plan_add_diagram(usage->transient_ram, usage->transient_disk, name, qparts, valence, size, 1);
+        }
+
+        // DIIS subspace: amplitudes and error vectors
+        if (cc_opts->diis_enabled && (rank < 3 || cc_opts->diis_triples)) {
+            sprintf(name, "t%d_diis", rank);
+            plan_add_diagram(usage->transient_ram, usage->transient_disk, name, qparts, valence, size,
+                             2 * cc_opts->diis_dim);
+        }
+
+        if (size > max_ampl_size) {
+            max_ampl_size = size;
+            max_ampl_qparts = qparts;
+            max_ampl_valence = valence;
+        }
+    }
+
+    if (sector->veff_qparts != NULL) {
+        size_t size = plan_diagram_size(sector->veff_qparts, sector->veff_valence, NOT_PERM_UNIQUE);
+        sprintf(name, "veff%d%d", sector->h, sector->p);
+        plan_add_diagram(usage->resident_ram, usage->resident_disk, name,
+                         sector->veff_qparts, sector->veff_valence, size, 1);
+        usage->amplitudes += size;
+
+        // three-body effective interaction is solved for: its constant part
+        // is kept during the iterations, contractions produce its copies
+        if (strlen(sector->veff_qparts) == 6) {
+            sprintf(name, "veff%d%d_const", sector->h, sector->p);
+            plan_add_diagram(usage->transient_ram, usage->transient_disk, name,
+                             sector->veff_qparts, sector->veff_valence, size, 1);
+        }
+        if (size > max_ampl_size) {
+            max_ampl_size = size;
+            max_ampl_qparts = sector->veff_qparts;
+            max_ampl_valence = sector->veff_valence;
+        }
+    }
+
+    // intermediates and reordered copies of amplitudes
+    int pppp_ladder = (sector->pppp_ladder == 1) || (sector->pppp_ladder == 2 && triples);
+    plan_intermediates(usage, pppp_ladder, max_ampl_qparts, max_ampl_valence, max_ampl_size);
+
+    /*
+     * FLOPs per iteration: dominant contractions only
+     */
+    char *t2_qparts = sector->ampl_qparts[1] ? sector->ampl_qparts[1] : "hhpp";
+    char *t2_valence = sector->ampl_qparts[1] ? sector->ampl_valence[1] : "0000";
+    char *t3_qparts = sector->ampl_qparts[2];
+    char *t3_valence = sector->ampl_valence[2];
+
+    if (sector->ampl_qparts[1] != NULL) {
+        // particle-particle and hole-hole ladders, ring terms
+        if (t2_qparts[2] == 'p' && t2_qparts[3] == 'p') {
+            usage->flops += plan_contraction_flops("pppp", "0000", t2_qparts, t2_valence, "pp");
+        }
+        if (t2_qparts[0] == 'h' && t2_qparts[1] == 'h') {
+            usage->flops += plan_contraction_flops("hhhh", "0000", t2_qparts, t2_valence, "hh");
+        }
+        if (strchr(t2_qparts, 'h') != NULL && strchr(t2_qparts, 'p') != NULL) {
+            usage->flops += 4 * plan_contraction_flops("phhp", "0000", t2_qparts, t2_valence, "hp");
+        }
+    }
+    if (t3_qparts != NULL && (triples || pert_triples || sector->ampl_qparts[1] == NULL)) {
+        // T3 <- V T2, T2 <- V T3
+        usage->flops += plan_contraction_flops("pphp", "0000", t2_qparts, t2_valence, "p");
+        usage->flops += plan_contraction_flops("hhph", "0000", t2_qparts, t2_valence, "h");
+        usage->flops += plan_contraction_flops("pphp", "0000", t3_qparts, t3_valence, "hpp");
+        usage->flops += plan_contraction_flops("hhph", "0000", t3_qparts, t3_valence, "hhp");
+
+        // T3 <- V T3 (the -2, -3 and full CCSDT models)
+        if (model == CC_MODEL_CCSDT_2 || model == CC_MODEL_CCSDT_3 || model == CC_MODEL_CCSDT) {
+            usage->flops += plan_contraction_flops("pppp", "0000", t3_qparts, t3_valence, "pp");
+            usage->flops += plan_contraction_flops("hhhh", "0000", t3_qparts, t3_valence, "hh");
+            usage->flops += 9 * plan_contraction_flops("phhp", "0000", t3_qparts, t3_valence, "hp");
+        }
+    }
+}
+
+
+/**
+ * Adds 'count' diagrams of the given size to the RAM and disk usage counters
+ * for each of the fixed disk usage levels (see guess_storage_class()).
+ * Metadata of the diagrams are counted in RAM for all the levels.
+ */
+static void plan_add_diagram(double *ram, double *disk, char *name, char *qparts, char *valence,
+                             size_t size, int count)
+{
+    int rank = (int) strlen(qparts);
+    int saved_level = cc_opts->disk_usage_level;
+    int saved_tier = cc_opts->compressed_tier;
+    double metadata = (double) plan_diagram_metadata_size(qparts, valence);
+
+    cc_opts->compressed_tier = 0;
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        cc_opts->disk_usage_level = level;
+        ram[level] += metadata * count;
+        int storage_type = guess_storage_class(name, rank, qparts, valence, size);
+        if (storage_type == CC_DIAGRAM_IN_MEM) {
+            ram[level] += (double) size * count;
+        }
+        else {
+            disk[level] += (double) size * count;
+        }
+    }
+    cc_opts->disk_usage_level = saved_level;
+    cc_opts->compressed_tier = saved_tier;
+}
+
+
+/**
+ * Intermediates of the sector: the largest of the contraction targets
+ * alive at the same time, for each of the disk usage levels.
+ * - three copies of the largest amplitude (or effective interaction):
+ *   two intermediates and the buffer of perm();
+ * - particle-particle ladder with T1-like amplitudes: the product of pppp
+ *   and T1 (ppph, placed as an ordinary diagram) and either its reordered
+ *   copy or the non-unique blocks of pppp restored in RAM during the
+ *   contraction (see mult_algorithm_m_mm_openmp_external()).
+ */
+static void plan_intermediates(plan_usage_t *usage, int pppp_ladder, char *max_ampl_qparts,
+                               char *max_ampl_valence, size_t max_ampl_size)
+{
+    double copies_ram[PLAN_NUM_LEVELS] = {0};
+    double copies_disk[PLAN_NUM_LEVELS] = {0};
+    double ladder_ram[PLAN_NUM_LEVELS] = {0};
+    double ladder_disk[PLAN_NUM_LEVELS] = {0};
+    double restored = 0.0;
+
+    if (max_ampl_qparts != NULL) {
+        plan_add_diagram(copies_ram, copies_disk, "intermediate",
+                         max_ampl_qparts, max_ampl_valence, max_ampl_size, 3);
+    }
+
+    if (pppp_ladder) {
+        size_t ppph_size = plan_diagram_size("ppph", "0000", NOT_PERM_UNIQUE);
+        plan_add_diagram(ladder_ram, ladder_disk, "intermediate", "ppph", "0000", ppph_size, 1);
+        if (cc_opts->openmp_algorithm == CC_OPENMP_ALGORITHM_EXTERNAL) {
+            restored = (double) plan_diagram_size("pppp", "0000", NOT_PERM_UNIQUE) -
+                       (double) plan_diagram_size("pppp", "0000", IS_PERM_UNIQUE);
+        }
+    }
+
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        // the reordered copy of ppph is placed as the product itself
+        double ladder = ladder_ram[level] + ((ladder_ram[level] > restored) ? ladder_ram[level] : restored);
+        double ram = (copies_ram[level] > ladder) ? copies_ram[level] : ladder;
+        double disk = (copies_disk[level] > 2 * ladder_disk[level]) ? copies_disk[level] : 2 * ladder_disk[level];
+        usage->transient_ram[level] += ram;
+        usage->transient_disk[level] += disk;
+    }
+}
+
+
+/**
+ * Size of the totally symmetric diagram (in bytes), see diagram_estimate_size().
+ */
+static size_t plan_diagram_size(char *qparts, char *valence, int perm_unique)
+{
+    static char *t3space = "000000";
+    static char *orders[] = {"12", "1234", "123456"};
+
+    int rank = (int) strlen(qparts);
+    return diagram_estimate_size(qparts, valence, t3space + (6 - rank), orders[rank / 2 - 1],
+                                 perm_unique, get_totally_symmetric_irrep());
+}
+
+
+/**
+ * Size of metadata of the diagram (in bytes), see diagram_estimate_metadata_size().
+ */
+static size_t plan_diagram_metadata_size(char *qparts, char *valence)
+{
+    static char *t3space = "000000";
+    static char *orders[] = {"12", "1234", "123456"};
+
+    int rank = (int) strlen(qparts);
+    return diagram_estimate_metadata_size(qparts, valence, t3space + (6 - rank), orders[rank / 2 - 1],
+                                          NOT_PERM_UNIQUE, get_totally_symmetric_irrep());
+}
+
+
+/**
+ * FLOPs for the contraction of two diagrams over the lines 'contracted'.
+ * For the Abelian symmetry this is size1 * size2 / dim(contracted lines),
+ * where sizes are symmetry-reduced and the dimension is not.
+ */
+static double plan_contraction_flops(char *qparts_1, char *valence_1, char *qparts_2, char *valence_2,
+                                     char *contracted)
+{
+    int n_holes = 0;
+    int n_parts = 0;
+    for (int i = 0; i < get_num_spinors(); i++) {
+        if (is_hole(i)) {
+            n_holes++;
+        }
+        else {
+            n_parts++;
+        }
+    }
+
+    double dim = 1.0;
+    for (int i = 0; contracted[i] != '\0'; i++) {
+        dim *= (contracted[i] == 'h') ? n_holes : n_parts;
+    }
+
+    double n1 = (double) plan_diagram_size(qparts_1, valence_1, NOT_PERM_UNIQUE) / SIZEOF_WORKING_TYPE;
+    double n2 = (double) plan_diagram_size(qparts_2, valence_2, NOT_PERM_UNIQUE) / SIZEOF_WORKING_TYPE;
+    double flops_per_fma = (arith == CC_ARITH_COMPLEX) ? 8.0 : 2.0;
+
+    return (dim > 0.0) ? flops_per_fma * n1 * n2 / dim : 0.0;
+}
+
+
+/**
+ * Prints peak RAM per sector and disk footprint for all disk usage levels.
+ */
+static void plan_print_report(cc_options_t *opts, int n_sectors, plan_sector_t **visited, plan_usage_t *usage)
+{
+    char model_name[64];
+    double peak_ram[PLAN_NUM_LEVELS] = {0};
+    double peak_disk[PLAN_NUM_LEVELS] = {0};
+    double resident_ram[PLAN_NUM_LEVELS] = {0};
+    double resident_disk[PLAN_NUM_LEVELS] = {0};
+    double total_flops = 0.0;
+
+    // memory independent of the system size: options and the DIIS error
+    // matrix (one DIIS queue exists at a time)
+    double untagged = (double) sizeof(cc_options_t);
+    if (opts->diis_enabled) {
+        untagged += (double) sizeof(diis_queue_t) + sizeof(double) * DIIS_MAX * DIIS_MAX;
+    }
+
+    get_cc_model_name(opts->sector_h, opts->sector_p, opts->cc_model, model_name);
+
+    printf("\n");
+    printf(" Resource estimate for %s in the sector %dh%dp\n", model_name, opts->sector_h, opts->sector_p);
+    printf(" ---------------------------------------------------\n");
+    printf(" spinors: %d, spinor blocks: %d, tile size: %d, arithmetic: %s\n",
+           get_num_spinors(), (int) n_spinor_blocks, opts->tile_size,
+           (arith == CC_ARITH_COMPLEX) ? "complex" : "real");
+    printf(" DIIS subspace: %d%s\n\n", opts->diis_enabled ? opts->diis_dim : 0,
+           opts->diis_triples ? " (including triples)" : "");
+
+    printf(" Peak RAM (Gb) by sector and disk usage level:\n\n");
+    printf(" %-6s %11s %11s", "sector", "integrals", "amplitudes");
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        printf("   level %d", level);
+    }
+    printf(" %13s\n", "GFLOP/iter");
+
+    for (int i = 0; i < n_sectors; i++) {
+        plan_usage_t *u = &usage[i];
+
+        printf(" %-6s %11.3f %11.3f", visited[i]->label, u->integrals / PLAN_GB, u->amplitudes / PLAN_GB);
+        for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+            // data of the previous sectors is kept in the stack of diagrams
+            resident_ram[level] += u->resident_ram[level];
+            resident_disk[level] += u->resident_disk[level];
+            double ram = resident_ram[level] + u->transient_ram[level] + untagged;
+            double disk = resident_disk[level] + u->transient_disk[level];
+            peak_ram[level] = (ram > peak_ram[level]) ? ram : peak_ram[level];
+            peak_disk[level] = (disk > peak_disk[level]) ? disk : peak_disk[level];
+            printf(" %9.3f", ram / PLAN_GB);
+        }
+        printf(" %13.1f\n", u->flops * 1e-9);
+        total_flops += u->flops;
+    }
+
+    printf("\n %-30s", "peak RAM, Gb");
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        printf(" %9.3f", peak_ram[level] / PLAN_GB);
+    }
+    printf("\n %-30s", "disk footprint, Gb");
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        printf(" %9.3f", peak_disk[level] / PLAN_GB);
+    }
+    printf("\n\n");
+
+    // recommendation under the current memory limit
+    int level_fits = -1;
+    for (int level = 0; level < PLAN_NUM_LEVELS; level++) {
+        if (peak_ram[level] * PLAN_RAM_MARGIN <= (double) opts->max_memory_size) {
+            level_fits = level;
+            break;
+        }
+    }
+    printf(" Memory limit: %.3f Gb\n", opts->max_memory_size / PLAN_GB);
+    if (level_fits >= 0) {
+        printf(" Lowest disk usage level within the limit: %d (with %.0f%% margin)\n", level_fits,
+               (PLAN_RAM_MARGIN - 1.0) * 100.0);
+    }
+    else {
+        printf(" No fixed disk usage level fits into the memory limit (with %.0f%% margin)\n",
+               (PLAN_RAM_MARGIN - 1.0) * 100.0);
+    }
+    printf(" Arithmetic work: %.1f GFLOP per iteration (all sectors), "
+           "at most %.1f GFLOP for %d iterations per sector\n",
+           total_flops * 1e-9, total_flops * 1e-9 * opts->maxiter, opts->maxiter);
+    printf(" (sizes are exact for the stored diagrams; intermediates and FLOPs are estimates)\n\n");
+}
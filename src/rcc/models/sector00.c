@@ -211,9 +211,10 @@ int sector_0h0p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(0h0p) amplitude equations.
+ * Requests sorting of integrals used in the CC(0h0p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_0h0p()
+void request_integrals_0h0p()
 {
     int triples = (cc_opts->cc_model < CC_MODEL_CCSDT_1A) ? 0 : 1;
     triples = triples || cc_opts->cc_model == CC_MODEL_CCSD_T3 || cc_opts->cc_model == CC_MODEL_CCSD_T4;
@@ -247,7 +248,15 @@ void sort_integrals_0h0p()
         request_sorting("hpph", "hpph", "0000", "1234");
         request_sorting("pppp", "pppp", "0000", "1234");
     }
+}
 
+
+/**
+ * Sorting of integrals used in the CC(0h0p) amplitude equations.
+ */
+void sort_integrals_0h0p()
+{
+    request_integrals_0h0p();
     perform_sorting();
 
     //print_amplitude_distribution_analysis("hhpp");
@@ -329,10 +329,10 @@ void construct_disconnected_rank4_rank2(char *src1_name, char *src2_name, char *
      */
     for (size_t iblock = 0; iblock < dst_diagram->n_blocks; iblock++) {
         block_t *block = dst_diagram->blocks[iblock];
-        block_load(block);
         if (block->is_unique == 0) {
             continue;
         }
+        block_load(block);
 
         int dim_i = block->shape[0];
         int dim_j = block->shape[1];
@@ -206,9 +206,10 @@ int sector_0h1p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(0h1p) amplitude equations.
+ * Requests sorting of integrals used in the CC(0h1p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_0h1p()
+void request_integrals_0h1p()
 {
     // prepare one-electron integrals
     //request_sorting("vh", "ph", "10", "12");
@@ -237,6 +238,15 @@ void sort_integrals_0h1p()
         request_sorting("vppp", "pppp", "1000", "1234");
         request_sorting("vphh", "pphh", "1000", "1234");
     }
+}
+
+
+/**
+ * Sorting of integrals used in the CC(0h1p) amplitude equations.
+ */
+void sort_integrals_0h1p()
+{
+    request_integrals_0h1p();
     perform_sorting();
 
     // prepare one-electron integrals
@@ -185,9 +185,10 @@ int sector_0h2p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(0h2p) amplitude equations.
+ * Requests sorting of integrals used in the CC(0h2p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_0h2p()
+void request_integrals_0h2p()
 {
     // sorting -- interaction diagrams with valence lines
     request_sorting("vvpp", "pppp", "1100", "1234");
@@ -196,6 +197,15 @@ void sort_integrals_0h2p()
     if (cc_opts->cc_model >= CC_MODEL_CCSD_T3) {
         request_sorting("vhhp", "phhp", "1000", "1234");
     }
+}
+
+
+/**
+ * Sorting of integrals used in the CC(0h2p) amplitude equations.
+ */
+void sort_integrals_0h2p()
+{
+    request_integrals_0h2p();
     perform_sorting();
 
     // prepare cluster amplitudes from previous sectors
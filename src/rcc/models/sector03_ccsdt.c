@@ -235,9 +235,10 @@ int sector_0h3p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(0h3p) amplitude equations.
+ * Requests sorting of integrals used in the CC(0h3p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_0h3p()
+void request_integrals_0h3p()
 {
     request_sorting("vphp", "pphp", "1000", "1234");
     request_sorting("ppph", "ppph", "0000", "1234");
@@ -251,6 +252,15 @@ void sort_integrals_0h3p()
     request_sorting("vvvv", "pppp", "1111", "1234");
     request_sorting("pvph", "ppph", "0100", "1234");
     request_sorting("pvhv", "pphp", "0101", "1234");
+}
+
+
+/**
+ * Sorting of integrals used in the CC(0h3p) amplitude equations.
+ */
+void sort_integrals_0h3p()
+{
+    request_integrals_0h3p();
     perform_sorting();
 
     if (cc_opts->print_level >= CC_PRINT_DEBUG) {
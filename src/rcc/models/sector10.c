@@ -258,9 +258,10 @@ int sector_1h0p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(1h0p) amplitude equations.
+ * Requests sorting of integrals used in the CC(1h0p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_1h0p()
+void request_integrals_1h0p()
 {
     // prepare one-electron integrals
     request_sorting("hg", "hh", "01", "12");
@@ -278,6 +279,15 @@ void sort_integrals_1h0p()
     if (cc_opts->cc_model >= CC_MODEL_CCSD_T3) {
         request_sorting("ppgh", "pphh", "0010", "1234");
     }
+}
+
+
+/**
+ * Sorting of integrals used in the CC(1h0p) amplitude equations.
+ */
+void sort_integrals_1h0p()
+{
+    request_integrals_1h0p();
     perform_sorting();
 
     // prepare cluster amplitudes from the 0h0p sector
@@ -285,9 +285,10 @@ int sector_1h1p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(1h1p) amplitude equations.
+ * Requests sorting of integrals used in the CC(1h1p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_1h1p()
+void request_integrals_1h1p()
 {
     // sorting -- interaction diagrams with valence lines
     request_sorting("vg", "ph", "11", "12");
@@ -307,6 +308,15 @@ void sort_integrals_1h1p()
         request_sorting("vhhp", "phhp", "1000", "1234");
         //request_sorting("vphh", "pphh", "1000", "1234");
     }
+}
+
+
+/**
+ * Sorting of integrals used in the CC(1h1p) amplitude equations.
+ */
+void sort_integrals_1h1p()
+{
+    request_integrals_1h1p();
     perform_sorting();
 
     // prepare amplitudes from previous sectors
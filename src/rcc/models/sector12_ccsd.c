@@ -305,7 +305,11 @@ int sector_1h2p(cc_options_t *opts)
 }
 
 
-void sort_integrals_1h2p()
+/**
+ * Requests sorting of integrals used in the CC(1h2p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
+ */
+void request_integrals_1h2p()
 {
     /*
      * two-electron integrals
@@ -339,6 +343,12 @@ void sort_integrals_1h2p()
     request_sorting("vvhg", "pphh", "1101", "1234");
     request_sorting("vvpg", "ppph", "1101", "1234");
     request_sorting("pvpg", "ppph", "0101", "1234");
+}
+
+
+void sort_integrals_1h2p()
+{
+    request_integrals_1h2p();
     perform_sorting();
 
     /*
@@ -151,14 +151,24 @@ int sector_2h0p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(2h0p) amplitude equations.
+ * Requests sorting of integrals used in the CC(2h0p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_2h0p()
+void request_integrals_2h0p()
 {
     // sorting -- interaction diagrams with valence lines
     request_sorting("hhgg", "hhhh", "0011", "1234");
     request_sorting("ppgg", "pphh", "0011", "1234");
     request_sorting("phgg", "phhh", "0011", "1234");
+}
+
+
+/**
+ * Sorting of integrals used in the CC(2h0p) amplitude equations.
+ */
+void sort_integrals_2h0p()
+{
+    request_integrals_2h0p();
     perform_sorting();
 
     // prepare amplitudes from previous sectors
@@ -301,7 +301,11 @@ int sector_2h1p(cc_options_t *opts)
 }
 
 
-void sort_integrals_2h1p()
+/**
+ * Requests sorting of integrals used in the CC(2h1p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
+ */
+void request_integrals_2h1p()
 {
     /*
      * two-electron integrals
@@ -333,7 +337,12 @@ void sort_integrals_2h1p()
     request_sorting("pgvg", "phph", "0111", "1234");
     request_sorting("ppvg", "ppph", "0011", "1234");
     request_sorting("ppvh", "ppph", "0010", "1234");
+}
 
+
+void sort_integrals_2h1p()
+{
+    request_integrals_2h1p();
     perform_sorting();
 
     /*
@@ -186,9 +186,10 @@ int sector_3h0p(cc_options_t *opts)
 
 
 /**
- * Sorting of integrals used in the CC(0h3p) amplitude equations.
+ * Requests sorting of integrals used in the CC(3h0p) amplitude equations.
+ * (only requests are registered, see perform_sorting()).
  */
-void sort_integrals_3h0p()
+void request_integrals_3h0p()
 {
     /*request_sorting("vphp", "pphp", "1000", "1234");
     request_sorting("ppph", "ppph", "0000", "1234");
@@ -208,6 +209,15 @@ void sort_integrals_3h0p()
     request_sorting("gghh", "hhhh", "1100", "1234");
     request_sorting("gphh", "hphh", "1000", "1234");
     request_sorting("pghg", "phhh", "0101", "1234");
+}
+
+
+/**
+ * Sorting of integrals used in the CC(0h3p) amplitude equations.
+ */
+void sort_integrals_3h0p()
+{
+    request_integrals_3h0p();
     perform_sorting();
 
     if (cc_opts->print_level >= CC_PRINT_DEBUG) {
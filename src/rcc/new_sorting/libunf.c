@@ -6,6 +6,9 @@
  * alexvoleynichenko@gmail.com
  */
 
+// mmap(), madvise()
+#define _DEFAULT_SOURCE
+
 #include <assert.h>
 #include <complex.h>
 #include <ctype.h>
@@ -14,9 +17,17 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "libunf.h"
 
+// maximum number of type specifiers in a single format string
+#define UNF_MAX_FORMAT_ITEMS 32
+
+// number of compiled format strings stored for each file
+#define UNF_FORMAT_CACHE_SIZE 8
+
 enum {
     TYPE_CHAR,
     TYPE_INTEGER_1,
@@ -29,16 +40,56 @@ enum {
     TYPE_COMPLEX_8,
 };
 
-static int try_read_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_read, int *n_args_read, va_list ap);
+/*
+ * format string compiled into the list of type specifiers.
+ * array_dim_type is -1 for scalars.
+ */
+typedef struct {
+    int data_type;
+    int type_size;
+    int num_repeats;
+    int array_dim_type;
+} unf_format_item_t;
+
+typedef struct {
+    char *fmt;
+    int n_items;
+    unf_format_item_t items[UNF_MAX_FORMAT_ITEMS];
+} unf_format_t;
+
+struct unf_format_cache {
+    int next;
+    unf_format_t formats[UNF_FORMAT_CACHE_SIZE];
+};
+
+static int read_record(unf_file_t *file, char *fmt, int is_view, va_list ap);
+
+static int try_read_bytes(unf_file_t *file, unf_format_t *format, int is_view,
+                          size_t *n_bytes_read, int *n_args_read, va_list ap);
+
+static int try_write_bytes(unf_file_t *file, unf_format_t *format, size_t *n_bytes_written, int *n_args_written,
+                           va_list ap);
 
-static int try_write_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_written, int *n_args_written, va_list ap);
+static unf_format_t *get_format(unf_file_t *file, char *fmt);
+
+static int compile_format(char *fmt, unf_format_t *format);
 
 static int fmt_get_type_size(char **fmt, int *data_type, int *type_size, int *num_repeats);
 
+static size_t raw_read(unf_file_t *file, void *dst, size_t n_bytes);
+
+static int raw_seek(unf_file_t *file, int64_t offset, int whence);
+
+static int64_t raw_tell(unf_file_t *file);
+
 static int seek_backward(unf_file_t *file);
 
 static int seek_forward(unf_file_t *file);
 
+static int seek_forward_body(unf_file_t *file, int32_t record_size);
+
+static int seek_indexed(unf_file_t *file, unf_position_t pos, int offset);
+
 
 /**
  * Opens an unformatted file indicated by filename and returns a file stream
@@ -111,6 +162,7 @@ unf_file_t *unf_open(const char *path, const char *mode, unf_access_t access, ..
     unf_file->access = access;
     unf_file->record_len = record_len;
     unf_file->error_flag = 0;
+    unf_file->is_readable = (strcmp(mode, "r") == 0);
 
     return unf_file;
 }
@@ -130,6 +182,17 @@ int unf_close(unf_file_t *file)
         return UNF_ERROR;
     }
 
+    if (file->map_addr != NULL) {
+        munmap(file->map_addr, file->map_size);
+    }
+    free(file->rec_offsets);
+    if (file->fmt_cache != NULL) {
+        for (int i = 0; i < UNF_FORMAT_CACHE_SIZE; i++) {
+            free(file->fmt_cache->formats[i].fmt);
+        }
+        free(file->fmt_cache);
+    }
+
     int status = fclose(file->file_ptr);
     if (status == EOF) {
         return UNF_ERROR;
@@ -172,6 +235,12 @@ int unf_write(unf_file_t *file, char *fmt, ...)
         return 0;
     }
 
+    unf_format_t *format = get_format(file, fmt);
+    if (format == NULL) {
+        file->error_flag = 1;
+        return 0;
+    }
+
     // only for sequential files: size of the record in bytes
     // here: just template, to be overwritten in future
     if (file->access == UNF_ACCESS_SEQUENTIAL) {
@@ -190,7 +259,7 @@ int unf_write(unf_file_t *file, char *fmt, ...)
 
     va_list ap;
     va_start(ap, fmt);
-    int err = try_write_bytes(file, fmt, &n_bytes_written, &n_arguments_written, ap);
+    int err = try_write_bytes(file, format, &n_bytes_written, &n_arguments_written, ap);
     va_end(ap);
 
     if (err == UNF_ERROR) {
@@ -254,6 +323,12 @@ int unf_write_rec(unf_file_t *file, int rec, char *fmt, ...)
         return 0;
     }
 
+    unf_format_t *format = get_format(file, fmt);
+    if (format == NULL) {
+        file->error_flag = 1;
+        return 0;
+    }
+
     // find the required entry
     off_t offset = (rec - 1) * file->record_len;
     int err = fseek(file->file_ptr, offset, SEEK_SET);
@@ -269,7 +344,7 @@ int unf_write_rec(unf_file_t *file, int rec, char *fmt, ...)
 
     va_list ap;
     va_start(ap, fmt);
-    err = try_write_bytes(file, fmt, &n_bytes_written, &n_arguments_written, ap);
+    err = try_write_bytes(file, format, &n_bytes_written, &n_arguments_written, ap);
     va_end(ap);
 
     if (n_bytes_written > file->record_len) {
@@ -314,61 +389,38 @@ int unf_write_rec(unf_file_t *file, int rec, char *fmt, ...)
  */
 int unf_read(unf_file_t *file, char *fmt, ...)
 {
-    if (file == NULL ||
-        file->access == UNF_ACCESS_DIRECT) {
-        errno = EINVAL;
-        return 0;
-    }
-
-    // only for sequential files: size of the record in bytes
-    int32_t record_size = 0;
-    if (file->access == UNF_ACCESS_SEQUENTIAL) {
-        size_t n_read = fread(&record_size, 1, sizeof(int32_t), file->file_ptr);
-        if (n_read != sizeof(int32_t)) {
-            file->error_flag = 1;
-            return 0;
-        }
-    }
-
-    // read target bytes.
-    // the same code for both sequential and stream access mode.
-    size_t n_bytes_read = 0;
-    int n_arguments_read = 0;
-
     va_list ap;
     va_start(ap, fmt);
-    int err = try_read_bytes(file, fmt, &n_bytes_read, &n_arguments_read, ap);
+    int n_arguments_read = read_record(file, fmt, 0, ap);
     va_end(ap);
 
-    if (err == UNF_ERROR) {
-        file->error_flag = 1;
-        return n_arguments_read;
-    }
-
-    // only for sequential files: check the record size and rewind to the end of the entry
-
-    if (file->access == UNF_ACCESS_SEQUENTIAL) {
-        // rewind to the end of the record if needed
-        if (n_bytes_read != record_size) {
-            off_t offset = record_size - n_bytes_read;
-            fseek(file->file_ptr, offset, SEEK_CUR);
-        }
+    return n_arguments_read;
+}
 
-        // read size of the record in bytes
-        int32_t record_size_2 = 0;
-        size_t n_read = fread(&record_size_2, 1, sizeof(int32_t), file->file_ptr);
-        if (n_read != sizeof(int32_t)) {
-            file->error_flag = 1;
-            return n_arguments_read;
-        }
 
-        // two sizes of a record must coincide
-        if (record_size != record_size_2) {
-            file->error_flag = 1;
-            return n_arguments_read;
-        }
+/**
+ * Reads the next record of a memory-mapped sequential or stream access file
+ * (see unf_map()) without copying array payloads.
+ * The format string is the same as for unf_read(). Scalars are copied as usual,
+ * while for each array the address of a 'const void *' pointer must be passed;
+ * it receives the location of the array data inside the mapping.
+ * The pointers remain valid until unf_close() and are aligned only as
+ * the layout of the record allows.
+ *
+ * Returns the number of receiving arguments successfully assigned.
+ */
+int unf_read_view(unf_file_t *file, char *fmt, ...)
+{
+    if (file == NULL || file->map_addr == NULL) {
+        errno = EINVAL;
+        return 0;
     }
 
+    va_list ap;
+    va_start(ap, fmt);
+    int n_arguments_read = read_record(file, fmt, 1, ap);
+    va_end(ap);
+
     return n_arguments_read;
 }
 
@@ -396,9 +448,15 @@ int unf_read_rec(unf_file_t *file, int rec, char *fmt, ...)
         return 0;
     }
 
+    unf_format_t *format = get_format(file, fmt);
+    if (format == NULL) {
+        file->error_flag = 1;
+        return 0;
+    }
+
     // find the required entry
-    off_t offset = (rec - 1) * file->record_len;
-    int err = fseek(file->file_ptr, offset, SEEK_SET);
+    int64_t offset = (int64_t) (rec - 1) * file->record_len;
+    int err = raw_seek(file, offset, SEEK_SET);
     if (err != 0) {
         file->error_flag = 1;
         return 0;
@@ -410,7 +468,7 @@ int unf_read_rec(unf_file_t *file, int rec, char *fmt, ...)
 
     va_list ap;
     va_start(ap, fmt);
-    err = try_read_bytes(file, fmt, &n_bytes_read, &n_arguments_read, ap);
+    err = try_read_bytes(file, format, 0, &n_bytes_read, &n_arguments_read, ap);
     va_end(ap);
 
     if (n_bytes_read > file->record_len) {
@@ -440,14 +498,13 @@ int unf_next_rec_size(unf_file_t *file)
     /*
      * read size of the record in bytes
      */
-    int record_size = 0;
-    size_t err = fread(&record_size, 1, sizeof(int32_t), file->file_ptr);
+    int32_t record_size = 0;
+    size_t err = raw_read(file, &record_size, sizeof(int32_t));
     if (err != sizeof(int32_t)) {
         return 0;
     }
 
-    off_t offset = -4;
-    fseek(file->file_ptr, offset, SEEK_CUR);
+    raw_seek(file, -(int64_t) sizeof(int32_t), SEEK_CUR);
 
     return record_size;
 }
@@ -478,15 +535,20 @@ int unf_seek(unf_file_t *file, unf_position_t pos, int offset)
         return UNF_ERROR;
     }
 
+    // the record index allows to jump directly to the target record
+    if (file->rec_offsets != NULL) {
+        return seek_indexed(file, pos, offset);
+    }
+
     // set the position for further seeking
     if (pos == UNF_POS_BEGIN) {
-        int err = fseek(file->file_ptr, 0, SEEK_SET);
+        int err = raw_seek(file, 0, SEEK_SET);
         if (err != 0) {
             return UNF_ERROR;
         }
     }
     else if (pos == UNF_POS_END) {
-        int err = fseek(file->file_ptr, 0, SEEK_END);
+        int err = raw_seek(file, 0, SEEK_END);
         if (err != 0) {
             return UNF_ERROR;
         }
@@ -559,6 +621,128 @@ int unf_skip(unf_file_t *file)
 }
 
 
+/**
+ * Switches a file opened for reading to the memory-mapped access.
+ * The whole file is mapped read-only with the MADV_SEQUENTIAL hint;
+ * all subsequent reads are served from the mapping (no stdio buffering
+ * and no system calls), and unf_read_view() becomes available.
+ *
+ * Returns UNF_SUCCESS upon success, UNF_ERROR otherwise
+ * (the file remains usable in the ordinary mode in this case).
+ */
+int unf_map(unf_file_t *file)
+{
+    if (file == NULL || !file->is_readable) {
+        errno = EINVAL;
+        return UNF_ERROR;
+    }
+
+    if (file->map_addr != NULL) {
+        return UNF_SUCCESS;
+    }
+
+    int fd = fileno(file->file_ptr);
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        return UNF_ERROR;
+    }
+
+    size_t map_size = (size_t) file_stat.st_size;
+    void *addr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return UNF_ERROR;
+    }
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+
+    file->map_pos = (size_t) ftello(file->file_ptr);
+    file->map_addr = (char *) addr;
+    file->map_size = map_size;
+    file->map_eof = 0;
+
+    return UNF_SUCCESS;
+}
+
+
+/**
+ * Builds the index of records of the sequential file in one pass over
+ * the record markers. With the index, unf_seek(), unf_backspace() and
+ * unf_rewind() jump directly to the target record instead of walking
+ * the file record by record. The current position is preserved.
+ *
+ * Returns UNF_SUCCESS upon success, UNF_ERROR otherwise.
+ */
+int unf_build_index(unf_file_t *file)
+{
+    if (file == NULL ||
+        file->access != UNF_ACCESS_SEQUENTIAL ||
+        !file->is_readable) {
+        errno = EINVAL;
+        return UNF_ERROR;
+    }
+
+    free(file->rec_offsets);
+    file->rec_offsets = NULL;
+    file->n_records = 0;
+
+    int64_t saved_pos = raw_tell(file);
+    int64_t capacity = 1024;
+    int64_t n_records = 0;
+    int64_t *offsets = (int64_t *) malloc(sizeof(int64_t) * capacity);
+    if (offsets == NULL) {
+        return UNF_ERROR;
+    }
+
+    raw_seek(file, 0, SEEK_SET);
+    int64_t pos = 0;
+    while (1) {
+        if (n_records + 1 == capacity) {
+            capacity *= 2;
+            int64_t *new_offsets = (int64_t *) realloc(offsets, sizeof(int64_t) * capacity);
+            if (new_offsets == NULL) {
+                free(offsets);
+                raw_seek(file, saved_pos, SEEK_SET);
+                return UNF_ERROR;
+            }
+            offsets = new_offsets;
+        }
+        offsets[n_records] = pos;
+
+        int32_t record_size = 0;
+        if (raw_read(file, &record_size, sizeof(int32_t)) != sizeof(int32_t)) {
+            break; // end of file
+        }
+        if (seek_forward_body(file, record_size) == UNF_ERROR) {
+            free(offsets);
+            raw_seek(file, saved_pos, SEEK_SET);
+            return UNF_ERROR;
+        }
+
+        pos += 2 * sizeof(int32_t) + record_size;
+        n_records++;
+    }
+
+    file->rec_offsets = offsets;
+    file->n_records = n_records;
+    raw_seek(file, saved_pos, SEEK_SET);
+
+    return UNF_SUCCESS;
+}
+
+
+/**
+ * Returns the number of records in the sequential file, or -1
+ * if the record index has not been built (see unf_build_index()).
+ */
+int64_t unf_num_records(unf_file_t *file)
+{
+    if (file == NULL || file->rec_offsets == NULL) {
+        return -1;
+    }
+
+    return file->n_records;
+}
+
+
 /**
  * Checks if the end of the given unformatted file has been reached.
  *
@@ -566,6 +750,10 @@ int unf_skip(unf_file_t *file)
  */
 int unf_eof(unf_file_t *file)
 {
+    if (file->map_addr != NULL) {
+        return file->map_eof;
+    }
+
     return feof(file->file_ptr);
 }
 
@@ -581,6 +769,10 @@ int unf_error(unf_file_t *file)
         return UNF_ERROR;
     }
 
+    if (file->map_addr != NULL) {
+        return UNF_SUCCESS;
+    }
+
     return ferror(file->file_ptr) ? UNF_ERROR : UNF_SUCCESS;
 }
 
@@ -592,46 +784,89 @@ int unf_error(unf_file_t *file)
  */
 
 
-static int try_read_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_read, int *n_args_read, va_list ap)
+/*
+ * reads the next record of sequential and stream access files.
+ * if 'is_view' is set, array payloads are not copied; pointers into the mapping are returned instead.
+ */
+static int read_record(unf_file_t *file, char *fmt, int is_view, va_list ap)
 {
-    assert(file != NULL);
+    if (file == NULL ||
+        file->access == UNF_ACCESS_DIRECT) {
+        errno = EINVAL;
+        return 0;
+    }
 
-    *n_args_read = 0;
-    *n_bytes_read = 0;
+    unf_format_t *format = get_format(file, fmt);
+    if (format == NULL) {
+        file->error_flag = 1;
+        return 0;
+    }
 
-    char *p = fmt;
-    while (*p) {
-        // nothing to do, just skip
-        if (*p == ',') {
-            p++;
-            continue;
+    // only for sequential files: size of the record in bytes
+    int32_t record_size = 0;
+    if (file->access == UNF_ACCESS_SEQUENTIAL) {
+        size_t n_read = raw_read(file, &record_size, sizeof(int32_t));
+        if (n_read != sizeof(int32_t)) {
+            file->error_flag = 1;
+            return 0;
         }
+    }
 
-        int num_repeats = 1;
-        int type_size;
-        int data_type;
-        if (fmt_get_type_size(&p, &data_type, &type_size, &num_repeats) == UNF_ERROR) {
-            return UNF_ERROR;
+    // read target bytes.
+    // the same code for both sequential and stream access mode.
+    size_t n_bytes_read = 0;
+    int n_arguments_read = 0;
+
+    int err = try_read_bytes(file, format, is_view, &n_bytes_read, &n_arguments_read, ap);
+
+    if (err == UNF_ERROR) {
+        file->error_flag = 1;
+        return n_arguments_read;
+    }
+
+    // only for sequential files: check the record size and rewind to the end of the entry
+
+    if (file->access == UNF_ACCESS_SEQUENTIAL) {
+        // rewind to the end of the record if needed
+        if (n_bytes_read != record_size) {
+            int64_t offset = (int64_t) record_size - (int64_t) n_bytes_read;
+            raw_seek(file, offset, SEEK_CUR);
         }
 
-        /*
-         * array or not?
-         * array dimension can be specified by either integer-4 '[i4]' or integer-8 '[i8]' number
-         */
-        int is_array = 0;
-        int array_dim_type = TYPE_INTEGER_4;
-        if (strncmp(p, "[i4]", 4) == 0) {
-            is_array = 1;
-            array_dim_type = TYPE_INTEGER_4;
-            p += 4;
+        // read size of the record in bytes
+        int32_t record_size_2 = 0;
+        size_t n_read = raw_read(file, &record_size_2, sizeof(int32_t));
+        if (n_read != sizeof(int32_t)) {
+            file->error_flag = 1;
+            return n_arguments_read;
         }
-        else if (strncmp(p, "[i8]", 4) == 0) {
-            is_array = 1;
-            array_dim_type = TYPE_INTEGER_8;
-            p += 4;
+
+        // two sizes of a record must coincide
+        if (record_size != record_size_2) {
+            file->error_flag = 1;
+            return n_arguments_read;
         }
+    }
 
-        for (int i_repeat = 0; i_repeat < num_repeats; i_repeat++) {
+    return n_arguments_read;
+}
+
+
+static int try_read_bytes(unf_file_t *file, unf_format_t *format, int is_view,
+                          size_t *n_bytes_read, int *n_args_read, va_list ap)
+{
+    assert(file != NULL);
+
+    *n_args_read = 0;
+    *n_bytes_read = 0;
+
+    for (int i_item = 0; i_item < format->n_items; i_item++) {
+        unf_format_item_t *item = &format->items[i_item];
+        int type_size = item->type_size;
+        int is_array = item->array_dim_type >= 0;
+        int array_dim_type = item->array_dim_type;
+
+        for (int i_repeat = 0; i_repeat < item->num_repeats; i_repeat++) {
             /*
              * get pointer to data to be written
              */
@@ -659,18 +894,27 @@ static int try_read_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_read, int
             }
 
             /*
-             * read entry from the unformatted file
+             * read entry from the unformatted file,
+             * return its location in the mapping (views of arrays),
              * or skip it, if the data pointer is NULL
              */
             size_t n_bytes = array_dim * type_size;
-            if (data_ptr != NULL) {
-                size_t err = fread(data_ptr, 1, n_bytes, file->file_ptr);
+            if (data_ptr != NULL && is_view && is_array) {
+                if (file->map_pos + n_bytes > file->map_size) {
+                    file->map_eof = 1;
+                    return UNF_ERROR;
+                }
+                *(const void **) data_ptr = file->map_addr + file->map_pos;
+                file->map_pos += n_bytes;
+            }
+            else if (data_ptr != NULL) {
+                size_t err = raw_read(file, data_ptr, n_bytes);
                 if (err != n_bytes) {
                     return UNF_ERROR;
                 }
             }
             else {
-                int err = fseek(file->file_ptr, (off_t) n_bytes, SEEK_CUR);
+                int err = raw_seek(file, (int64_t) n_bytes, SEEK_CUR);
                 if (err != 0) {
                     return UNF_ERROR;
                 }
@@ -685,45 +929,21 @@ static int try_read_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_read, int
 }
 
 
-static int try_write_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_written, int *n_args_written, va_list ap)
+static int try_write_bytes(unf_file_t *file, unf_format_t *format, size_t *n_bytes_written, int *n_args_written,
+                           va_list ap)
 {
     assert(file != NULL);
 
     *n_args_written = 0;
     *n_bytes_written = 0;
 
-    char *p = fmt;
-    while (*p) {
-        // nothing to do, just skip
-        if (*p == ',') {
-            p++;
-            continue;
-        }
-
-        int num_repeats = 1;
-        int type_size;
-        int data_type;
-
-        if (fmt_get_type_size(&p, &data_type, &type_size, &num_repeats) == UNF_ERROR) {
-            return UNF_ERROR;
-        }
-
-        /*
-         * array or not?
-         * array dimension can be specified by either integer-4 '[i4]' or integer-8 '[i8]' number
-         */
-        int is_array = 0;
-        int array_dim_type = TYPE_INTEGER_4;
-        if (strncmp(p, "[i4]", 4) == 0) {
-            is_array = 1;
-            array_dim_type = TYPE_INTEGER_4;
-            p += 4;
-        }
-        else if (strncmp(p, "[i8]", 4) == 0) {
-            is_array = 1;
-            array_dim_type = TYPE_INTEGER_8;
-            p += 4;
-        }
+    for (int i_item = 0; i_item < format->n_items; i_item++) {
+        unf_format_item_t *item = &format->items[i_item];
+        int data_type = item->data_type;
+        int type_size = item->type_size;
+        int num_repeats = item->num_repeats;
+        int is_array = item->array_dim_type >= 0;
+        int array_dim_type = item->array_dim_type;
 
         for (int i_repeat = 0; i_repeat < num_repeats; i_repeat++) {
             /*
@@ -822,6 +1042,89 @@ static int try_write_bytes(unf_file_t *file, char *fmt, size_t *n_bytes_written,
 }
 
 
+/*
+ * returns the compiled format descriptor for the format string 'fmt'.
+ * format strings are parsed only once; descriptors are cached in the file object
+ * (the least recently added one is replaced).
+ * returns NULL if the format string is invalid.
+ */
+static unf_format_t *get_format(unf_file_t *file, char *fmt)
+{
+    if (file->fmt_cache == NULL) {
+        file->fmt_cache = (struct unf_format_cache *) calloc(1, sizeof(struct unf_format_cache));
+        if (file->fmt_cache == NULL) {
+            return NULL;
+        }
+    }
+
+    struct unf_format_cache *cache = file->fmt_cache;
+    for (int i = 0; i < UNF_FORMAT_CACHE_SIZE; i++) {
+        if (cache->formats[i].fmt != NULL && strcmp(cache->formats[i].fmt, fmt) == 0) {
+            return &cache->formats[i];
+        }
+    }
+
+    unf_format_t *format = &cache->formats[cache->next];
+    free(format->fmt);
+    format->fmt = NULL;
+    if (compile_format(fmt, format) == UNF_ERROR) {
+        return NULL;
+    }
+    format->fmt = strdup(fmt);
+    if (format->fmt == NULL) {
+        return NULL;
+    }
+    cache->next = (cache->next + 1) % UNF_FORMAT_CACHE_SIZE;
+
+    return format;
+}
+
+
+// returns 0 if success, -1 if error
+static int compile_format(char *fmt, unf_format_t *format)
+{
+    format->n_items = 0;
+
+    char *p = fmt;
+    while (*p) {
+        // nothing to do, just skip
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+
+        if (format->n_items == UNF_MAX_FORMAT_ITEMS) {
+            errno = EINVAL;
+            return UNF_ERROR;
+        }
+
+        unf_format_item_t *item = &format->items[format->n_items];
+        item->num_repeats = 1;
+        if (fmt_get_type_size(&p, &item->data_type, &item->type_size, &item->num_repeats) == UNF_ERROR) {
+            return UNF_ERROR;
+        }
+
+        /*
+         * array or not?
+         * array dimension can be specified by either integer-4 '[i4]' or integer-8 '[i8]' number
+         */
+        item->array_dim_type = -1;
+        if (strncmp(p, "[i4]", 4) == 0) {
+            item->array_dim_type = TYPE_INTEGER_4;
+            p += 4;
+        }
+        else if (strncmp(p, "[i8]", 4) == 0) {
+            item->array_dim_type = TYPE_INTEGER_8;
+            p += 4;
+        }
+
+        format->n_items++;
+    }
+
+    return UNF_SUCCESS;
+}
+
+
 // returns 0 if success, -1 if error
 static int fmt_get_type_size(char **fmt, int *data_type, int *type_size, int *num_repeats)
 {
@@ -920,18 +1223,28 @@ static int seek_forward(unf_file_t *file)
 {
     // read size of the record in bytes
     int32_t record_size = 0;
-    size_t err = fread(&record_size, 1, sizeof(int32_t), file->file_ptr);
+    size_t err = raw_read(file, &record_size, sizeof(int32_t));
     if (err != sizeof(int32_t)) {
         return UNF_ERROR;
     }
 
-    int status = fseek(file->file_ptr, record_size, SEEK_CUR);
+    return seek_forward_body(file, record_size);
+}
+
+
+/*
+ * skips the record payload of 'record_size' bytes and checks the trailing record marker
+ * (the leading one has already been read).
+ */
+static int seek_forward_body(unf_file_t *file, int32_t record_size)
+{
+    int status = raw_seek(file, record_size, SEEK_CUR);
     if (status != 0) {
         return UNF_ERROR;
     }
 
     int32_t record_size_2 = 0;
-    err = fread(&record_size_2, 1, sizeof(int32_t), file->file_ptr);
+    size_t err = raw_read(file, &record_size_2, sizeof(int32_t));
     if (err != sizeof(int32_t)) {
         return UNF_ERROR;
     }
@@ -956,23 +1269,129 @@ static int seek_backward(unf_file_t *file)
     // (without setting error flag however)
 
     // access the last record size
-    off_t offset = -4;
-    int err = fseek(file->file_ptr, offset, SEEK_CUR);
+    int err = raw_seek(file, -(int64_t) sizeof(int32_t), SEEK_CUR);
     if (err != 0) {
         return UNF_ERROR;
     }
 
     int32_t record_size = 0;
-    size_t n_read = fread(&record_size, 1, sizeof(int32_t), file->file_ptr);
+    size_t n_read = raw_read(file, &record_size, sizeof(int32_t));
     if (n_read != sizeof(int32_t)) {
         return UNF_ERROR;
     }
 
-    offset = -(2 * sizeof(int32_t) + record_size);
-    err = fseek(file->file_ptr, offset, SEEK_CUR);
+    int64_t offset = -(int64_t) (2 * sizeof(int32_t) + record_size);
+    err = raw_seek(file, offset, SEEK_CUR);
     if (err != 0) {
         return UNF_ERROR;
     }
 
     return UNF_SUCCESS;
 }
+
+
+/**
+ * Moves to the record 'offset' records away from the position 'pos'
+ * using the record index (auxiliary function).
+ * Returns UNF_SUCCESS upon success, UNF_ERROR otherwise.
+ */
+static int seek_indexed(unf_file_t *file, unf_position_t pos, int offset)
+{
+    int64_t n_records = file->n_records;
+    int64_t *offsets = file->rec_offsets;
+
+    // number of the record at the origin position
+    int64_t irec = 0;
+    if (pos == UNF_POS_BEGIN) {
+        irec = 0;
+    }
+    else if (pos == UNF_POS_END) {
+        irec = n_records;
+    }
+    else {
+        // first record boundary not before the current position
+        int64_t cur_pos = raw_tell(file);
+        int64_t lo = 0;
+        int64_t hi = n_records;
+        while (lo < hi) {
+            int64_t mid = lo + (hi - lo) / 2;
+            if (offsets[mid] < cur_pos) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        irec = lo;
+    }
+
+    int64_t target = irec + offset;
+    if (target < 0 || target > n_records) {
+        return UNF_ERROR;
+    }
+
+    if (raw_seek(file, offsets[target], SEEK_SET) != 0) {
+        return UNF_ERROR;
+    }
+
+    return UNF_SUCCESS;
+}
+
+
+/*
+ * low-level I/O: either the stdio stream or the memory mapping (see unf_map())
+ */
+
+static size_t raw_read(unf_file_t *file, void *dst, size_t n_bytes)
+{
+    if (file->map_addr == NULL) {
+        return fread(dst, 1, n_bytes, file->file_ptr);
+    }
+
+    size_t n_avail = file->map_pos < file->map_size ? file->map_size - file->map_pos : 0;
+    if (n_bytes > n_avail) {
+        n_bytes = n_avail;
+        file->map_eof = 1;
+    }
+    memcpy(dst, file->map_addr + file->map_pos, n_bytes);
+    file->map_pos += n_bytes;
+
+    return n_bytes;
+}
+
+
+// returns 0 if success, -1 if error (as fseek() does)
+static int raw_seek(unf_file_t *file, int64_t offset, int whence)
+{
+    if (file->map_addr == NULL) {
+        return fseeko(file->file_ptr, (off_t) offset, whence);
+    }
+
+    int64_t new_pos = offset;
+    if (whence == SEEK_CUR) {
+        new_pos += (int64_t) file->map_pos;
+    }
+    else if (whence == SEEK_END) {
+        new_pos += (int64_t) file->map_size;
+    }
+
+    if (new_pos < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    file->map_pos = (size_t) new_pos;
+    file->map_eof = 0;
+
+    return 0;
+}
+
+
+static int64_t raw_tell(unf_file_t *file)
+{
+    if (file->map_addr == NULL) {
+        return (int64_t) ftello(file->file_ptr);
+    }
+
+    return (int64_t) file->map_pos;
+}
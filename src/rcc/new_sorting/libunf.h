@@ -13,6 +13,7 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <stdio.h>
 
 typedef enum {
@@ -32,11 +33,24 @@ enum {
     UNF_SUCCESS = 0,
 };
 
+struct unf_format_cache;
+
 typedef struct {
     FILE *file_ptr;
     int access;
     int record_len; // is used only for direct-access files
     int error_flag;
+    int is_readable;
+    // memory-mapped access (see unf_map())
+    char *map_addr;
+    size_t map_size;
+    size_t map_pos;
+    int map_eof;
+    // record index (see unf_build_index())
+    int64_t *rec_offsets;
+    int64_t n_records;
+    // format strings parsed once per file
+    struct unf_format_cache *fmt_cache;
 } unf_file_t;
 
 unf_file_t *unf_open(const char *path, const char *mode, unf_access_t access, ...);
@@ -51,6 +65,14 @@ int unf_read(unf_file_t *file, char *fmt, ...);
 
 int unf_read_rec(unf_file_t *file, int rec, char *fmt, ...);
 
+int unf_read_view(unf_file_t *file, char *fmt, ...);
+
+int unf_map(unf_file_t *file);
+
+int unf_build_index(unf_file_t *file);
+
+int64_t unf_num_records(unf_file_t *file);
+
 int unf_next_rec_size(unf_file_t *file);
 
 int unf_seek(unf_file_t *file, unf_position_t pos, int offset);
@@ -58,6 +58,7 @@ void read_mdprop(char *path, mrconee_data_t *mrconee_data)
         printf(" exp-t will be continue without any property calculations\n");
         return;
     }
+    unf_map(file);
 
     for (int prop_count = 1; unf_next_rec_size(file) != 0; prop_count++) {
         /*
@@ -23,9 +23,31 @@
 
 #include "new_sort_1e.h"
 
+#include <complex.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "memory.h"
+#include "mrconee.h"
+#include "options.h"
+#include "spinors.h"
+
+void sort_onel_core_fock(double complex *h_ints);
+
+
+/*
+ * the core Fock operator is read from MRCONEE by read_mrconee(),
+ * so no HINT file is needed
+ */
 void new_sort_1e()
 {
-    printf("new sort 1e\n");
+    mrconee_data_t *mrconee_data = cc_opts->mrconee_data;
+    int nspinors = get_num_spinors();
+
+    double complex *h_ints = (double complex *) cc_malloc(sizeof(double complex) * nspinors * nspinors);
+    memcpy(h_ints, mrconee_data->fock, sizeof(double complex) * nspinors * nspinors);
+
+    sort_onel_core_fock(h_ints);
+
+    cc_free(h_ints);
 }
@@ -21,20 +21,49 @@
  *  Google Groups: https://groups.google.com/d/forum/exp-t-program
  */
 
+#define _DEFAULT_SOURCE
+
 #include "new_sort_2e.h"
 
 #include <spinors.h>
 
 #include "error.h"
+#include "memory.h"
+#include "omp.h"
 #include "options.h"
 #include "libunf.h"
 #include "../sorting/sorting_request.h"
 #include "../include/timer.h"
 #include "mrconee.h"
 #include "../include/engine.h"
+#include "../engine/tensor.h"
 
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/*
+ * MDCINT is read by a single reader thread which decodes Fortran records
+ * (in any of the int4/int8 x real/complex formats) into large batches.
+ * Batches are passed through a bounded queue to a pool of worker threads,
+ * which expand the Kramers-pair symmetry and scatter Coulomb integrals into
+ * the blocks of the target diagrams.
+ *
+ * Unique target blocks are distributed among the workers, every worker
+ * expands all batches in the order of records and writes only into its own
+ * blocks. Each matrix element is thus written by one thread in the same
+ * order as in the serial code, and the result does not depend on the number
+ * of threads. A target block receives direct integrals <12|34>, its exchange
+ * buffer receives <12|43>; antisymmetrized integrals <12||34> are assembled
+ * when all records are processed, as in sort_twoel().
+ */
+
+// minimum number of integrals held in one batch
+#define CC_MDCINT_BATCH_SIZE (1 << 19)
+
+// maximum number of records held in one batch
+#define CC_MDCINT_BATCH_RECORDS 4096
 
 enum {
     INT_CLASS_NO_BARS = 0,
@@ -42,18 +71,86 @@ enum {
     INT_CLASS_TWO_BARS
 };
 
+enum {
+    MDCINT_BATCH_FREE = 0,
+    MDCINT_BATCH_FILLING,
+    MDCINT_BATCH_READY
+};
+
+typedef struct {
+    int state;
+    int64_t seq;            // sequence number of the batch in the file
+    int n_pending;          // number of workers which have not yet expanded the batch
+    int n_records;
+    int32_t ikr[CC_MDCINT_BATCH_RECORDS];
+    int32_t jkr[CC_MDCINT_BATCH_RECORDS];
+    int32_t nonzr[CC_MDCINT_BATCH_RECORDS];
+    size_t offset[CC_MDCINT_BATCH_RECORDS];
+    size_t n_ints;
+    size_t capacity;
+    int32_t *ind;           // (indk, indl) pairs
+    double complex *val;
+} mdcint_batch_t;
+
+typedef struct {
+    int n_batches;
+    mdcint_batch_t *batches;
+    int n_workers;
+    int64_t n_ready;        // number of batches passed to the workers so far
+    int reader_done;
+} mdcint_queue_t;
+
+/*
+ * unique block of a target diagram with its exchange buffer
+ */
+typedef struct {
+    block_t *block;
+    sorting_request_t *req;
+    void *exchange;
+    int owner;              // worker writing into this block
+} mdcint_target_t;
+
+typedef struct {
+    diagram_t *dg;
+    mdcint_target_t **block_targets;    // same indexing as dg->blocks, NULL for non-unique blocks
+} mdcint_diagram_t;
+
 static int sign(int x);
 
-void expand_ints(diagram_t *dg, int ikr, int jkr, int nonzr, void *ind_buf, double *val_buf, int32_t *kr, int nkr);
+static int read_mdcint_record(unf_file_t *mdcint, mdcint_batch_t *batch, int64_t *ind_buf_8, double *val_buf_real);
+
+static int acquire_free_batch(mdcint_queue_t *queue);
+
+static int acquire_ready_batch(mdcint_queue_t *queue, int64_t seq, int *finished);
+
+static void release_batch(mdcint_queue_t *queue, int ibatch);
+
+static void distribute_targets(mdcint_target_t *targets, int n_targets, int n_workers);
+
+static void expand_batch(mdcint_batch_t *batch, mdcint_diagram_t *diagrams, int n_diagrams, int worker,
+                         int32_t *kr, int nkr);
+
+static mdcint_target_t *find_target(mdcint_diagram_t *tdg, int *spinor_blocks, int worker);
+
+static void set_block_element(block_t *block, void *buf, int *idx, double complex val);
+
+static void assemble_target(mdcint_target_t *target);
+
+void expand_ints(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int ikr, int jkr, int nonzr,
+                 int32_t *ind, double complex *val, int32_t *kr, int nkr);
 
 int int_class(int ikr, int jkr, int kkr, int lkr);
 
-void put_integral(diagram_t *dg, int i, int j, int k, int l, double complex val);
+void put_integral(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int i, int j, int k, int l,
+                  double complex val);
 
-void perm_symm(diagram_t *dg, int i, int j, int k, int l, double complex val, int nkr, int32_t *kr);
+void perm_symm(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int ikr, int jkr, int kkr, int lkr,
+               double complex val, int nkr, int32_t *kr);
 
 int kr2abs(int ikr, int32_t *kr, int nkr);
 
+int is_pppp_diagram(char *holes_particles, char *valence, char *order);
+
 
 void new_sort_2e()
 {
@@ -71,6 +168,9 @@ void new_sort_2e()
         return;
     }
 
+    // multi-GB file read in one sequential sweep: map it if possible, otherwise use stdio
+    unf_map(mdcint);
+
     int use_int4 = mrconee_data->dirac_int_size == 4;
     int use_int8 = mrconee_data->dirac_int_size == 8;
 
@@ -102,8 +202,8 @@ void new_sort_2e()
     unf_backspace(mdcint);
 
     int32_t num_spinors = 2 * nkr;
-    int32_t *kr = (int32_t *) calloc(num_spinors, sizeof(int32_t *));
-    int64_t *kr_8 = (int64_t *) calloc(num_spinors, sizeof(int64_t *));
+    int32_t *kr = (int32_t *) calloc(num_spinors, sizeof(int32_t));
+    int64_t *kr_8 = (int64_t *) calloc(num_spinors, sizeof(int64_t));
 
     if (use_int4) {
         nread = unf_read(mdcint, "c18,i4,i4[i4]", date_time, &nkr, kr, &num_spinors);
@@ -130,6 +230,83 @@ void new_sort_2e()
         printf("%4d%4d    %4d%4d\n", kr[2*i], kr[2*i + 1], kr2abs(i + 1, kr, nkr), kr2abs(-(i + 1), kr, nkr));
     }
 
+    /*
+     * target diagrams: only rank-4 ones, one-electron diagrams will be sorted later.
+     * blocks of the target diagrams are kept in memory until all records are processed.
+     */
+    int n_diagrams = 0;
+    int n_targets = 0;
+    mdcint_diagram_t *diagrams = (mdcint_diagram_t *) cc_malloc(sizeof(mdcint_diagram_t) * (n_requests + 1));
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        diagram_t *dg = sorting_requests[ireq].dg;
+        if (dg->rank != 4) {
+            continue;
+        }
+        diagrams[n_diagrams].dg = dg;
+        diagrams[n_diagrams].block_targets = (mdcint_target_t **) cc_calloc(dg->n_blocks + 1, sizeof(mdcint_target_t *));
+        n_diagrams++;
+        for (size_t iblock = 0; iblock < dg->n_blocks; iblock++) {
+            if (dg->blocks[iblock]->is_unique) {
+                n_targets++;
+            }
+        }
+    }
+
+    mdcint_target_t *targets = (mdcint_target_t *) cc_malloc(sizeof(mdcint_target_t) * (n_targets + 1));
+    n_targets = 0;
+    for (int ireq = 0, idg = 0; ireq < n_requests; ireq++) {
+        diagram_t *dg = sorting_requests[ireq].dg;
+        if (dg->rank != 4) {
+            continue;
+        }
+        for (size_t iblock = 0; iblock < dg->n_blocks; iblock++) {
+            block_t *block = dg->blocks[iblock];
+            if (!block->is_unique) {
+                continue;
+            }
+            block_load(block);
+            memset(block->buf, 0, block->size * SIZEOF_WORKING_TYPE);
+
+            mdcint_target_t *target = &targets[n_targets++];
+            target->block = block;
+            target->req = &sorting_requests[ireq];
+            target->exchange = cc_calloc(block->size, SIZEOF_WORKING_TYPE);
+            target->owner = 0;
+            diagrams[idg].block_targets[iblock] = target;
+        }
+        idg++;
+    }
+
+    /*
+     * queue of batches between the reader and the workers.
+     * a single record can contain up to num_spinors^2 integrals.
+     */
+    int n_threads = cc_opts->nthreads < 2 ? 2 : cc_opts->nthreads;
+    size_t max_record_size = (size_t) num_spinors * num_spinors;
+    size_t batch_capacity = CC_MDCINT_BATCH_SIZE > max_record_size ? CC_MDCINT_BATCH_SIZE : max_record_size;
+
+    mdcint_queue_t queue;
+    queue.n_batches = n_threads;
+    queue.n_workers = 0;
+    queue.n_ready = 0;
+    queue.reader_done = 0;
+    queue.batches = (mdcint_batch_t *) cc_malloc(sizeof(mdcint_batch_t) * queue.n_batches);
+    for (int ibatch = 0; ibatch < queue.n_batches; ibatch++) {
+        mdcint_batch_t *batch = &queue.batches[ibatch];
+        batch->state = MDCINT_BATCH_FREE;
+        batch->seq = -1;
+        batch->n_pending = 0;
+        batch->n_records = 0;
+        batch->n_ints = 0;
+        batch->capacity = batch_capacity;
+        batch->ind = (int32_t *) cc_malloc(sizeof(int32_t) * 2 * batch_capacity);
+        batch->val = (double complex *) cc_malloc(sizeof(double complex) * batch_capacity);
+    }
+
+    // scratch buffers used by the reader to convert int8 indices and real values
+    int64_t *ind_buf_8 = use_int8 ? (int64_t *) cc_malloc(sizeof(int64_t) * 2 * max_record_size) : NULL;
+    double *val_buf_real = (double *) cc_malloc(sizeof(double) * max_record_size);
+
     /*
      * read chunks of non-zero two-electron integrals
      *
@@ -138,11 +315,144 @@ void new_sort_2e()
      * (cbuf(1, inz), inz = 1, nonzr)
      */
     int64_t count_non_zero = 0;
+    int64_t count_records = 0;
+    double time_start = abs_time();
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        #pragma omp single
+        {
+            queue.n_workers = omp_get_num_threads() - 1;
+            distribute_targets(targets, n_targets, queue.n_workers);
+            printf(" reading 2e ints: 1 reader thread, %d worker threads, %d batches x %zu ints\n",
+                   queue.n_workers, queue.n_batches, batch_capacity);
+        }
+
+        if (omp_get_thread_num() == 0) {
+            /*
+             * reader: decode records into batches until the terminating record
+             */
+            int eof = 0;
+            while (!eof) {
+                int ibatch;
+                while ((ibatch = acquire_free_batch(&queue)) < 0) {
+                    sched_yield();
+                }
+                mdcint_batch_t *batch = &queue.batches[ibatch];
+                batch->n_records = 0;
+                batch->n_ints = 0;
+
+                while (batch->n_records < CC_MDCINT_BATCH_RECORDS &&
+                       batch->n_ints + max_record_size <= batch->capacity) {
+                    if (!read_mdcint_record(mdcint, batch, ind_buf_8, val_buf_real)) {
+                        eof = 1;
+                        break;
+                    }
+                    count_non_zero += batch->nonzr[batch->n_records - 1];
+                    count_records++;
+                }
+
+                #pragma omp critical (cc_mdcint_queue)
+                {
+                    if (batch->n_records > 0 && queue.n_workers > 0) {
+                        batch->seq = queue.n_ready++;
+                        batch->n_pending = queue.n_workers;
+                        batch->state = MDCINT_BATCH_READY;
+                    }
+                    else {
+                        batch->state = MDCINT_BATCH_FREE;
+                    }
+                }
 
-    char *ind_buf = (char *) calloc(num_spinors * num_spinors, 2 * sizeof(int32_t));
-    char *ind_buf_8 = (char *) calloc(num_spinors * num_spinors, 2 * sizeof(int64_t));
-    double *val_buf_real = (double *) calloc(num_spinors * num_spinors, sizeof(double));
-    double *val_buf_complex = (double *) calloc(num_spinors * num_spinors, sizeof(double));
+                if (queue.n_workers == 0) {
+                    // no workers were spawned by the runtime: expand the batch in place
+                    expand_batch(batch, diagrams, n_diagrams, -1, kr, nkr);
+                }
+            }
+
+            #pragma omp critical (cc_mdcint_queue)
+            {
+                queue.reader_done = 1;
+            }
+        }
+        else {
+            /*
+             * worker: expand all batches in the order of records,
+             * scatter integrals into the worker's own target blocks
+             */
+            int worker = omp_get_thread_num() - 1;
+            int64_t next_seq = 0;
+            while (1) {
+                int finished = 0;
+                int ibatch = acquire_ready_batch(&queue, next_seq, &finished);
+                if (finished) {
+                    break;
+                }
+                if (ibatch < 0) {
+                    sched_yield();
+                    continue;
+                }
+                expand_batch(&queue.batches[ibatch], diagrams, n_diagrams, worker, kr, nkr);
+                release_batch(&queue, ibatch);
+                next_seq++;
+            }
+        }
+    }
+
+    /*
+     * <12||34> = <12|34> - <12|43>
+     */
+    #pragma omp parallel for num_threads(cc_opts->nthreads) schedule(dynamic)
+    for (int itgt = 0; itgt < n_targets; itgt++) {
+        assemble_target(&targets[itgt]);
+    }
+
+    double time_finish = abs_time();
+    printf(" number of records          %lld\n", (long long) count_records);
+    printf(" number of non-zero ints    %lld\n", (long long) count_non_zero);
+    printf(" time for reading 2e ints   %.2f sec\n\n", time_finish - time_start);
+
+    for (int itgt = 0; itgt < n_targets; itgt++) {
+        block_store(targets[itgt].block);
+    }
+
+    /*
+     * cleanup
+     */
+
+    unf_close(mdcint);
+
+    for (int ibatch = 0; ibatch < queue.n_batches; ibatch++) {
+        cc_free(queue.batches[ibatch].ind);
+        cc_free(queue.batches[ibatch].val);
+    }
+    cc_free(queue.batches);
+    cc_free(ind_buf_8);
+    cc_free(val_buf_real);
+    for (int itgt = 0; itgt < n_targets; itgt++) {
+        cc_free(targets[itgt].exchange);
+    }
+    cc_free(targets);
+    for (int idg = 0; idg < n_diagrams; idg++) {
+        cc_free(diagrams[idg].block_targets);
+    }
+    cc_free(diagrams);
+    free(kr);
+}
+
+
+/*
+ * reads the next record of MDCINT and appends it to the batch.
+ * returns 0 at the terminating record or on read error.
+ */
+static int read_mdcint_record(unf_file_t *mdcint, mdcint_batch_t *batch, int64_t *ind_buf_8, double *val_buf_real)
+{
+    mrconee_data_t *mrconee_data = cc_opts->mrconee_data;
+    int use_int4 = mrconee_data->dirac_int_size == 4;
+    int is_real = mrconee_data->group_arith == 1 || mrconee_data->is_spinfree == 1;
+
+    int32_t *ind = batch->ind + 2 * batch->n_ints;
+    double complex *val = batch->val + batch->n_ints;
 
     int32_t ikr = 0;
     int32_t jkr = 0;
@@ -150,81 +460,254 @@ void new_sort_2e()
     int64_t ikr8 = 0;
     int64_t jkr8 = 0;
     int64_t nonzr8 = 0;
-    double time_start = abs_time();
+    int nread;
 
-    while (true) {
-        if (mrconee_data->group_arith == 1 || mrconee_data->is_spinfree == 1) {
-            if (use_int4) {
-                nread = unf_read(mdcint, "3i4,c8[i4],r8[i4]", &ikr, &jkr, &nonzr, ind_buf, &nonzr, val_buf_real,
-                                 &nonzr);
-
-                for (int ireq = 0; ireq < n_requests; ireq++) {
-                    sorting_request_t *req = &sorting_requests[ireq];
-                    diagram_t *dg = req->dg;
-                    if (dg->rank != 4) { // one-electron diagrams will be sorted later
-                        continue;
-                    }
+    if (use_int4) {
+        if (is_real) {
+            nread = unf_read(mdcint, "3i4,c8[i4],r8[i4]", &ikr, &jkr, &nonzr, ind, &nonzr, val_buf_real, &nonzr);
+        }
+        else {
+            nread = unf_read(mdcint, "3i4,c8[i4],z8[i4]", &ikr, &jkr, &nonzr, ind, &nonzr, val, &nonzr);
+        }
+    }
+    else {
+        if (is_real) {
+            nread = unf_read(mdcint, "3i8,c16[i8],r8[i8]", &ikr8, &jkr8, &nonzr8, ind_buf_8, &nonzr8, val_buf_real,
+                             &nonzr8);
+        }
+        else {
+            nread = unf_read(mdcint, "3i8,c16[i8],z8[i8]", &ikr8, &jkr8, &nonzr8, ind_buf_8, &nonzr8, val, &nonzr8);
+        }
+        ikr = (int32_t) ikr8;
+        jkr = (int32_t) jkr8;
+        nonzr = (int32_t) nonzr8;
+    }
 
-                    expand_ints(dg, ikr, jkr, nonzr, ind_buf, val_buf_real, kr, nkr);
-                }
+    if (nread != 5 || unf_error(mdcint)) {
+        perror(" error while reading MDCINT file");
+        return 0;
+    }
 
-            }
-            else {
-                nread = unf_read(mdcint, "3i8,c16[i8],r8[i8]", &ikr8, &jkr8, &nonzr8, ind_buf_8, &nonzr8, val_buf_real,
-                                 &nonzr8);
-                ikr = (int32_t) ikr8;
-                jkr = (int32_t) jkr8;
-                nonzr = (int32_t) nonzr8;
-            }
+    if (ikr == 0 && jkr == 0) {
+        return 0;
+    }
+
+    if (!use_int4) {
+        for (int i = 0; i < 2 * nonzr; i++) {
+            ind[i] = (int32_t) ind_buf_8[i];
         }
-        else {
-            if (use_int4) {
-                nread = unf_read(mdcint, "3i4,c8[i4],z8[i4]", &ikr, &jkr, &nonzr, ind_buf, &nonzr, val_buf_complex,
-                                 &nonzr);
+    }
+    if (is_real) {
+        for (int i = 0; i < nonzr; i++) {
+            val[i] = val_buf_real[i] + 0.0 * I;
+        }
+    }
+
+    int irec = batch->n_records;
+    batch->ikr[irec] = ikr;
+    batch->jkr[irec] = jkr;
+    batch->nonzr[irec] = nonzr;
+    batch->offset[irec] = batch->n_ints;
+    batch->n_records++;
+    batch->n_ints += nonzr;
+
+    return 1;
+}
+
+
+/*
+ * bounded queue of batches.
+ * all state transitions are performed inside the 'cc_mdcint_queue' critical section.
+ */
+static int acquire_free_batch(mdcint_queue_t *queue)
+{
+    int ibatch = -1;
+
+    #pragma omp critical (cc_mdcint_queue)
+    {
+        for (int i = 0; i < queue->n_batches; i++) {
+            if (queue->batches[i].state == MDCINT_BATCH_FREE) {
+                queue->batches[i].state = MDCINT_BATCH_FILLING;
+                ibatch = i;
+                break;
             }
-            else {
-                nread = unf_read(mdcint, "3i8,c16[i8],z8[i8]", &ikr8, &jkr8, &nonzr8, ind_buf_8, &nonzr8,
-                                 val_buf_complex, &nonzr8);
-                ikr = (int32_t) ikr8;
-                jkr = (int32_t) jkr8;
-                nonzr = (int32_t) nonzr8;
+        }
+    }
+
+    return ibatch;
+}
+
+
+/*
+ * returns the batch with the sequence number 'seq' if it is ready.
+ * a batch is shared by all workers and is freed when the last of them releases it.
+ */
+static int acquire_ready_batch(mdcint_queue_t *queue, int64_t seq, int *finished)
+{
+    int ibatch = -1;
+
+    #pragma omp critical (cc_mdcint_queue)
+    {
+        for (int i = 0; i < queue->n_batches; i++) {
+            if (queue->batches[i].state == MDCINT_BATCH_READY && queue->batches[i].seq == seq) {
+                ibatch = i;
+                break;
             }
         }
+        *finished = (ibatch < 0 && queue->reader_done && seq >= queue->n_ready);
+    }
 
-        if (nread != 5 || unf_error(mdcint)) {
+    return ibatch;
+}
 
-            perror(" error while reading MDCINT file");
-            break;
+
+static void release_batch(mdcint_queue_t *queue, int ibatch)
+{
+    #pragma omp critical (cc_mdcint_queue)
+    {
+        mdcint_batch_t *batch = &queue->batches[ibatch];
+        batch->n_pending--;
+        if (batch->n_pending == 0) {
+            batch->state = MDCINT_BATCH_FREE;
         }
+    }
+}
+
+
+/*
+ * assigns target blocks to workers: the next block goes to the least loaded one
+ */
+static void distribute_targets(mdcint_target_t *targets, int n_targets, int n_workers)
+{
+    if (n_workers < 1) {
+        return;
+    }
+
+    size_t *load = (size_t *) cc_calloc(n_workers, sizeof(size_t));
 
-        if (ikr == 0 && jkr == 0) {
-            break;
+    for (int itgt = 0; itgt < n_targets; itgt++) {
+        int min_worker = 0;
+        for (int iw = 1; iw < n_workers; iw++) {
+            if (load[iw] < load[min_worker]) {
+                min_worker = iw;
+            }
         }
+        targets[itgt].owner = min_worker;
+        load[min_worker] += targets[itgt].block->size;
+    }
+
+    cc_free(load);
+}
+
+
+/*
+ * worker < 0: the caller owns all target blocks
+ */
+static void expand_batch(mdcint_batch_t *batch, mdcint_diagram_t *diagrams, int n_diagrams, int worker,
+                         int32_t *kr, int nkr)
+{
+    for (int irec = 0; irec < batch->n_records; irec++) {
+        size_t offset = batch->offset[irec];
+        expand_ints(diagrams, n_diagrams, worker, batch->ikr[irec], batch->jkr[irec], batch->nonzr[irec],
+                    batch->ind + 2 * offset, batch->val + offset, kr, nkr);
+    }
+}
+
+
+/*
+ * target block of the diagram for the quadruple of spinor blocks,
+ * NULL if there is no such unique block or it belongs to another worker
+ */
+static mdcint_target_t *find_target(mdcint_diagram_t *tdg, int *spinor_blocks, int worker)
+{
+    diagram_t *dg = tdg->dg;
 
-        count_non_zero += nonzr;
+    block_t *block = diagram_get_block(dg, spinor_blocks);
+    if (block == NULL || !block->is_unique) {
+        return NULL;
     }
 
-    double time_finish = abs_time();
-    printf(" number of non-zero ints    %lld\n", count_non_zero);
-    printf(" time for reading 2e ints   %.2f sec\n\n", time_finish - time_start);
+    int dims[4] = {n_spinor_blocks, n_spinor_blocks, n_spinor_blocks, n_spinor_blocks};
+    size_t iblock = dg->inv_index[tensor_index_to_linear(4, dims, spinor_blocks)];
+    mdcint_target_t *target = tdg->block_targets[iblock];
 
+    if (worker >= 0 && target->owner != worker) {
+        return NULL;
+    }
 
-    /*
-     * cleanup
-     */
+    return target;
+}
 
-    unf_close(mdcint);
 
-    free(ind_buf);
-    free(ind_buf_8);
-    free(val_buf_real);
-    free(val_buf_complex);
-    free(kr);
+/*
+ * the same as block_set_element(), but the values are written to 'buf'
+ * which has the shape of the block
+ */
+static void set_block_element(block_t *block, void *buf, int *idx, double complex val)
+{
+    int dims[4];
+    int rel_idx[4];
+
+    for (int i = 0; i < 4; i++) {
+        dims[i] = block->shape[i];
+        int j;
+        for (j = 0; j < dims[i]; j++) {
+            if (idx[i] == block->indices[i][j]) {
+                rel_idx[i] = j;
+                break;
+            }
+        }
+        // no such element
+        if (j == dims[i]) {
+            return;
+        }
+    }
 
-    print_amplitude_distribution_analysis("hhpp");
-    //print_amplitude_distribution_analysis("pphh");
+    size_t offset = tensor_index_to_linear(4, dims, rel_idx);
+    if (arith == CC_ARITH_COMPLEX) {
+        ((double complex *) buf)[offset] = val;
+    }
+    else {
+        ((double *) buf)[offset] = creal(val);
+    }
+}
 
-    //exit(0);
+
+/*
+ * direct and exchange integrals are combined in the same order as in
+ * sort_twoel_task(), including the conjugation of the pppp (3412) blocks
+ */
+static void assemble_target(mdcint_target_t *target)
+{
+    block_t *block = target->block;
+    sorting_request_t *req = target->req;
+    size_t size = block->size;
+
+    if (arith == CC_ARITH_COMPLEX) {
+        double complex *direct = block->buf;
+        double complex *exchange = (double complex *) target->exchange;
+        int is_swapped = block->spinor_blocks[2] > block->spinor_blocks[3];
+        int do_conj = is_pppp_diagram(req->hp, req->valence, req->order);
+
+        for (size_t i = 0; i < size; i++) {
+            if (!do_conj) {
+                direct[i] = direct[i] - exchange[i];
+            }
+            else if (!is_swapped) {
+                direct[i] = conj(direct[i] - exchange[i]);
+            }
+            else {
+                direct[i] = conj(-exchange[i]) + direct[i];
+            }
+        }
+    }
+    else {
+        double *direct = (double *) block->buf;
+        double *exchange = (double *) target->exchange;
+        for (size_t i = 0; i < size; i++) {
+            direct[i] = direct[i] - exchange[i];
+        }
+    }
 }
 
 
@@ -240,22 +723,19 @@ int kr2abs(int ikr, int32_t *kr, int nkr)
 }
 
 
-void expand_ints(diagram_t *dg, int ikr, int jkr, int nonzr, void *ind_buf, double *val_buf, int32_t *kr, int nkr)
+void expand_ints(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int ikr, int jkr, int nonzr,
+                 int32_t *ind, double complex *val, int32_t *kr, int nkr)
 {
-    int32_t *indk = (int32_t *) calloc(nonzr, sizeof(int32_t));
-    int32_t *indl = (int32_t *) calloc(nonzr, sizeof(int32_t));
-
-    for (int i = 0; i < nonzr; i++) {
-        indk[i] = ((int32_t *) ind_buf)[2 * i];
-        indl[i] = ((int32_t *) ind_buf)[2 * i + 1];
+    if (nonzr == 0) {
+        return;
     }
 
-    int kclass = int_class(ikr, indk[0], jkr, indl[0]);
+    int kclass = int_class(ikr, ind[0], jkr, ind[1]);
 
     for (int idx = 0; idx < nonzr; idx++) {
-        int kkr = indk[idx];
-        int lkr = indl[idx];
-        double complex val = val_buf[idx] + 0.0 * I;
+        int kkr = ind[2 * idx];
+        int lkr = ind[2 * idx + 1];
+        double complex cint = val[idx];
 
         // pass to Dirac notation: (ij|kl) -> <ik|jl>
         int ikrd = ikr;
@@ -266,16 +746,16 @@ void expand_ints(diagram_t *dg, int ikr, int jkr, int nonzr, void *ind_buf, doub
         //printf("%3d%3d%3d%3d\n", ikrd, jkrd, kkrd, lkrd);
 
         if (kclass == INT_CLASS_NO_BARS || kclass == INT_CLASS_TWO_BARS) {
-            perm_symm(dg, ikrd, jkrd, kkrd, lkrd, val, nkr, kr);
+            perm_symm(diagrams, n_diagrams, worker, ikrd, jkrd, kkrd, lkrd, cint, nkr, kr);
             if (cc_opts->mrconee_data->is_spinfree == 1) {
-                perm_symm(dg, ikrd, -lkrd, kkrd, -jkrd, val, nkr, kr);  // MUST be in NR case
-                perm_symm(dg, -kkrd, jkrd, -ikrd, lkrd, val, nkr, kr);  // MUST be in NR case
+                perm_symm(diagrams, n_diagrams, worker, ikrd, -lkrd, kkrd, -jkrd, cint, nkr, kr);  // MUST be in NR case
+                perm_symm(diagrams, n_diagrams, worker, -kkrd, jkrd, -ikrd, lkrd, cint, nkr, kr);  // MUST be in NR case
             }
-            perm_symm(dg, -kkrd, -lkrd, -ikrd, -jkrd, val, nkr, kr);
+            perm_symm(diagrams, n_diagrams, worker, -kkrd, -lkrd, -ikrd, -jkrd, cint, nkr, kr);
         }
         else {
-            perm_symm(dg, ikrd, jkrd, kkrd, lkrd, val, nkr, kr);
-            perm_symm(dg, -kkrd, -lkrd, -ikrd, -jkrd, -val, nkr, kr);
+            perm_symm(diagrams, n_diagrams, worker, ikrd, jkrd, kkrd, lkrd, cint, nkr, kr);
+            perm_symm(diagrams, n_diagrams, worker, -kkrd, -lkrd, -ikrd, -jkrd, -cint, nkr, kr);
         }
 
 
@@ -299,47 +779,50 @@ void expand_ints(diagram_t *dg, int ikr, int jkr, int nonzr, void *ind_buf, doub
             end if
          */
     }
-
-    free(indk);
-    free(indl);
 }
 
 
-void perm_symm(diagram_t *dg, int ikr, int jkr, int kkr, int lkr, double complex val, int nkr, int32_t *kr)
+void perm_symm(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int ikr, int jkr, int kkr, int lkr,
+               double complex val, int nkr, int32_t *kr)
 {
     int i = kr2abs(ikr, kr, nkr) - 1;
     int j = kr2abs(jkr, kr, nkr) - 1;
     int k = kr2abs(kkr, kr, nkr) - 1;
     int l = kr2abs(lkr, kr, nkr) - 1;
 
-    put_integral(dg, i, j, k, l, val);
-    put_integral(dg, j, i, l, k, val);
-    put_integral(dg, k, l, i, j, conj(val));
-    put_integral(dg, l, k, j, i, conj(val));
-
-    put_integral(dg, i, j, l, k, -val);
-    put_integral(dg, j, i, k, l, -val);
-    put_integral(dg, k, l, j, i, -conj(val));
-    put_integral(dg, l, k, i, j, -conj(val));
+    put_integral(diagrams, n_diagrams, worker, i, j, k, l, val);
+    put_integral(diagrams, n_diagrams, worker, j, i, l, k, val);
+    put_integral(diagrams, n_diagrams, worker, k, l, i, j, conj(val));
+    put_integral(diagrams, n_diagrams, worker, l, k, j, i, conj(val));
 }
 
 
-void put_integral(diagram_t *dg, int i, int j, int k, int l, double complex val)
+/*
+ * Coulomb integral <ij|kl> is the direct contribution to <ij||kl>
+ * and the exchange contribution to <ij||lk>
+ */
+void put_integral(mdcint_diagram_t *diagrams, int n_diagrams, int worker, int i, int j, int k, int l,
+                  double complex val)
 {
-    int idx[4];
-    idx[0] = i;
-    idx[1] = j;
-    idx[2] = k;
-    idx[3] = l;
-    /*idx[0] = spinor_index_global2local[i];
-    idx[1] = spinor_index_global2local[j];
-    idx[2] = spinor_index_global2local[k];
-    idx[3] = spinor_index_global2local[l];*/
-
-    //printf("set %d/%d/%d/%d   %.6g\n", i, j, k, l, creal(val));
+    int idx[4] = {i, j, k, l};
+    int idx_exchange[4] = {i, j, l, k};
 
+    int spinor_blocks[4];
+    for (int p = 0; p < 4; p++) {
+        spinor_blocks[p] = spinor_info[idx[p]].blockno;
+    }
+    int spinor_blocks_exchange[4] = {spinor_blocks[0], spinor_blocks[1], spinor_blocks[3], spinor_blocks[2]};
 
-    diagram_set(dg, val, idx);
+    for (int idg = 0; idg < n_diagrams; idg++) {
+        mdcint_target_t *direct = find_target(&diagrams[idg], spinor_blocks, worker);
+        if (direct != NULL) {
+            set_block_element(direct->block, direct->block->buf, idx, val);
+        }
+        mdcint_target_t *exchange = find_target(&diagrams[idg], spinor_blocks_exchange, worker);
+        if (exchange != NULL) {
+            set_block_element(exchange->block, exchange->exchange, idx_exchange, val);
+        }
+    }
 }
 
 
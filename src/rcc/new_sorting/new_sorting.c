@@ -29,6 +29,7 @@
 
 #include "error.h"
 #include "mdprop.h"
+#include "memory.h"
 #include "mrconee.h"
 #include "options.h"
 #include "spinors.h"
@@ -135,8 +136,17 @@ void new_sorting(cc_options_t *options)
         mrconee_data->totally_sym_irrep = new_irrep_a1;
     }
 
+    /*
+     * symmetry module takes ownership of the list of irrep names and releases it with cc_free(),
+     * while names read from MRCONEE are allocated with calloc() and belong to mrconee_data
+     */
+    char **rep_names = (char **) cc_calloc(mrconee_data->num_irreps, sizeof(char *));
+    for (int i = 0; i < mrconee_data->num_irreps; i++) {
+        rep_names[i] = cc_strdup(mrconee_data->irrep_names[i]);
+    }
+
     setup_symmetry(mrconee_data->group_arith, mrconee_data->point_group, mrconee_data->num_irreps,
-                   mrconee_data->irrep_names, mrconee_data->totally_sym_irrep, mrconee_data->mult_table);
+                   rep_names, mrconee_data->totally_sym_irrep, mrconee_data->mult_table);
 
     /*
      * setup information about spinors and active space
@@ -70,9 +70,13 @@ cc_options_t *new_options()
     opts->print_model_space = 0;
     opts->print_model_vectors = 0;
     opts->print_eff_config = 0;
+    opts->print_trace = 0;
+    opts->print_perf_counters = 0;
+    opts->print_memory_timeline = 0;
     opts->recommended_arith = CC_ARITH_REAL;
     opts->max_memory_size = 1024u * 1024u * 1024u;  // 1 Gb
     opts->compress = CC_COMPRESS_NONE;
+    opts->compress_lossy_tol = 1e-12;
 
     // compression of arrays with triples amplitudes
     opts->do_compress_triples = 0;
@@ -81,6 +85,9 @@ cc_options_t *new_options()
 
     opts->tile_size = 100;
     opts->disk_usage_level = CC_DISK_USAGE_LEVEL_2;  // rank-6+ and pppp on disk
+    opts->compressed_tier = 0;
+    opts->compressed_tier_fraction = 0.5;
+    opts->cholesky_thresh = 0.0;
     opts->nthreads = 1;
     opts->openmp_algorithm = CC_OPENMP_ALGORITHM_EXTERNAL;
     opts->cuda_enabled = 0;
@@ -93,6 +100,7 @@ cc_options_t *new_options()
     strcpy(opts->integral_file_prop, "MDPROP");
     opts->x2cmmf = 0;
     opts->new_sorting = 0;
+    opts->presort_integrals = 1;
     // for Daniel Maison integral program
     opts->gaunt_defined = 0;
     opts->breit_defined = 0;
@@ -146,12 +154,14 @@ cc_options_t *new_options()
     // resort integrals or not
     opts->reuse_integrals_1 = 0;
     opts->reuse_integrals_2 = 0;
+    opts->integral_cache_dir[0] = '\0';
 
     // read precomputed amplitudes from disk (as initial guess) or not
     memset(opts->reuse_amplitudes, 0, sizeof(opts->reuse_amplitudes));
 
     // flush non-converged amplitudes to disk
     opts->do_flush_iter = 0;
+    opts->do_flush_time = 0;
 
     // denominator shifts
     memset(opts->shifts, 0, sizeof(opts->shifts));
@@ -363,6 +373,18 @@ void print_options(cc_options_t *opts)
     else {
         printf("\n");
     }
+    if (opts->print_trace == 1) {
+        printf(" %-15s  %-40s  %s\n", "print \"trace\"", "timeline of engine activity", "trace.json");
+    }
+    else if (opts->print_trace == 2) {
+        printf(" %-15s  %-40s  %s\n", "print \"trace blocks\"", "timeline incl. events of individual blocks", "trace.json");
+    }
+    if (opts->print_perf_counters) {
+        printf(" %-15s  %-40s  %s\n", "print \"counters\"", "hardware performance counters", "yes");
+    }
+    if (opts->print_memory_timeline) {
+        printf(" %-15s  %-40s  %s\n", "print \"memory\"", "memory usage by diagrams (time series)", "memory.csv");
+    }
 
     printf(" %-15s  %-40s  %s\n", "flush_amplitude", "write formatted files with cluser ampl-s",
            opts->do_flush_amplitudes_txt ? "yes" : "no");
@@ -370,7 +392,13 @@ void print_options(cc_options_t *opts)
     printf(" %-15s  %-40s  %s\n", "arith", "recommended arithmetic",
            opts->recommended_arith == CC_ARITH_REAL ? "real" : "complex");
     printf(" %-15s  %-40s  %.1f Mb\n", "memory", "max allowed RAM usage", opts->max_memory_size / (1024.0 * 1024.0));
-    printf(" %-15s  %-40s  %s\n", "compress", "compression of integrals on disk", opts->compress ? "LZ4" : "disabled");
+    if (opts->compress == CC_COMPRESS_LOSSY) {
+        printf(" %-15s  %-40s  lossy, tol=%g\n", "compress", "compression of data on disk", opts->compress_lossy_tol);
+    }
+    else {
+        char *codec_names[] = {"disabled", "LZ4", "shuffle+LZ4", "lossy", "sparse"};
+        printf(" %-15s  %-40s  %s\n", "compress", "compression of data on disk", codec_names[opts->compress]);
+    }
     if (opts->do_compress_triples) {
         printf(" %-15s %-40s  yes, thresh=%g, datatype=%s\n", "compress_triples",
                "compression of triples tensors in RAM",
@@ -381,6 +409,9 @@ void print_options(cc_options_t *opts)
     }
     printf(" %-15s  %-40s  ", "disk_usage", "disk usage level");
     switch (opts->disk_usage_level) {
+        case CC_DISK_USAGE_AUTO:
+            printf("auto (placement under the memory limit)\n");
+            break;
         case CC_DISK_USAGE_LEVEL_0:
             printf("0 (all data in RAM)\n");
             break;
@@ -400,6 +431,14 @@ void print_options(cc_options_t *opts)
             printf("\n");
             break;
     }
+    if (opts->compressed_tier) {
+        printf(" %-15s  %-40s  enabled, max %.1f Mb\n", "disk_usage ram", "compressed in-RAM tier for disk diagrams",
+               opts->compressed_tier_fraction * opts->max_memory_size / (1024.0 * 1024.0));
+    }
+    if (opts->cholesky_thresh > 0.0) {
+        printf(" %-15s  %-40s  enabled, thresh %g\n", "disk_usage cholesky", "Cholesky representation of pppp integrals",
+               opts->cholesky_thresh);
+    }
     printf(" %-15s  %-40s  %d\n", "tilesize", "max dimension of formal blocks (tiles)", opts->tile_size);
     printf(" %-15s  %-40s  %d\n", "nthreads", "number of OpenMP parallel threads", opts->nthreads);
     printf(" %-15s  %-40s  %s\n", "openmp_algorithm", "parallelization algorithm for mult",
@@ -432,6 +471,9 @@ void print_options(cc_options_t *opts)
     }
     printf("\n");
 
+    printf(" %-15s  %-40s  %s\n", "reuse cache", "persistent cache of sorted integrals",
+           opts->integral_cache_dir[0] != '\0' ? opts->integral_cache_dir : "disabled");
+
     printf(" %-15s  %-40s  ", "skip", "skip computations in sectors:");
     for (int i = 0; i < MAX_SECTOR_RANK; i++) {
         for (int j = 0; j < MAX_SECTOR_RANK; j++) {
@@ -442,16 +484,23 @@ void print_options(cc_options_t *opts)
     }
     printf("\n");
 
-    printf(" %-15s  %-40s  ", "flush", "flush amplitudes");
-    if (opts->do_flush_iter > 0) {
+    printf(" %-15s  %-40s  ", "flush", "flush amplitudes and restart checkpoint");
+    if (opts->do_flush_iter > 0 && opts->do_flush_time > 0) {
+        printf("each %d iterations or %d min\n", opts->do_flush_iter, opts->do_flush_time / 60);
+    }
+    else if (opts->do_flush_iter > 0) {
         printf("each %d iterations\n", opts->do_flush_iter);
     }
+    else if (opts->do_flush_time > 0) {
+        printf("each %d min\n", opts->do_flush_time / 60);
+    }
     else {
         printf("no\n");
     }
 
     printf(" %-15s  %-40s  %s\n", "interface", "source of transformed molecular integrals",
-           opts->int_source == CC_INTEGRALS_DIRAC ? "DIRAC" : "PySCF");
+           opts->int_source == CC_INTEGRALS_DIRAC ? "DIRAC" :
+           opts->int_source == CC_INTEGRALS_PYSCF ? "PySCF" : "synthetic");
 
     printf(" %-15s  %-40s  %s\n", "integrals", "one-electron Hamiltonian integrals file", opts->integral_file_1);
     printf(" %-15s  %-40s  %s\n", "", "two-electron (Coulomb) integrals file", opts->integral_file_2);
@@ -470,6 +519,13 @@ void print_options(cc_options_t *opts)
     else {
         printf("no\n");
     }
+    printf(" %-15s  %-40s  ", "presort", "sort integrals for all sectors at once");
+    if (opts->presort_integrals) {
+        printf("yes\n");
+    }
+    else {
+        printf("no\n");
+    }
     printf(" %-15s  %-40s  ", "gaunt", "two-electron (Gaunt) integrals file");
     if (opts->gaunt_defined) {
         printf("%s\n", opts->integral_file_gaunt);
@@ -51,19 +51,22 @@ void display_help();
  * Parses command-line arguments:
  * -s, --scratch=PATH         Path to scratch directory (default: ./scratch)
  * -n, --no-clean             Do not clean scratch directory on exit
+ *     --plan                 Estimate memory, disk and FLOPs and exit (dry run)
  * -?, --help                 Print this help list and exit
  *     --usage                Print a short usage message and exit
  * -V, --version              Print program version and exit
  * Usage: expt.x [-n?V] [-s PATH] [--no-clean-scratch] [--scratch-dir=PATH]
- *               [--help] [--usage] [--version] <input-file>
+ *               [--plan] [--help] [--usage] [--version] <input-file>
  */
-void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path, int *do_clean_scratch)
+void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path, int *do_clean_scratch,
+                int *do_plan)
 {
     int args_clean;              /* =0 if do not clean scratch directory on exit */
     char *args_scratch_dir;      /* Path to scratch directory (default: ./scratch) */
     char **args_inputFiles;      /* input files */
     int args_numInputFiles;      /* number of input files */
     int args_print_usage;        /* --usage option */
+    int args_plan;               /* --plan option: dry run */
 
     int opt = 0;
     int longIndex = 0;
@@ -77,6 +80,7 @@ void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path
             {"version",  no_argument,       NULL, 'V'},
             {"scratch",  required_argument, NULL, 's'},
             {"usage",    no_argument,       NULL, 0},
+            {"plan",     no_argument,       NULL, 0},
             {"help",     no_argument,       NULL, 'h'},
             {NULL,       no_argument,       NULL, 0}
     };
@@ -87,6 +91,7 @@ void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path
     args_numInputFiles = 0;
     args_print_usage = 0;
     args_clean = 1;
+    args_plan = 0;
 
     /* Process the arguments with getopt_long(), then
      * populate args_*.
@@ -115,6 +120,9 @@ void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path
                     display_usage();
                     exit(0);
                 }
+                if (strcmp("plan", longOpts[longIndex].name) == 0) {
+                    args_plan = 1;
+                }
                 break;
             default:
                 /* You won't actually get here. */
@@ -139,6 +147,7 @@ void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path
     strcpy(input_name, args_inputFiles[0]);
     *scratch_dir_path = args_scratch_dir;
     *do_clean_scratch = args_clean;
+    *do_plan = args_plan;
 }
 
 
@@ -164,7 +173,7 @@ void display_version()
 void display_usage()
 {
     printf("Usage: expt.x [-n?V] [-s PATH] [--no-clean] [--scratch=PATH]\n");
-    printf("       [--help] [--usage] [--version] <input-file>\n");
+    printf("       [--plan] [--help] [--usage] [--version] <input-file>\n");
     exit(0);
 }
 
@@ -185,6 +194,8 @@ void display_help()
     printf("  -n, --no-clean             Do not clean scratch directory on exit\n");
     printf("                             (use this option to preserve cluster amplitudes etc)\n");
     printf("  -s, --scratch=PATH         Path to scratch directory (default: ./scratch)\n");
+    printf("      --plan                 Estimate RAM, disk space and FLOPs per iteration\n");
+    printf("                             for the input file and exit (nothing is computed)\n");
     printf("  -?, --help                 Print this help list and exit\n");
     printf("      --usage                Print a short usage message and exit\n");
     printf("  -V, --version              Print program version and exit\n");
@@ -25,6 +25,7 @@
 #ifndef CC_PARSE_ARGV_H_INCLUDED
 #define CC_PARSE_ARGV_H_INCLUDED
 
-void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path, int *do_clean_scratch);
+void parse_argv(int argc, char **argv, char *input_name, char **scratch_dir_path, int *do_clean_scratch,
+                int *do_plan);
 
 #endif // CC_PARSE_ARGV_H_INCLUDED
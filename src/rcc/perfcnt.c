@@ -0,0 +1,246 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Hardware performance counters around the main kernels (see perfcnt.h).
+ *
+ * Each thread opens its own group of counters (perf_event_open(2) with
+ * pid = 0, cpu = -1) on the first use; the group is read by one read()
+ * system call. Events which are not supported by the CPU (or forbidden by
+ * /proc/sys/kernel/perf_event_paranoid) are silently skipped.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfcnt.h"
+
+int cc_perfcnt_enabled = 0;
+
+static char *kernel_names[PERFCNT_N_KERNELS] = {
+        "mulblocks",
+        "tensor_transpose",
+        "diveps_block",
+        "sort_fill_block",
+        "lz4_compress",
+        "lz4_decompress"
+};
+
+static struct {
+    uint64_t n_calls;
+    uint64_t values[PERFCNT_N_EVENTS];
+} totals[PERFCNT_N_KERNELS];
+
+// event was opened by at least one thread
+static int event_available[PERFCNT_N_EVENTS];
+
+// per-thread group of counters:
+// group_fd = -2 (not opened yet) or -1 (unavailable)
+static __thread int group_fd = -2;
+static __thread int event_pos[PERFCNT_N_EVENTS];
+
+static void open_counters();
+
+
+/**
+ * Enables counters (on Linux only).
+ */
+void perfcnt_enable()
+{
+#ifdef __linux__
+    cc_perfcnt_enabled = 1;
+#else
+    printf(" hardware performance counters are available on Linux only\n");
+#endif
+}
+
+
+/**
+ * Reads current values of counters of the calling thread.
+ * Unavailable events are set to zero.
+ */
+void perfcnt_read(perfcnt_sample_t *sample)
+{
+    memset(sample, 0, sizeof(perfcnt_sample_t));
+
+#ifdef __linux__
+    if (group_fd == -2) {
+        open_counters();
+    }
+    if (group_fd == -1) {
+        return;
+    }
+
+    // PERF_FORMAT_GROUP: number of events + values in order of opening
+    uint64_t buf[1 + PERFCNT_N_EVENTS];
+    if (read(group_fd, buf, sizeof(buf)) <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < PERFCNT_N_EVENTS; i++) {
+        if (event_pos[i] >= 0 && (uint64_t) event_pos[i] < buf[0]) {
+            sample->values[i] = buf[1 + event_pos[i]];
+        }
+    }
+#endif
+}
+
+
+/**
+ * Adds the difference between current values of counters and the 'start'
+ * sample to the totals of the kernel. Can be called from any thread.
+ */
+void perfcnt_add(perfcnt_kernel_t kernel, perfcnt_sample_t *start)
+{
+    perfcnt_sample_t end;
+    perfcnt_read(&end);
+
+    #pragma omp atomic
+    totals[kernel].n_calls++;
+
+    for (int i = 0; i < PERFCNT_N_EVENTS; i++) {
+        uint64_t diff = end.values[i] - start->values[i];
+        #pragma omp atomic
+        totals[kernel].values[i] += diff;
+    }
+}
+
+
+/**
+ * Prints counters aggregated per kernel.
+ */
+void perfcnt_print_stats()
+{
+    if (!cc_perfcnt_enabled) {
+        return;
+    }
+
+    int any_event = 0;
+    for (int i = 0; i < PERFCNT_N_EVENTS; i++) {
+        any_event |= event_available[i];
+    }
+    if (!any_event) {
+        printf(" hardware performance counters are not available (see /proc/sys/kernel/perf_event_paranoid)\n");
+        return;
+    }
+
+    printf("\n");
+    printf(" Hardware performance counters (user space, threads of the BLAS library are not counted)\n");
+    printf(" ---------------------------------------------------------------------------------------------------------\n");
+    printf("  %-18s %10s %16s %16s %6s %14s %14s %8s %8s\n",
+           "kernel", "calls", "cycles", "instructions", "IPC", "LLC misses", "dTLB misses", "LLC/ki", "dTLB/ki");
+    printf(" ---------------------------------------------------------------------------------------------------------\n");
+    for (int k = 0; k < PERFCNT_N_KERNELS; k++) {
+        if (totals[k].n_calls == 0) {
+            continue;
+        }
+        uint64_t *v = totals[k].values;
+        double kinstr = v[PERFCNT_INSTRUCTIONS] / 1000.0;
+        printf("  %-18s %10" PRIu64 " %16" PRIu64 " %16" PRIu64 " %6.2f %14" PRIu64 " %14" PRIu64 " %8.3f %8.3f\n",
+               kernel_names[k], totals[k].n_calls, v[PERFCNT_CYCLES], v[PERFCNT_INSTRUCTIONS],
+               (v[PERFCNT_CYCLES] > 0) ? (double) v[PERFCNT_INSTRUCTIONS] / v[PERFCNT_CYCLES] : 0.0,
+               v[PERFCNT_LLC_MISSES], v[PERFCNT_DTLB_MISSES],
+               (kinstr > 0) ? v[PERFCNT_LLC_MISSES] / kinstr : 0.0,
+               (kinstr > 0) ? v[PERFCNT_DTLB_MISSES] / kinstr : 0.0);
+    }
+    printf(" ---------------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < PERFCNT_N_EVENTS; i++) {
+        static char *event_names[] = {"cycles", "instructions", "LLC misses", "dTLB misses"};
+        if (!event_available[i]) {
+            printf("  event '%s' is not supported (zero values)\n", event_names[i]);
+        }
+    }
+}
+
+
+#ifdef __linux__
+
+static int perf_event_open(struct perf_event_attr *attr, int group)
+{
+    return (int) syscall(__NR_perf_event_open, attr, 0 /* this thread */, -1 /* any cpu */, group, 0);
+}
+
+
+/*
+ * opens the group of counters for the calling thread
+ */
+static void open_counters()
+{
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[PERFCNT_N_EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+    };
+
+    group_fd = -1;
+    int n_opened = 0;
+
+    for (int i = 0; i < PERFCNT_N_EVENTS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // the first successfully opened event becomes the group leader
+        int fd = perf_event_open(&attr, group_fd);
+        if (fd == -1) {
+            event_pos[i] = -1;
+            continue;
+        }
+        if (group_fd == -1) {
+            group_fd = fd;
+        }
+        event_pos[i] = n_opened++;
+        event_available[i] = 1;
+    }
+}
+
+#else
+
+static void open_counters()
+{
+    group_fd = -1;
+}
+
+#endif /* __linux__ */
@@ -552,10 +552,10 @@ void conjugate_t2()
 
     for (size_t iblock = 0; iblock < diag_t2conj->n_blocks; iblock++) {
         block_t *block = diag_t2conj->blocks[iblock];
-        block_load(block);
         if (block->is_unique == 0) {
             continue;
         }
+        block_load(block);
 
         int *indices = (int *) cc_malloc(block->size * rank * sizeof(int));
         block_gen_indices(block, indices);
@@ -42,6 +42,7 @@
 #include "options.h"
 #include "spinors.h"
 #include "memory.h"
+#include "io.h"
 #include "cc_properies.h"
 
 #define MAX_LINE_LEN 1024
@@ -142,6 +143,8 @@ void directive_ih_incomplete_main_model_spaces(cc_options_t *opts);
 
 void directive_restrict_t3(cc_options_t *opts);
 
+void directive_compress(cc_options_t *opts);
+
 void directive_compress_triples(cc_options_t *opts);
 
 void directive_spinor_labels(cc_options_t *opts);
@@ -320,7 +323,7 @@ int readinp(char *file_name, cc_options_t *opts)
                 directive_disk_usage(opts);
                 break;
             case KEYWORD_COMPRESS:
-                opts->compress = CC_COMPRESS_LZ4;
+                directive_compress(opts);
                 break;
             case KEYWORD_COMPRESS_TRIPLES:
                 directive_compress_triples(opts);
@@ -521,6 +524,17 @@ void directive_title(cc_options_t *opts)
 /**
  * Syntax:
  * print ( low || medium || high || debug )
+ * print ( "model space" || "eff config" || "model vectors" || "trace" || "trace blocks" ||
+ *         "counters" || "memory" )
+ *
+ * "trace" enables the timeline of engine activity written to trace.json in
+ * the Chrome trace-event format (the same as the EXPT_TRACE env variable).
+ * "trace blocks" adds events of individual blocks (block kernels and i/o) to
+ * the timeline (the same as the EXPT_TRACE_BLOCKS env variable).
+ * "counters" enables hardware performance counters around the main kernels
+ * (Linux only, the same as the EXPT_PERF_COUNTERS env variable).
+ * "memory" writes the time series of memory usage by diagrams and subsystems
+ * to memory.csv (the same as the EXPT_MEMORY_TIMELINE env variable).
  */
 void directive_print(cc_options_t *opts)
 {
@@ -529,7 +543,11 @@ void directive_print(cc_options_t *opts)
                        "Additional printing options:\n"
                        "  \"model space\"\n"
                        "  \"eff config\"\n"
-                       "  \"model vectors\"\n";
+                       "  \"model vectors\"\n"
+                       "  \"trace\"\n"
+                       "  \"trace blocks\"\n"
+                       "  \"counters\"\n"
+                       "  \"memory\"\n";
 
     int token_type = next_token();
 
@@ -567,6 +585,18 @@ void directive_print(cc_options_t *opts)
         else if (strcmp(yytext, "eff config") == 0) {
             opts->print_eff_config = 1;
         }
+        else if (strcmp(yytext, "trace") == 0) {
+            opts->print_trace = (opts->print_trace == 2) ? 2 : 1;
+        }
+        else if (strcmp(yytext, "trace blocks") == 0) {
+            opts->print_trace = 2;
+        }
+        else if (strcmp(yytext, "counters") == 0) {
+            opts->print_perf_counters = 1;
+        }
+        else if (strcmp(yytext, "memory") == 0) {
+            opts->print_memory_timeline = 1;
+        }
         else {
             yyerror(msg);
         }
@@ -1370,11 +1400,15 @@ void directive_shift(cc_options_t *opts)
  * reuse <list of arguments>
  * argument: one of: integrals 1-integrals 2-integrals amplitudes
  *                   0h0p 0h1p 1h0p 0h2p 2h0p 1h1p
+ *                   cache <directory>
+ * 'cache' enables the persistent cache of sorted two-electron integrals
+ * shared between runs with the same integrals (see sort_cache.c).
  */
 void directive_reuse(cc_options_t *opts)
 {
     static char *msg = "wrong parameter of the reuse directive!\n"
-                       "Possible values: integrals 1-integrals 2-integrals amplitudes 0h0p 0h1p 1h0p 0h2p 2h0p 1h1p 0h3p";
+                       "Possible values: integrals 1-integrals 2-integrals amplitudes 0h0p 0h1p 1h0p 0h2p 2h0p 1h1p 0h3p "
+                       "cache <directory>";
     int token_type;
 
     token_type = next_token();
@@ -1394,6 +1428,25 @@ void directive_reuse(cc_options_t *opts)
         else if (strcmp(yytext, "2-integrals") == 0) {
             opts->reuse_integrals_2 = 1;
         }
+        else if (strcmp(yytext, "cache") == 0) {
+            token_type = next_token();
+            if (token_type == END_OF_LINE || token_type == END_OF_FILE) {
+                yyerror("directory of the integral cache not specified");
+            }
+            // relative path: with respect to the working directory at startup, not the scratch one
+            int len;
+            if (yytext[0] == '/') {
+                len = snprintf(opts->integral_cache_dir, CC_MAX_CACHE_DIR_LENGTH, "%s", yytext);
+            }
+            else {
+                char cwd[CC_MAX_PATH_LENGTH];
+                io_getcwd(cwd, CC_MAX_PATH_LENGTH);
+                len = snprintf(opts->integral_cache_dir, CC_MAX_CACHE_DIR_LENGTH, "%s/%s", cwd, yytext);
+            }
+            if (len < 0 || len >= CC_MAX_CACHE_DIR_LENGTH) {
+                yyerror("path to the integral cache directory is too long");
+            }
+        }
         else if (strcmp(yytext, "amplitudes") == 0) {
             for (int h = 0; h < MAX_SECTOR_RANK; h++) {
                 for (int p = 0; p < MAX_SECTOR_RANK; p++) {
@@ -1480,8 +1533,10 @@ void directive_flush(cc_options_t *opts)
         opts->do_flush_iter = ival;
     }
     else if (strcmp(yytext, "min") == 0) {
+        opts->do_flush_time = ival * 60;
     }
     else if (strcmp(yytext, "hrs") == 0) {
+        opts->do_flush_time = ival * 3600;
     }
     else {
         yyerror(msg2);
@@ -1697,18 +1752,36 @@ void directive_tilesize(cc_options_t *opts)
 
 /**
  * Syntax:
- * disk_usage <integer mode>
+ * disk_usage ( <integer mode> | auto ) [ram [<fraction of max memory>]] [cholesky [<threshold>]]
+ * Integer mode sets the fixed placement rules (default 2), with 'auto' the
+ * placement of integrals is chosen according to their sizes and the memory limit.
+ * The 'ram' keyword enables the compressed in-RAM tier: diagrams which are
+ * to be stored on disk according to the disk usage level are kept compressed
+ * in RAM instead (default fraction of memory used for the tier is 0.5).
+ * The 'cholesky' keyword replaces the pppp integrals by their pivoted Cholesky
+ * decomposition with the given threshold (default 1e-6): blocks of integrals
+ * are reconstructed from the Cholesky vectors when they are accessed.
  */
 void directive_disk_usage(cc_options_t *opts)
 {
     static char *msg = "wrong specification of disk usage!\n"
-                       "A positive integer is expected";
-    int level;
+                       "A positive integer or 'auto' is expected";
+    int level = CC_DISK_USAGE_AUTO;
 
-    if (!match(TT_INTEGER)) {
+    int token_type = next_token();
+    if (token_type == TT_WORD) {
+        str_tolower(yytext);
+        if (strcmp(yytext, "auto") != 0) {
+            yyerror(msg);
+        }
+        level = CC_DISK_USAGE_AUTO;
+    }
+    else if (token_type == TT_INTEGER) {
+        level = atoi(yytext);
+    }
+    else {
         yyerror(msg);
     }
-    level = atoi(yytext);
 
     if (level > 4) {
         opts->disk_usage_level = 4;
@@ -1717,9 +1790,45 @@ void directive_disk_usage(cc_options_t *opts)
         opts->disk_usage_level = level;
     }
 
-    if (opts->disk_usage_level == 4) {
+    if (opts->disk_usage_level == 4 && opts->compress == CC_COMPRESS_NONE) {
         opts->compress = CC_COMPRESS_LZ4;
     }
+
+    // compressed in-RAM tier and Cholesky representation of pppp
+    token_type = next_token();
+    while (token_type != END_OF_LINE && token_type != END_OF_FILE) {
+        str_tolower(yytext);
+        if (token_type == TT_WORD && strcmp(yytext, "ram") == 0) {
+            opts->compressed_tier = 1;
+            token_type = next_token();
+            if (token_type == TT_FLOAT) {
+                if (atof(yytext) <= 0.0 || atof(yytext) >= 1.0) {
+                    yyerror("wrong specification of disk usage!\n"
+                            "fraction of max memory for the compressed tier must be a number between 0 and 1");
+                }
+                opts->compressed_tier_fraction = atof(yytext);
+                token_type = next_token();
+            }
+        }
+        else if (token_type == TT_WORD && strcmp(yytext, "cholesky") == 0) {
+            opts->cholesky_thresh = 1e-6;
+            token_type = next_token();
+            if (token_type == TT_FLOAT || token_type == TT_INTEGER) {
+                if (atof(yytext) <= 0.0) {
+                    yyerror("wrong specification of disk usage!\n"
+                            "threshold for the Cholesky decomposition must be positive");
+                }
+                opts->cholesky_thresh = atof(yytext);
+                token_type = next_token();
+            }
+        }
+        else {
+            yyerror("wrong specification of disk usage!\n"
+                    "only the 'ram [<fraction of max memory>]' and 'cholesky [<threshold>]' options\n"
+                    "can follow the disk usage level");
+        }
+    }
+    put_back(token_type);
 }
 
 
@@ -2281,7 +2390,10 @@ void directive_overlap(cc_options_t *opts)
 
 /**
  * Syntax:
- * interface (dirac | pyscf)
+ * interface (dirac | pyscf | synthetic)
+ *
+ * synthetic: integrals are generated, the system is described in the file
+ * given by the 'integrals' directive (see synthetic_interface.c)
  */
 void directive_interface(cc_options_t *opts)
 {
@@ -2297,6 +2409,9 @@ void directive_interface(cc_options_t *opts)
         else if (strcmp(yytext, "pyscf") == 0) {
             cc_opts->int_source = CC_INTEGRALS_PYSCF;
         }
+        else if (strcmp(yytext, "synthetic") == 0) {
+            cc_opts->int_source = CC_INTEGRALS_SYNTHETIC;
+        }
         else {
             yyerror(msg);
         }
@@ -2556,6 +2671,44 @@ void directive_restrict_t3(cc_options_t *opts)
 }
 
 
+/**
+ * Syntax:
+ * compress [lz4 | shuffle | lossy <tolerance> | sparse]
+ * LZ4 is used by default
+ */
+void directive_compress(cc_options_t *opts)
+{
+    static char *msg = "wrong specification of the compression algorithm!\n"
+                       "allowed algorithms are 'lz4', 'shuffle', 'lossy <tolerance>' and 'sparse'";
+    int token_type;
+
+    token_type = next_token();
+    if (token_type == END_OF_LINE || token_type == END_OF_FILE) {
+        put_back(token_type);
+        opts->compress = CC_COMPRESS_LZ4;
+        return;
+    }
+
+    str_tolower(yytext);
+    if (strcmp(yytext, "lz4") == 0) {
+        opts->compress = CC_COMPRESS_LZ4;
+    }
+    else if (strcmp(yytext, "shuffle") == 0) {
+        opts->compress = CC_COMPRESS_SHUFFLE;
+    }
+    else if (strcmp(yytext, "lossy") == 0) {
+        opts->compress = CC_COMPRESS_LOSSY;
+        opts->compress_lossy_tol = match_positive_float_number();
+    }
+    else if (strcmp(yytext, "sparse") == 0) {
+        opts->compress = CC_COMPRESS_SPARSE;
+    }
+    else {
+        yyerror(msg);
+    }
+}
+
+
 void directive_compress_triples(cc_options_t *opts)
 {
     static char *msg1 = "wrong specification of the triples compression parameters!\n"
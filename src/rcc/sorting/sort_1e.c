@@ -34,9 +34,12 @@
 #include "io.h"
 #include "memory.h"
 #include "options.h"
+#include "perfcnt.h"
 #include "spinors.h"
 #include "symmetry.h"
 
+void sort_onel_core_fock(double complex *h_ints);
+
 void fill_block_one_elec(block_t *block, double complex *ints_matrix, int ignore_diagonal);
 
 void reconstruct_fock(int nspinors, double complex *h_matrix, double complex *fock_matrix);
@@ -58,9 +61,6 @@ void sort_onel()
 {
     int nspinors = get_num_spinors();
     double complex *h_ints = (double complex *) x_zeros(CC_COMPLEX, nspinors, nspinors);
-    double complex *f_ints = (double complex *) x_zeros(CC_COMPLEX, nspinors, nspinors);
-
-    printf(" sorting one-electron integrals ...\n");
 
     // read one-electron integrals -- core Fock operator
     // ? а что если HINT нет?
@@ -68,6 +68,24 @@ void sort_onel()
     io_read_compressed(fd, h_ints, sizeof(double complex) * nspinors * nspinors);
     io_close(fd);
 
+    sort_onel_core_fock(h_ints);
+
+    cc_free(h_ints);
+}
+
+
+/**
+ * constructs the Fock matrix from the matrix of the core Fock operator
+ * (nspinors x nspinors, modified in place by one-electron properties)
+ * and fills the one-electron diagrams.
+ */
+void sort_onel_core_fock(double complex *h_ints)
+{
+    int nspinors = get_num_spinors();
+    double complex *f_ints = (double complex *) x_zeros(CC_COMPLEX, nspinors, nspinors);
+
+    printf(" sorting one-electron integrals ...\n");
+
     // read one-electron operators from the OneProp code by Leonid V. Skripnikov
     if (cc_opts->oneprop_on) {
         for (int ioper = 0; ioper < cc_opts->n_oneprop; ioper++) {
@@ -160,7 +178,6 @@ void sort_onel()
         }
     }
 
-    cc_free(h_ints);
     cc_free(f_ints);
 
     printf("done\n");
@@ -273,6 +290,11 @@ void fill_block_one_elec(block_t *block, double complex *ints_matrix, int ignore
 {
     assert(block->rank == 2);
 
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
     int nspinors = get_num_spinors();
 
     int dims_1 = block->shape[0];
@@ -307,6 +329,10 @@ void fill_block_one_elec(block_t *block, double complex *ints_matrix, int ignore
             index++;
         }
     }
+
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_SORT_FILL, &perf_start);
+    }
 }
 
 
@@ -337,6 +363,12 @@ void reconstruct_fock(int nspinors, double complex *h_matrix, double complex *fo
     int *occ_spinors = (int *) cc_malloc(sizeof(int) * nocc);
     get_spinor_indices_occupied(occ_spinors);
 
+    // elements are accessed directly: blocks must be resident (and pinned)
+    diagram_t *dg_fock[] = {dg_hhhh, dg_hhhp, dg_hphh, dg_hphp};
+    for (int i = 0; i < 4; i++) {
+        diagram_load_blocks(dg_fock[i]);
+    }
+
     printf("   Fock matrix reconstruction ...\n");
     for (int i = 0; i < nspinors; i++) {
         for (int j = 0; j < nspinors; j++) {
@@ -368,6 +400,10 @@ void reconstruct_fock(int nspinors, double complex *h_matrix, double complex *fo
         }
     }
 
+    for (int i = 0; i < 4; i++) {
+        diagram_unload_blocks(dg_fock[i]);
+    }
+
     cc_free(occ_spinors);
 }
 
@@ -383,6 +419,7 @@ double recalculate_scf_energy(double complex *h_ints)
         errquit("in sort_onel(): diagram 'hhhh' is required to construct Fock matrix, but it was not found");
     }
 
+    diagram_load_blocks(dg_hhhh);
     for (int i = 0; i < nspinors; i++) {
         if (!is_hole(i)) { continue; }
         new_escf += h_ints[i * nspinors + i];
@@ -395,6 +432,7 @@ double recalculate_scf_energy(double complex *h_ints)
             new_escf += 0.5 * diagram_get(dg_hhhh, idx4);
         }
     }
+    diagram_unload_blocks(dg_hhhh);
 
     return new_escf;
 }
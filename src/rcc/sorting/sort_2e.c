@@ -27,52 +27,113 @@
 #include <complex.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "sort_cholesky.h"
 #include "sorting_request.h"
+#include "twoel_buffer.h"
 
 #include "io.h"
 #include "memory.h"
+#include "omp.h"
 #include "options.h"
+#include "perfcnt.h"
 #include "spinors.h"
 #include "timer.h"
+#include "twoel_container.h"
 
 enum {
     CC_DIRECT,
     CC_EXCHANGE
 };
 
+// tile size for the transposition of two last indices (exchange integrals)
+#define CC_SORTING_TRANSPOSE_TILE 16
 
-double complex ****allocate_twoel_buffer(size_t dim);
 
-void free_twoel_buffer(size_t dim, double complex ****v_ints);
-
-size_t load_coulomb_block(double complex ****v_ints,
+size_t load_coulomb_block(twoel_buffer_t *v_ints,
                           int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
-size_t load_gaunt_block(double complex ****v_ints,
+size_t load_gaunt_block(twoel_buffer_t *v_ints,
                         int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
-size_t load_twoprop_blocks(double complex ****v_ints,
+size_t load_twoprop_blocks(twoel_buffer_t *v_ints,
                            int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
 
-void clear_twoel_buffer(double complex ****v_ints, int spinor_block_1, int spinor_block_2, int spinor_block_3,
-                        int spinor_block_4);
-
-void fill_block_twoelec(block_t *block, int sign, double complex ****v_ints, int direct);
-void fill_block_twoelec_complex_direct(block_t *block, int sign, double complex ****v_ints);
-void fill_block_twoelec_complex_exchange(block_t *block, int sign, double complex ****v_ints);
-void fill_block_twoelec_real_direct(block_t *block, int sign, double complex ****v_ints);
-void fill_block_twoelec_real_exchange(block_t *block, int sign, double complex ****v_ints);
+void fill_block_twoelec(block_t *block, int sign, twoel_buffer_t *v_ints, int direct);
+void fill_block_twoelec_complex_direct(block_t *block, int sign, twoel_buffer_t *v_ints);
+void fill_block_twoelec_complex_exchange(block_t *block, int sign, twoel_buffer_t *v_ints);
+void fill_block_twoelec_real_direct(block_t *block, int sign, twoel_buffer_t *v_ints);
+void fill_block_twoelec_real_exchange(block_t *block, int sign, twoel_buffer_t *v_ints);
 
 int is_pppp_diagram(char *holes_particles, char *valence, char *order);
 
 
+/*
+ * target block of one of the requested diagrams.
+ * block (1234) gets direct integrals from the quadruple of spinor blocks
+ * (1234) and exchange integrals from the quadruple (1243), so targets are
+ * grouped by the unordered pair of the last two spinor blocks: all
+ * contributions to a block come from one task, and the block is loaded and
+ * stored once.
+ */
+typedef struct {
+    block_t *block;
+    sorting_request_t *req;
+    int key[4];     // sb1, sb2, min(sb3,sb4), max(sb3,sb4)
+} twoel_target_t;
+
+/*
+ * pair of quadruples (1234) and (1243) (sb3 <= sb4) with all their targets
+ */
+typedef struct {
+    int spinor_blocks[4];
+    int first_target;
+    int n_targets;
+    size_t cost;    // size of files to be read (or number of integrals to be generated)
+} twoel_task_t;
+
+static twoel_target_t *collect_twoel_targets(int *n_targets);
+
+static twoel_task_t *group_twoel_targets(twoel_target_t *targets, int n_targets, int *n_tasks);
+
+static size_t estimate_twoel_task_cost(int spinor_block_1, int spinor_block_2, int spinor_block_3,
+                                       int spinor_block_4);
+
+static int cmp_twoel_targets(const void *p1, const void *p2);
+
+static int cmp_twoel_tasks_by_cost(const void *p1, const void *p2);
+
+static void sort_twoel_task(twoel_task_t *task, twoel_target_t *targets, twoel_buffer_t **v_ints,
+                            size_t *n_integrals_read, size_t *n_blocks_processed);
+
+static void open_twoel_containers();
+
+static void close_twoel_containers();
+
+static twoel_container_t *open_twoel_container(char *prefix);
+
+static size_t read_twoel_block_container(twoel_container_t *cont, int spinor_block_1, int spinor_block_2,
+                                         int spinor_block_3, int spinor_block_4, twoel_buffer_t *vint_array,
+                                         double complex factor1, double complex factor2, size_t *n_bytes_read);
+
+static void accumulate_twoel_integrals(twoel_buffer_t *vint_array, int32_t nint, int16_t *buf_indices,
+                                       double complex *buf_integrals, double complex factor1,
+                                       double complex factor2);
+
+/*
+ * containers of integrals written by the DIRAC interface (see twoel_container.h).
+ * NULL if there is no container: integrals are then read from old-style
+ * files <prefix>-I-J-K-L (one file per quadruple of spinor blocks), if any.
+ */
+static twoel_container_t *coulomb_container = NULL;
+static twoel_container_t *gaunt_container = NULL;
+static twoel_container_t *twoprop_containers[CC_MAX_NPROP];
+
+
 void sort_twoel()
 {
-    int spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4;
     size_t n_integrals_read_total = 0;
     size_t n_blocks_processed_total = 0;
-    sorting_request_t *req;
-    double complex ****v_ints = NULL;
     const double BYTES_TO_GB = 1.0 / (1024.0 * 1024.0 * 1024.0);
 
     if (num_twoelec_requests(sorting_requests, n_requests) == 0) {
@@ -80,107 +141,66 @@ void sort_twoel()
         return;
     }
 
-    printf(" sorting two-electron integrals\n");
-    printf("   step    #blocks   ints read    time,s  rate,G/s\n");
-    double sort_twoel_time_start = abs_time();
+    open_twoel_containers();
 
-    v_ints = allocate_twoel_buffer(get_max_spinor_block_size());
+    // pppp integrals represented by the Cholesky vectors are not sorted
+    sort_cholesky_pppp();
 
-    for (spinor_block_1 = 0; spinor_block_1 < n_spinor_blocks; spinor_block_1++) {
-        size_t n_blocks_processed = 0;
-        size_t n_integrals_read = 0;
-        double time_start = abs_time();
+    // list of actions: which blocks are to be filled from which quadruples.
+    // quadruples not used by any of the requests are never read
+    int n_targets = 0;
+    int n_tasks = 0;
+    twoel_target_t *targets = collect_twoel_targets(&n_targets);
+    twoel_task_t *tasks = group_twoel_targets(targets, n_targets, &n_tasks);
 
-        printf(" %3d /%3ld ", spinor_block_1, n_spinor_blocks);
+    // target blocks are accessed only through block_load()/block_store(),
+    // so the diagrams already filled can be evicted to give room for the buffers
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        diagram_set_evictable(sorting_requests[ireq].dg);
+    }
 
-        for (spinor_block_2 = 0; spinor_block_2 < n_spinor_blocks; spinor_block_2++) {
-            for (spinor_block_3 = 0; spinor_block_3 < n_spinor_blocks; spinor_block_3++) {
-                for (spinor_block_4 = 0; spinor_block_4 < n_spinor_blocks; spinor_block_4++) {
+    // each thread has its own pair of buffers for integrals
+    // (they grow up to the size of the largest quadruple of spinor blocks)
+    size_t max_block_size = get_max_spinor_block_size();
+    size_t twoel_buf_size = max_block_size * max_block_size * max_block_size * max_block_size * sizeof(double complex);
+    int n_threads = get_num_sorting_threads(2 * twoel_buf_size);
 
-                    clear_twoel_buffer(v_ints, spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4);
+    twoel_buffer_t **v_ints = (twoel_buffer_t **) cc_malloc(sizeof(twoel_buffer_t *) * 2 * n_threads);
+    for (int ibuf = 0; ibuf < 2 * n_threads; ibuf++) {
+        v_ints[ibuf] = allocate_twoel_buffer();
+    }
 
-                    // load pre-sorted integrals: Coulomb, Gaunt, other (two-electron properties)
-                    size_t n_coulomb_ints = load_coulomb_block(v_ints, spinor_block_1, spinor_block_2,
-                                                               spinor_block_3, spinor_block_4);
-                    size_t n_gaunt_ints = 0;
-                    if (cc_opts->gaunt_defined) {
-                        n_gaunt_ints = load_gaunt_block(v_ints, spinor_block_1, spinor_block_2,
-                                                        spinor_block_3, spinor_block_4);
-                    }
-                    size_t n_twoprop_ints = 0;
-                    if (cc_opts->n_twoprop > 0) {
-                        n_twoprop_ints = load_twoprop_blocks(v_ints, spinor_block_1, spinor_block_2,
-                                                             spinor_block_3, spinor_block_4);
-                    }
-                    if (n_coulomb_ints == 0 && n_gaunt_ints == 0 && n_twoprop_ints == 0) {
-                        continue;
-                    }
+    printf(" sorting two-electron integrals (%d threads)\n", n_threads);
+    printf("   step    #blocks   ints read    time,s  rate,G/s\n");
+    double sort_twoel_time_start = abs_time();
 
-                    // direct contribution
-                    for (int ireq = 0; ireq < n_requests; ireq++) {
-                        req = &sorting_requests[ireq];
-                        diagram_t *dg = req->dg;
-                        if (dg->rank != 4) { // one-electron diagrams will be sorted later
-                            continue;
-                        }
+    int first_task = 0;
+    for (int spinor_block_1 = 0; spinor_block_1 < n_spinor_blocks; spinor_block_1++) {
+        size_t n_blocks_processed = 0;
+        size_t n_integrals_read = 0;
+        double time_start = abs_time();
 
-                        int spinor_blocks_nums[4];
-                        spinor_blocks_nums[0] = spinor_block_1;
-                        spinor_blocks_nums[1] = spinor_block_2;
-                        spinor_blocks_nums[2] = spinor_block_3;
-                        spinor_blocks_nums[3] = spinor_block_4;
-                        block_t *sb = diagram_get_block(dg, spinor_blocks_nums);
-                        if (sb == NULL) {
-                            continue;
-                        }
-                        if (sb->is_unique == 0) {
-                            continue;
-                        }
+        printf(" %3d /%3ld ", spinor_block_1, n_spinor_blocks);
 
-                        // block was found. fill it!
-                        block_load(sb);
-                        fill_block_twoelec(sb, 1, v_ints, CC_DIRECT);
-                        block_store(sb);
-                    } // end of loop over requests
-
-                    // exchange contribution
-                    for (int ireq = 0; ireq < n_requests; ireq++) {
-                        req = &sorting_requests[ireq];
-                        diagram_t *dg = req->dg;
-                        if (dg->rank != 4) { // one-electron diagrams will be sorted later
-                            continue;
-                        }
+        // tasks are ordered by sb1; the largest files are processed first
+        int n_step_tasks = 0;
+        while (first_task + n_step_tasks < n_tasks &&
+               tasks[first_task + n_step_tasks].spinor_blocks[0] == spinor_block_1) {
+            n_step_tasks++;
+        }
+        twoel_task_t *step_tasks = tasks + first_task;
+        qsort(step_tasks, n_step_tasks, sizeof(twoel_task_t), cmp_twoel_tasks_by_cost);
+        first_task += n_step_tasks;
+
+        #pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1) reduction(+:n_integrals_read,n_blocks_processed)
+        for (int itask = 0; itask < n_step_tasks; itask++) {
+            sort_twoel_task(&step_tasks[itask], targets, v_ints + 2 * omp_get_thread_num(),
+                            &n_integrals_read, &n_blocks_processed);
+        }
 
-                        int spinor_blocks_nums[4];
-                        spinor_blocks_nums[0] = spinor_block_1;
-                        spinor_blocks_nums[1] = spinor_block_2;
-                        spinor_blocks_nums[2] = spinor_block_4;
-                        spinor_blocks_nums[3] = spinor_block_3;
-                        block_t *sb = diagram_get_block(dg, spinor_blocks_nums);
-                        if (sb == NULL) {
-                            continue;
-                        }
-                        if (sb->is_unique == 0) {
-                            continue;
-                        }
+        n_integrals_read_total += n_integrals_read;
+        n_blocks_processed_total += n_blocks_processed;
 
-                        // block was found. fill it!
-                        block_load(sb);
-                        fill_block_twoelec(sb, -1, v_ints, CC_EXCHANGE);
-                        if (is_pppp_diagram(req->hp, req->valence, req->order) && (arith == CC_ARITH_COMPLEX)) {
-                            conj_vector(sb->size, sb->buf);
-                        }
-                        block_store(sb);
-
-                        // update statistics
-                        n_integrals_read += n_coulomb_ints;
-                        n_integrals_read_total += n_coulomb_ints;
-                        n_blocks_processed += 1;
-                        n_blocks_processed_total += 1;
-                    } // end of loop over requests
-                }
-            }
-        }
         // intermediate statistics
         size_t n_bytes_read = n_integrals_read * ((arith == CC_ARITH_COMPLEX) ? sizeof(double complex) : sizeof(double));
         double time_elapsed = abs_time() - time_start;
@@ -189,9 +209,15 @@ void sort_twoel()
         printf("%10.0f", time_elapsed);
         printf("%10.2f", n_bytes_read / time_elapsed * BYTES_TO_GB);
         printf("\n");
-    } // end of 4 nested 'for' loops over spinor blocks
+    } // end of loop over the first spinor block
 
-    free_twoel_buffer(get_max_spinor_block_size(), v_ints);
+    for (int ibuf = 0; ibuf < 2 * n_threads; ibuf++) {
+        free_twoel_buffer(v_ints[ibuf]);
+    }
+    cc_free(v_ints);
+    cc_free(tasks);
+    cc_free(targets);
+    close_twoel_containers();
 
     // print statistics
     double sort_twoel_time_elapsed = abs_time() - sort_twoel_time_start;
@@ -205,26 +231,310 @@ void sort_twoel()
 }
 
 
-/**
- * allocates 4-dimensional array for two electron integrals of size
- * dim x dim x dim x dim.
- * returns pointer to the allocated array.
+/*
+ * number of threads is limited by the memory required for their buffers
+ * (at most half of the memory left)
+ */
+int get_num_sorting_threads(size_t twoel_buf_size)
+{
+    int n_threads = cc_opts->nthreads;
+    size_t used = cc_get_current_memory_usage();
+    size_t available = (cc_opts->max_memory_size > used) ? (cc_opts->max_memory_size - used) / 2 : 0;
+
+    if (n_threads * twoel_buf_size > available) {
+        n_threads = available / twoel_buf_size;
+    }
+    if (n_threads < 1) {
+        n_threads = 1;
+    }
+
+    return n_threads;
+}
+
+
+/*
+ * unique blocks of all the two-electron diagrams to be sorted,
+ * ordered by the pair of quadruples they are filled from
  */
-double complex ****allocate_twoel_buffer(size_t dim)
+static twoel_target_t *collect_twoel_targets(int *n_targets)
 {
-    double complex ****buf = NULL;
-
-    buf = (double complex ****) cc_malloc(sizeof(double complex ***) * dim);
-    for (size_t i = 0; i < dim; i++) {
-        buf[i] = (double complex ***) cc_malloc(sizeof(double complex **) * dim);
-        for (size_t j = 0; j < dim; j++) {
-            buf[i][j] = (double complex **) cc_malloc(sizeof(double complex *) * dim);
-            for (size_t k = 0; k < dim; k++) {
-                buf[i][j][k] = (double complex *) cc_malloc(sizeof(double complex) * dim);
+    size_t max_targets = 0;
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        diagram_t *dg = sorting_requests[ireq].dg;
+        if (dg->rank == 4) {
+            max_targets += dg->n_blocks;
+        }
+    }
+
+    twoel_target_t *targets = (twoel_target_t *) cc_malloc(sizeof(twoel_target_t) * (max_targets + 1));
+
+    *n_targets = 0;
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        diagram_t *dg = req->dg;
+        if (dg->rank != 4) { // one-electron diagrams will be sorted later
+            continue;
+        }
+
+        for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+            block_t *block = dg->blocks[ib];
+            if (block->is_unique == 0 || block->storage_type == CC_DIAGRAM_CHOLESKY) {
+                continue;
             }
+
+            twoel_target_t *target = &targets[(*n_targets)++];
+            target->block = block;
+            target->req = req;
+            target->key[0] = block->spinor_blocks[0];
+            target->key[1] = block->spinor_blocks[1];
+            target->key[2] = (block->spinor_blocks[2] < block->spinor_blocks[3]) ? block->spinor_blocks[2] : block->spinor_blocks[3];
+            target->key[3] = (block->spinor_blocks[2] < block->spinor_blocks[3]) ? block->spinor_blocks[3] : block->spinor_blocks[2];
+        }
+    }
+
+    qsort(targets, *n_targets, sizeof(twoel_target_t), cmp_twoel_targets);
+
+    return targets;
+}
+
+
+/*
+ * one task for each pair of quadruples used by at least one target
+ */
+static twoel_task_t *group_twoel_targets(twoel_target_t *targets, int n_targets, int *n_tasks)
+{
+    twoel_task_t *tasks = (twoel_task_t *) cc_malloc(sizeof(twoel_task_t) * (n_targets + 1));
+
+    *n_tasks = 0;
+    for (int i = 0; i < n_targets; i++) {
+        if (i > 0 && cmp_twoel_targets(&targets[i - 1], &targets[i]) == 0) {
+            tasks[*n_tasks - 1].n_targets++;
+            continue;
+        }
+
+        twoel_task_t *task = &tasks[(*n_tasks)++];
+        for (int k = 0; k < 4; k++) {
+            task->spinor_blocks[k] = targets[i].key[k];
+        }
+        task->first_target = i;
+        task->n_targets = 1;
+
+        int *sb = task->spinor_blocks;
+        task->cost = estimate_twoel_task_cost(sb[0], sb[1], sb[2], sb[3]);
+        if (sb[2] != sb[3]) {
+            task->cost += estimate_twoel_task_cost(sb[0], sb[1], sb[3], sb[2]);
         }
     }
 
+    return tasks;
+}
+
+
+/*
+ * estimated amount of work for the quadruple of spinor blocks
+ */
+static size_t estimate_twoel_task_cost(int spinor_block_1, int spinor_block_2, int spinor_block_3,
+                                       int spinor_block_4)
+{
+    char vint_file_name[CC_MAX_FILE_NAME_LENGTH];
+    size_t cost = 0;
+
+    if (cc_opts->int_source == CC_INTEGRALS_SYNTHETIC || cc_opts->int_source == CC_INTEGRALS_PYSCF) {
+        cost = (size_t) get_spinor_block_size(spinor_block_1) * get_spinor_block_size(spinor_block_2) *
+               get_spinor_block_size(spinor_block_3) * get_spinor_block_size(spinor_block_4);
+    }
+    else if (coulomb_container) {
+        cost += twoel_container_quadruple_size(coulomb_container, spinor_block_1 + 1, spinor_block_2 + 1,
+                                               spinor_block_3 + 1, spinor_block_4 + 1);
+    }
+    else {
+        sprintf(vint_file_name, "VINT-%d-%d-%d-%d",
+                spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
+        cost += io_fsize(vint_file_name);
+    }
+
+    if (cc_opts->gaunt_defined && gaunt_container) {
+        cost += twoel_container_quadruple_size(gaunt_container, spinor_block_1 + 1, spinor_block_2 + 1,
+                                               spinor_block_3 + 1, spinor_block_4 + 1);
+    }
+    else if (cc_opts->gaunt_defined) {
+        sprintf(vint_file_name, "GINT-%d-%d-%d-%d",
+                spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
+        cost += io_fsize(vint_file_name);
+    }
+
+    for (int iprop = 0; iprop < cc_opts->n_twoprop; iprop++) {
+        if (twoprop_containers[iprop]) {
+            cost += twoel_container_quadruple_size(twoprop_containers[iprop], spinor_block_1 + 1,
+                                                   spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
+            continue;
+        }
+        sprintf(vint_file_name, "TWOPROP%d-%d-%d-%d-%d", iprop + 1,
+                spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
+        cost += io_fsize(vint_file_name);
+    }
+
+    return cost;
+}
+
+
+static int cmp_twoel_targets(const void *p1, const void *p2)
+{
+    const twoel_target_t *t1 = (const twoel_target_t *) p1;
+    const twoel_target_t *t2 = (const twoel_target_t *) p2;
+
+    for (int k = 0; k < 4; k++) {
+        if (t1->key[k] != t2->key[k]) {
+            return (t1->key[k] < t2->key[k]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+
+static int cmp_twoel_tasks_by_cost(const void *p1, const void *p2)
+{
+    const twoel_task_t *t1 = (const twoel_task_t *) p1;
+    const twoel_task_t *t2 = (const twoel_task_t *) p2;
+
+    if (t1->cost > t2->cost) {
+        return -1;
+    }
+    else if (t1->cost < t2->cost) {
+        return 1;
+    }
+    return 0;
+}
+
+
+/*
+ * loads pre-sorted integrals for the quadruple of spinor blocks:
+ * Coulomb, Gaunt, other (two-electron properties).
+ * synthetic integrals are generated instead of the Coulomb ones,
+ * PySCF integrals are gathered from the mapped file (see sort_pyscf.c).
+ * returns total number of integrals loaded.
+ */
+size_t load_twoel_quadruple(twoel_buffer_t *v_ints, int spinor_block_1, int spinor_block_2,
+                            int spinor_block_3, int spinor_block_4)
+{
+    clear_twoel_buffer(v_ints, spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4);
+
+    size_t n_coulomb_ints = 0;
+    if (cc_opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        n_coulomb_ints = load_synthetic_block(v_ints, spinor_block_1, spinor_block_2,
+                                              spinor_block_3, spinor_block_4);
+    }
+    else if (cc_opts->int_source == CC_INTEGRALS_PYSCF) {
+        n_coulomb_ints = load_pyscf_block(v_ints, spinor_block_1, spinor_block_2,
+                                          spinor_block_3, spinor_block_4);
+    }
+    else {
+        n_coulomb_ints = load_coulomb_block(v_ints, spinor_block_1, spinor_block_2,
+                                            spinor_block_3, spinor_block_4);
+    }
+    size_t n_gaunt_ints = 0;
+    if (cc_opts->gaunt_defined) {
+        n_gaunt_ints = load_gaunt_block(v_ints, spinor_block_1, spinor_block_2,
+                                        spinor_block_3, spinor_block_4);
+    }
+    size_t n_twoprop_ints = 0;
+    if (cc_opts->n_twoprop > 0) {
+        n_twoprop_ints = load_twoprop_blocks(v_ints, spinor_block_1, spinor_block_2,
+                                             spinor_block_3, spinor_block_4);
+    }
+
+    return n_coulomb_ints + n_gaunt_ints + n_twoprop_ints;
+}
+
+
+/*
+ * loads integrals for the pair of quadruples (1234) and (1243) into the
+ * thread's buffers and fills all the target blocks of the task: each block
+ * is loaded and stored once.
+ */
+static void sort_twoel_task(twoel_task_t *task, twoel_target_t *targets, twoel_buffer_t **v_ints,
+                            size_t *n_integrals_read, size_t *n_blocks_processed)
+{
+    int *sb = task->spinor_blocks;
+    int is_diagonal = (sb[2] == sb[3]);
+
+    // buffer 0: (sb1,sb2,sb3,sb4), buffer 1: (sb1,sb2,sb4,sb3)
+    twoel_buffer_t *buffers[2];
+    size_t n_ints[2];
+    buffers[0] = v_ints[0];
+    n_ints[0] = load_twoel_quadruple(buffers[0], sb[0], sb[1], sb[2], sb[3]);
+    if (is_diagonal) {
+        buffers[1] = buffers[0];
+        n_ints[1] = n_ints[0];
+        *n_integrals_read += n_ints[0];
+    }
+    else {
+        buffers[1] = v_ints[1];
+        n_ints[1] = load_twoel_quadruple(buffers[1], sb[0], sb[1], sb[3], sb[2]);
+        *n_integrals_read += n_ints[0] + n_ints[1];
+    }
+
+    if (n_ints[0] == 0 && n_ints[1] == 0) {
+        return;
+    }
+
+    for (int itarget = task->first_target; itarget < task->first_target + task->n_targets; itarget++) {
+        twoel_target_t *target = &targets[itarget];
+        sorting_request_t *req = target->req;
+        block_t *block = target->block;
+
+        // block (sb1,sb2,sb4,sb3) takes direct integrals from buffer 1
+        int is_swapped = block->spinor_blocks[2] > block->spinor_blocks[3];
+        int idirect = is_swapped ? 1 : 0;
+        int iexchange = is_swapped ? 0 : 1;
+        int do_direct = (n_ints[idirect] != 0);
+        int do_exchange = (n_ints[iexchange] != 0);
+        if (!do_direct && !do_exchange) {
+            continue;
+        }
+
+        // the pppp (3412) block is conjugated after the exchange contribution.
+        // the order of contributions is the same as in the sweep over
+        // quadruples in the lexicographic order: for sb3 > sb4 the exchange
+        // quadruple comes first
+        int do_conj = is_pppp_diagram(req->hp, req->valence, req->order) && (arith == CC_ARITH_COMPLEX);
+
+        block_load(block);
+        if (!is_swapped && do_direct) {
+            fill_block_twoelec(block, 1, buffers[idirect], CC_DIRECT);
+        }
+        if (do_exchange) {
+            fill_block_twoelec(block, -1, buffers[iexchange], CC_EXCHANGE);
+            if (do_conj) {
+                conj_vector(block->size, block->buf);
+            }
+        }
+        if (is_swapped && do_direct) {
+            fill_block_twoelec(block, 1, buffers[idirect], CC_DIRECT);
+        }
+        block_store(block);
+
+        *n_blocks_processed += 1;
+    }
+}
+
+
+/**
+ * allocates an (empty) staging buffer for two-electron integrals.
+ * memory is allocated by clear_twoel_buffer() for the particular quadruple
+ * of spinor blocks.
+ */
+twoel_buffer_t *allocate_twoel_buffer()
+{
+    twoel_buffer_t *buf = (twoel_buffer_t *) cc_malloc(sizeof(twoel_buffer_t));
+
+    buf->ints = NULL;
+    buf->mem = NULL;
+    buf->capacity = 0;
+    for (int i = 0; i < 4; i++) {
+        buf->dims[i] = 0;
+    }
+
     return buf;
 }
 
@@ -249,7 +559,7 @@ int num_twoelec_requests(sorting_request_t *requests, int num_requests)
  * Returns number of integrals read
  * vint_array = factor1 * vint_array + factor2 * new_integrals
  */
-size_t read_twoel_block_unformatted(char *vint_file_name, double complex ****vint_array, double complex factor1,
+size_t read_twoel_block_unformatted(char *vint_file_name, twoel_buffer_t *vint_array, double complex factor1,
                                     double complex factor2, size_t *n_bytes_read)
 {
     int32_t nint;
@@ -260,11 +570,10 @@ size_t read_twoel_block_unformatted(char *vint_file_name, double complex ****vin
     int fd;
     int nloop = 0;
     int empty_file = 0;
-    double dfactor1 = creal(factor1);
-    double dfactor2 = creal(factor2);
 
-    static double complex buf_integrals[CC_SORTING_IO_BUF_SIZE];
-    static int16_t buf_indices[4 * CC_SORTING_IO_BUF_SIZE];
+    // can be called by several threads at once (see sort_twoel())
+    double complex *buf_integrals = (double complex *) cc_malloc(sizeof(double complex) * CC_SORTING_IO_BUF_SIZE);
+    int16_t *buf_indices = (int16_t *) cc_malloc(sizeof(int16_t) * 4 * CC_SORTING_IO_BUF_SIZE);
 
     fd = io_open(vint_file_name, "r");
 
@@ -285,51 +594,132 @@ size_t read_twoel_block_unformatted(char *vint_file_name, double complex ****vin
             io_read_compressed(fd, buf_integrals, nint * sizeof(double));
         }
         
+        accumulate_twoel_integrals(vint_array, nint, buf_indices, buf_integrals, factor1, factor2);
+
+        n_integrals_read += nint;
         if (arith == CC_ARITH_REAL) {
-            int32_t iint;
-            #pragma omp parallel for private(iint) shared(nint,arith,dfactor1,dfactor2,buf_indices,buf_integrals,spinor_index_global2local,vint_array) default(none) schedule(static)
-            for (iint = 0; iint < nint; iint++) {
-                // absolute spinor indices
-                int i = buf_indices[iint * 4] - 1; // -1 since numeration from 0 in C and from 1 in F90
-                int j = buf_indices[iint * 4 + 1] - 1;
-                int k = buf_indices[iint * 4 + 2] - 1;
-                int l = buf_indices[iint * 4 + 3] - 1;
-                i = spinor_index_global2local[i];
-                j = spinor_index_global2local[j];
-                k = spinor_index_global2local[k];
-                l = spinor_index_global2local[l];
-    
-                // here "local" spinor indices are used
-                // (inside the spinor block under consideration)
-                double v_ijkl = ((double *) buf_integrals)[iint];
-                vint_array[i][j][k][l] = dfactor1 * vint_array[i][j][k][l] + dfactor2 * v_ijkl + 0.0 * I; 
-            }
+            nbr += nint * sizeof(double) + nint * 4 * sizeof(int16_t) + sizeof(int32_t);
         }
-        else { // CC_ARITH_COMPLEX
-            int32_t iint;
-            #pragma omp parallel for private(iint) shared(nint,arith,factor1,factor2,buf_indices,buf_integrals,spinor_index_global2local,vint_array) default(none) schedule(static)
-            for (iint = 0; iint < nint; iint++) {
-                // absolute spinor indices
-                int i = buf_indices[iint * 4] - 1; // -1 since numeration from 0 in C and from 1 in F90
-                int j = buf_indices[iint * 4 + 1] - 1;
-                int k = buf_indices[iint * 4 + 2] - 1;
-                int l = buf_indices[iint * 4 + 3] - 1;
-                i = spinor_index_global2local[i];
-                j = spinor_index_global2local[j];
-                k = spinor_index_global2local[k];
-                l = spinor_index_global2local[l];
-
-                // here "local" spinor indices are used
-                // (inside the spinor block under consideration)
-                double complex v_ijkl = buf_integrals[iint];
-                vint_array[i][j][k][l] = factor1 * vint_array[i][j][k][l] + factor2 * v_ijkl;
-            }
+        else {  // complex arith
+            nbr += nint * sizeof(double complex) + nint * 4 * sizeof(int16_t) + sizeof(int32_t);
         }
+    }
+    io_close(fd);
+    *n_bytes_read = nbr;
+
+    cc_free(buf_integrals);
+    cc_free(buf_indices);
+
+    if (empty_file) {
+        return 0;
+    }
+
+    return n_integrals_read;
+}
+
+
+
+/**
+ * the same as read_twoel_block_unformatted(), but integrals of the quadruple
+ * of spinor blocks are read from the container (chunk by chunk)
+ */
+static size_t read_twoel_block_container(twoel_container_t *cont, int spinor_block_1, int spinor_block_2,
+                                         int spinor_block_3, int spinor_block_4, twoel_buffer_t *vint_array,
+                                         double complex factor1, double complex factor2, size_t *n_bytes_read)
+{
+    int64_t n_extents;
+    twoel_extent_t *extents = twoel_container_lookup(cont, spinor_block_1 + 1, spinor_block_2 + 1,
+                                                     spinor_block_3 + 1, spinor_block_4 + 1, &n_extents);
+    size_t n_integrals_read = 0;
 
+    *n_bytes_read = 0;
+    if (n_extents == 0) {
+        return 0;
+    }
+
+    int32_t max_nint = 0;
+    for (int64_t i = 0; i < n_extents; i++) {
+        max_nint = (extents[i].nint > max_nint) ? extents[i].nint : max_nint;
+    }
+
+    // can be called by several threads at once (see sort_twoel())
+    double complex *buf_integrals = (double complex *) cc_malloc(sizeof(double complex) * max_nint);
+    int16_t *buf_indices = (int16_t *) cc_malloc(sizeof(int16_t) * 4 * max_nint);
+    char *scratch = (char *) cc_malloc(cont->max_length);
+
+    for (int64_t i = 0; i < n_extents; i++) {
+        twoel_container_read(cont, extents + i, scratch, buf_indices, buf_integrals);
+        accumulate_twoel_integrals(vint_array, extents[i].nint, buf_indices, buf_integrals, factor1, factor2);
+        n_integrals_read += extents[i].nint;
+        *n_bytes_read += extents[i].length;
+    }
+
+    cc_free(scratch);
+    cc_free(buf_integrals);
+    cc_free(buf_indices);
+
+    return n_integrals_read;
+}
+
+
+static void open_twoel_containers()
+{
+    char prefix[CC_MAX_FILE_NAME_LENGTH];
+
+    if (cc_opts->int_source == CC_INTEGRALS_DIRAC) {
+        coulomb_container = open_twoel_container("VINT");
+    }
+    if (cc_opts->gaunt_defined) {
+        gaunt_container = open_twoel_container("GINT");
+    }
+    for (int iprop = 0; iprop < cc_opts->n_twoprop; iprop++) {
+        sprintf(prefix, "TWOPROP%d", iprop + 1);
+        twoprop_containers[iprop] = open_twoel_container(prefix);
+    }
+}
+
+
+static void close_twoel_containers()
+{
+    twoel_container_close(coulomb_container);
+    twoel_container_close(gaunt_container);
+    coulomb_container = NULL;
+    gaunt_container = NULL;
+    for (int iprop = 0; iprop < cc_opts->n_twoprop; iprop++) {
+        twoel_container_close(twoprop_containers[iprop]);
+        twoprop_containers[iprop] = NULL;
+    }
+}
+
+
+static twoel_container_t *open_twoel_container(char *prefix)
+{
+    twoel_container_t *cont = twoel_container_open(prefix);
+
+    size_t value_size = (arith == CC_ARITH_COMPLEX) ? sizeof(double complex) : sizeof(double);
+    if (cont && cont->n_extents > 0 && cont->value_size != value_size) {
+        errquit("integrals in '%s.*' do not correspond to the %s arithmetic", prefix,
+                (arith == CC_ARITH_COMPLEX) ? "complex" : "real");
+    }
+
+    return cont;
+}
+
+/*
+ * vint_array = factor1 * vint_array + factor2 * new_integrals
+ * for the portion of integrals read from disk (indices are global, from 1)
+ */
+static void accumulate_twoel_integrals(twoel_buffer_t *vint_array, int32_t nint, int16_t *buf_indices,
+                                       double complex *buf_integrals, double complex factor1,
+                                       double complex factor2)
+{
+    double dfactor1 = creal(factor1);
+    double dfactor2 = creal(factor2);
 
-        /*
-        //#pragma omp parallel for shared(nint,arith,factor1,factor2,dfactor1,dfactor2,buf_indices,buf_integrals,spinor_index_global2local,vint_array) default(none) schedule(static)
-        for (int32_t iint = 0; iint < nint; iint++) {
+    if (arith == CC_ARITH_REAL) {
+        int32_t iint;
+        #pragma omp parallel for private(iint) shared(nint,arith,dfactor1,dfactor2,buf_indices,buf_integrals,spinor_index_global2local,vint_array) default(none) schedule(static)
+        for (iint = 0; iint < nint; iint++) {
             // absolute spinor indices
             int i = buf_indices[iint * 4] - 1; // -1 since numeration from 0 in C and from 1 in F90
             int j = buf_indices[iint * 4 + 1] - 1;
@@ -342,62 +732,74 @@ size_t read_twoel_block_unformatted(char *vint_file_name, double complex ****vin
 
             // here "local" spinor indices are used
             // (inside the spinor block under consideration)
-            if (arith == CC_ARITH_COMPLEX) {
-                double complex v_ijkl = buf_integrals[iint];
-                vint_array[i][j][k][l] = factor1 * vint_array[i][j][k][l] + factor2 * v_ijkl;
-            }
-            else {
-                double v_ijkl = ((double *) buf_integrals)[iint];
-                vint_array[i][j][k][l] = dfactor1 * vint_array[i][j][k][l] + dfactor2 * v_ijkl + 0.0 * I;
-            }
-        }*/
-
-        n_integrals_read += nint;
-        if (arith == CC_ARITH_REAL) {
-            nbr += nint * sizeof(double) + nint * 4 * sizeof(int16_t) + sizeof(int32_t);
-        }
-        else {  // complex arith
-            nbr += nint * sizeof(double complex) + nint * 4 * sizeof(int16_t) + sizeof(int32_t);
+            double v_ijkl = ((double *) buf_integrals)[iint];
+            size_t ijkl = twoel_buffer_index(vint_array, i, j, k, l);
+            vint_array->ints[ijkl] = dfactor1 * vint_array->ints[ijkl] + dfactor2 * v_ijkl + 0.0 * I;
         }
     }
-    io_close(fd);
-    *n_bytes_read = nbr;
+    else { // CC_ARITH_COMPLEX
+        int32_t iint;
+        #pragma omp parallel for private(iint) shared(nint,arith,factor1,factor2,buf_indices,buf_integrals,spinor_index_global2local,vint_array) default(none) schedule(static)
+        for (iint = 0; iint < nint; iint++) {
+            // absolute spinor indices
+            int i = buf_indices[iint * 4] - 1; // -1 since numeration from 0 in C and from 1 in F90
+            int j = buf_indices[iint * 4 + 1] - 1;
+            int k = buf_indices[iint * 4 + 2] - 1;
+            int l = buf_indices[iint * 4 + 3] - 1;
+            i = spinor_index_global2local[i];
+            j = spinor_index_global2local[j];
+            k = spinor_index_global2local[k];
+            l = spinor_index_global2local[l];
 
-    if (empty_file) {
-        return 0;
+            // here "local" spinor indices are used
+            // (inside the spinor block under consideration)
+            double complex v_ijkl = buf_integrals[iint];
+            size_t ijkl = twoel_buffer_index(vint_array, i, j, k, l);
+            vint_array->ints[ijkl] = factor1 * vint_array->ints[ijkl] + factor2 * v_ijkl;
+        }
     }
-
-    return n_integrals_read;
 }
 
 
-void clear_twoel_buffer(double complex ****v_ints, int spinor_block_1, int spinor_block_2, int spinor_block_3,
+/**
+ * prepares the buffer for integrals of the given quadruple of spinor blocks:
+ * sets its dimensions, enlarges it if needed and fills with zeros.
+ */
+void clear_twoel_buffer(twoel_buffer_t *v_ints, int spinor_block_1, int spinor_block_2, int spinor_block_3,
                         int spinor_block_4)
 {
-    // sizes of spinor blocks
-    int block1_size = get_spinor_block_size(spinor_block_1);
-    int block2_size = get_spinor_block_size(spinor_block_2);
-    int block3_size = get_spinor_block_size(spinor_block_3);
-    int block4_size = get_spinor_block_size(spinor_block_4);
-
-    // init buffer array with zeroes
-    for (int i = 0; i < block1_size; i++) {
-        for (int j = 0; j < block2_size; j++) {
-            for (int k = 0; k < block3_size; k++) {
-                memset(v_ints[i][j][k], 0, block4_size * sizeof(double complex));
-            }
-        }
+    v_ints->dims[0] = get_spinor_block_size(spinor_block_1);
+    v_ints->dims[1] = get_spinor_block_size(spinor_block_2);
+    v_ints->dims[2] = get_spinor_block_size(spinor_block_3);
+    v_ints->dims[3] = get_spinor_block_size(spinor_block_4);
+
+    size_t size = (size_t) v_ints->dims[0] * v_ints->dims[1] * v_ints->dims[2] * v_ints->dims[3];
+
+    if (size > v_ints->capacity) {
+        cc_free(v_ints->mem);
+        v_ints->mem = cc_malloc(size * sizeof(double complex) + CC_TWOEL_BUFFER_ALIGNMENT);
+        uintptr_t addr = (uintptr_t) v_ints->mem;
+        addr = (addr + CC_TWOEL_BUFFER_ALIGNMENT - 1) & ~((uintptr_t) CC_TWOEL_BUFFER_ALIGNMENT - 1);
+        v_ints->ints = (double complex *) addr;
+        v_ints->capacity = size;
     }
+
+    memset(v_ints->ints, 0, size * sizeof(double complex));
 }
 
 
-size_t load_coulomb_block(double complex ****v_ints,
+size_t load_coulomb_block(twoel_buffer_t *v_ints,
                           int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
 {
     char vint_file_name[CC_MAX_FILE_NAME_LENGTH];
     size_t n_integrals_read;
     size_t n_bytes_read;
 
+    if (coulomb_container) {
+        return read_twoel_block_container(coulomb_container, spinor_block_1, spinor_block_2, spinor_block_3,
+                                          spinor_block_4, v_ints, 0.0 + 0.0 * I, 1.0 + 0.0 * I, &n_bytes_read);
+    }
+
     sprintf(vint_file_name, "VINT-%d-%d-%d-%d",
             spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
     if (io_file_exists(vint_file_name) == 0) {
@@ -411,13 +813,18 @@ size_t load_coulomb_block(double complex ****v_ints,
 }
 
 
-size_t load_gaunt_block(double complex ****v_ints,
+size_t load_gaunt_block(twoel_buffer_t *v_ints,
                         int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
 {
     char vint_file_name[CC_MAX_FILE_NAME_LENGTH];
     size_t n_integrals_read;
     size_t n_bytes_read;
 
+    if (gaunt_container) {
+        return read_twoel_block_container(gaunt_container, spinor_block_1, spinor_block_2, spinor_block_3,
+                                          spinor_block_4, v_ints, 1.0 + 0.0 * I, 1.0 + 0.0 * I, &n_bytes_read);
+    }
+
     sprintf(vint_file_name, "GINT-%d-%d-%d-%d",
             spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
     if (io_file_exists(vint_file_name) == 0) {
@@ -434,7 +841,7 @@ size_t load_gaunt_block(double complex ****v_ints,
 /**
  * two-electron property integrals
  */
-size_t load_twoprop_blocks(double complex ****v_ints,
+size_t load_twoprop_blocks(twoel_buffer_t *v_ints,
                            int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
 {
     char vint_file_name[CC_MAX_FILE_NAME_LENGTH];
@@ -444,6 +851,14 @@ size_t load_twoprop_blocks(double complex ****v_ints,
     // load two-electron property integrals (if needed)
     // read TWOPROP* files
     for (int iprop = 0; iprop < cc_opts->n_twoprop; iprop++) {
+        double complex lambda = cc_opts->twoprop_lambda[iprop];
+
+        if (twoprop_containers[iprop]) {
+            n_integrals_read += read_twoel_block_container(twoprop_containers[iprop], spinor_block_1,
+                                                           spinor_block_2, spinor_block_3, spinor_block_4,
+                                                           v_ints, 1.0 + 0.0 * I, lambda, &n_bytes_read);
+            continue;
+        }
 
         sprintf(vint_file_name, "TWOPROP%d-%d-%d-%d-%d", iprop+1,
                 spinor_block_1 + 1, spinor_block_2 + 1, spinor_block_3 + 1, spinor_block_4 + 1);
@@ -451,7 +866,6 @@ size_t load_twoprop_blocks(double complex ****v_ints,
             continue;
         }
 
-        double complex lambda = cc_opts->twoprop_lambda[iprop];
         n_integrals_read += read_twoel_block_unformatted(vint_file_name, v_ints, 1.0+0.0*I, lambda, &n_bytes_read);
     }
 
@@ -459,11 +873,16 @@ size_t load_twoprop_blocks(double complex ****v_ints,
 }
 
 
-void fill_block_twoelec(block_t *block, int sign, double complex ****v_ints, int direct_flag)
+void fill_block_twoelec(block_t *block, int sign, twoel_buffer_t *v_ints, int direct_flag)
 {
     assert(block->rank == 4);
     assert(direct_flag == CC_DIRECT || direct_flag == CC_EXCHANGE);
 
+    perfcnt_sample_t perf_start;
+    if (cc_perfcnt_enabled) {
+        perfcnt_read(&perf_start);
+    }
+
     // four different functions for maximum performance
     if ((arith == CC_ARITH_COMPLEX) && direct_flag == CC_DIRECT) {
         fill_block_twoelec_complex_direct(block, sign, v_ints);
@@ -477,10 +896,39 @@ void fill_block_twoelec(block_t *block, int sign, double complex ****v_ints, int
     else if ((arith == CC_ARITH_REAL) && direct_flag == CC_EXCHANGE) {
         fill_block_twoelec_real_exchange(block, sign, v_ints);
     }
+
+    if (cc_perfcnt_enabled) {
+        perfcnt_add(PERFCNT_SORT_FILL, &perf_start);
+    }
+}
+
+
+/*
+ * offsets of the block's spinors in the staging buffer along one dimension
+ * (local indices multiplied by the stride). returns 1 if the offsets go one
+ * after another with the given stride (the block spans a contiguous range).
+ */
+static int get_buffer_offsets(int dim, int *block_indices, size_t stride, size_t *offsets)
+{
+    int contiguous = 1;
+
+    for (int i = 0; i < dim; i++) {
+        offsets[i] = spinor_index_global2local[block_indices[i]] * stride;
+        if (i > 0 && offsets[i] != offsets[i - 1] + stride) {
+            contiguous = 0;
+        }
+    }
+
+    return contiguous;
 }
 
 
-void fill_block_twoelec_complex_direct(block_t *block, int sign, double complex ****v_ints)
+/*
+ * direct pattern: block[i1][i2][i3][i4] += sign * v[i1][i2][i3][i4].
+ * each line (i1,i2,i3) is a contiguous copy in the common case when the
+ * block spans the whole spinor block in the last dimension.
+ */
+void fill_block_twoelec_complex_direct(block_t *block, int sign, twoel_buffer_t *v_ints)
 {
     assert(block->rank == 4);
 
@@ -488,35 +936,44 @@ void fill_block_twoelec_complex_direct(block_t *block, int sign, double complex
     int dims_2 = block->shape[1];
     int dims_3 = block->shape[2];
     int dims_4 = block->shape[3];
-    int *block_indices_1 = block->indices[0];
-    int *block_indices_2 = block->indices[1];
-    int *block_indices_3 = block->indices[2];
-    int *block_indices_4 = block->indices[3];
+    size_t stride_3 = v_ints->dims[3];
+    size_t stride_2 = v_ints->dims[2] * stride_3;
+    size_t stride_1 = v_ints->dims[1] * stride_2;
+    size_t offsets_1[dims_1], offsets_2[dims_2], offsets_3[dims_3], offsets_4[dims_4];
+
+    get_buffer_offsets(dims_1, block->indices[0], stride_1, offsets_1);
+    get_buffer_offsets(dims_2, block->indices[1], stride_2, offsets_2);
+    get_buffer_offsets(dims_3, block->indices[2], stride_3, offsets_3);
+    int contiguous = get_buffer_offsets(dims_4, block->indices[3], 1, offsets_4);
 
-    size_t index = 0;
+    double complex *dst = block->buf;
     for (int i1 = 0; i1 < dims_1; i1++) {
-        int idx_1 = block_indices_1[i1]; // relative index to spinor indices
-        idx_1 = spinor_index_global2local[idx_1];
         for (int i2 = 0; i2 < dims_2; i2++) {
-            int idx_2 = block_indices_2[i2];
-            idx_2 = spinor_index_global2local[idx_2];
             for (int i3 = 0; i3 < dims_3; i3++) {
-                int idx_3 = block_indices_3[i3];
-                idx_3 = spinor_index_global2local[idx_3];
-                for (int i4 = 0; i4 < dims_4; i4++) {
-                    int idx_4 = block_indices_4[i4];
-                    idx_4 = spinor_index_global2local[idx_4];
-
-                    block->buf[index] += sign * v_ints[idx_1][idx_2][idx_3][idx_4];
-                    index++;
+                const double complex *src = v_ints->ints + offsets_1[i1] + offsets_2[i2] + offsets_3[i3];
+                if (contiguous) {
+                    src += offsets_4[0];
+                    for (int i4 = 0; i4 < dims_4; i4++) {
+                        dst[i4] += sign * src[i4];
+                    }
+                }
+                else {
+                    for (int i4 = 0; i4 < dims_4; i4++) {
+                        dst[i4] += sign * src[offsets_4[i4]];
+                    }
                 }
+                dst += dims_4;
             }
         }
     }
 }
 
 
-void fill_block_twoelec_complex_exchange(block_t *block, int sign, double complex ****v_ints)
+/*
+ * exchange pattern: block[i1][i2][i3][i4] += sign * v[i1][i2][i4][i3].
+ * for each (i1,i2) the last two indices are transposed by tiles.
+ */
+void fill_block_twoelec_complex_exchange(block_t *block, int sign, twoel_buffer_t *v_ints)
 {
     assert(block->rank == 4);
 
@@ -524,121 +981,124 @@ void fill_block_twoelec_complex_exchange(block_t *block, int sign, double comple
     int dims_2 = block->shape[1];
     int dims_3 = block->shape[2];
     int dims_4 = block->shape[3];
-    int *block_indices_1 = block->indices[0];
-    int *block_indices_2 = block->indices[1];
-    int *block_indices_3 = block->indices[2];
-    int *block_indices_4 = block->indices[3];
+    size_t stride_3 = v_ints->dims[3];
+    size_t stride_2 = v_ints->dims[2] * stride_3;
+    size_t stride_1 = v_ints->dims[1] * stride_2;
+    size_t offsets_1[dims_1], offsets_2[dims_2], offsets_3[dims_3], offsets_4[dims_4];
 
-    size_t index = 0;
+    get_buffer_offsets(dims_1, block->indices[0], stride_1, offsets_1);
+    get_buffer_offsets(dims_2, block->indices[1], stride_2, offsets_2);
+    get_buffer_offsets(dims_3, block->indices[2], 1, offsets_3);
+    get_buffer_offsets(dims_4, block->indices[3], stride_3, offsets_4);
+
+    double complex *dst = block->buf;
     for (int i1 = 0; i1 < dims_1; i1++) {
-        int idx_1 = block_indices_1[i1]; // relative index to spinor indices
-        idx_1 = spinor_index_global2local[idx_1];
         for (int i2 = 0; i2 < dims_2; i2++) {
-            int idx_2 = block_indices_2[i2];
-            idx_2 = spinor_index_global2local[idx_2];
-            for (int i3 = 0; i3 < dims_3; i3++) {
-                int idx_3 = block_indices_3[i3];
-                idx_3 = spinor_index_global2local[idx_3];
-                for (int i4 = 0; i4 < dims_4; i4++) {
-                    int idx_4 = block_indices_4[i4];
-                    idx_4 = spinor_index_global2local[idx_4];
-
-                    block->buf[index] += sign * v_ints[idx_1][idx_2][idx_4][idx_3];
-                    index++;
+            const double complex *src = v_ints->ints + offsets_1[i1] + offsets_2[i2];
+            for (int t3 = 0; t3 < dims_3; t3 += CC_SORTING_TRANSPOSE_TILE) {
+                int end_3 = (t3 + CC_SORTING_TRANSPOSE_TILE < dims_3) ? t3 + CC_SORTING_TRANSPOSE_TILE : dims_3;
+                for (int t4 = 0; t4 < dims_4; t4 += CC_SORTING_TRANSPOSE_TILE) {
+                    int end_4 = (t4 + CC_SORTING_TRANSPOSE_TILE < dims_4) ? t4 + CC_SORTING_TRANSPOSE_TILE : dims_4;
+                    for (int i3 = t3; i3 < end_3; i3++) {
+                        double complex *dst_line = dst + (size_t) i3 * dims_4;
+                        const double complex *src_col = src + offsets_3[i3];
+                        for (int i4 = t4; i4 < end_4; i4++) {
+                            dst_line[i4] += sign * src_col[offsets_4[i4]];
+                        }
+                    }
                 }
             }
+            dst += (size_t) dims_3 * dims_4;
         }
     }
 }
 
 
-void fill_block_twoelec_real_direct(block_t *block, int sign, double complex ****v_ints)
+void fill_block_twoelec_real_direct(block_t *block, int sign, twoel_buffer_t *v_ints)
 {
     assert(block->rank == 4);
 
-    double *dbuf = (double *) block->buf;
-
     int dims_1 = block->shape[0];
     int dims_2 = block->shape[1];
     int dims_3 = block->shape[2];
     int dims_4 = block->shape[3];
-    int *block_indices_1 = block->indices[0];
-    int *block_indices_2 = block->indices[1];
-    int *block_indices_3 = block->indices[2];
-    int *block_indices_4 = block->indices[3];
+    size_t stride_3 = v_ints->dims[3];
+    size_t stride_2 = v_ints->dims[2] * stride_3;
+    size_t stride_1 = v_ints->dims[1] * stride_2;
+    size_t offsets_1[dims_1], offsets_2[dims_2], offsets_3[dims_3], offsets_4[dims_4];
 
-    size_t index = 0;
+    get_buffer_offsets(dims_1, block->indices[0], stride_1, offsets_1);
+    get_buffer_offsets(dims_2, block->indices[1], stride_2, offsets_2);
+    get_buffer_offsets(dims_3, block->indices[2], stride_3, offsets_3);
+    int contiguous = get_buffer_offsets(dims_4, block->indices[3], 1, offsets_4);
+
+    double *dst = (double *) block->buf;
     for (int i1 = 0; i1 < dims_1; i1++) {
-        int idx_1 = block_indices_1[i1]; // relative index to spinor indices
-        idx_1 = spinor_index_global2local[idx_1];
         for (int i2 = 0; i2 < dims_2; i2++) {
-            int idx_2 = block_indices_2[i2];
-            idx_2 = spinor_index_global2local[idx_2];
             for (int i3 = 0; i3 < dims_3; i3++) {
-                int idx_3 = block_indices_3[i3];
-                idx_3 = spinor_index_global2local[idx_3];
-                for (int i4 = 0; i4 < dims_4; i4++) {
-                    int idx_4 = block_indices_4[i4];
-                    idx_4 = spinor_index_global2local[idx_4];
-
-                    dbuf[index] += sign * creal(v_ints[idx_1][idx_2][idx_3][idx_4]);
-                    index++;
+                const double complex *src = v_ints->ints + offsets_1[i1] + offsets_2[i2] + offsets_3[i3];
+                if (contiguous) {
+                    src += offsets_4[0];
+                    for (int i4 = 0; i4 < dims_4; i4++) {
+                        dst[i4] += sign * creal(src[i4]);
+                    }
                 }
+                else {
+                    for (int i4 = 0; i4 < dims_4; i4++) {
+                        dst[i4] += sign * creal(src[offsets_4[i4]]);
+                    }
+                }
+                dst += dims_4;
             }
         }
     }
 }
 
 
-void fill_block_twoelec_real_exchange(block_t *block, int sign, double complex ****v_ints)
+void fill_block_twoelec_real_exchange(block_t *block, int sign, twoel_buffer_t *v_ints)
 {
     assert(block->rank == 4);
 
-    double *dbuf = (double *) block->buf;
-
     int dims_1 = block->shape[0];
     int dims_2 = block->shape[1];
     int dims_3 = block->shape[2];
     int dims_4 = block->shape[3];
-    int *block_indices_1 = block->indices[0];
-    int *block_indices_2 = block->indices[1];
-    int *block_indices_3 = block->indices[2];
-    int *block_indices_4 = block->indices[3];
+    size_t stride_3 = v_ints->dims[3];
+    size_t stride_2 = v_ints->dims[2] * stride_3;
+    size_t stride_1 = v_ints->dims[1] * stride_2;
+    size_t offsets_1[dims_1], offsets_2[dims_2], offsets_3[dims_3], offsets_4[dims_4];
 
-    size_t index = 0;
+    get_buffer_offsets(dims_1, block->indices[0], stride_1, offsets_1);
+    get_buffer_offsets(dims_2, block->indices[1], stride_2, offsets_2);
+    get_buffer_offsets(dims_3, block->indices[2], 1, offsets_3);
+    get_buffer_offsets(dims_4, block->indices[3], stride_3, offsets_4);
+
+    double *dst = (double *) block->buf;
     for (int i1 = 0; i1 < dims_1; i1++) {
-        int idx_1 = block_indices_1[i1]; // relative index to spinor indices
-        idx_1 = spinor_index_global2local[idx_1];
         for (int i2 = 0; i2 < dims_2; i2++) {
-            int idx_2 = block_indices_2[i2];
-            idx_2 = spinor_index_global2local[idx_2];
-            for (int i3 = 0; i3 < dims_3; i3++) {
-                int idx_3 = block_indices_3[i3];
-                idx_3 = spinor_index_global2local[idx_3];
-                for (int i4 = 0; i4 < dims_4; i4++) {
-                    int idx_4 = block_indices_4[i4];
-                    idx_4 = spinor_index_global2local[idx_4];
-
-                    dbuf[index] += sign * creal(v_ints[idx_1][idx_2][idx_4][idx_3]);
-                    index++;
+            const double complex *src = v_ints->ints + offsets_1[i1] + offsets_2[i2];
+            for (int t3 = 0; t3 < dims_3; t3 += CC_SORTING_TRANSPOSE_TILE) {
+                int end_3 = (t3 + CC_SORTING_TRANSPOSE_TILE < dims_3) ? t3 + CC_SORTING_TRANSPOSE_TILE : dims_3;
+                for (int t4 = 0; t4 < dims_4; t4 += CC_SORTING_TRANSPOSE_TILE) {
+                    int end_4 = (t4 + CC_SORTING_TRANSPOSE_TILE < dims_4) ? t4 + CC_SORTING_TRANSPOSE_TILE : dims_4;
+                    for (int i3 = t3; i3 < end_3; i3++) {
+                        double *dst_line = dst + (size_t) i3 * dims_4;
+                        const double complex *src_col = src + offsets_3[i3];
+                        for (int i4 = t4; i4 < end_4; i4++) {
+                            dst_line[i4] += sign * creal(src_col[offsets_4[i4]]);
+                        }
+                    }
                 }
             }
+            dst += (size_t) dims_3 * dims_4;
         }
     }
 }
 
 
-void free_twoel_buffer(size_t dim, double complex ****v_ints)
+void free_twoel_buffer(twoel_buffer_t *v_ints)
 {
-    for (size_t i = 0; i < dim; i++) {
-        for (size_t j = 0; j < dim; j++) {
-            for (size_t k = 0; k < dim; k++) {
-                cc_free(v_ints[i][j][k]);
-            }
-            cc_free(v_ints[i][j]);
-        }
-        cc_free(v_ints[i]);
-    }
+    cc_free(v_ints->mem);
     cc_free(v_ints);
 }
 
@@ -0,0 +1,339 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Persistent cache of sorted two-electron integrals (see sort_cache.h).
+ */
+
+#include "sort_cache.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "engine.h"
+#include "error.h"
+#include "io.h"
+#include "memory.h"
+#include "options.h"
+#include "spinors.h"
+#include "utils.h"
+
+// version of the entry layout; to be incremented when the layout changes
+#define CC_SORT_CACHE_VERSION 2
+
+// number of leading bytes of each integral file used for the key
+#define CC_SORT_CACHE_HEADER_BYTES (64 * 1024)
+
+static uint64_t get_entry_key(char *name, char *qparts, char *valence, char *order, int operator_symmetry);
+
+static uint64_t hash_string(uint64_t h, const char *str);
+
+static uint64_t hash_int(uint64_t h, int64_t x);
+
+static uint64_t hash_file_header(uint64_t h, char *path);
+
+static void make_path(char *path, size_t max_len, const char *format, ...);
+
+
+int sort_cache_enabled()
+{
+    return cc_opts->integral_cache_dir[0] != '\0';
+}
+
+
+/**
+ * Tries to take the sorted two-electron diagram from the cache.
+ * Returns 1 if the diagram was found (it is pushed to the diagram stack),
+ * 0 if it must be sorted.
+ */
+int sort_cache_load(char *name, char *qparts, char *valence, char *order, int operator_symmetry)
+{
+    char meta_path[CC_MAX_PATH_LENGTH];
+
+    if (!sort_cache_enabled()) {
+        return 0;
+    }
+
+    uint64_t key = get_entry_key(name, qparts, valence, order, operator_symmetry);
+    make_path(meta_path, sizeof(meta_path), "%s/%016llx.dg", cc_opts->integral_cache_dir, (unsigned long long) key);
+    if (!io_file_exists(meta_path)) {
+        return 0;
+    }
+
+    // entries are never compressed (see sort_cache_store())
+    int compress = cc_opts->compress;
+    cc_opts->compress = CC_COMPRESS_NONE;
+    diagram_t *dg = diagram_read_binary(meta_path);
+    cc_opts->compress = compress;
+    if (dg == NULL) {
+        return 0;
+    }
+
+    // blocks are moved to the storage planned for the diagram;
+    // on-disk blocks keep referring to the shared cache files
+    diagram_set_shared(dg);
+    size_t size = 0;
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        if (dg->blocks[ib]->is_unique) {
+            size += dg->blocks[ib]->size * SIZEOF_WORKING_TYPE;
+        }
+    }
+    diagram_set_storage_type(dg, guess_storage_class(name, 4, qparts, valence, size));
+    diagram_set_readonly(dg);
+    diagram_set_evictable(dg);
+    printf(" Sorted integrals '%s' are taken from the cache (%016llx)\n", name, (unsigned long long) key);
+
+    return 1;
+}
+
+
+/**
+ * Puts the diagram sorted for the request 'req' into the cache.
+ * Block files are written first, the metadata file is renamed into place
+ * last, so an entry never becomes visible half-written. Concurrent runs
+ * writing the same entry produce identical files.
+ * Entries are written without compression, whatever the 'compress' option.
+ */
+void sort_cache_store(sorting_request_t *req)
+{
+    char meta_path[CC_MAX_PATH_LENGTH];
+    char tmp_path[CC_MAX_PATH_LENGTH + 32];
+    char *cache_dir = cc_opts->integral_cache_dir;
+
+    if (!sort_cache_enabled() || req->rank != 4) {
+        return;
+    }
+
+    diagram_t *dg = diagram_stack_find(req->dg_name);
+    if (dg == NULL) {
+        return;
+    }
+
+    uint64_t key = get_entry_key(req->dg_name, req->hp, req->valence, req->order, req->operator_symmetry);
+    make_path(meta_path, sizeof(meta_path), "%s/%016llx.dg", cache_dir, (unsigned long long) key);
+    if (io_file_exists(meta_path)) {
+        return;
+    }
+
+    if (!io_directory_exists(cache_dir) && io_mkdir(cache_dir) != 0 && !io_directory_exists(cache_dir)) {
+        printf(" Warning: cannot create the integral cache directory '%s'\n", cache_dir);
+        cache_dir[0] = '\0';
+        return;
+    }
+
+    /*
+     * data of unique blocks
+     */
+    int *storage_types = (int *) cc_malloc(sizeof(int) * (dg->n_blocks + 1));
+    char **file_names = (char **) cc_malloc(sizeof(char *) * (dg->n_blocks + 1));
+    char **cache_names = (char **) cc_malloc(sizeof(char *) * (dg->n_blocks + 1));
+
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        block_t *block = dg->blocks[ib];
+        cache_names[ib] = NULL;
+        if (block->storage_type == CC_DIAGRAM_DUMMY) {
+            continue;
+        }
+
+        cache_names[ib] = (char *) cc_malloc(CC_MAX_PATH_LENGTH);
+        make_path(cache_names[ib], CC_MAX_PATH_LENGTH, "%s/%016llx-%zu.sb", cache_dir, (unsigned long long) key, ib);
+        make_path(tmp_path, sizeof(tmp_path), "%s.%zu", cache_names[ib], run_id());
+
+        int fd = io_open(tmp_path, "w");
+        if (fd == -1) {
+            errquit("sort_cache_store(): unable to open file %s", tmp_path);
+        }
+        // raw data regardless of the 'compress' option: cached blocks are mapped into memory
+        block_load(block);
+        io_write(fd, block->buf, block->size * SIZEOF_WORKING_TYPE);
+        block_unload(block);
+        io_close(fd);
+        io_rename(tmp_path, cache_names[ib]);
+    }
+
+    /*
+     * metadata: blocks are written as on-disk ones referring to the cache files.
+     * storage of the diagram itself is left untouched.
+     */
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        block_t *block = dg->blocks[ib];
+        storage_types[ib] = block->storage_type;
+        file_names[ib] = block->file_name;
+        if (cache_names[ib] != NULL) {
+            block->storage_type = CC_DIAGRAM_ON_DISK;
+            block->file_name = cache_names[ib];
+        }
+    }
+
+    make_path(tmp_path, sizeof(tmp_path), "%s.%zu", meta_path, run_id());
+    int compress = cc_opts->compress;
+    cc_opts->compress = CC_COMPRESS_NONE;
+    diagram_write_binary(dg, tmp_path);
+    cc_opts->compress = compress;
+
+    for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+        block_t *block = dg->blocks[ib];
+        block->storage_type = storage_types[ib];
+        block->file_name = file_names[ib];
+        cc_free(cache_names[ib]);
+    }
+
+    io_rename(tmp_path, meta_path);
+    printf(" Sorted integrals '%s' are put into the cache (%016llx)\n", req->dg_name, (unsigned long long) key);
+
+    cc_free(storage_types);
+    cc_free(file_names);
+    cc_free(cache_names);
+}
+
+
+/*
+ * key of the cache entry: the system (integrals, spinor spaces, data layout)
+ * and the request signature
+ */
+static uint64_t get_entry_key(char *name, char *qparts, char *valence, char *order, int operator_symmetry)
+{
+    uint64_t h = sort_cache_system_key();
+
+    h = hash_string(h, name);
+    h = hash_string(h, qparts);
+    h = hash_string(h, valence);
+    h = hash_string(h, order);
+    h = hash_int(h, operator_symmetry);
+
+    return h;
+}
+
+
+/*
+ * part of the key common for all the entries (computed once per run):
+ * integrals, layout of data and spinor spaces
+ */
+uint64_t sort_cache_system_key()
+{
+    static int key_ready = 0;
+    static uint64_t key = 0;
+
+    if (key_ready) {
+        return key;
+    }
+
+    uint64_t h = FNV1A_OFFSET_BASIS;
+
+    h = hash_int(h, CC_SORT_CACHE_VERSION);
+
+    // integrals
+    h = hash_int(h, cc_opts->int_source);
+    h = hash_int(h, cc_opts->new_sorting);
+    h = hash_file_header(h, cc_opts->integral_file_1);
+    h = hash_file_header(h, cc_opts->integral_file_2);
+    if (cc_opts->gaunt_defined) {
+        h = hash_file_header(h, cc_opts->integral_file_gaunt);
+    }
+    if (cc_opts->breit_defined) {
+        h = hash_file_header(h, cc_opts->integral_file_breit);
+    }
+    h = hash_int(h, cc_opts->n_twoprop);
+    for (int iprop = 0; iprop < cc_opts->n_twoprop; iprop++) {
+        h = hash_file_header(h, cc_opts->twoprop_file[iprop]);
+        h = fnv1a_hash(h, &cc_opts->twoprop_lambda[iprop], sizeof(double complex));
+    }
+
+    // layout of data
+    h = hash_int(h, arith);
+    h = hash_int(h, SIZEOF_WORKING_TYPE);
+    h = hash_int(h, cc_opts->tile_size);
+
+    // spinors: symmetry, spinor blocks, occupations and active space
+    int n_spinors = get_num_spinors();
+    h = hash_int(h, n_spinors);
+    for (int i = 0; i < n_spinors; i++) {
+        h = hash_int(h, spinor_info[i].repno);
+        h = hash_int(h, spinor_info[i].blockno);
+        h = hash_int(h, spinor_info[i].occ);
+        h = hash_int(h, spinor_info[i].space_flags);
+    }
+
+    key = h;
+    key_ready = 1;
+
+    return key;
+}
+
+
+static uint64_t hash_string(uint64_t h, const char *str)
+{
+    return fnv1a_hash(h, str, strlen(str) + 1);
+}
+
+
+static uint64_t hash_int(uint64_t h, int64_t x)
+{
+    return fnv1a_hash(h, &x, sizeof(x));
+}
+
+
+/*
+ * size and leading bytes of the file (missing files are hashed as empty ones)
+ */
+static uint64_t hash_file_header(uint64_t h, char *path)
+{
+    size_t size = io_fsize(path);
+    h = hash_int(h, (int64_t) size);
+
+    int fd = io_open(path, "r");
+    if (fd == -1) {
+        return h;
+    }
+
+    size_t count = size < CC_SORT_CACHE_HEADER_BYTES ? size : CC_SORT_CACHE_HEADER_BYTES;
+    char *buf = (char *) cc_malloc(count + 1);
+    int64_t n_read = io_read(fd, buf, count);
+    if (n_read > 0) {
+        h = fnv1a_hash(h, buf, (size_t) n_read);
+    }
+    cc_free(buf);
+    io_close(fd);
+
+    return h;
+}
+
+
+/*
+ * formats the path of the cache file, stops if it does not fit into the buffer
+ * (the length of the cache directory is checked by the input parser)
+ */
+static void make_path(char *path, size_t max_len, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(path, max_len, format, args);
+    va_end(args);
+
+    if (len < 0 || (size_t) len >= max_len) {
+        errquit("sort_cache: path of the cache file is too long (directory '%s')", cc_opts->integral_cache_dir);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Persistent cache of sorted two-electron integrals.
+ *
+ * Sorted rank-4 diagrams are stored in the cache directory and reused by
+ * subsequent runs with the same integrals (e.g. scans over sectors, active
+ * spaces or CC models). An entry is keyed by a hash of the integral file
+ * headers, tile size, arithmetic, spinor occupations and spaces and the
+ * request signature (name, qparts, valence, order, symmetry).
+ *
+ * Entry layout:
+ *   <key>.dg       diagram metadata (diagram_write_binary() format), blocks
+ *                  are on-disk ones referring to the files below
+ *   <key>-<i>.sb   raw (never compressed) data of the i-th unique block
+ * Cached blocks are mapped into memory directly (read-only, copy-on-write,
+ * see block_set_shared()), also when the 'compress' option is set, so the
+ * option is not a part of the key.
+ */
+
+#ifndef CC_SORT_CACHE_H_INCLUDED
+#define CC_SORT_CACHE_H_INCLUDED
+
+#include <stdint.h>
+
+#include "sorting_request.h"
+
+int sort_cache_enabled();
+
+int sort_cache_load(char *name, char *qparts, char *valence, char *order, int operator_symmetry);
+
+void sort_cache_store(sorting_request_t *req);
+
+uint64_t sort_cache_system_key();
+
+#endif // CC_SORT_CACHE_H_INCLUDED
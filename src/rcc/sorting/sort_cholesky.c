@@ -0,0 +1,505 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Pivoted Cholesky decomposition of the pppp integrals.
+ *
+ * The antisymmetrized integrals <pq||rs> over particles are expressed via the
+ * matrix M(xy,zw) = <yz|xw> over pairs of particle spinors:
+ *   <pq|rs> = M(rp,qs).
+ * M is Hermitian; it is positive semidefinite for the Coulomb interaction,
+ * but the Gaunt or two-electron property contributions can make it
+ * indefinite. Thus the decomposition is M = sum_J s_J L_J L_J^+, where
+ * s_J = +1/-1 is the sign of the pivot.
+ *
+ * Columns of M are loaded from the quadruples of spinor blocks (Y,Z,X,W) for
+ * all the particle tiles X,Y at once, so the decomposition proceeds by panels:
+ * the pair of spinor blocks (Z,W) containing the largest diagonal element is
+ * selected, all its columns with large enough diagonal elements are loaded,
+ * the contribution of the vectors found so far is subtracted (one matrix
+ * product) and the pivots are chosen within the panel. The procedure stops
+ * when the largest residual diagonal element is below the threshold.
+ *
+ * Vectors are stored in RAM (V^2 per vector), no V^4 arrays are allocated.
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sort_cholesky.h"
+#include "sorting_request.h"
+#include "twoel_buffer.h"
+
+#include "engine.h"
+#include "error.h"
+#include "linalg.h"
+#include "memory.h"
+#include "omp.h"
+#include "options.h"
+#include "spinors.h"
+#include "symmetry.h"
+#include "timer.h"
+
+// max number of columns in the panel
+#define CHOLESKY_MAX_PANEL 512
+
+// columns with small diagonal elements (relative to the max one) are not
+// taken into the panel
+#define CHOLESKY_SPAN 1e-2
+
+extern int pyscf_chunked_eri;
+
+/*
+ * particle spinors: positions in the pairs index, lists for each spinor block
+ */
+typedef struct {
+    int n_particles;
+    int *pos;                  // global spinor index -> position among particles (-1 for holes)
+    int *particles;            // position -> global spinor index
+    int *n_block_particles;    // for each spinor block
+    int **block_particles;     // global indices of particles of each spinor block
+} particle_space_t;
+
+static cholesky_vectors_t *decompose_pppp(double thresh);
+
+static void init_particle_space(particle_space_t *space);
+
+static void free_particle_space(particle_space_t *space);
+
+static void load_diagonal(particle_space_t *space, twoel_buffer_t **v_ints, int n_threads, double *diag);
+
+static void load_panel(particle_space_t *space, twoel_buffer_t **v_ints, int n_threads,
+                       size_t n_columns, size_t *columns, double complex *panel);
+
+
+/**
+ * Cholesky decomposition is applicable to the pppp (0000) diagrams sorted
+ * from the quadruples of spinor blocks (see sort_twoel()). Integrals read
+ * from the previous runs are used as they are.
+ */
+int sort_cholesky_is_applicable(char *qparts, char *valence, char *order, int operator_symmetry)
+{
+    if (cc_opts->cholesky_thresh <= 0.0 || cc_opts->reuse_integrals_2) {
+        return 0;
+    }
+    if (cc_opts->int_source != CC_INTEGRALS_SYNTHETIC &&
+        !(cc_opts->int_source == CC_INTEGRALS_DIRAC && !cc_opts->new_sorting) &&
+        !(cc_opts->int_source == CC_INTEGRALS_PYSCF && pyscf_chunked_eri)) {
+        return 0;
+    }
+    if (strcmp(qparts, "pppp") != 0 || strcmp(valence, "0000") != 0) {
+        return 0;
+    }
+    if (strcmp(order, "1234") != 0 && strcmp(order, "3412") != 0) {
+        return 0;
+    }
+
+    return operator_symmetry == get_totally_symmetric_irrep();
+}
+
+
+/**
+ * Binds the diagrams of the CC_DIAGRAM_CHOLESKY storage type to the Cholesky
+ * vectors. The decomposition is performed only once: the pppp integrals are
+ * the same for all the sectors.
+ * Must be called when the sources of two-electron integrals are opened.
+ */
+void sort_cholesky_pppp()
+{
+    int n_cholesky = 0;
+
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        if (req->rank == 4 && diagram_get_storage_type(req->dg) == CC_DIAGRAM_CHOLESKY) {
+            n_cholesky++;
+        }
+    }
+    if (n_cholesky == 0) {
+        return;
+    }
+
+    if (cholesky_tier_get_vectors() == NULL) {
+        cholesky_tier_set_vectors(decompose_pppp(cc_opts->cholesky_thresh));
+    }
+
+    // pppp (3412) contains complex conjugate integrals (see sort_twoel_task())
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        if (req->rank != 4 || diagram_get_storage_type(req->dg) != CC_DIAGRAM_CHOLESKY) {
+            continue;
+        }
+
+        int do_conj = (strcmp(req->order, "3412") == 0) && (arith == CC_ARITH_COMPLEX);
+        for (size_t ib = 0; ib < req->dg->n_blocks; ib++) {
+            req->dg->blocks[ib]->chol_conj = do_conj;
+        }
+    }
+}
+
+
+/*
+ * pivoted Cholesky decomposition of the matrix M(xy,zw) = <yz|xw>
+ * (see the description at the top of the file)
+ */
+static cholesky_vectors_t *decompose_pppp(double thresh)
+{
+    double time_start = abs_time();
+    double complex z_one = 1.0;
+    double complex z_minus_one = -1.0;
+
+    particle_space_t space;
+    init_particle_space(&space);
+    size_t n_particles = space.n_particles;
+    size_t n_pairs = n_particles * n_particles;
+
+    // each thread has its own buffer for integrals
+    size_t max_block_size = get_max_spinor_block_size();
+    size_t twoel_buf_size = max_block_size * max_block_size * max_block_size * max_block_size * sizeof(double complex);
+    int n_threads = get_num_sorting_threads(twoel_buf_size);
+    twoel_buffer_t **v_ints = (twoel_buffer_t **) cc_malloc(sizeof(twoel_buffer_t *) * n_threads);
+    for (int ithread = 0; ithread < n_threads; ithread++) {
+        v_ints[ithread] = allocate_twoel_buffer();
+    }
+
+    printf(" Cholesky decomposition of pppp integrals (%zu particles, threshold %g, %d threads)\n",
+           n_particles, thresh, n_threads);
+
+    double *diag = (double *) cc_calloc(n_pairs, sizeof(double));
+    load_diagonal(&space, v_ints, n_threads, diag);
+
+    // size of the panel is limited by a quarter of the memory left
+    size_t used = cc_get_current_memory_usage();
+    size_t available = (cc_opts->max_memory_size > used) ? (cc_opts->max_memory_size - used) / 4 : 0;
+    size_t max_panel = available / (n_pairs * sizeof(double complex));
+    max_panel = (max_panel < 1) ? 1 : max_panel;
+    max_panel = (max_panel > CHOLESKY_MAX_PANEL) ? CHOLESKY_MAX_PANEL : max_panel;
+
+    size_t capacity = (2 * n_particles > 16) ? 2 * n_particles : 16;
+    size_t n_vectors = 0;
+    double complex *vectors = (double complex *) cc_malloc(capacity * n_pairs * sizeof(double complex));
+    int *signs = (int *) cc_malloc(capacity * sizeof(int));
+
+    double complex *panel = (double complex *) cc_malloc(max_panel * n_pairs * sizeof(double complex));
+    size_t *columns = (size_t *) cc_malloc(max_panel * sizeof(size_t));
+    int *is_pivot = (int *) cc_malloc(max_panel * sizeof(int));
+    size_t *candidates = (size_t *) cc_malloc(max_block_size * max_block_size * sizeof(size_t));
+
+    size_t n_panels = 0;
+    size_t n_negative = 0;
+    double max_diag = 0.0;
+
+    while (n_vectors < n_pairs) {
+        size_t imax = 0;
+        max_diag = 0.0;
+        for (size_t i = 0; i < n_pairs; i++) {
+            if (fabs(diag[i]) > max_diag) {
+                max_diag = fabs(diag[i]);
+                imax = i;
+            }
+        }
+        if (max_diag < thresh) {
+            break;
+        }
+
+        // candidate columns: the same pair of spinor blocks as the max diagonal element
+        double min_diag = (CHOLESKY_SPAN * max_diag > thresh) ? CHOLESKY_SPAN * max_diag : thresh;
+        int sb_z = spinor_info[space.particles[imax / n_particles]].blockno;
+        int sb_w = spinor_info[space.particles[imax % n_particles]].blockno;
+        size_t n_candidates = 0;
+        for (int iz = 0; iz < space.n_block_particles[sb_z]; iz++) {
+            for (int iw = 0; iw < space.n_block_particles[sb_w]; iw++) {
+                size_t pair = space.pos[space.block_particles[sb_z][iz]] * n_particles +
+                              space.pos[space.block_particles[sb_w][iw]];
+                if (fabs(diag[pair]) >= min_diag) {
+                    candidates[n_candidates++] = pair;
+                }
+            }
+        }
+
+        // the largest ones are taken
+        size_t n_columns = 0;
+        while (n_columns < max_panel && n_columns < n_candidates) {
+            size_t ibest = n_columns;
+            for (size_t i = n_columns + 1; i < n_candidates; i++) {
+                if (fabs(diag[candidates[i]]) > fabs(diag[candidates[ibest]])) {
+                    ibest = i;
+                }
+            }
+            size_t tmp = candidates[n_columns];
+            candidates[n_columns] = candidates[ibest];
+            candidates[ibest] = tmp;
+            columns[n_columns] = candidates[n_columns];
+            is_pivot[n_columns] = 0;
+            n_columns++;
+        }
+
+        // panel[c][p] = M(p, columns[c]) - sum_J s_J L_J[p] conj(L_J[columns[c]])
+        load_panel(&space, v_ints, n_threads, n_columns, columns, panel);
+        if (n_vectors > 0) {
+            double complex *coef = (double complex *) cc_malloc(n_columns * n_vectors * sizeof(double complex));
+            for (size_t c = 0; c < n_columns; c++) {
+                for (size_t j = 0; j < n_vectors; j++) {
+                    coef[c * n_vectors + j] = signs[j] * conj(vectors[j * n_pairs + columns[c]]);
+                }
+            }
+            xgemm(CC_DOUBLE_COMPLEX, "N", "N", n_columns, n_pairs, n_vectors, &z_minus_one, coef, n_vectors,
+                  vectors, n_pairs, &z_one, panel, n_pairs);
+            cc_free(coef);
+        }
+
+        // pivots within the panel
+        size_t n_pivots = 0;
+        while (n_vectors < n_pairs) {
+            size_t cbest = 0;
+            double dbest = 0.0;
+            for (size_t c = 0; c < n_columns; c++) {
+                double d = fabs(creal(panel[c * n_pairs + columns[c]]));
+                if (!is_pivot[c] && d > dbest) {
+                    dbest = d;
+                    cbest = c;
+                }
+            }
+            if (dbest < min_diag) {
+                break;
+            }
+
+            if (n_vectors == capacity) {
+                capacity *= 2;
+                double complex *new_vectors = (double complex *) cc_malloc(capacity * n_pairs * sizeof(double complex));
+                int *new_signs = (int *) cc_malloc(capacity * sizeof(int));
+                memcpy(new_vectors, vectors, n_vectors * n_pairs * sizeof(double complex));
+                memcpy(new_signs, signs, n_vectors * sizeof(int));
+                cc_free(vectors);
+                cc_free(signs);
+                vectors = new_vectors;
+                signs = new_signs;
+            }
+
+            // new vector: L = R[:,q] / sqrt(|R[q,q]|)
+            double complex *col = panel + cbest * n_pairs;
+            double complex *vec = vectors + n_vectors * n_pairs;
+            double d = creal(col[columns[cbest]]);
+            int sign = (d > 0.0) ? 1 : -1;
+            double scale = 1.0 / sqrt(fabs(d));
+
+            #pragma omp parallel for num_threads(cc_opts->nthreads) schedule(static)
+            for (size_t p = 0; p < n_pairs; p++) {
+                vec[p] = col[p] * scale;
+                diag[p] -= sign * (creal(vec[p]) * creal(vec[p]) + cimag(vec[p]) * cimag(vec[p]));
+            }
+            diag[columns[cbest]] = 0.0;
+            is_pivot[cbest] = 1;
+
+            // update of the rest of the panel
+            for (size_t c = 0; c < n_columns; c++) {
+                if (is_pivot[c]) {
+                    continue;
+                }
+                double complex f = sign * conj(vec[columns[c]]);
+                double complex *dst = panel + c * n_pairs;
+                #pragma omp parallel for num_threads(cc_opts->nthreads) schedule(static)
+                for (size_t p = 0; p < n_pairs; p++) {
+                    dst[p] -= f * vec[p];
+                }
+            }
+
+            signs[n_vectors] = sign;
+            n_negative += (sign < 0);
+            n_vectors++;
+            n_pivots++;
+        }
+
+        // round-off errors: the diagonal element cannot be used as a pivot
+        if (n_pivots == 0) {
+            diag[imax] = 0.0;
+        }
+        n_panels++;
+    }
+
+    max_diag = 0.0;
+    for (size_t i = 0; i < n_pairs; i++) {
+        max_diag = (fabs(diag[i]) > max_diag) ? fabs(diag[i]) : max_diag;
+    }
+
+    // final storage: [pair][J], working type
+    cholesky_vectors_t *chol = (cholesky_vectors_t *) cc_malloc(sizeof(cholesky_vectors_t));
+    chol->n_particles = n_particles;
+    chol->pos = space.pos;
+    chol->n_vectors = n_vectors;
+    chol->signs = (int *) cc_malloc(n_vectors * sizeof(int) + 1);
+    memcpy(chol->signs, signs, n_vectors * sizeof(int));
+    chol->vectors = cc_malloc(n_pairs * n_vectors * SIZEOF_WORKING_TYPE + 1);
+    for (size_t p = 0; p < n_pairs; p++) {
+        for (size_t j = 0; j < n_vectors; j++) {
+            if (arith == CC_ARITH_COMPLEX) {
+                ((double complex *) chol->vectors)[p * n_vectors + j] = vectors[j * n_pairs + p];
+            }
+            else {
+                ((double *) chol->vectors)[p * n_vectors + j] = creal(vectors[j * n_pairs + p]);
+            }
+        }
+    }
+    space.pos = NULL;
+
+    printf("   number of vectors                  %zu (%zu with negative pivots)\n", n_vectors, n_negative);
+    printf("   number of panels                   %zu\n", n_panels);
+    printf("   max residual diagonal element      %.3e\n", max_diag);
+    printf("   memory for vectors, MB             %.1f\n", n_pairs * n_vectors * SIZEOF_WORKING_TYPE / (1024.0 * 1024.0));
+    printf("   time for decomposition, sec        %.2f\n", abs_time() - time_start);
+
+    cc_free(candidates);
+    cc_free(is_pivot);
+    cc_free(columns);
+    cc_free(panel);
+    cc_free(signs);
+    cc_free(vectors);
+    cc_free(diag);
+    for (int ithread = 0; ithread < n_threads; ithread++) {
+        free_twoel_buffer(v_ints[ithread]);
+    }
+    cc_free(v_ints);
+    free_particle_space(&space);
+
+    return chol;
+}
+
+
+static void init_particle_space(particle_space_t *space)
+{
+    int n_spinors = get_num_spinors();
+
+    space->n_particles = 0;
+    space->pos = (int *) cc_malloc(sizeof(int) * n_spinors);
+    space->particles = (int *) cc_malloc(sizeof(int) * n_spinors);
+    for (int i = 0; i < n_spinors; i++) {
+        space->pos[i] = -1;
+        if (is_particle(i)) {
+            space->pos[i] = space->n_particles;
+            space->particles[space->n_particles] = i;
+            space->n_particles++;
+        }
+    }
+
+    space->n_block_particles = (int *) cc_malloc(sizeof(int) * n_spinor_blocks);
+    space->block_particles = (int **) cc_malloc(sizeof(int *) * n_spinor_blocks);
+    for (size_t isb = 0; isb < n_spinor_blocks; isb++) {
+        space->n_block_particles[isb] = 0;
+        space->block_particles[isb] = (int *) cc_malloc(sizeof(int) * spinor_blocks[isb].size);
+        for (int i = 0; i < spinor_blocks[isb].size; i++) {
+            int idx = spinor_blocks[isb].indices[i];
+            if (is_particle(idx)) {
+                space->block_particles[isb][space->n_block_particles[isb]++] = idx;
+            }
+        }
+    }
+}
+
+
+static void free_particle_space(particle_space_t *space)
+{
+    for (size_t isb = 0; isb < n_spinor_blocks; isb++) {
+        cc_free(space->block_particles[isb]);
+    }
+    cc_free(space->block_particles);
+    cc_free(space->n_block_particles);
+    cc_free(space->particles);
+    cc_free(space->pos);
+}
+
+
+/*
+ * diagonal elements M(zw,zw) = <wz|zw> from the quadruples (W,Z,Z,W)
+ */
+static void load_diagonal(particle_space_t *space, twoel_buffer_t **v_ints, int n_threads, double *diag)
+{
+    int n_sb = n_spinor_blocks;
+    size_t n_particles = space->n_particles;
+
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+    for (int ipair = 0; ipair < n_sb * n_sb; ipair++) {
+        int sb_z = ipair / n_sb;
+        int sb_w = ipair % n_sb;
+        if (space->n_block_particles[sb_z] == 0 || space->n_block_particles[sb_w] == 0) {
+            continue;
+        }
+
+        twoel_buffer_t *buf = v_ints[omp_get_thread_num()];
+        load_twoel_quadruple(buf, sb_w, sb_z, sb_z, sb_w);
+
+        for (int iz = 0; iz < space->n_block_particles[sb_z]; iz++) {
+            int z = space->block_particles[sb_z][iz];
+            int lz = spinor_index_global2local[z];
+            for (int iw = 0; iw < space->n_block_particles[sb_w]; iw++) {
+                int w = space->block_particles[sb_w][iw];
+                int lw = spinor_index_global2local[w];
+                diag[space->pos[z] * n_particles + space->pos[w]] =
+                        creal(buf->ints[twoel_buffer_index(buf, lw, lz, lz, lw)]);
+            }
+        }
+    }
+}
+
+
+/*
+ * columns of M for the given pairs (z,w) of the same pair of spinor blocks:
+ * panel[c][(x,y)] = <yz|xw>, from the quadruples (Y,Z,X,W)
+ */
+static void load_panel(particle_space_t *space, twoel_buffer_t **v_ints, int n_threads,
+                       size_t n_columns, size_t *columns, double complex *panel)
+{
+    int n_sb = n_spinor_blocks;
+    size_t n_particles = space->n_particles;
+    size_t n_pairs = n_particles * n_particles;
+    int sb_z = spinor_info[space->particles[columns[0] / n_particles]].blockno;
+    int sb_w = spinor_info[space->particles[columns[0] % n_particles]].blockno;
+
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+    for (int ipair = 0; ipair < n_sb * n_sb; ipair++) {
+        int sb_x = ipair / n_sb;
+        int sb_y = ipair % n_sb;
+        if (space->n_block_particles[sb_x] == 0 || space->n_block_particles[sb_y] == 0) {
+            continue;
+        }
+
+        twoel_buffer_t *buf = v_ints[omp_get_thread_num()];
+        load_twoel_quadruple(buf, sb_y, sb_z, sb_x, sb_w);
+
+        for (size_t c = 0; c < n_columns; c++) {
+            int lz = spinor_index_global2local[space->particles[columns[c] / n_particles]];
+            int lw = spinor_index_global2local[space->particles[columns[c] % n_particles]];
+            double complex *dst = panel + c * n_pairs;
+            for (int ix = 0; ix < space->n_block_particles[sb_x]; ix++) {
+                int x = space->block_particles[sb_x][ix];
+                int lx = spinor_index_global2local[x];
+                for (int iy = 0; iy < space->n_block_particles[sb_y]; iy++) {
+                    int y = space->block_particles[sb_y][iy];
+                    int ly = spinor_index_global2local[y];
+                    dst[space->pos[x] * n_particles + space->pos[y]] =
+                            buf->ints[twoel_buffer_index(buf, ly, lz, lx, lw)];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Pivoted Cholesky decomposition of the pppp two-electron integrals.
+ *
+ * Requests for the pppp (0000) diagrams are not sorted into the full V^4
+ * arrays: the integrals are decomposed once during sorting and the blocks
+ * are reconstructed from the Cholesky vectors on demand (see
+ * cholesky_tier.h). Enabled by the 'disk_usage ... cholesky [<thresh>]'
+ * directive.
+ */
+
+#ifndef CC_SORT_CHOLESKY_H_INCLUDED
+#define CC_SORT_CHOLESKY_H_INCLUDED
+
+int sort_cholesky_is_applicable(char *qparts, char *valence, char *order, int operator_symmetry);
+
+void sort_cholesky_pppp();
+
+#endif /* CC_SORT_CHOLESKY_H_INCLUDED */
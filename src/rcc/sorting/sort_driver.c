@@ -25,13 +25,12 @@
  * Sorting of integrals (creating basic diagrams from the raw integral arrays).
  *
  * Algorithm in brief:
- * (1) Split MDCINT into smaller files
- *     (one 4-dim integral block <IJ|KL> = one "VINT-I-J-K-L" file)
- *     (file dirac_binary.f90)
+ * (1) Split MDCINT into 4-dim integral blocks <IJ|KL> stored in the single
+ *     container "VINT.*" (file dirac_binary.f90, see twoel_container.h)
  * (2) Put diagrams to be sorted into the queue
- * (3) Read "VINT-I-J-K-L" files one-by-one; for each file find corresponding
+ * (3) Read integral blocks one-by-one; for each block <IJ|KL> find corresponding
  *     blocks in 2-particle diagrams in the queue; fill these blocks with
- *     integrals from "VINT-I-J-K-L" file.
+ *     integrals from the block <IJ|KL>.
  * (4) Read files again, but add integrals with interchanged K,L indices with
  *     the opposite sign (antisymmetrzation): <ij||kl> = <ij|kl> - <ij|lk>
  * (5) Construct Fock matrix (using the "hhhh" diagram and the "HINT" file)
@@ -46,6 +45,8 @@
 #include <string.h>
 
 #include "sorting_request.h"
+#include "sort_cache.h"
+#include "sort_cholesky.h"
 
 #include "engine.h"
 #include "error.h"
@@ -74,8 +75,34 @@ void sort_pyscf_one_electron();
 
 void sort_pyscf_two_electron();
 
+void sort_synthetic_one_electron();
+
 void pyscf_data_free();
 
+extern int pyscf_chunked_eri;
+
+static void create_templates();
+
+static int activate_presorted(char *name, char *qparts, char *valence, char *order, int operator_symmetry);
+
+static void release_integral_sources();
+
+
+/*
+ * diagrams sorted in advance for all the sectors to be visited
+ * (see perform_presorting()). Diagrams of the subsequent sectors are parked
+ * off RAM until their sector requests them.
+ */
+typedef struct {
+    sorting_request_t req;
+    diagram_t *dg;       // to check that the diagram was not replaced since sorting
+    int64_t block_id;    // id of its first block (the same reason)
+    int parked;
+} presorted_diagram_t;
+
+static presorted_diagram_t presorted[CC_MAX_SORTING_REQUESTS];
+static int n_presorted = 0;
+
 
 /**
  * prints sorting configuration:
@@ -98,7 +125,17 @@ void sorting_print_configuration()
         printf(" size of i/o buffer for integrals and indices   %.3f MB\n", io_total_buf_size_mb);
         printf(" size of the buffer for two-elec integrals      %.3f MB\n", twoelec_buf_size_mb);
     }
-    else { // pyscf
+    else if (cc_opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        const double twoelec_buf_size_mb = pow(get_max_spinor_block_size(), 4) / (1024.0 * 1024.0);
+        printf(" size of the buffer for two-elec integrals      %.3f MB\n", twoelec_buf_size_mb);
+    }
+    else if (pyscf_chunked_eri) {
+        const double twoelec_buf_size_mb = pow(get_max_spinor_block_size(), 4) / (1024.0 * 1024.0);
+        const double eri_file_size_mb = io_fsize(cc_opts->integral_file_2) / (1024.0 * 1024.0);
+        printf(" size of the buffer for two-elec integrals      %.3f MB\n", twoelec_buf_size_mb);
+        printf(" size of the mapped file with integrals         %.3f MB\n", eri_file_size_mb);
+    }
+    else { // pyscf, dense layout
         const double twoelec_buf_size_mb = pow(get_num_spinors(), 4) * 16.0 / (8.0 * 1024.0 * 1024.0);
         printf(" size of the buffer for two-elec integrals      %.3f MB\n", twoelec_buf_size_mb);
     }
@@ -108,7 +145,8 @@ void sorting_print_configuration()
 /**
  * Leaves requests for sorting of 1- and 2-particle diagrams with given
  * "holes/particles" and "valence" characteristics from the raw integrals.
- * The new (empty) diagram will be added to the diagram stack.
+ * The new (empty) diagram will be added to the diagram stack by
+ * perform_sorting().
  * Diagram will have the 'standard' order (12) or (1234)
  *
  * Arguments:
@@ -142,11 +180,18 @@ void request_sorting_sym(char *name, char *qparts, char *valence, char *order, i
                 name, qparts, valence, order);
     }
 
+    // diagram could be already sorted in advance
+    if (activate_presorted(name, qparts, valence, order, operator_symmetry)) {
+        return;
+    }
+
     // ??? здесь считывать уже готовые ?
     // try to read from disk
     sprintf(file_name, "%s.dg", name);
     if (rank == 2 && cc_opts->reuse_integrals_1) {
-        if (diagram_read_binary(file_name) != NULL) {
+        diagram_t *dg = diagram_read_binary(file_name);
+        if (dg != NULL) {
+            diagram_set_readonly(dg);
             printf(" Reuse 1-electron integrals file '%s'\n", name);
             return;
         }
@@ -155,7 +200,10 @@ void request_sorting_sym(char *name, char *qparts, char *valence, char *order, i
         }
     }
     if (rank == 4 && cc_opts->reuse_integrals_2) {
-        if (diagram_read_binary(file_name) != NULL) {
+        diagram_t *dg = diagram_read_binary(file_name);
+        if (dg != NULL) {
+            diagram_set_readonly(dg);
+            diagram_set_evictable(dg);
             printf(" Reuse 2-electron integrals file '%s'\n", name);
             return;
         }
@@ -164,21 +212,16 @@ void request_sorting_sym(char *name, char *qparts, char *valence, char *order, i
         }
     }
 
-    // create the diagram template:
-    // 1. one-particle diagram
-    if (rank == 2) {
-        tmplt_sym(name, qparts, valence, "12", NOT_PERM_UNIQUE, operator_symmetry);
-    }
-        // 2. two-particle diagram
-    else if (rank == 4) {
-        tmplt_sym(name, qparts, valence, "1234", IS_PERM_UNIQUE, operator_symmetry); // здесь нужно писать 'order'
-    }
-    else {
-        errquit("in request sorting(): only diagrams with rank = 2 or 4 are allowed: %s[%s/%s/%s]\n",
-                name, qparts, valence, order);
+    // sorted by one of the previous runs with the same integrals
+    // (pppp integrals to be decomposed are never stored in the cache)
+    if (rank == 4 && !sort_cholesky_is_applicable(qparts, valence, order, operator_symmetry) &&
+        sort_cache_load(name, qparts, valence, order, operator_symmetry)) {
+        return;
     }
 
-    append_sorting_request(sorting_requests, &n_requests, name, qparts, valence, order);
+    // the diagram template will be created by perform_sorting(),
+    // when all the diagrams to be sorted are known
+    append_sorting_request(sorting_requests, &n_requests, name, qparts, valence, order, operator_symmetry);
 }
 
 
@@ -188,6 +231,170 @@ void request_sorting(char *name, char *qparts, char *valence, char *order)
 }
 
 
+/**
+ * Sorting of integrals requested by all the sectors to be visited in one pass
+ * over the raw integrals. Requests of all the sectors must be already left
+ * (each request remembers its sector, see append_sorting_request()); the
+ * current sector is the first one.
+ * Diagrams required for the subsequent sectors are parked off RAM (on disk or
+ * in the compressed tier) and are activated by request_sorting() when their
+ * sector starts. Diagram names requested by several sectors are sorted once.
+ */
+void perform_presorting()
+{
+    int sect_h = cc_opts->curr_sector_h;
+    int sect_p = cc_opts->curr_sector_p;
+    int n_unique = 0;
+    int n_parked = 0;
+
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        int is_repeated = 0;
+        for (int j = 0; j < n_unique; j++) {
+            if (strcmp(sorting_requests[j].dg_name, req->dg_name) == 0) {
+                is_repeated = 1;
+                break;
+            }
+        }
+        if (!is_repeated) {
+            sorting_requests[n_unique++] = *req;
+        }
+    }
+    n_requests = n_unique;
+
+    n_presorted = 0;
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        presorted_diagram_t *entry = &presorted[n_presorted++];
+
+        entry->req = *req;
+        entry->parked = (req->rank == 4) && (req->sect_h != sect_h || req->sect_p != sect_p);
+        if (entry->parked) {
+            placement_park_diagram(req->dg_name);
+            n_parked++;
+        }
+    }
+
+    printf("\n");
+    printf(" Integrals for all the sectors are sorted in one pass: %d diagrams, %d of them\n", n_presorted, n_parked);
+    printf(" are kept off RAM until the subsequent sectors start\n");
+
+    perform_sorting();
+    placement_unpark_all();
+
+    for (int i = 0; i < n_presorted; i++) {
+        presorted_diagram_t *entry = &presorted[i];
+        entry->dg = diagram_stack_find(entry->req.dg_name);
+        entry->block_id = (entry->dg != NULL && entry->dg->n_blocks > 0) ? entry->dg->blocks[0]->id : -1;
+    }
+}
+
+
+/**
+ * Makes the diagram sorted in advance available for the current sector.
+ * Returns 1 if the diagram was found, 0 if it must be sorted.
+ */
+static int activate_presorted(char *name, char *qparts, char *valence, char *order, int operator_symmetry)
+{
+    for (int i = 0; i < n_presorted; i++) {
+        presorted_diagram_t *entry = &presorted[i];
+        sorting_request_t *req = &entry->req;
+
+        if (strcmp(req->dg_name, name) != 0) {
+            continue;
+        }
+        if (strcmp(req->hp, qparts) != 0 || strcmp(req->valence, valence) != 0 ||
+            strcmp(req->order, order) != 0 || req->operator_symmetry != operator_symmetry) {
+            return 0;
+        }
+
+        // the diagram could be replaced or erased by one of the previous sectors
+        diagram_t *dg = diagram_stack_find(name);
+        if (dg == NULL || dg != entry->dg ||
+            (dg->n_blocks > 0 && dg->blocks[0]->id != entry->block_id)) {
+            return 0;
+        }
+
+        if (entry->parked && diagram_get_storage_type(dg) != CC_DIAGRAM_CHOLESKY) {
+            size_t size = 0;
+            for (size_t ib = 0; ib < dg->n_blocks; ib++) {
+                if (dg->blocks[ib]->is_unique) {
+                    size += dg->blocks[ib]->size * SIZEOF_WORKING_TYPE;
+                }
+            }
+
+            int storage_type = guess_storage_class(name, req->rank, qparts, valence, size);
+            diagram_set_storage_type(dg, storage_type);
+            diagram_set_readonly(dg);
+            diagram_set_evictable(dg);
+            entry->parked = 0;
+
+            // the file refers to the blocks of the current storage
+            char dg_file_name[CC_MAX_PATH_LENGTH];
+            sprintf(dg_file_name, "%s.dg", name);
+            diagram_write_binary(dg, dg_file_name);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Creates (empty) templates of all the diagrams to be sorted.
+ * In the automatic disk usage mode the placement of these diagrams
+ * (RAM vs disk) is planned before any of them is allocated.
+ */
+static void create_templates()
+{
+    // pppp integrals represented by the Cholesky vectors: blocks without data
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+        if (req->rank == 4 && sort_cholesky_is_applicable(req->hp, req->valence, req->order, req->operator_symmetry)) {
+            cholesky_tier_reserve(req->dg_name);
+        }
+    }
+
+    if (cc_opts->disk_usage_level == CC_DISK_USAGE_AUTO) {
+        placement_clear();
+        for (int ireq = 0; ireq < n_requests; ireq++) {
+            sorting_request_t *req = &sorting_requests[ireq];
+            size_t size = 0;
+            if (cholesky_tier_is_reserved(req->dg_name)) {
+                continue;
+            }
+            if (req->rank == 2) {
+                size = diagram_estimate_size(req->hp, req->valence, "00", "12", NOT_PERM_UNIQUE,
+                                             req->operator_symmetry);
+            }
+            else {
+                size = diagram_estimate_size(req->hp, req->valence, "0000", "1234", IS_PERM_UNIQUE,
+                                             req->operator_symmetry);
+            }
+            placement_add_diagram(req->dg_name, req->hp, req->valence, size);
+        }
+        placement_make_plan();
+    }
+
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        sorting_request_t *req = &sorting_requests[ireq];
+
+        // 1. one-particle diagram
+        if (req->rank == 2) {
+            tmplt_sym(req->dg_name, req->hp, req->valence, "12", NOT_PERM_UNIQUE, req->operator_symmetry);
+        }
+            // 2. two-particle diagram
+        else {
+            tmplt_sym(req->dg_name, req->hp, req->valence, "1234", IS_PERM_UNIQUE, req->operator_symmetry); // здесь нужно писать 'order'
+        }
+
+        req->dg = diagram_stack_find(req->dg_name);
+    }
+}
+
+
 /**
  * main function of the sorting module
  */
@@ -202,6 +409,7 @@ void perform_sorting()
 
     timer_new_entry("sort", "Sorting of integrals");
     timer_start("sort");
+    cc_memory_push_tag("sorting");
 
     printf("\n");
     printf(" Integral sorting for the %dh%dp sector\n", sect_h, sect_p);
@@ -214,23 +422,59 @@ void perform_sorting()
     // для успешно считанных не надо делать reorder (точнее, нельзя!)
     // повторно писать их на диск тоже не нужно
 
+    if (n_requests == 0) {
+        printf(" all integrals required for this sector have been sorted in advance\n");
+        release_integral_sources();
+        cc_memory_pop_tag();
+        timer_stop("sort");
+        return;
+    }
+
     sorting_print_configuration();
 
+    create_templates();
+
+    timer_new_entry("sort_2e", "Sorting of 2-electron integrals");
+    timer_new_entry("sort_1e", "Sorting of 1-electron integrals");
+    timer_new_entry("sort_write", "Sorting: reordering and writing diagrams");
+
     if (cc_opts->int_source == CC_INTEGRALS_DIRAC) {
         if (cc_opts->new_sorting) {
+            timer_start("sort_2e");
             new_sort_2e();
+            timer_stop("sort_2e");
+            timer_start("sort_1e");
             new_sort_1e();
+            timer_stop("sort_1e");
         }
         else {
+            timer_start("sort_2e");
             sort_twoel();
+            timer_stop("sort_2e");
+            timer_start("sort_1e");
             sort_onel();
+            timer_stop("sort_1e");
         }
     }
+    else if (cc_opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        timer_start("sort_2e");
+        sort_twoel();
+        timer_stop("sort_2e");
+        timer_start("sort_1e");
+        sort_synthetic_one_electron();
+        timer_stop("sort_1e");
+    }
     else {
+        timer_start("sort_2e");
         sort_pyscf_two_electron();
+        timer_stop("sort_2e");
+        timer_start("sort_1e");
         sort_pyscf_one_electron();
+        timer_stop("sort_1e");
     }
 
+    timer_start("sort_write");
+
     // только для реально отсортированных в этом запуске запросов!
     // reorder some diagrams (if required)
     for (ireq = 0; ireq < n_requests; ireq++) {
@@ -256,25 +500,33 @@ void perform_sorting()
 
     // write diagrams to disk
     // только реально обработанные запросы!
+    // sorted integrals are not modified anymore and can be mapped into memory
+    // or evicted to disk under memory pressure
     for (ireq = 0; ireq < n_requests; ireq++) {
         char dg_file_name[CC_MAX_PATH_LENGTH];
         req = &sorting_requests[ireq];
         sprintf(dg_file_name, "%s.dg", req->dg_name);
-        diagram_write_binary(diagram_stack_find(req->dg_name), dg_file_name);
+        diagram_t *dg = diagram_stack_find(req->dg_name);
+        // Cholesky blocks are rebuilt and written as in-memory ones,
+        // so that the file can be used with 'reuse 2-integrals'
+        diagram_write_binary(dg, dg_file_name);
+        if (diagram_get_storage_type(dg) != CC_DIAGRAM_CHOLESKY) {
+            sort_cache_store(req);
+        }
+        diagram_set_readonly(dg);
+        diagram_set_evictable(dg);
         //printf("%s ", req->dg_name);
     }
 
+    timer_stop("sort_write");
+
     /*
      * finalize
      */
     n_requests = 0;
-    if (cc_opts->int_source == CC_INTEGRALS_PYSCF) {
-        if (cc_opts->curr_sector_h == cc_opts->sector_h &&
-            cc_opts->curr_sector_p == cc_opts->sector_p) {
-            pyscf_data_free();
-        }
-    }
+    release_integral_sources();
 
+    cc_memory_pop_tag();
     timer_stop("sort");
     //printf("   number of blocks read from disk: %d\n", n_blocks_read);
     //printf("   total number of integrals read from disk: %ld\n", n_integrals_read);
@@ -287,6 +539,12 @@ void perform_sorting()
         printf(" time for DIRAC interface (integral extraction & write), sec: %.2f\n", timer_get("dirac"));
         printf(" total time for sorting operations, sec: %.2f\n", timer_get("dirac") + timer_get("sort"));
     }
+    else if (cc_opts->int_source == CC_INTEGRALS_SYNTHETIC) {
+        printf(" time for sorting of synthetic integrals (generation included), sec: %.2f\n", timer_get("sort"));
+    }
+    else if (cc_opts->int_source == CC_INTEGRALS_DIRAC) {
+        printf(" time for 2-e integrals sorting (MDCINT read directly), sec: %.2f\n", timer_get("sort"));
+    }
     else {
         printf(" time for 2-e integrals sorting, sec: %.2f\n", timer_get("sort"));
         printf(" time for PySCF interface (reading integrals), sec: %.2f\n", timer_get("pyscf"));
@@ -297,3 +555,16 @@ void perform_sorting()
     print_asctime();
 }
 
+
+/*
+ * raw integrals are not required after sorting for the target sector
+ */
+static void release_integral_sources()
+{
+    if (cc_opts->int_source == CC_INTEGRALS_PYSCF) {
+        if (cc_opts->curr_sector_h == cc_opts->sector_h &&
+            cc_opts->curr_sector_p == cc_opts->sector_p) {
+            pyscf_data_free();
+        }
+    }
+}
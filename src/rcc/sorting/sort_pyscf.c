@@ -33,9 +33,12 @@
 
 #include "sorting_request.h"
 
+#include "twoel_buffer.h"
+
 #include "io.h"
 #include "memory.h"
 #include "options.h"
+#include "pyscf_eri.h"
 #include "spinors.h"
 #include "timer.h"
 
@@ -45,32 +48,6 @@ enum {
 };
 
 
-double complex ****allocate_twoel_buffer(size_t dim);
-
-void free_twoel_buffer(size_t dim, double complex ****v_ints);
-
-size_t load_coulomb_block(double complex ****v_ints,
-                          int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
-
-size_t load_gaunt_block(double complex ****v_ints,
-                        int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
-
-size_t load_twoprop_blocks(double complex ****v_ints,
-                           int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
-
-void clear_twoel_buffer(double complex ****v_ints, int spinor_block_1, int spinor_block_2, int spinor_block_3,
-                        int spinor_block_4);
-
-void fill_block_twoelec(block_t *block, int sign, double complex ****v_ints, int direct);
-
-void fill_block_twoelec_complex_direct(block_t *block, int sign, double complex ****v_ints);
-
-void fill_block_twoelec_complex_exchange(block_t *block, int sign, double complex ****v_ints);
-
-void fill_block_twoelec_real_direct(block_t *block, int sign, double complex ****v_ints);
-
-void fill_block_twoelec_real_exchange(block_t *block, int sign, double complex ****v_ints);
-
 int is_pppp_diagram(char *holes_particles, char *valence, char *order);
 
 double complex get_eri(int nspinors, double complex *eris, size_t *eri_index, int p, int q, int r, int s);
@@ -79,8 +56,14 @@ double complex get_eri_goldstone(int nspinors, double complex *eris, int p, int
 
 void fill_block_twoelec_complex_pyscf(block_t *block);
 
+void sort_twoel();
+
 extern double complex *pyscf_unique_eri;
 extern size_t *pyscf_eri_index;
+extern int pyscf_chunked_eri;
+
+// mapped file with integrals in the chunked layout, open during sort_twoel()
+static pyscf_eri_t *pyscf_eri = NULL;
 
 
 void fill_block_one_elec(block_t *block, double complex *ints_matrix, int ignore_diagonal);
@@ -109,24 +92,17 @@ void sort_pyscf_one_electron()
             continue;
         }
 
-        int spinor_blocks_nums[2];
-        spinor_blocks_nums[0] = 0;
-        spinor_blocks_nums[1] = 0;
+        // a single block for the dense layout, tiles for the chunked one
+        for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+            block_t *sb = dg->blocks[isb];
+            if (sb->is_unique == 0) {
+                continue;
+            }
 
-        block_t *sb = diagram_get_block(dg, spinor_blocks_nums);
-        if (sb == NULL) {
-            continue;
-        }
-        if (sb->is_unique == 0) {
-            continue;
+            block_load(sb);
+            fill_block_one_elec(sb, one_electron_ints, 1);
+            block_store(sb);
         }
-
-        // block was found. fill it!
-        block_load(sb);
-
-        fill_block_one_elec(sb, one_electron_ints, 1);
-
-        block_store(sb);
     } // end of loop over requests
 
     cc_free(one_electron_ints);
@@ -140,6 +116,19 @@ void sort_pyscf_two_electron()
         return;
     }
 
+    // chunked layout: the same sorting as for the DIRAC integrals,
+    // quadruples of spinor blocks are gathered from the mapped file
+    if (pyscf_chunked_eri) {
+        pyscf_eri = pyscf_eri_open(cc_opts->integral_file_2);
+        if (pyscf_eri == NULL) {
+            errquit("cannot open file with pyscf 2e integrals '%s'", cc_opts->integral_file_2);
+        }
+        sort_twoel();
+        pyscf_eri_close(pyscf_eri);
+        pyscf_eri = NULL;
+        return;
+    }
+
     for (int ireq = 0; ireq < n_requests; ireq++) {
         sorting_request_t *req = &sorting_requests[ireq];
 
@@ -188,6 +177,8 @@ void sort_pyscf_two_electron()
             printf("begin pppp\n");
 
             block_t *block = dg->blocks[0];
+            block_load(block);
+
             size_t dims_1 = block->shape[0];
             size_t dims_2 = block->shape[1];
             size_t dims_3 = block->shape[2];
@@ -198,13 +189,14 @@ void sort_pyscf_two_electron()
             size_t coef_2 = num_part * num_part;
             size_t coef_3 = num_part;
 
-            const size_t buf_size = 100000000;
+            size_t total_size = dims_1 * dims_2 * dims_3 * dims_4;
+            const size_t max_buf_size = 100000000;
+            size_t buf_size = (total_size < max_buf_size) ? total_size : max_buf_size;
             double complex *buf = cc_calloc(buf_size, sizeof(double complex));
 
             int f_pppp = io_open("../pyscf_pppp.dat", "r");
 
             //size_t index = 0;
-            size_t total_size = dims_1 * dims_2 * dims_3 * dims_4;
             size_t num_remain = total_size;
             size_t index = 0;
 
@@ -247,6 +239,7 @@ void sort_pyscf_two_electron()
             io_close(f_pppp);
 
             cc_free(buf);
+            block_store(block);
 
             printf("end pppp\n");
             continue;
@@ -281,6 +274,27 @@ void sort_pyscf_two_electron()
 }
 
 
+/*
+ * gathers integrals <ij|kl> of the quadruple of spinor blocks from the
+ * mapped file (chunked layout only).
+ * returns number of integrals loaded.
+ */
+size_t load_pyscf_block(twoel_buffer_t *v_ints,
+                        int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
+{
+    int quadruple[4] = {spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4};
+    int *indices[4];
+
+    for (int k = 0; k < 4; k++) {
+        indices[k] = spinor_blocks[quadruple[k]].indices;
+    }
+
+    pyscf_eri_read_quadruple(pyscf_eri, v_ints->dims, indices, v_ints->ints);
+
+    return (size_t) v_ints->dims[0] * v_ints->dims[1] * v_ints->dims[2] * v_ints->dims[3];
+}
+
+
 void fill_block_twoelec_complex_pyscf(block_t *block)
 {
     assert(block->rank == 4);
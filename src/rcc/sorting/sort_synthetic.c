@@ -0,0 +1,149 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Sorting of the synthetic integrals (see interfaces/synthetic_interface.c).
+ *
+ * Two-electron integrals are generated directly into the buffer for the
+ * quadruple of spinor blocks, i.e. they replace the VINT-* files of the
+ * DIRAC interface, the rest of the sorting algorithm is the same
+ * (sort_twoel()). One-electron diagrams are filled with the diagonal
+ * Fock matrix (canonical HF spinors).
+ */
+
+#include "sort.h"
+
+#include <complex.h>
+#include <stdio.h>
+
+#include "sorting_request.h"
+#include "twoel_buffer.h"
+
+#include "interfaces.h"
+#include "memory.h"
+#include "options.h"
+#include "spinors.h"
+
+void fill_block_one_elec(block_t *block, double complex *ints_matrix, int ignore_diagonal);
+
+static int is_block_requested(int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
+
+
+/**
+ * Fills the buffer with integrals <ij|kl> for the given quadruple of spinor
+ * blocks ("local" spinor indices inside the blocks are used, as for the
+ * VINT-* files).
+ * Integrals are generated only if the blocks of any of the diagrams to be
+ * sorted are to be filled from them.
+ * Returns number of integrals generated.
+ */
+size_t load_synthetic_block(twoel_buffer_t *v_ints,
+                            int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
+{
+    if (!is_block_requested(spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4)) {
+        return 0;
+    }
+
+    spinor_block_t *sb_1 = &spinor_blocks[spinor_block_1];
+    spinor_block_t *sb_2 = &spinor_blocks[spinor_block_2];
+    spinor_block_t *sb_3 = &spinor_blocks[spinor_block_3];
+    spinor_block_t *sb_4 = &spinor_blocks[spinor_block_4];
+
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int i = 0; i < sb_1->size; i++) {
+        for (int j = 0; j < sb_2->size; j++) {
+            for (int k = 0; k < sb_3->size; k++) {
+                double complex *v_ijk = v_ints->ints + twoel_buffer_index(v_ints, i, j, k, 0);
+                for (int l = 0; l < sb_4->size; l++) {
+                    v_ijk[l] = synthetic_eri(sb_1->indices[i], sb_2->indices[j],
+                                             sb_3->indices[k], sb_4->indices[l]);
+                }
+            }
+        }
+    }
+
+    return (size_t) sb_1->size * sb_2->size * sb_3->size * sb_4->size;
+}
+
+
+void sort_synthetic_one_electron()
+{
+    int nspinors = get_num_spinors();
+    double complex *f_ints = (double complex *) cc_calloc(nspinors * nspinors, sizeof(double complex));
+
+    for (int i = 0; i < nspinors; i++) {
+        f_ints[i * nspinors + i] = spinor_info[i].eps;
+    }
+
+    printf(" fill 1-electron diagrams ... ");
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        diagram_t *dg = sorting_requests[ireq].dg;
+        if (dg->rank != 2) { // only one-electron diagrams
+            continue;
+        }
+        printf("%s ", dg->name);
+
+        for (size_t isb = 0; isb < dg->n_blocks; isb++) {
+            block_t *block = dg->blocks[isb];
+            block_load(block);
+            int ignore_diagonal = cc_opts->use_oe ? 0 : 1;
+            fill_block_one_elec(block, f_ints, ignore_diagonal);
+            block_unload(block);
+        }
+    }
+    printf("done\n");
+
+    cc_free(f_ints);
+}
+
+
+/*
+ * checks if any of the two-electron diagrams to be sorted has the unique
+ * block which is filled from the given quadruple of spinor blocks
+ * (directly or as an exchange contribution, see sort_twoel())
+ */
+static int is_block_requested(int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4)
+{
+    int direct_nums[4] = {spinor_block_1, spinor_block_2, spinor_block_3, spinor_block_4};
+    int exchange_nums[4] = {spinor_block_1, spinor_block_2, spinor_block_4, spinor_block_3};
+
+    for (int ireq = 0; ireq < n_requests; ireq++) {
+        diagram_t *dg = sorting_requests[ireq].dg;
+        if (dg->rank != 4) {
+            continue;
+        }
+
+        block_t *direct = diagram_get_block(dg, direct_nums);
+        block_t *exchange = diagram_get_block(dg, exchange_nums);
+        if ((direct && direct->is_unique) || (exchange && exchange->is_unique)) {
+            return 1;
+        }
+
+        // the Cholesky decomposition reads all the quadruples of pppp (see sort_cholesky.c)
+        if (direct && diagram_get_storage_type(dg) == CC_DIAGRAM_CHOLESKY) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -24,23 +24,33 @@
 #include <string.h>
 
 #include "sorting_request.h"
+#include "options.h"
 
 sorting_request_t sorting_requests[CC_MAX_SORTING_REQUESTS];
 int n_requests = 0;
 
 
+/*
+ * NOTE: the template of the diagram is created later (by perform_sorting()),
+ * so req->dg is NULL until then
+ */
 sorting_request_t *append_sorting_request(sorting_request_t *requests, int *num_requests,
-                                          char *name, char *qparts, char *valence, char *order)
+                                          char *name, char *qparts, char *valence, char *order,
+                                          int operator_symmetry)
 {
     sorting_request_t *req;
 
     req = sorting_requests + (*num_requests);
-    req->dg = diagram_stack_find(name);
+    req->dg = NULL;
     strcpy(req->dg_name, name);
     strcpy(req->hp, qparts);
     strcpy(req->valence, valence);
     strcpy(req->order, order);
+    req->rank = strlen(qparts);
+    req->operator_symmetry = operator_symmetry;
     req->done = 0;
+    req->sect_h = cc_opts->curr_sector_h;
+    req->sect_p = cc_opts->curr_sector_p;
 
     *num_requests = *num_requests + 1;
     return req;
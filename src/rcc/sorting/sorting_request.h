@@ -26,7 +26,7 @@
 
 #include "engine.h"
 
-#define CC_MAX_SORTING_REQUESTS 64
+#define CC_MAX_SORTING_REQUESTS 256
 
 typedef struct {
     diagram_t *dg;
@@ -34,7 +34,11 @@ typedef struct {
     char hp[CC_DIAGRAM_MAX_RANK];
     char valence[CC_DIAGRAM_MAX_RANK];
     char order[CC_DIAGRAM_MAX_RANK];
+    int rank;
+    int operator_symmetry;
     int done;
+    int sect_h;    // Fock space sector which requested the diagram
+    int sect_p;
 } sorting_request_t;
 
 extern sorting_request_t sorting_requests[CC_MAX_SORTING_REQUESTS];
@@ -43,6 +47,7 @@ extern int n_requests;
 int num_twoelec_requests(sorting_request_t *requests, int num_requests);
 
 sorting_request_t *append_sorting_request(sorting_request_t *requests, int *num_requests,
-                                          char *name, char *qparts, char *valence, char *order);
+                                          char *name, char *qparts, char *valence, char *order,
+                                          int operator_symmetry);
 
 #endif /* CC_SORTING_REQUEST_H_INCLUDED */
@@ -0,0 +1,69 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Staging buffer for two-electron integrals of one quadruple of spinor
+ * blocks (sb1,sb2,sb3,sb4): a contiguous aligned array v[i][j][k][l] with
+ * dimensions equal to the sizes of the spinor blocks. Indices are local
+ * (within the spinor block, see spinor_index_global2local).
+ */
+
+#ifndef CC_TWOEL_BUFFER_H_INCLUDED
+#define CC_TWOEL_BUFFER_H_INCLUDED
+
+#include <complex.h>
+#include <stddef.h>
+
+#define CC_TWOEL_BUFFER_ALIGNMENT 64
+
+typedef struct {
+    double complex *ints;    // aligned, points into 'mem'
+    void *mem;
+    size_t capacity;         // number of elements allocated
+    int dims[4];             // sizes of spinor blocks of the current quadruple
+} twoel_buffer_t;
+
+static inline size_t twoel_buffer_index(twoel_buffer_t *buf, int i, int j, int k, int l)
+{
+    return (((size_t) i * buf->dims[1] + j) * buf->dims[2] + k) * buf->dims[3] + l;
+}
+
+twoel_buffer_t *allocate_twoel_buffer();
+
+void free_twoel_buffer(twoel_buffer_t *v_ints);
+
+void clear_twoel_buffer(twoel_buffer_t *v_ints, int spinor_block_1, int spinor_block_2, int spinor_block_3,
+                        int spinor_block_4);
+
+size_t load_synthetic_block(twoel_buffer_t *v_ints,
+                            int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
+
+size_t load_pyscf_block(twoel_buffer_t *v_ints,
+                        int spinor_block_1, int spinor_block_2, int spinor_block_3, int spinor_block_4);
+
+size_t load_twoel_quadruple(twoel_buffer_t *v_ints, int spinor_block_1, int spinor_block_2,
+                            int spinor_block_3, int spinor_block_4);
+
+int get_num_sorting_threads(size_t twoel_buf_size);
+
+#endif /* CC_TWOEL_BUFFER_H_INCLUDED */
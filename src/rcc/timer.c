@@ -22,7 +22,7 @@
  */
 
 /*
- * Utility for time measurements.
+ * Utility for time measurements (hierarchical profiler).
  *
  * Example of usage:
  *   timer_new_entry("fock", "Fock matrix construction");
@@ -30,6 +30,17 @@
  *   . . . some code . . .
  *   time_stop("fock");
  *   timer_stats();  // print statistics
+ *
+ * Keys are interned: each key is assigned a handle (index in the table of
+ * entries) found by the hash table lookup, so timer_start()/timer_stop() take
+ * O(1) time. Handles can also be used directly (timer_start_handle()).
+ *
+ * Each thread has its own profile: the call tree of timer regions (a region
+ * started while another one is running becomes its child) and flat per-entry
+ * totals. For each node of the call tree the number of calls, min/max/total
+ * (inclusive) time and the number of FLOPs and bytes processed are collected;
+ * exclusive time is the inclusive time minus the inclusive times of children.
+ * Profiles of all threads are merged when statistics are printed.
  */
 
 #include <string.h>
@@ -39,23 +50,74 @@
 
 #include "platform.h"
 #include "error.h"
+#include "memory.h"
 #include "timer.h"
+#include "trace.h"
 
 #define TIMER_MAX_LABEL   64
 #define TIMER_MAX_KEY     64
-#define TIMER_MAX_ENTRIES 64
+#define TIMER_MAX_ENTRIES 256
+#define TIMER_HASH_SIZE   1024
+#define TIMER_MAX_DEPTH   64
+#define TIMER_MAX_THREADS 1024
 
 struct timer_entry {
     char key[TIMER_MAX_KEY];      // simple identifier for the entry
     char label[TIMER_MAX_LABEL];  // comment for the entry
-    int on;           // is timer "running"
-    double total;     // summarized time from all previous measurements
-    double t0;        // absolute time of the current starting point
 };
 typedef struct timer_entry timer_entry_t;
 
+// node of the call tree
+typedef struct timer_node {
+    timer_handle_t entry;
+    struct timer_node *parent;
+    struct timer_node *first_child;
+    struct timer_node *next_sibling;
+    size_t n_calls;
+    double total;     // inclusive time from all previous measurements
+    double min;
+    double max;
+    double t0;        // absolute time of the current starting point
+    double flops;
+    double bytes;
+} timer_node_t;
+
+// profile of the thread
+typedef struct {
+    timer_node_t root;
+    timer_node_t *stack[TIMER_MAX_DEPTH];  // running regions
+    int depth;
+    // flat statistics (per entry, nested calls of the same entry are not counted)
+    double flat_total[TIMER_MAX_ENTRIES];
+    double flat_t0[TIMER_MAX_ENTRIES];
+    int flat_depth[TIMER_MAX_ENTRIES];
+} timer_profile_t;
+
 static timer_entry_t timer_entries[TIMER_MAX_ENTRIES];
 static int n_entries = 0;
+static int hash_table[TIMER_HASH_SIZE];   // (handle + 1), 0 = empty slot
+
+static __thread timer_profile_t *thread_profile = NULL;
+static timer_profile_t *all_profiles[TIMER_MAX_THREADS];
+static int n_profiles = 0;
+
+static timer_handle_t timer_lookup(char *key);
+
+static unsigned int hash_key(char *key);
+
+static timer_profile_t *get_profile();
+
+static timer_node_t *find_child(timer_node_t *parent, timer_handle_t entry, int create);
+
+static void merge_tree(timer_node_t *dst, timer_node_t *src);
+
+static void delete_tree(timer_node_t *node);
+
+static void print_tree(timer_node_t *node, int level);
+
+static void write_tree_json(FILE *f, timer_node_t *node, int level);
+
+static double children_time(timer_node_t *node);
 
 
 /**
@@ -64,38 +126,73 @@ static int n_entries = 0;
  */
 void timer_new_entry(char *key, char *label)
 {
-    int i;
+    timer_intern(key, label);
+}
 
-    for (i = 0; i < n_entries; i++) {
-        // found old entry
-        if (strncmp(timer_entries[i].key, key, TIMER_MAX_KEY) == 0) {
-            return;
-        }
-    }
 
-    // create new entry
-    if (n_entries == TIMER_MAX_ENTRIES) {
-        errquit("max number of timer entries exceeded (see macro TIMER_MAX_ENTRIES in src/util/timer.c)");
+/**
+ * Returns handle of the entry with mnemonic name 'key'. The entry is
+ * created if it does not exist yet.
+ */
+timer_handle_t timer_intern(char *key, char *label)
+{
+    timer_handle_t h = timer_lookup(key);
+    if (h >= 0) {
+        return h;
     }
 
-    strncpy(timer_entries[n_entries].key, key, TIMER_MAX_KEY);
-    timer_entries[n_entries].key[TIMER_MAX_KEY - 1] = '\0';
-    strncpy(timer_entries[n_entries].label, label, TIMER_MAX_LABEL);
-    timer_entries[n_entries].label[TIMER_MAX_LABEL - 1] = '\0';
-    timer_entries[n_entries].on = 0;
-    timer_entries[n_entries].t0 = 0.0;
-    timer_entries[n_entries].total = 0.0;
+    #pragma omp critical (timer_entries)
+    {
+        h = timer_lookup(key);
+        if (h < 0) {
+            if (n_entries == TIMER_MAX_ENTRIES) {
+                errquit("max number of timer entries exceeded (see macro TIMER_MAX_ENTRIES in src/rcc/timer.c)");
+            }
 
-    n_entries++;
+            h = n_entries;
+            strncpy(timer_entries[h].key, key, TIMER_MAX_KEY);
+            timer_entries[h].key[TIMER_MAX_KEY - 1] = '\0';
+            strncpy(timer_entries[h].label, label, TIMER_MAX_LABEL);
+            timer_entries[h].label[TIMER_MAX_LABEL - 1] = '\0';
+            n_entries++;
+
+            // publish the entry only when it is filled
+            #pragma omp flush
+            unsigned int slot = hash_key(timer_entries[h].key);
+            while (hash_table[slot] != 0) {
+                slot = (slot + 1) % TIMER_HASH_SIZE;
+            }
+            hash_table[slot] = h + 1;
+            #pragma omp flush
+        }
+    }
+
+    return h;
 }
 
 
 /**
- * Remove all timer entries.
+ * Remove all timer entries and statistics.
  */
 void timer_clear_all()
 {
-    n_entries = 0;
+    #pragma omp critical (timer_entries)
+    {
+        for (int i = 0; i < n_profiles; i++) {
+            timer_profile_t *p = all_profiles[i];
+            for (timer_node_t *child = p->root.first_child; child != NULL;) {
+                timer_node_t *next = child->next_sibling;
+                delete_tree(child);
+                child = next;
+            }
+            p->root.first_child = NULL;
+            p->depth = 0;
+            memset(p->flat_total, 0, sizeof(p->flat_total));
+            memset(p->flat_depth, 0, sizeof(p->flat_depth));
+        }
+        memset(hash_table, 0, sizeof(hash_table));
+        n_entries = 0;
+    }
 }
 
 
@@ -104,18 +201,14 @@ void timer_clear_all()
  */
 void timer_start(char *key)
 {
-    int i;
+    timer_handle_t h = timer_lookup(key);
 
-    for (i = 0; i < n_entries; i++) {
-        if (strncmp(timer_entries[i].key, key, TIMER_MAX_KEY) == 0) {
-            timer_entries[i].on = 1;
-            timer_entries[i].t0 = abs_time();
-            return;
-        }
+    if (h < 0) {
+        printf("key: %s\n", key);
+        errquit("unknown timer!");
     }
 
-    printf("key: %s\n", key);
-    errquit("unknown timer!");
+    timer_start_handle(h);
 }
 
 
@@ -125,56 +218,230 @@ void timer_start(char *key)
  */
 void timer_stop(char *key)
 {
-    int i;
+    timer_handle_t h = timer_lookup(key);
+
+    if (h < 0) {
+        printf("key: %s\n", key);
+        errquit("unknown timer!");
+    }
+
+    timer_stop_handle(h);
+}
+
+
+/**
+ * Begin time measurement for the entry 'h'. The new region becomes a child of
+ * the innermost running region of the calling thread.
+ * Restart of the running entry resets its starting point.
+ */
+void timer_start_handle(timer_handle_t h)
+{
+    timer_profile_t *p = get_profile();
+    double t = abs_time();
 
-    for (i = 0; i < n_entries; i++) {
-        if (strncmp(timer_entries[i].key, key, TIMER_MAX_KEY) == 0) {
-            timer_entries[i].on = 0;
-            timer_entries[i].total += abs_time() - timer_entries[i].t0;
-            return;
+    // restart
+    if (p->flat_depth[h] > 0) {
+        for (int i = p->depth - 1; i >= 0; i--) {
+            if (p->stack[i]->entry == h) {
+                p->stack[i]->t0 = t;
+                p->flat_t0[h] = t;
+                return;
+            }
         }
     }
 
-    printf("key: %s\n", key);
-    errquit("unknown timer!");
+    if (p->depth == TIMER_MAX_DEPTH) {
+        errquit("max depth of nested timers exceeded (see macro TIMER_MAX_DEPTH in src/rcc/timer.c)");
+    }
+
+    timer_node_t *parent = (p->depth > 0) ? p->stack[p->depth - 1] : &p->root;
+    timer_node_t *node = find_child(parent, h, 1);
+    node->t0 = t;
+    p->stack[p->depth] = node;
+    p->depth++;
+
+    if (p->flat_depth[h] == 0) {
+        p->flat_t0[h] = t;
+    }
+    p->flat_depth[h]++;
 }
 
 
 /**
- * Returns total time elapsed for the entry with mnemonic name 'key'.
+ * Stop time measurement for the entry 'h'.
+ * Regions are not required to be strictly nested: the innermost running
+ * region with the entry 'h' is stopped.
  */
-double timer_get(char *key)
+void timer_stop_handle(timer_handle_t h)
 {
-    int i;
+    timer_profile_t *p = get_profile();
+    double t = abs_time();
+    int pos = -1;
 
-    for (i = 0; i < n_entries; i++) {
-        if (strncmp(timer_entries[i].key, key, TIMER_MAX_KEY) == 0) {
-            return timer_entries[i].total;
+    for (int i = p->depth - 1; i >= 0; i--) {
+        if (p->stack[i]->entry == h) {
+            pos = i;
+            break;
         }
     }
+    if (pos == -1) {
+        // not running
+        return;
+    }
 
-    printf("key: %s\n", key);
-    errquit("unknown timer!");
+    timer_node_t *node = p->stack[pos];
+    double dt = t - node->t0;
+    if (node->n_calls == 0 || dt < node->min) {
+        node->min = dt;
+    }
+    if (node->n_calls == 0 || dt > node->max) {
+        node->max = dt;
+    }
+    node->total += dt;
+    node->n_calls++;
+
+    if (cc_trace_enabled) {
+        trace_event("region", timer_entries[h].key, NULL, node->t0, t, 0, 0.0);
+    }
+
+    for (int i = pos; i < p->depth - 1; i++) {
+        p->stack[i] = p->stack[i + 1];
+    }
+    p->depth--;
+
+    p->flat_depth[h]--;
+    if (p->flat_depth[h] == 0) {
+        p->flat_total[h] += t - p->flat_t0[h];
+    }
+}
+
+
+/**
+ * Attaches the number of floating-point operations to the innermost running
+ * region of the calling thread.
+ */
+void timer_add_flops(double n_flops)
+{
+    timer_profile_t *p = get_profile();
+    timer_node_t *node = (p->depth > 0) ? p->stack[p->depth - 1] : &p->root;
+    node->flops += n_flops;
+}
+
+
+/**
+ * Attaches the number of bytes processed to the innermost running region of
+ * the calling thread.
+ */
+void timer_add_bytes(double n_bytes)
+{
+    timer_profile_t *p = get_profile();
+    timer_node_t *node = (p->depth > 0) ? p->stack[p->depth - 1] : &p->root;
+    node->bytes += n_bytes;
+}
+
+
+/**
+ * Returns total time elapsed for the entry with mnemonic name 'key'
+ * (in the calling thread).
+ */
+double timer_get(char *key)
+{
+    timer_handle_t h = timer_lookup(key);
+
+    if (h < 0) {
+        printf("key: %s\n", key);
+        errquit("unknown timer!");
+    }
+
+    return get_profile()->flat_total[h];
 }
 
 
 /**
- * Prints table with time statistics for all entries.
+ * Prints table with time statistics for all entries
+ * and the call tree (profiles of all threads are merged).
  */
 void timer_stats()
 {
-    int i;
-    double total = 0.0;
+    timer_profile_t *p = get_profile();
 
     printf("\n");
     printf(" time for (sec):\n");
     printf(" -------------------------------------------------------\n");
-    for (i = 0; i < n_entries; i++) {
-        printf("  %-40s%13.3f\n", timer_entries[i].label, timer_entries[i].total);
-        total += timer_entries[i].total;
+    for (int i = 0; i < n_entries; i++) {
+        printf("  %-40s%13.3f\n", timer_entries[i].label, p->flat_total[i]);
     }
     printf(" -------------------------------------------------------\n");
     printf("\n");
+
+    timer_node_t merged;
+    memset(&merged, 0, sizeof(timer_node_t));
+    for (int i = 0; i < n_profiles; i++) {
+        merge_tree(&merged, &all_profiles[i]->root);
+    }
+
+    printf(" call tree (sec), %d thread(s):\n", n_profiles);
+    printf(" ------------------------------------------------------------------------------------------------------------------\n");
+    printf("  %-30s%10s%12s%12s%11s%11s%11s%10s%10s\n",
+           "region", "calls", "incl", "excl", "min", "max", "mean", "GFLOP", "GB");
+    printf(" ------------------------------------------------------------------------------------------------------------------\n");
+    for (timer_node_t *child = merged.first_child; child != NULL; child = child->next_sibling) {
+        print_tree(child, 0);
+    }
+    printf(" ------------------------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+
+    for (timer_node_t *child = merged.first_child; child != NULL;) {
+        timer_node_t *next = child->next_sibling;
+        delete_tree(child);
+        child = next;
+    }
+}
+
+
+/**
+ * Writes the summary of the profile (flat statistics and the call tree)
+ * to the file in the JSON format.
+ */
+void timer_write_json(char *path)
+{
+    timer_profile_t *p = get_profile();
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        printf(" timer_write_json(): unable to open file '%s'\n", path);
+        return;
+    }
+
+    timer_node_t merged;
+    memset(&merged, 0, sizeof(timer_node_t));
+    for (int i = 0; i < n_profiles; i++) {
+        merge_tree(&merged, &all_profiles[i]->root);
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"n_threads\": %d,\n", n_profiles);
+    fprintf(f, "  \"timers\": [\n");
+    for (int i = 0; i < n_entries; i++) {
+        fprintf(f, "    {\"key\": \"%s\", \"label\": \"%s\", \"total\": %.6f}%s\n",
+                timer_entries[i].key, timer_entries[i].label, p->flat_total[i], (i < n_entries - 1) ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+    fprintf(f, "  \"call_tree\": [\n");
+    for (timer_node_t *child = merged.first_child; child != NULL; child = child->next_sibling) {
+        write_tree_json(f, child, 2);
+        fprintf(f, "%s\n", child->next_sibling ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    fclose(f);
+
+    for (timer_node_t *child = merged.first_child; child != NULL;) {
+        timer_node_t *next = child->next_sibling;
+        delete_tree(child);
+        child = next;
+    }
 }
 
 
@@ -187,3 +454,177 @@ double abs_time()
     gettimeofday(&cur_time, NULL);
     return (cur_time.tv_sec * 1000000u + cur_time.tv_usec) / 1.e6;
 }
+
+
+/*
+ * returns handle of the entry or -1 if not found
+ */
+static timer_handle_t timer_lookup(char *key)
+{
+    unsigned int slot = hash_key(key);
+
+    while (hash_table[slot] != 0) {
+        timer_handle_t h = hash_table[slot] - 1;
+        if (strncmp(timer_entries[h].key, key, TIMER_MAX_KEY - 1) == 0) {
+            return h;
+        }
+        slot = (slot + 1) % TIMER_HASH_SIZE;
+    }
+
+    return -1;
+}
+
+
+// FNV-1a
+static unsigned int hash_key(char *key)
+{
+    unsigned int h = 2166136261u;
+
+    for (int i = 0; key[i] != '\0' && i < TIMER_MAX_KEY - 1; i++) {
+        h ^= (unsigned char) key[i];
+        h *= 16777619u;
+    }
+
+    return h % TIMER_HASH_SIZE;
+}
+
+
+static timer_profile_t *get_profile()
+{
+    if (thread_profile != NULL) {
+        return thread_profile;
+    }
+
+    timer_profile_t *p = (timer_profile_t *) cc_calloc(1, sizeof(timer_profile_t));
+    p->root.entry = -1;
+
+    #pragma omp critical (timer_profiles)
+    {
+        if (n_profiles == TIMER_MAX_THREADS) {
+            errquit("get_profile(): too many threads (> %d)", TIMER_MAX_THREADS);
+        }
+        all_profiles[n_profiles] = p;
+        n_profiles++;
+    }
+
+    thread_profile = p;
+    return p;
+}
+
+
+static timer_node_t *find_child(timer_node_t *parent, timer_handle_t entry, int create)
+{
+    timer_node_t *last = NULL;
+
+    for (timer_node_t *child = parent->first_child; child != NULL; child = child->next_sibling) {
+        if (child->entry == entry) {
+            return child;
+        }
+        last = child;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    timer_node_t *node = (timer_node_t *) cc_calloc(1, sizeof(timer_node_t));
+    node->entry = entry;
+    node->parent = parent;
+
+    // children are kept in order of creation
+    if (last == NULL) {
+        parent->first_child = node;
+    }
+    else {
+        last->next_sibling = node;
+    }
+
+    return node;
+}
+
+
+/*
+ * adds statistics of all children of 'src' to children of 'dst'
+ */
+static void merge_tree(timer_node_t *dst, timer_node_t *src)
+{
+    for (timer_node_t *child = src->first_child; child != NULL; child = child->next_sibling) {
+        timer_node_t *node = find_child(dst, child->entry, 1);
+        if (node->n_calls == 0 || (child->n_calls > 0 && child->min < node->min)) {
+            node->min = child->min;
+        }
+        if (child->max > node->max) {
+            node->max = child->max;
+        }
+        node->n_calls += child->n_calls;
+        node->total += child->total;
+        node->flops += child->flops;
+        node->bytes += child->bytes;
+        merge_tree(node, child);
+    }
+}
+
+
+static void delete_tree(timer_node_t *node)
+{
+    for (timer_node_t *child = node->first_child; child != NULL;) {
+        timer_node_t *next = child->next_sibling;
+        delete_tree(child);
+        child = next;
+    }
+    cc_free(node);
+}
+
+
+static double children_time(timer_node_t *node)
+{
+    double t = 0.0;
+
+    for (timer_node_t *child = node->first_child; child != NULL; child = child->next_sibling) {
+        t += child->total;
+    }
+
+    return t;
+}
+
+
+static void print_tree(timer_node_t *node, int level)
+{
+    char name[TIMER_MAX_KEY + 2 * TIMER_MAX_DEPTH];
+    double excl = node->total - children_time(node);
+    double mean = (node->n_calls > 0) ? node->total / node->n_calls : 0.0;
+
+    sprintf(name, "%*s%s", 2 * level, "", timer_entries[node->entry].key);
+    printf("  %-30s%10ld%12.3f%12.3f%11.3f%11.3f%11.3f%10.1f%10.2f\n", name, node->n_calls,
+           node->total, excl > 0.0 ? excl : 0.0, node->min, node->max, mean, node->flops * 1e-9,
+           node->bytes / (1024.0 * 1024.0 * 1024.0));
+
+    for (timer_node_t *child = node->first_child; child != NULL; child = child->next_sibling) {
+        print_tree(child, level + 1);
+    }
+}
+
+
+static void write_tree_json(FILE *f, timer_node_t *node, int level)
+{
+    double excl = node->total - children_time(node);
+    double mean = (node->n_calls > 0) ? node->total / node->n_calls : 0.0;
+    int indent = 2 * level;
+
+    fprintf(f, "%*s{\"key\": \"%s\", \"calls\": %ld, \"inclusive\": %.6f, \"exclusive\": %.6f, "
+               "\"min\": %.6f, \"max\": %.6f, \"mean\": %.6f, \"flops\": %.0f, \"bytes\": %.0f",
+            indent, "", timer_entries[node->entry].key, node->n_calls, node->total, excl > 0.0 ? excl : 0.0,
+            node->min, node->max, mean, node->flops, node->bytes);
+
+    if (node->first_child == NULL) {
+        fprintf(f, "}");
+        return;
+    }
+
+    fprintf(f, ", \"children\": [\n");
+    for (timer_node_t *child = node->first_child; child != NULL; child = child->next_sibling) {
+        write_tree_json(f, child, level + 1);
+        fprintf(f, "%s\n", child->next_sibling ? "," : "");
+    }
+    fprintf(f, "%*s]}", indent, "");
+}
@@ -0,0 +1,269 @@
+/*
+ *  EXP-T -- A Relativistic Fock-Space Multireference Coupled Cluster Program
+ *  Copyright (C) 2018-2025 The EXP-T developers.
+ *
+ *  This file is part of EXP-T.
+ *
+ *  EXP-T is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EXP-T is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with EXP-T.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  E-mail:        exp-t-program@googlegroups.com
+ *  Google Groups: https://groups.google.com/d/forum/exp-t-program
+ */
+
+/*
+ * Timeline of engine activity in the Chrome trace-event format (see trace.h).
+ *
+ * Events are stored as "complete" events (ph = 'X': begin time + duration),
+ * thus timer regions are not required to be strictly nested. The file is
+ * opened when tracing is enabled; a thread appends its buffer to the file
+ * when the buffer is full, so no events are lost in long runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "omp.h"
+
+#include "error.h"
+#include "timer.h"
+#include "trace.h"
+
+#define TRACE_BUFFER_SIZE 32768   // number of events per thread
+#define TRACE_MAX_NAME    32
+#define TRACE_MAX_ARGS    64
+#define TRACE_MAX_PATH    1024
+
+typedef struct {
+    const char *category;        // must be a string literal
+    char name[TRACE_MAX_NAME];
+    char args[TRACE_MAX_ARGS];   // names of diagrams
+    double ts;                   // begin time, microseconds from the start of tracing
+    double dur;                  // duration, microseconds
+    size_t size;
+    double n_bytes;
+} trace_record_t;
+
+typedef struct trace_buffer {
+    int tid;
+    int omp_thread_num;
+    size_t n_events;             // number of events in the buffer
+    trace_record_t *events;
+    struct trace_buffer *next;
+} trace_buffer_t;
+
+int cc_trace_enabled = 0;
+int cc_trace_blocks = 0;
+
+static double trace_t0 = 0.0;
+static char trace_path[TRACE_MAX_PATH] = "trace.json";
+
+// output file, accessed only inside the 'cc_trace' critical section
+static FILE *trace_file = NULL;
+static size_t n_written = 0;
+static size_t n_flushes = 0;
+
+// list of per-thread buffers
+static trace_buffer_t *buffers = NULL;
+static int n_buffers = 0;
+
+static __thread trace_buffer_t *thread_buffer = NULL;
+
+static trace_buffer_t *get_thread_buffer();
+
+static void flush_buffer(trace_buffer_t *buf);
+
+static void write_json_string(FILE *f, const char *s);
+
+
+/**
+ * Enables tracing. Events will be written to the file 'path'
+ * (if path is NULL or "1", to "trace.json" in the scratch directory).
+ * Events of individual blocks (block kernels, block i/o) are recorded only
+ * if 'with_blocks' is set, otherwise the timeline contains coarse spans
+ * (timer regions and engine operations).
+ */
+void trace_enable(char *path, int with_blocks)
+{
+    if (path != NULL && *path != '\0' && strcmp(path, "1") != 0) {
+        strncpy(trace_path, path, TRACE_MAX_PATH - 1);
+        trace_path[TRACE_MAX_PATH - 1] = '\0';
+    }
+
+    trace_file = fopen(trace_path, "w");
+    if (trace_file == NULL) {
+        errquit("cannot open file '%s' for the trace", trace_path);
+    }
+    fprintf(trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    trace_t0 = abs_time();
+    cc_trace_enabled = 1;
+    cc_trace_blocks = with_blocks;
+}
+
+
+/**
+ * Records the event [t_begin, t_end] to the buffer of the calling thread.
+ * 'category' must be a string literal, 'args' (names of diagrams) can be NULL.
+ * The full buffer is written to the file (the flush is recorded as an event
+ * of its own).
+ */
+void trace_event(const char *category, const char *name, const char *args,
+                 double t_begin, double t_end, size_t size, double n_bytes)
+{
+    trace_buffer_t *buf = get_thread_buffer();
+
+    if (buf->n_events == TRACE_BUFFER_SIZE) {
+        double t_flush = abs_time();
+        flush_buffer(buf);
+        trace_event("trace", "trace_flush", NULL, t_flush, abs_time(), 0, 0.0);
+    }
+
+    trace_record_t *rec = &buf->events[buf->n_events];
+
+    rec->category = category;
+    strncpy(rec->name, name, TRACE_MAX_NAME - 1);
+    rec->name[TRACE_MAX_NAME - 1] = '\0';
+    if (args != NULL) {
+        strncpy(rec->args, args, TRACE_MAX_ARGS - 1);
+        rec->args[TRACE_MAX_ARGS - 1] = '\0';
+    }
+    else {
+        rec->args[0] = '\0';
+    }
+    rec->ts = (t_begin - trace_t0) * 1e6;
+    rec->dur = (t_end - t_begin) * 1e6;
+    rec->size = size;
+    rec->n_bytes = n_bytes;
+
+    buf->n_events++;
+}
+
+
+/**
+ * Writes events remaining in the buffers of all threads and closes the file.
+ * Must be called outside parallel regions.
+ */
+void trace_write_json()
+{
+    if (!cc_trace_enabled) {
+        return;
+    }
+
+    for (trace_buffer_t *buf = buffers; buf != NULL; buf = buf->next) {
+        flush_buffer(buf);
+    }
+
+    fprintf(trace_file, "\n]}\n");
+    fclose(trace_file);
+    trace_file = NULL;
+    cc_trace_enabled = 0;
+    cc_trace_blocks = 0;
+
+    printf(" trace of %d threads written to %s (%ld events", n_buffers, trace_path, n_written);
+    if (n_flushes > 0) {
+        printf(", buffers were flushed %ld times during the run", n_flushes);
+    }
+    printf(")\n");
+}
+
+
+/*
+ * returns the buffer of the calling thread, allocates it on the first call.
+ * the lock is taken only once per thread.
+ */
+static trace_buffer_t *get_thread_buffer()
+{
+    if (thread_buffer != NULL) {
+        return thread_buffer;
+    }
+
+    trace_buffer_t *buf = (trace_buffer_t *) malloc(sizeof(trace_buffer_t));
+    buf->events = (trace_record_t *) malloc(sizeof(trace_record_t) * TRACE_BUFFER_SIZE);
+    if (buf->events == NULL) {
+        errquit("cannot allocate the trace buffer (%ld bytes)", sizeof(trace_record_t) * TRACE_BUFFER_SIZE);
+    }
+    buf->n_events = 0;
+    buf->omp_thread_num = omp_get_thread_num();
+    buf->next = NULL;
+
+    #pragma omp critical (cc_trace)
+    {
+        buf->tid = n_buffers++;
+
+        // append to the end of list: the master thread goes first
+        trace_buffer_t **tail = &buffers;
+        while (*tail != NULL) {
+            tail = &(*tail)->next;
+        }
+        *tail = buf;
+
+        // thread name
+        fprintf(trace_file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"name\":\"thread %d (omp %d)\"}}",
+                (buf->tid == 0) ? "" : ",\n", buf->tid, buf->tid, buf->omp_thread_num);
+    }
+
+    thread_buffer = buf;
+    return buf;
+}
+
+
+/*
+ * appends events of the buffer to the file and empties the buffer
+ */
+static void flush_buffer(trace_buffer_t *buf)
+{
+    #pragma omp critical (cc_trace)
+    {
+        for (size_t i = 0; i < buf->n_events; i++) {
+            trace_record_t *rec = &buf->events[i];
+            fprintf(trace_file, ",\n{\"name\":");
+            write_json_string(trace_file, rec->name);
+            fprintf(trace_file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{",
+                    rec->category, rec->ts, rec->dur, buf->tid);
+            fprintf(trace_file, "\"size\":%zu,\"bytes\":%.0f", rec->size, rec->n_bytes);
+            if (rec->args[0] != '\0') {
+                fprintf(trace_file, ",\"diagrams\":");
+                write_json_string(trace_file, rec->args);
+            }
+            fprintf(trace_file, "}}");
+        }
+        n_written += buf->n_events;
+        if (buf->n_events == TRACE_BUFFER_SIZE) {
+            n_flushes++;
+        }
+    }
+
+    buf->n_events = 0;
+}
+
+
+static void write_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', f);
+            fputc(*s, f);
+        }
+        else if ((unsigned char) *s < 0x20) {
+            fputc(' ', f);
+        }
+        else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
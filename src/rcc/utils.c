@@ -436,3 +436,20 @@ int int_array_to_str(int n, const int *array, char *str)
 
     return 0;
 }
+
+
+/**
+ * 64-bit FNV-1a hash of 'count' bytes; 'h' is the hash of the preceding data
+ * (or FNV1A_OFFSET_BASIS at the beginning)
+ */
+uint64_t fnv1a_hash(uint64_t h, const void *data, size_t count)
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    for (size_t i = 0; i < count; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
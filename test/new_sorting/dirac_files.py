@@ -0,0 +1,116 @@
+#
+# Writes a small model system in the format of DIRAC's unformatted
+# MRCONEE and MDCINT files (4-byte integers, spinfree, C1 double group).
+#
+# Spatial orbitals get random real integrals (pq|rs) with the 8-fold
+# permutational symmetry; every orbital gives one Kramers pair of spinors.
+# MDCINT holds the records (ikr jkr|kkr lkr) for ikr >= jkr and unbarred
+# indices only, the rest is restored by the Kramers and spinfree symmetries.
+# The one-electron matrix is chosen so that the Fock matrix is diagonal.
+#
+
+import math
+import random
+import struct
+
+
+def fortran_record(f, data):
+    f.write(struct.pack('<i', len(data)))
+    f.write(data)
+    f.write(struct.pack('<i', len(data)))
+
+
+def spatial_integrals(n, eps, scale, decay, seed):
+    rnd = random.Random(seed)
+    ints = {}
+    for p in range(n):
+        for q in range(p + 1):
+            for r in range(n):
+                for s in range(r + 1):
+                    if (r, s) > (p, q):
+                        continue
+                    v = scale * (2.0 * rnd.random() - 1.0)
+                    v *= math.exp(-decay * (abs(eps[p] - eps[q]) + abs(eps[r] - eps[s])))
+                    if p == q and r == s:
+                        v = abs(v) + scale
+                    ints[(p, q, r, s)] = v
+    return ints
+
+
+def get_spatial(ints, p, q, r, s):
+    pq = (max(p, q), min(p, q))
+    rs = (max(r, s), min(r, s))
+    if rs > pq:
+        pq, rs = rs, pq
+    return ints[pq + rs]
+
+
+def write_dirac_files(mrconee_path, mdcint_path, nocc=3, nvirt=4,
+                      eps_occ=(-2.0, -0.5), eps_virt=(0.1, 5.0),
+                      scale=0.02, decay=0.5, seed=2018, enuc=0.0):
+    n = nocc + nvirt
+    eps = []
+    for i in range(nocc):
+        eps.append(eps_occ[0] + (eps_occ[1] - eps_occ[0]) * i / max(nocc - 1, 1))
+    for a in range(nvirt):
+        eps.append(eps_virt[0] + (eps_virt[1] - eps_virt[0]) * a / max(nvirt - 1, 1))
+    ints = spatial_integrals(n, eps, scale, decay, seed)
+
+    # spinors: 2p (unbarred, alpha) and 2p+1 (barred, beta)
+    nspinors = 2 * n
+    nocc_spinors = 2 * nocc
+
+    def coulomb(a, b, c, d):
+        # <ab|cd> = (ac|bd)
+        if a % 2 != c % 2 or b % 2 != d % 2:
+            return 0.0
+        return get_spatial(ints, a // 2, c // 2, b // 2, d // 2)
+
+    def antisym(a, b, c, d):
+        return coulomb(a, b, c, d) - coulomb(a, b, d, c)
+
+    h = [[0.0] * nspinors for _ in range(nspinors)]
+    for a in range(nspinors):
+        for b in range(nspinors):
+            v = -sum(antisym(a, i, b, i) for i in range(nocc_spinors))
+            if a == b:
+                v += eps[a // 2]
+            h[a][b] = v
+    escf = enuc + sum(h[i][i] for i in range(nocc_spinors))
+    escf += 0.5 * sum(antisym(i, j, i, j) for i in range(nocc_spinors) for j in range(nocc_spinors))
+
+    with open(mrconee_path, 'wb') as f:
+        # nspinors, breit, enuc, invsym, nz_arith, is_spinfree, norb_total, escf
+        fortran_record(f, struct.pack('<2id4id', nspinors, 0, enuc, 1, 1, 1, nspinors, escf))
+        # nsymrp, repnames, nactive, nstr, nfrozen(0:2), ndelete
+        fortran_record(f, struct.pack('<i14s6i', 1, b'A'.ljust(14), nocc_spinors, n, 0, 0, 0, 0))
+        # abelian subgroup: fermion and boson irreps
+        fortran_record(f, struct.pack('<i4s4s', 1, b'   A', b'   a'))
+        fortran_record(f, struct.pack('<4i', 2, 1, 1, 2))
+        data = b''.join(struct.pack('<iid', 1, 1, eps[a // 2]) for a in range(nspinors))
+        data += struct.pack('<%di' % nspinors, *([1] * nspinors))
+        data += struct.pack('<2i', n, 1)
+        fortran_record(f, data)
+        fock = []
+        for a in range(nspinors):
+            for b in range(nspinors):
+                fock += [h[a][b], 0.0]
+        fortran_record(f, struct.pack('<%dd' % len(fock), *fock))
+
+    with open(mdcint_path, 'wb') as f:
+        kr = []
+        for i in range(n):
+            kr += [2 * i + 1, 2 * i + 2]
+        fortran_record(f, b'01Jan26   00:00:00' + struct.pack('<i%di' % len(kr), n, *kr))
+        for ikr in range(1, n + 1):
+            for jkr in range(1, ikr + 1):
+                ind = []
+                val = []
+                for kkr in range(1, n + 1):
+                    for lkr in range(1, n + 1):
+                        ind += [kkr, lkr]
+                        val.append(get_spatial(ints, ikr - 1, jkr - 1, kkr - 1, lkr - 1))
+                fortran_record(f, struct.pack('<3i%di%dd' % (len(ind), len(val)), ikr, jkr, len(val), *(ind + val)))
+        fortran_record(f, struct.pack('<3i', 0, 0, 0))
+
+    return escf
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+#
+# Test: integrals sorted directly from the MDCINT file (new_sorting) must
+# give the same FS-CCSD 0h1p energies as the default DIRAC path through the
+# VINT container. The MRCONEE and MDCINT files of a small model system are
+# written by dirac_files.py; no DIRAC is required
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+from dirac_files import write_dirac_files
+
+write_dirac_files("MRCONEE", "MDCINT", scale=0.1, decay=0.2)
+
+filter_scf  = Filter("SCF reference energy =",   -9.536154124735, 1e-8)
+filter_mp2  = Filter("MP2 correlation energy =", -0.010244602014, 1e-8)
+filter_ccsd = Filter("CCSD correlation energy =", -0.010956150026, 1e-8)
+filter_tot  = Filter("Total CCSD energy =",      -9.547110274761, 1e-8)
+filter_e1 = Filter("@    1", 0.0928800440, 1e-7)
+filter_e2 = Filter("@    2", 1.6962757184, 1e-7)
+
+filter_list = [
+  filter_scf, filter_mp2, filter_ccsd, filter_tot,
+  filter_e1, filter_e2
+]
+
+ret_codes = []
+for inp in ["ccsd.inp", "ccsd_new_sorting.inp", "ccsd_new_sorting_complex.inp"]:
+    ret = Test(inp, inp, filters=filter_list).run()
+    ret_codes.append(ret)
+
+execute("rm -rf scratch MRCONEE MDCINT")
+
+sys.exit(1 if any(ret_codes) else 0)
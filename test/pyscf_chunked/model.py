@@ -0,0 +1,105 @@
+#
+# Model system for the PySCF interface: random real integrals over spatial
+# orbitals (8-fold symmetry), spin orbitals with arbitrary phases, so that
+# the integrals over spinors are complex. The Fock matrix is diagonal.
+#
+# Integrals are written in the chunked layout (scripts/pyscf_eri_chunked.py)
+# and in the old dense layout: one file per diagram ../pyscf_<name>.dat with
+# antisymmetrized integrals <pq||rs> (see sort_pyscf_two_electron()).
+#
+
+import cmath
+import os
+import random
+import struct
+import sys
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'scripts'))
+from pyscf_eri_chunked import write_spinor_info, write_chunked_eri
+
+DENSE_DIAGRAMS = ["hhhh", "hhpp", "pphh", "phhp", "pphp", "phpp", "phhh", "hhhp", "hphh", "hphp"]
+
+
+class Model:
+
+    def __init__(self, eps_occ, eps_virt, scale=0.05, seed=2018):
+        rnd = random.Random(seed)
+        eps = list(eps_occ) + list(eps_virt)
+        n = len(eps)
+        self.n_orbitals = n
+        self.n_spinors = 2 * n
+        self.eps = [eps[p // 2] for p in range(self.n_spinors)]
+        self.occ = [1 if p // 2 < len(eps_occ) else 0 for p in range(self.n_spinors)]
+        self.phase = [cmath.exp(1j * rnd.uniform(0.0, 2.0 * cmath.pi)) for p in range(self.n_spinors)]
+
+        # (ij|kl), the largest values on the diagonal
+        self.spatial = {}
+        for i in range(n):
+            for j in range(i + 1):
+                for k in range(n):
+                    for l in range(k + 1):
+                        if (k, l) > (i, j):
+                            continue
+                        v = scale * rnd.uniform(-1.0, 1.0)
+                        if i == j and k == l:
+                            v += 0.5
+                        for key in [(i, j, k, l), (j, i, k, l), (i, j, l, k), (j, i, l, k),
+                                    (k, l, i, j), (l, k, i, j), (k, l, j, i), (l, k, j, i)]:
+                            self.spatial[key] = v
+
+    def mulliken(self, p, q, r, s):
+        # (pq|rs) over spinors
+        if p % 2 != q % 2 or r % 2 != s % 2:
+            return 0.0
+        ph = self.phase
+        v = self.spatial[(p // 2, q // 2, r // 2, s // 2)]
+        return v * (ph[p].conjugate() * ph[q] * ph[r].conjugate() * ph[s])
+
+    def coulomb(self, p, q, r, s):
+        # <pq|rs> = (pr|qs)
+        return self.mulliken(p, r, q, s)
+
+    def antisym(self, p, q, r, s):
+        return self.coulomb(p, q, r, s) - self.coulomb(p, q, s, r)
+
+    def write_spinor_info(self, path):
+        write_spinor_info(path, 0.0, 0.0, self.occ, self.eps)
+
+    def write_chunked(self, path, chunk_size):
+        def get_block(sp, sq, sr, ss):
+            rng = lambda sl: range(sl.start, sl.stop)
+            return [[[[self.mulliken(p, q, r, s) for s in rng(ss)] for r in rng(sr)] for q in rng(sq)]
+                    for p in rng(sp)]
+        write_chunked_eri(path, self.n_spinors, get_block, chunk_size=chunk_size)
+
+    def write_dense(self, directory):
+        spinors = {
+            'h': [p for p in range(self.n_spinors) if self.occ[p]],
+            'p': [p for p in range(self.n_spinors) if not self.occ[p]]
+        }
+        for name in DENSE_DIAGRAMS:
+            idx = [spinors[c] for c in name]
+            values = []
+            for p in idx[0]:
+                for q in idx[1]:
+                    for r in idx[2]:
+                        for s in idx[3]:
+                            v = self.antisym(p, q, r, s)
+                            values += [v.real, v.imag]
+            write_values(os.path.join(directory, "pyscf_%s.dat" % name), values)
+
+        # pppp: conj(buf[a][c][b][d]) is put into the block [a][b][c][d]
+        part = spinors['p']
+        values = []
+        for a in part:
+            for c in part:
+                for b in part:
+                    for d in part:
+                        v = self.antisym(a, b, c, d)
+                        values += [v.real, v.imag]
+        write_values(os.path.join(directory, "pyscf_pppp.dat"), values)
+
+
+def write_values(path, values):
+    with open(path, 'wb') as f:
+        f.write(struct.pack('<%dd' % len(values), *values))
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+#
+# Test: two-electron integrals of the PySCF interface in the chunked layout
+# (scripts/pyscf_eri_chunked.py) must give the same CCSD energies as the old
+# dense layout. Chunks (4 spinors) and tiles (3 spinors) are smaller than the
+# number of spinors (10); no PySCF is required, see model.py
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+from model import Model, DENSE_DIAGRAMS
+
+model = Model(eps_occ=[-1.0, -0.6], eps_virt=[0.3, 0.7, 1.2])
+model.write_spinor_info("pyscf_1e.bin")
+model.write_chunked("pyscf_2e.bin", chunk_size=4)
+model.write_dense(".")
+
+filter_mp2  = Filter("MP2 correlation energy =",  -0.013300247264, 1e-8)
+filter_ccsd = Filter("CCSD correlation energy =", -0.020416489098, 1e-8)
+
+filter_list = [
+  filter_mp2, filter_ccsd
+]
+
+ret_codes = []
+for inp in ["ccsd_dense.inp", "ccsd_chunked.inp", "ccsd_chunked_omp.inp"]:
+    ret = Test(inp, inp, filters=filter_list).run()
+    ret_codes.append(ret)
+
+execute("rm -rf scratch pyscf_1e.bin pyscf_2e.bin pyscf_pppp.dat")
+for name in DENSE_DIAGRAMS:
+    execute("rm -f pyscf_%s.dat" % name)
+
+sys.exit(1 if any(ret_codes) else 0)
@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+
+#
+# Test: FS-CCSD in the 0h1p sector for the synthetic integral generator
+# (interface synthetic); no DIRAC is required
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+filter_scf  = Filter("SCF reference energy =",   -10.234389756143, 1e-8)
+filter_mp2  = Filter("MP2 correlation energy =",  -0.002527204223, 1e-8)
+filter_ccsd = Filter("CCSD correlation energy =", -0.002522595727, 1e-8)
+filter_tot  = Filter("Total CCSD energy =",      -10.236912351869, 1e-8)
+filter_e1 = Filter("@    1", 0.1979413160, 1e-7)
+filter_e2 = Filter("@    2", 0.4017712655, 1e-7)
+filter_e3 = Filter("@    3", 0.6023645031, 1e-7)
+filter_e4 = Filter("@    4", 0.8071238946, 1e-7)
+
+filter_list = [
+  filter_scf, filter_mp2, filter_ccsd, filter_tot,
+  filter_e1, filter_e2, filter_e3, filter_e4
+]
+
+ret = Test("synthetic 0h1p", "ccsd.inp", filters=filter_list).run()
+execute("rm -rf scratch")
+
+sys.exit(ret)
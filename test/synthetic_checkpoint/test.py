@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+
+#
+# Test: restart from the checkpoint file. The first run is stopped after
+# 5 iterations, the second one continues it and must converge to the same energies
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute, FSCC_PATH
+
+execute("rm -rf scratch")
+execute(FSCC_PATH + " --no-clean ck_stop.inp > ck_stop.out")
+
+filter_restart = Filter("restart from the checkpoint file checkpoint.chk after iteration", 5.0, 0.5)
+filter_ccsd = Filter("CCSD correlation energy =", -0.002522595727, 1e-8)
+filter_e1 = Filter("@    1", 0.1979413160, 1e-7)
+filter_e2 = Filter("@    2", 0.4017712655, 1e-7)
+filter_e3 = Filter("@    3", 0.6023645031, 1e-7)
+filter_e4 = Filter("@    4", 0.8071238946, 1e-7)
+
+filter_list = [
+  filter_restart, filter_ccsd, filter_e1, filter_e2, filter_e3, filter_e4
+]
+
+ret = Test("synthetic 0h1p, restart", "ck_restart.inp", filters=filter_list).run("--no-clean")
+execute("rm -rf scratch")
+
+sys.exit(ret)
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+#
+# Test: Cholesky representation of the pppp integrals (disk_usage auto cholesky).
+# The second run reuses the sorted integrals of the first one (reuse 2-integrals):
+# pppp integrals are then read as ordinary ones
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+filter_ccsd = Filter("CCSD correlation energy =", -0.002522595727, 1e-8)
+filter_e1 = Filter("@    1", 0.1979413160, 1e-7)
+filter_e2 = Filter("@    2", 0.4017712655, 1e-7)
+filter_e3 = Filter("@    3", 0.6023645031, 1e-7)
+filter_e4 = Filter("@    4", 0.8071238946, 1e-7)
+
+filter_list = [
+  filter_ccsd, filter_e1, filter_e2, filter_e3, filter_e4
+]
+
+# return codes
+ret_codes = []
+
+execute("rm -rf scratch")
+
+ret = Test("synthetic 0h1p, Cholesky pppp", "ccsd.inp", filters=filter_list).run("--no-clean")
+ret_codes.append(ret)
+
+ret = Test("synthetic 0h1p, Cholesky pppp, reuse", "ccsd_reuse.inp", filters=filter_list).run("--no-clean")
+ret_codes.append(ret)
+
+execute("rm -rf scratch")
+
+sys.exit(1 if any(ret_codes) else 0)
@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+#
+# Test: compressed storage tier (disk_usage 2) with all codecs and with the
+# compressed blocks kept in RAM; energies must coincide with the plain run
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+# return codes
+ret_codes = []
+
+# lossless codecs must reproduce the reference exactly,
+# the lossy one is allowed to deviate within its tolerance
+inputs = [
+  ("lz4.inp",     1e-8),
+  ("shuffle.inp", 1e-8),
+  ("sparse.inp",  1e-8),
+  ("lossy.inp",   1e-7),
+  ("ram.inp",     1e-8),
+]
+
+for inp, eps in inputs:
+    filter_list = [
+      Filter("CCSD correlation energy =", -0.002522595727, eps),
+      Filter("@    1", 0.1979413160, max(eps, 1e-7)),
+      Filter("@    2", 0.4017712655, max(eps, 1e-7)),
+      Filter("@    3", 0.6023645031, max(eps, 1e-7)),
+      Filter("@    4", 0.8071238946, max(eps, 1e-7)),
+    ]
+    ret = Test("synthetic 0h1p, " + inp, inp, filters=filter_list).run()
+    ret_codes.append(ret)
+    execute("rm -rf scratch")
+
+sys.exit(1 if any(ret_codes) else 0)
@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+#
+# Test: automatic placement of integrals (disk_usage auto). Under the 64 mb
+# limit a part of the integrals is kept off RAM; energies must coincide
+# with the run where everything fits into memory
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+# return codes
+ret_codes = []
+
+filter_ccsd = Filter("CCSD correlation energy =", -0.002242066172, 1e-8)
+filter_e1 = Filter("@    1", 0.1430815970, 1e-7)
+filter_e2 = Filter("@    2", 0.2443345638, 1e-7)
+filter_e3 = Filter("@    3", 0.3440113991, 1e-7)
+filter_e4 = Filter("@    4", 0.4468799955, 1e-7)
+
+filter_list = [
+  filter_ccsd, filter_e1, filter_e2, filter_e3, filter_e4
+]
+
+ret = Test("synthetic 0h1p, reference", "ccsd_ref.inp", filters=filter_list).run()
+ret_codes.append(ret)
+execute("rm -rf scratch")
+
+# pppp integrals (12.2 MB) do not fit into the budget and go off RAM
+filter_placement = Filter("total in RAM", [None, 12.243], 1.0)
+
+ret = Test("synthetic 0h1p, disk_usage auto", "ccsd_auto.inp", filters=filter_list + [filter_placement]).run()
+ret_codes.append(ret)
+execute("rm -rf scratch")
+
+sys.exit(1 if any(ret_codes) else 0)
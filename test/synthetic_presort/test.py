@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+
+#
+# Test: FS-CCSD in the 1h1p sector with and without the presort of
+# two-electron integrals (EXPT_NO_PRESORT), serial and with 4 threads;
+# all runs must give the same energies
+#
+
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+# return codes
+ret_codes = []
+
+filter_ccsd = Filter("CCSD correlation energy =", -0.002522595727, 1e-8)
+filter_e1 = Filter("@    2", 0.7668592163, 1e-7)
+filter_e2 = Filter("@    3", 0.9501743272, 1e-7)
+filter_e3 = Filter("@    4", 0.9848079971, 1e-7)
+filter_e4 = Filter("@    5", 1.1684860005, 1e-7)
+filter_e5 = Filter("@    6", 1.2017718653, 1e-7)
+
+filter_list = [
+  filter_ccsd, filter_e1, filter_e2, filter_e3, filter_e4, filter_e5
+]
+
+#
+# default: integrals are presorted
+#
+
+os.environ.pop("EXPT_NO_PRESORT", None)
+ret = Test("synthetic 1h1p, presort", "ccsd.inp", filters=filter_list, output="ccsd_presort.out").run()
+ret_codes.append(ret)
+execute("rm -rf scratch")
+
+#
+# presort disabled
+#
+
+os.environ["EXPT_NO_PRESORT"] = "1"
+ret = Test("synthetic 1h1p, no presort", "ccsd.inp", filters=filter_list, output="ccsd_no_presort.out").run()
+ret_codes.append(ret)
+del os.environ["EXPT_NO_PRESORT"]
+execute("rm -rf scratch")
+
+#
+# parallel sorting (4 threads), with and without presort
+#
+
+ret = Test("synthetic 1h1p, presort, 4 threads", "ccsd_omp.inp", filters=filter_list,
+           output="ccsd_omp_presort.out").run()
+ret_codes.append(ret)
+execute("rm -rf scratch")
+
+os.environ["EXPT_NO_PRESORT"] = "1"
+ret = Test("synthetic 1h1p, no presort, 4 threads", "ccsd_omp.inp", filters=filter_list,
+           output="ccsd_omp_no_presort.out").run()
+ret_codes.append(ret)
+del os.environ["EXPT_NO_PRESORT"]
+execute("rm -rf scratch")
+
+sys.exit(1 if any(ret_codes) else 0)
@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+#
+# Test: cache of sorted integrals (reuse cache). The first run fills the cache,
+# the second one must take the integrals from it and give the same energies.
+# The third run with compressed block files must map the (raw) cached blocks
+#
+
+import sys
+import os
+import re
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+from minitest import Test, Filter, execute
+
+# return codes
+ret_codes = []
+
+filter_ccsd = Filter("CCSD correlation energy =", -0.002522595727, 1e-8)
+filter_e1 = Filter("@    1", 0.1979413160, 1e-7)
+filter_e2 = Filter("@    2", 0.4017712655, 1e-7)
+filter_e3 = Filter("@    3", 0.6023645031, 1e-7)
+filter_e4 = Filter("@    4", 0.8071238946, 1e-7)
+
+filter_list = [
+  filter_ccsd, filter_e1, filter_e2, filter_e3, filter_e4
+]
+
+execute("rm -rf icache")
+
+ret = Test("synthetic 0h1p, cache is filled", "ccsd.inp", filters=filter_list, output="ccsd_fill.out").run()
+ret_codes.append(ret)
+
+ret = Test("synthetic 0h1p, cache is used", "ccsd.inp", filters=filter_list, output="ccsd_reuse.out").run()
+ret_codes.append(ret)
+
+# the second run must not sort the integrals again
+with open("ccsd_reuse.out") as f:
+    if "are taken from the cache" not in f.read():
+        ret_codes.append(1)
+
+ret = Test("synthetic 0h1p, cache is used, compress lz4", "ccsd_lz4.inp", filters=filter_list,
+           output="ccsd_lz4.out").run()
+ret_codes.append(ret)
+
+# cached blocks are mapped into memory although other block files are compressed
+with open("ccsd_lz4.out") as f:
+    out = f.read()
+    mapped = re.search(r"mapped\s+(\d+) bytes", out)
+    if "are taken from the cache" not in out or not mapped or int(mapped.group(1)) == 0:
+        ret_codes.append(1)
+
+execute("rm -rf icache scratch")
+
+sys.exit(1 if any(ret_codes) else 0)